@@ -0,0 +1,96 @@
+// =============================================================================
+// apply_edits_bench.cpp - Batched Edit Benchmarks
+// =============================================================================
+//
+// Replace-all of one occurrence per kilobyte: GapBuffer::applyEdits in a
+// single pass versus issuing the same edits one by one in multi-cursor
+// (arbitrary) order, where every edit moves the gap across the document.
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "gap_buffer.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using mdeditor::Edit;
+using mdeditor::GapBuffer;
+
+namespace {
+
+constexpr size_t kSpacing = 1024;
+
+/// A document with a "needle" every kSpacing bytes
+std::string makeDocument(size_t size) {
+    std::string text(size, 'x');
+    for (size_t pos = 0; pos + 6 <= size; pos += kSpacing) {
+        text.replace(pos, 6, "needle");
+    }
+    return text;
+}
+
+std::vector<Edit> makeReplaceAll(size_t size, std::string_view replacement) {
+    std::vector<Edit> edits;
+    for (size_t pos = 0; pos + 6 <= size; pos += kSpacing) {
+        edits.push_back(Edit{pos, 6, replacement});
+    }
+    return edits;
+}
+
+} // anonymous namespace
+
+static void BM_ReplaceAll_ApplyEdits(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const std::string text = makeDocument(size);
+    const std::vector<Edit> edits = makeReplaceAll(size, "haystack");
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        GapBuffer buffer;
+        buffer.loadFromString(text);
+        state.ResumeTiming();
+        
+        buffer.applyEdits(edits);
+        benchmark::DoNotOptimize(buffer.length());
+    }
+    state.counters["edits"] = static_cast<double>(edits.size());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_ReplaceAll_ApplyEdits)
+    ->Arg(1 << 20)->Arg(10 << 20)->Arg(100 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ReplaceAll_SequentialShuffled(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const std::string text = makeDocument(size);
+    std::vector<Edit> edits = makeReplaceAll(size, "haystack");
+    std::shuffle(edits.begin(), edits.end(), std::mt19937(3));
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        GapBuffer buffer;
+        buffer.loadFromString(text);
+        state.ResumeTiming();
+        
+        // Map each pre-batch offset through the edits already applied
+        std::vector<size_t> appliedStarts;
+        for (const Edit& edit : edits) {
+            const size_t before = static_cast<size_t>(
+                std::lower_bound(appliedStarts.begin(), appliedStarts.end(), edit.start)
+                - appliedStarts.begin());
+            const size_t position = edit.start + before * 2;  // "haystack" is 2 longer
+            buffer.erase(position, edit.removedLength);
+            buffer.insert(position, edit.insertedText);
+            appliedStarts.insert(appliedStarts.begin() + before, edit.start);
+        }
+        benchmark::DoNotOptimize(buffer.length());
+    }
+    state.counters["edits"] = static_cast<double>(edits.size());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_ReplaceAll_SequentialShuffled)
+    ->Arg(1 << 20)->Arg(10 << 20)
+    ->Unit(benchmark::kMillisecond);
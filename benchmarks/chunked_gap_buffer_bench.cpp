@@ -0,0 +1,63 @@
+// =============================================================================
+// chunked_gap_buffer_bench.cpp - Single vs Chunked Gap Buffer Benchmarks
+// =============================================================================
+//
+// Alternates single-byte edits between the start and the end of a large
+// document: the worst case for GapBuffer (every edit moves the whole text
+// across the gap) and a bounded cost for ChunkedGapBuffer.
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "chunked_gap_buffer.h"
+#include "gap_buffer.h"
+
+#include <string>
+
+using mdeditor::ChunkedGapBuffer;
+using mdeditor::GapBuffer;
+
+namespace {
+
+std::string makeDocument(size_t size) {
+    std::string text(size, 'x');
+    for (size_t i = 79; i < size; i += 80) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+template <typename Buffer>
+void alternatingEnds(benchmark::State& state) {
+    Buffer buffer;
+    buffer.loadFromString(makeDocument(static_cast<size_t>(state.range(0)) << 20));
+    bool front = true;
+    for (auto _ : state) {
+        buffer.insert(front ? 0 : buffer.length(), "a");
+        front = !front;
+    }
+    benchmark::DoNotOptimize(buffer.length());
+}
+
+} // anonymous namespace
+
+static void BM_AlternatingEnds_GapBuffer(benchmark::State& state) {
+    alternatingEnds<GapBuffer>(state);
+}
+BENCHMARK(BM_AlternatingEnds_GapBuffer)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_AlternatingEnds_Chunked(benchmark::State& state) {
+    alternatingEnds<ChunkedGapBuffer>(state);
+}
+BENCHMARK(BM_AlternatingEnds_Chunked)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_LineFromOffset_Chunked(benchmark::State& state) {
+    ChunkedGapBuffer buffer;
+    buffer.loadFromString(makeDocument(static_cast<size_t>(state.range(0)) << 20));
+    size_t offset = 0;
+    for (auto _ : state) {
+        offset = (offset + 7919 * 4099) % buffer.length();
+        benchmark::DoNotOptimize(buffer.lineFromOffset(offset));
+    }
+}
+BENCHMARK(BM_LineFromOffset_Chunked)->Arg(64);
@@ -0,0 +1,259 @@
+// =============================================================================
+// editing_bench.cpp - GapBuffer Editing Latency Benchmarks
+// =============================================================================
+//
+// The core editing paths (moveGapTo, grow, recordPatch, the line index) at
+// document sizes of 64 KB, 1 MB, 16 MB and 128 MB:
+//
+//   - Typing: one character per keystroke at an advancing cursor
+//   - RandomPositionEdits: small inserts and erases at random offsets, so
+//     every edit moves the gap
+//   - BackspaceRun: one-byte erases walking backwards from the middle
+//   - LargePaste: 1 MB inserted at a random offset. The untimed cut after
+//     each paste lets the shrink policy return the gap, so every paste
+//     includes the grow a first paste into a large document pays
+//   - EditThenLineFromOffset / EditThenOffsetFromLine: a keystroke, then
+//     line mapping at a random position
+//   - EditThenTextStats: a keystroke, then the status bar counts
+//     (characters, words, lines), which the edit keeps current
+//   - EditThenDigest: a keystroke, then the ContentHash digest that tells
+//     whether the text still equals the saved file
+//   - GetText: the whole document, and a 4 KB viewport
+//
+// Pending patches are drained every kDrainInterval edits, as the editor does
+// once per frame, so the patch log stays bounded. Run only some sizes with
+// e.g. --benchmark_filter='Typing/1048576$', and write JSON for comparison
+// with the gapbuffer_bench_json target (see benchmarks/CMakeLists.txt).
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "content_hash.h"
+#include "gap_buffer.h"
+
+#include <random>
+#include <string>
+
+using mdeditor::GapBuffer;
+
+namespace {
+
+constexpr size_t kDrainInterval = 64;
+constexpr size_t kPasteSize = 1 << 20;
+
+/// Markdown-like document: lines of 20-100 bytes
+std::string makeDocument(size_t size) {
+    std::string text(size, 'x');
+    std::mt19937 rng(19);
+    for (size_t i = 20 + rng() % 80; i < size; i += 20 + rng() % 80) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+void loadDocument(GapBuffer& buffer, const benchmark::State& state) {
+    buffer.loadFromString(makeDocument(static_cast<size_t>(state.range(0))));
+}
+
+/// Drains pending patches every kDrainInterval calls
+void drainPeriodically(GapBuffer& buffer, size_t& edits) {
+    if (++edits % kDrainInterval == 0) {
+        buffer.drainPatches([](const mdeditor::PatchView&) {});
+    }
+}
+
+/// Moves the gap to offset before timing starts, so the first keystroke
+/// does not pay for a move across half of the document
+void placeGap(GapBuffer& buffer, size_t offset) {
+    buffer.insert(offset, "a");
+    buffer.erase(offset, 1);
+    buffer.drainPatches([](const mdeditor::PatchView&) {});
+}
+
+void applySizeArgs(benchmark::internal::Benchmark* bench) {
+    bench->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20)->Arg(128 << 20);
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Edits
+// =============================================================================
+
+static void BM_Typing(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    size_t cursor = buffer.length() / 2;
+    placeGap(buffer, cursor);
+    size_t edits = 0;
+    for (auto _ : state) {
+        buffer.insert(cursor, (cursor % 64 == 0) ? "\n" : "a");
+        ++cursor;
+        drainPeriodically(buffer, edits);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Typing)->Apply(applySizeArgs);
+
+static void BM_RandomPositionEdits(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    std::mt19937_64 rng(42);
+    size_t edits = 0;
+    for (auto _ : state) {
+        // Insert and erase alternate, so the size stays put
+        const size_t offset = rng() % (buffer.length() + 1);
+        if (edits % 2 == 0) {
+            buffer.insert(offset, "word ");
+        } else {
+            buffer.erase(offset, 5);
+        }
+        drainPeriodically(buffer, edits);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomPositionEdits)->Apply(applySizeArgs);
+
+static void BM_BackspaceRun(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    const size_t start = buffer.length() / 2;
+    size_t cursor = start;
+    placeGap(buffer, cursor);
+    size_t edits = 0;
+    for (auto _ : state) {
+        if (cursor == 0) {
+            // Start the run over on a fresh document
+            state.PauseTiming();
+            loadDocument(buffer, state);
+            cursor = start;
+            placeGap(buffer, cursor);
+            state.ResumeTiming();
+        }
+        buffer.erase(--cursor, 1);
+        drainPeriodically(buffer, edits);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BackspaceRun)->Apply(applySizeArgs);
+
+static void BM_LargePaste(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    const std::string paste = makeDocument(kPasteSize);
+    std::mt19937_64 rng(7);
+    for (auto _ : state) {
+        const size_t offset = rng() % (buffer.length() + 1);
+        buffer.insert(offset, paste);
+
+        // Take it out again (untimed), so every paste sees the same size
+        state.PauseTiming();
+        buffer.erase(offset, paste.size());
+        buffer.drainPatches([](const mdeditor::PatchView&) {});
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(paste.size()));
+}
+BENCHMARK(BM_LargePaste)->Apply(applySizeArgs)->Unit(benchmark::kMicrosecond);
+
+// =============================================================================
+// Line Mapping
+// =============================================================================
+
+/// A keystroke (the index is updated incrementally) and a lookup
+static void BM_EditThenLineFromOffset(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    std::mt19937_64 rng(11);
+    size_t cursor = buffer.length() / 2;
+    placeGap(buffer, cursor);
+    size_t edits = 0;
+    for (auto _ : state) {
+        buffer.insert(cursor++, "a");
+        drainPeriodically(buffer, edits);
+        benchmark::DoNotOptimize(buffer.lineFromOffset(rng() % buffer.length()));
+    }
+}
+BENCHMARK(BM_EditThenLineFromOffset)->Apply(applySizeArgs);
+
+static void BM_EditThenOffsetFromLine(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    std::mt19937_64 rng(11);
+    size_t cursor = buffer.length() / 2;
+    placeGap(buffer, cursor);
+    size_t edits = 0;
+    for (auto _ : state) {
+        buffer.insert(cursor++, "a");
+        drainPeriodically(buffer, edits);
+        benchmark::DoNotOptimize(buffer.offsetFromLine(rng() % buffer.lineCount(), 3));
+    }
+}
+BENCHMARK(BM_EditThenOffsetFromLine)->Apply(applySizeArgs);
+
+// =============================================================================
+// Document Statistics
+// =============================================================================
+
+/// A keystroke (alternating letters and spaces, so words change) and the
+/// counts; the first textStats() call counts the document before timing
+static void BM_EditThenTextStats(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    size_t cursor = buffer.length() / 2;
+    placeGap(buffer, cursor);
+    benchmark::DoNotOptimize(buffer.textStats());
+    size_t edits = 0;
+    for (auto _ : state) {
+        buffer.insert(cursor++, edits % 2 == 0 ? "a" : " ");
+        drainPeriodically(buffer, edits);
+        benchmark::DoNotOptimize(buffer.textStats());
+    }
+}
+BENCHMARK(BM_EditThenTextStats)->Apply(applySizeArgs);
+
+/// A keystroke, its patch fed to the hash, and the digest (one chunk rehashed)
+static void BM_EditThenDigest(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    size_t cursor = buffer.length() / 2;
+    placeGap(buffer, cursor);
+    mdeditor::ContentHash hash;
+    hash.rebuild(buffer);
+    for (auto _ : state) {
+        buffer.insert(cursor++, "a");
+        buffer.drainPatches([&hash](const mdeditor::PatchView& patch) {
+            hash.recordEdit(patch.start, patch.removedLength, patch.insertedText.size());
+        });
+        benchmark::DoNotOptimize(hash.digest(buffer));
+    }
+}
+BENCHMARK(BM_EditThenDigest)->Apply(applySizeArgs);
+
+// =============================================================================
+// Reads
+// =============================================================================
+
+static void BM_GetText(benchmark::State& state) {
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    placeGap(buffer, buffer.length() / 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.getText());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(buffer.length()));
+}
+BENCHMARK(BM_GetText)->Apply(applySizeArgs)->Unit(benchmark::kMicrosecond);
+
+static void BM_GetTextViewport(benchmark::State& state) {
+    constexpr size_t kViewport = 4096;
+    GapBuffer buffer;
+    loadDocument(buffer, state);
+    placeGap(buffer, buffer.length() / 2);
+    std::mt19937_64 rng(13);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.getText(rng() % (buffer.length() - kViewport), kViewport));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(kViewport));
+}
+BENCHMARK(BM_GetTextViewport)->Apply(applySizeArgs);
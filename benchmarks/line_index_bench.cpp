@@ -0,0 +1,106 @@
+// =============================================================================
+// line_index_bench.cpp - Line/Offset Mapping Benchmarks
+// =============================================================================
+//
+// Measures GapBuffer line mapping on a 1M-line document against a plain
+// byte-scanning baseline (the approach GapBuffer used before it kept a
+// line-start index).
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "gap_buffer.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+using mdeditor::GapBuffer;
+
+namespace {
+
+constexpr size_t kLines = 1'000'000;
+
+/// Builds a document of kLines lines with varying lengths (~40 MB)
+const std::string& millionLineDocument() {
+    static const std::string text = [] {
+        std::string result;
+        result.reserve(kLines * 40);
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < kLines; ++i) {
+            result.append(8 + rng() % 64, 'x');
+            result.push_back('\n');
+        }
+        return result;
+    }();
+    return text;
+}
+
+/// Loads the document and parks the gap in the middle, as after an edit
+GapBuffer makeBuffer() {
+    GapBuffer buffer;
+    buffer.loadFromString(millionLineDocument());
+    buffer.insert(buffer.length() / 2, "edit");
+    return buffer;
+}
+
+size_t scanLineFromOffset(const std::string& text, size_t offset) {
+    return static_cast<size_t>(std::count(text.begin(), text.begin() + offset, '\n'));
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Indexed queries
+// =============================================================================
+
+static void BM_LineCount(benchmark::State& state) {
+    GapBuffer buffer = makeBuffer();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.lineCount());
+    }
+}
+BENCHMARK(BM_LineCount);
+
+static void BM_LineFromOffset(benchmark::State& state) {
+    GapBuffer buffer = makeBuffer();
+    std::mt19937 rng(7);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.lineFromOffset(rng() % buffer.length()));
+    }
+}
+BENCHMARK(BM_LineFromOffset);
+
+static void BM_OffsetFromLine(benchmark::State& state) {
+    GapBuffer buffer = makeBuffer();
+    std::mt19937 rng(7);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.offsetFromLine(rng() % kLines, 3));
+    }
+}
+BENCHMARK(BM_OffsetFromLine);
+
+/// A keystroke followed by the status-bar cursor-to-line lookup
+static void BM_TypingWithLineLookup(benchmark::State& state) {
+    GapBuffer buffer = makeBuffer();
+    size_t cursor = buffer.length() / 3;
+    for (auto _ : state) {
+        buffer.insert(cursor, (cursor % 60 == 0) ? "\n" : "a");
+        ++cursor;
+        benchmark::DoNotOptimize(buffer.lineFromOffset(cursor));
+    }
+}
+BENCHMARK(BM_TypingWithLineLookup);
+
+// =============================================================================
+// Scanning baseline
+// =============================================================================
+
+static void BM_ScanLineFromOffset(benchmark::State& state) {
+    const std::string& text = millionLineDocument();
+    std::mt19937 rng(7);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scanLineFromOffset(text, rng() % text.size()));
+    }
+}
+BENCHMARK(BM_ScanLineFromOffset);
@@ -0,0 +1,99 @@
+// =============================================================================
+// multi_gap_buffer_bench.cpp - Ping-Pong Editing Benchmarks
+// =============================================================================
+//
+// Typing that alternates between distant places of one document, as with a
+// heading at the top and notes at the bottom, or two split views:
+//
+//   - PingPong: one keystroke at a cursor near the start, then one at a
+//     cursor near the end, both advancing
+//   - ThreeSites: keystrokes rotating between the start, middle and end
+//
+// each on GapBuffer (every switch moves the gap across the document),
+// ChunkedGapBuffer and MultiGapBuffer (one gap per cursor, nothing moves).
+// Sizes are in MB; pending patches are drained every 64 keystrokes.
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "chunked_gap_buffer.h"
+#include "gap_buffer.h"
+#include "multi_gap_buffer.h"
+
+#include <array>
+#include <string>
+
+using mdeditor::ChunkedGapBuffer;
+using mdeditor::GapBuffer;
+using mdeditor::MultiGapBuffer;
+
+namespace {
+
+constexpr size_t kDrainInterval = 64;
+
+std::string makeDocument(size_t size) {
+    std::string text(size, 'x');
+    for (size_t i = 79; i < size; i += 80) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+/// Types one byte per iteration at each cursor in turn
+template <typename Buffer, size_t Sites>
+void rotateSites(benchmark::State& state) {
+    Buffer buffer;
+    buffer.loadFromString(makeDocument(static_cast<size_t>(state.range(0)) << 20));
+
+    // Cursors spread from near the start to near the end
+    std::array<size_t, Sites> cursors{};
+    for (size_t i = 0; i < Sites; ++i) {
+        cursors[i] = 100 + (buffer.length() - 200) / (Sites - 1) * i;
+    }
+
+    size_t site = 0;
+    size_t edits = 0;
+    for (auto _ : state) {
+        buffer.insert(cursors[site], "a");
+        // The keystroke shifts every cursor behind it
+        for (size_t i = site; i < Sites; ++i) {
+            ++cursors[i];
+        }
+        site = (site + 1) % Sites;
+        if (++edits % kDrainInterval == 0) {
+            buffer.drainPatches([](const mdeditor::PatchView&) {});
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void applySizeArgs(benchmark::internal::Benchmark* bench) {
+    bench->Arg(1)->Arg(16)->Arg(64);
+}
+
+} // anonymous namespace
+
+static void BM_PingPong_GapBuffer(benchmark::State& state) {
+    rotateSites<GapBuffer, 2>(state);
+}
+BENCHMARK(BM_PingPong_GapBuffer)->Apply(applySizeArgs);
+
+static void BM_PingPong_Chunked(benchmark::State& state) {
+    rotateSites<ChunkedGapBuffer, 2>(state);
+}
+BENCHMARK(BM_PingPong_Chunked)->Apply(applySizeArgs);
+
+static void BM_PingPong_MultiGap(benchmark::State& state) {
+    rotateSites<MultiGapBuffer, 2>(state);
+}
+BENCHMARK(BM_PingPong_MultiGap)->Apply(applySizeArgs);
+
+static void BM_ThreeSites_GapBuffer(benchmark::State& state) {
+    rotateSites<GapBuffer, 3>(state);
+}
+BENCHMARK(BM_ThreeSites_GapBuffer)->Apply(applySizeArgs);
+
+static void BM_ThreeSites_MultiGap(benchmark::State& state) {
+    rotateSites<MultiGapBuffer, 3>(state);
+}
+BENCHMARK(BM_ThreeSites_MultiGap)->Apply(applySizeArgs);
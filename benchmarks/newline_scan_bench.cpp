@@ -0,0 +1,61 @@
+// =============================================================================
+// newline_scan_bench.cpp - Newline Kernel Throughput Benchmarks
+// =============================================================================
+//
+// Reports bytes_per_second for each kernel level the CPU supports, so the
+// SIMD speedup over the scalar loop is visible directly:
+//   gapbuffer_bench --benchmark_filter=Newlines
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "newline_scan.h"
+
+#include <random>
+#include <string>
+
+using mdeditor::simd::Level;
+
+namespace {
+
+/// Markdown-like text: ~1 newline per 40 bytes
+std::string makeText(size_t size) {
+    std::string text(size, ' ');
+    std::mt19937 rng(1);
+    for (char& c : text) {
+        c = (rng() % 40 == 0) ? '\n' : static_cast<char>('a' + rng() % 26);
+    }
+    return text;
+}
+
+void applyLevelArgs(benchmark::internal::Benchmark* bench) {
+    for (int level = 0; level <= static_cast<int>(mdeditor::simd::detectedLevel()); ++level) {
+        bench->Args({level, 64 << 10});   // L2-resident
+        bench->Args({level, 64 << 20});   // Memory-bound
+    }
+}
+
+} // anonymous namespace
+
+static void BM_CountNewlines(benchmark::State& state) {
+    const auto level = static_cast<Level>(state.range(0));
+    const std::string text = makeText(static_cast<size_t>(state.range(1)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mdeditor::simd::countNewlines(text, level));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetLabel(mdeditor::simd::levelName(level));
+}
+BENCHMARK(BM_CountNewlines)->Apply(applyLevelArgs);
+
+static void BM_FindNthNewline(benchmark::State& state) {
+    const auto level = static_cast<Level>(state.range(0));
+    const std::string text = makeText(static_cast<size_t>(state.range(1)));
+    const size_t last = mdeditor::simd::countNewlines(text) - 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mdeditor::simd::findNthNewline(text, last, level));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetLabel(mdeditor::simd::levelName(level));
+}
+BENCHMARK(BM_FindNthNewline)->Apply(applyLevelArgs);
@@ -0,0 +1,112 @@
+// =============================================================================
+// piece_tree_bench.cpp - Piece Tree vs Gap Buffer Benchmarks
+// =============================================================================
+//
+// Random-position edit workloads on documents of 1 MB, 100 MB and 1 GB:
+//
+//   - RandomEdits: small inserts and erases at uniformly random offsets.
+//     GapBuffer moves on average a third of the document per edit;
+//     PieceTree does O(log pieces) work.
+//   - RandomLineLookups: lineFromOffset/offsetFromLine at random positions
+//     after a batch of 10,000 scattered edits.
+//
+// The 1 GB cases need about 3 GB of memory (source text plus one buffer).
+// Run only some sizes with e.g. --benchmark_filter='/100$'.
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "gap_buffer.h"
+#include "piece_tree.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using mdeditor::GapBuffer;
+using mdeditor::PieceTree;
+
+namespace {
+
+std::string makeDocument(size_t size) {
+    std::string text(size, 'x');
+    for (size_t i = 79; i < size; i += 80) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+template <typename Model>
+void loadDocument(Model& model, benchmark::State& state) {
+    model.loadFromString(makeDocument(static_cast<size_t>(state.range(0)) << 20));
+}
+
+/// One small edit at a random offset: two inserts for every erase, so the
+/// document slowly grows
+template <typename Model>
+void randomEdit(Model& model, std::mt19937_64& rng) {
+    const size_t offset = rng() % (model.length() + 1);
+    if (rng() % 3 != 0) {
+        model.insert(offset, "edit\n");
+    } else {
+        model.erase(offset, 4);
+    }
+}
+
+template <typename Model>
+void randomEdits(benchmark::State& state) {
+    Model model;
+    loadDocument(model, state);
+    std::mt19937_64 rng(42);
+    for (auto _ : state) {
+        randomEdit(model, rng);
+    }
+    (void)model.flushPatches();
+    benchmark::DoNotOptimize(model.length());
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Model>
+void randomLineLookups(benchmark::State& state) {
+    Model model;
+    loadDocument(model, state);
+    std::mt19937_64 rng(7);
+
+    // Scatter the edits in one batch: one pass for GapBuffer, 10,000 pieces
+    // for PieceTree
+    std::vector<mdeditor::Edit> edits;
+    const size_t stride = model.length() / 10000;
+    for (size_t i = 0; i < 10000; ++i) {
+        edits.push_back(mdeditor::Edit{i * stride + rng() % (stride - 4), 4, "edit\n"});
+    }
+    model.applyEdits(edits);
+    (void)model.flushPatches();
+
+    for (auto _ : state) {
+        const size_t line = model.lineFromOffset(rng() % model.length());
+        benchmark::DoNotOptimize(model.offsetFromLine(line));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // anonymous namespace
+
+static void BM_RandomEdits_GapBuffer(benchmark::State& state) {
+    randomEdits<GapBuffer>(state);
+}
+BENCHMARK(BM_RandomEdits_GapBuffer)->Arg(1)->Arg(100)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+static void BM_RandomEdits_PieceTree(benchmark::State& state) {
+    randomEdits<PieceTree>(state);
+}
+BENCHMARK(BM_RandomEdits_PieceTree)->Arg(1)->Arg(100)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+static void BM_RandomLineLookups_GapBuffer(benchmark::State& state) {
+    randomLineLookups<GapBuffer>(state);
+}
+BENCHMARK(BM_RandomLineLookups_GapBuffer)->Arg(1)->Arg(100)->Arg(1024);
+
+static void BM_RandomLineLookups_PieceTree(benchmark::State& state) {
+    randomLineLookups<PieceTree>(state);
+}
+BENCHMARK(BM_RandomLineLookups_PieceTree)->Arg(1)->Arg(100)->Arg(1024);
@@ -0,0 +1,65 @@
+// =============================================================================
+// substring_scan_bench.cpp - Substring Search Benchmarks
+// =============================================================================
+//
+// Kernel throughput per level, and GapBuffer::findAll() over a 200 MB
+// document with the gap in the middle (the find-as-you-type worst case:
+// searching the whole document on every keystroke):
+//   gapbuffer_bench --benchmark_filter=Find
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "gap_buffer.h"
+#include "substring_scan.h"
+
+#include <random>
+#include <string>
+
+using mdeditor::simd::Level;
+
+namespace {
+
+/// Markdown-like text without the benchmark patterns: ~1 newline per 40 bytes
+std::string makeText(size_t size) {
+    std::string text(size, ' ');
+    std::mt19937 rng(1);
+    for (char& c : text) {
+        const unsigned r = rng() % 40;
+        c = (r == 0) ? '\n' : (r < 8) ? ' ' : static_cast<char>('a' + rng() % 26);
+    }
+    return text;
+}
+
+void applyLevelArgs(benchmark::internal::Benchmark* bench) {
+    for (int level = 0; level <= static_cast<int>(mdeditor::simd::detectedLevel()); ++level) {
+        bench->Args({level, 0});   // Case-sensitive
+        bench->Args({level, 1});   // ASCII case-insensitive
+    }
+}
+
+} // anonymous namespace
+
+static void BM_FindSubstring(benchmark::State& state) {
+    const auto level = static_cast<Level>(state.range(0));
+    const bool ignoreCase = state.range(1) != 0;
+    const std::string text = makeText(64 << 20);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mdeditor::simd::findSubstring(text, "Paragraph", ignoreCase, level));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetLabel(mdeditor::simd::levelName(level));
+}
+BENCHMARK(BM_FindSubstring)->Apply(applyLevelArgs);
+
+static void BM_GapBufferFindAll(benchmark::State& state) {
+    const bool ignoreCase = state.range(0) != 0;
+    mdeditor::GapBuffer buffer;
+    buffer.loadFromString(makeText(200 << 20));
+    buffer.insert(buffer.length() / 2, "paragraph");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.findAll("Paragraph", 0, std::string_view::npos, ignoreCase));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(buffer.length()));
+}
+BENCHMARK(BM_GapBufferFindAll)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,65 @@
+// =============================================================================
+// utf8_scan_bench.cpp - UTF-8 Validation Kernel Throughput Benchmarks
+// =============================================================================
+//
+// Reports bytes_per_second for each validation level the CPU supports, on
+// mostly-ASCII Markdown and on text with a multi-byte character every few
+// bytes, to compare against memory bandwidth:
+//   gapbuffer_bench --benchmark_filter=Utf8
+//
+// =============================================================================
+
+#include <benchmark/benchmark.h>
+#include "utf8_scan.h"
+
+#include <random>
+#include <string>
+
+using mdeditor::simd::Level;
+
+namespace {
+
+/// Markdown-like text; every nonAsciiEvery-th character is multi-byte
+std::string makeText(size_t size, unsigned nonAsciiEvery) {
+    const char* const wide[] = {"\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+    std::string text;
+    text.reserve(size + 4);
+    std::mt19937 rng(1);
+    while (text.size() < size) {
+        if (rng() % nonAsciiEvery == 0) {
+            text += wide[rng() % 3];
+        } else {
+            text += (rng() % 40 == 0) ? '\n' : static_cast<char>('a' + rng() % 26);
+        }
+    }
+    return text;
+}
+
+void applyLevelArgs(benchmark::internal::Benchmark* bench) {
+    for (int level = 0; level <= static_cast<int>(mdeditor::simd::detectedLevel()); ++level) {
+        bench->Args({level, 64 << 10});   // L2-resident
+        bench->Args({level, 64 << 20});   // Memory-bound
+    }
+}
+
+void runValidation(benchmark::State& state, unsigned nonAsciiEvery) {
+    const auto level = static_cast<Level>(state.range(0));
+    const std::string text = makeText(static_cast<size_t>(state.range(1)), nonAsciiEvery);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mdeditor::simd::findInvalidUtf8(text, level));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetLabel(mdeditor::simd::levelName(level));
+}
+
+} // anonymous namespace
+
+static void BM_ValidateUtf8_Ascii(benchmark::State& state) {
+    runValidation(state, 1000);
+}
+BENCHMARK(BM_ValidateUtf8_Ascii)->Apply(applyLevelArgs);
+
+static void BM_ValidateUtf8_Mixed(benchmark::State& state) {
+    runValidation(state, 4);
+}
+BENCHMARK(BM_ValidateUtf8_Mixed)->Apply(applyLevelArgs);
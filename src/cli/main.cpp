@@ -6,6 +6,7 @@
 // 1. Loading a sample markdown file
 // 2. Performing a sequence of insert/delete operations  
 // 3. Displaying original and modified text with statistics
+// 4. Printing GapBuffer operation counters (MD_GAPBUFFER_STATS builds)
 //
 // Usage: mdcli [path/to/file.md]
 //        Default: samples/sample.md
@@ -15,22 +16,15 @@
 #include "gap_buffer.h"
 
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 namespace fs = std::filesystem;
 
-/// Reads entire file content into a string
-std::string readFile(const fs::path& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + path.string());
-    }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
+/// Writes the buffer text to stdout without copying it
+void printText(const mdeditor::GapBuffer& buffer) {
+    const auto segments = buffer.segments();
+    std::cout << segments.before << segments.after << "\n";
 }
 
 /// Prints a separator line
@@ -44,7 +38,16 @@ void printSeparator(const std::string& title) {
 void printStats(const mdeditor::GapBuffer& buffer, const std::string& label) {
     std::cout << "[" << label << "] "
               << "Length: " << buffer.length() << " bytes, "
-              << "Lines: " << buffer.lineCount() << "\n";
+              << "Lines: " << buffer.lineCount() << ", "
+              << "Capacity: " << buffer.capacity() << " bytes\n";
+}
+
+/// Prints GapBuffer operation counters
+void printOperationStats(const mdeditor::GapBuffer::Stats& stats) {
+    std::cout << "Gap moves:         " << stats.gapMoves << " (" << stats.bytesMoved << " bytes moved)\n"
+              << "Grows:             " << stats.grows << " (" << stats.bytesAllocated << " bytes allocated)\n"
+              << "Patches coalesced: " << stats.patchesCoalesced << ", started: " << stats.patchesStarted << "\n"
+              << "Line scan bytes:   " << stats.lineScanBytes << "\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -66,15 +69,12 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
-        // Read file content
-        std::string content = readFile(filePath);
-        
-        // Create GapBuffer and load content
+        // Create GapBuffer and map the file (copied on the first edit)
         mdeditor::GapBuffer buffer;
-        buffer.loadFromString(content);
+        buffer.loadFromFile(filePath);
         
         printSeparator("ORIGINAL CONTENT");
-        std::cout << buffer.getText() << "\n";
+        printText(buffer);
         printStats(buffer, "Original");
         
         // --- Perform a sequence of edits ---
@@ -102,7 +102,7 @@ int main(int argc, char* argv[]) {
         }
         
         printSeparator("MODIFIED CONTENT");
-        std::cout << buffer.getText() << "\n";
+        printText(buffer);
         printStats(buffer, "Modified");
         
         // --- Demonstrate line/offset mapping ---
@@ -153,6 +153,11 @@ int main(int argc, char* argv[]) {
             std::cout << "\n\n";
         }
         
+        if (mdeditor::GapBuffer::statsEnabled()) {
+            printSeparator("GAPBUFFER OPERATION STATS");
+            printOperationStats(buffer.stats());
+        }
+        
         std::cout << "\nDemo completed successfully!\n";
         return 0;
         
@@ -11,13 +11,12 @@
 //
 // =============================================================================
 
+#include "atomic_file.h"
 #include "gap_buffer.h"
 #include "IMarkdownParser.h"
 
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 namespace fs = std::filesystem;
@@ -109,17 +108,6 @@ constexpr const char* HTML_TEMPLATE = R"(<!DOCTYPE html>
 </html>
 )";
 
-/// Reads entire file content into a string
-std::string readFile(const fs::path& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + path.string());
-    }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
-}
-
 /// Writes content to a file
 void writeFile(const fs::path& path, const std::string& content) {
     // Create parent directories if needed
@@ -127,11 +115,10 @@ void writeFile(const fs::path& path, const std::string& content) {
         fs::create_directories(path.parent_path());
     }
     
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot write file: " + path.string());
-    }
-    file << content;
+    // Replaced atomically; a preview need not survive a crash, so skip the sync
+    mdeditor::SaveOptions options;
+    options.sync = false;
+    mdeditor::writeFileAtomically(path, {content}, options);
 }
 
 /// Generates a complete HTML page with the rendered content
@@ -200,18 +187,15 @@ int main(int argc, char* argv[]) {
         
         // Load file into GapBuffer
         std::cout << "Loading markdown file...\n";
-        std::string content = readFile(inputPath);
-        
         mdeditor::GapBuffer buffer;
-        buffer.loadFromString(content);
+        buffer.loadFromFile(inputPath);
         
         std::cout << "  Size: " << buffer.length() << " bytes\n";
         std::cout << "  Lines: " << buffer.lineCount() << "\n\n";
         
         // Render to HTML
         std::cout << "Rendering to HTML...\n";
-        std::string markdown = buffer.getText();
-        std::string renderedHtml = parser->renderToHtml(markdown);
+        std::string renderedHtml = parser->renderToHtml(buffer.contiguousView());
         
         std::cout << "  Rendered HTML: " << renderedHtml.size() << " bytes\n\n";
         
@@ -0,0 +1,245 @@
+// =============================================================================
+// atomic_file.cpp - Vectored Save with Atomic Replace Implementation
+// =============================================================================
+
+#include "atomic_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace mdeditor {
+
+namespace {
+
+/// Temporary names tried before giving up (another process may race us)
+constexpr unsigned kMaxAttempts = 100;
+
+[[noreturn]] void throwSaveError(const char* what, const std::filesystem::path& path) {
+    throw std::runtime_error(std::string(what) + ": " + path.string());
+}
+
+/// Follows a symbolic link, so the rename replaces the file and keeps the link
+std::filesystem::path resolveTarget(const std::filesystem::path& path) {
+    std::error_code error;
+    if (std::filesystem::is_symlink(path, error)) {
+        std::filesystem::path target = std::filesystem::canonical(path, error);
+        if (!error) {
+            return target;
+        }
+    }
+    return path;
+}
+
+/// A hidden name next to target, unique within this process
+std::filesystem::path temporaryPath(const std::filesystem::path& target, unsigned long processId) {
+    static std::atomic<unsigned> counter{0};
+    const std::string name = "." + target.filename().string() + ".tmp-" +
+        std::to_string(processId) + "-" + std::to_string(counter.fetch_add(1));
+    return target.parent_path() / name;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Platform File Access
+// =============================================================================
+
+#ifdef _WIN32
+
+void writeFileAtomically(const std::filesystem::path& path,
+                         const std::vector<std::string_view>& runs,
+                         const SaveOptions& options) {
+    const std::filesystem::path target = resolveTarget(path);
+
+    std::filesystem::path temp;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    for (unsigned attempt = 0; file == INVALID_HANDLE_VALUE; ++attempt) {
+        temp = temporaryPath(target, GetCurrentProcessId());
+        file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE &&
+            (GetLastError() != ERROR_FILE_EXISTS || attempt + 1 == kMaxAttempts)) {
+            throwSaveError("Cannot create temporary file", temp);
+        }
+    }
+
+    try {
+        for (std::string_view run : runs) {
+            while (!run.empty()) {
+                const DWORD chunk = static_cast<DWORD>(std::min<size_t>(run.size(), 1u << 30));
+                DWORD written = 0;
+                if (!WriteFile(file, run.data(), chunk, &written, nullptr)) {
+                    throwSaveError("Cannot write file", temp);
+                }
+                run.remove_prefix(written);
+            }
+        }
+        if (options.sync && !FlushFileBuffers(file)) {
+            throwSaveError("Cannot sync file", temp);
+        }
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+
+        const DWORD flags = MOVEFILE_REPLACE_EXISTING | (options.sync ? MOVEFILE_WRITE_THROUGH : 0);
+        if (!MoveFileExW(temp.c_str(), target.c_str(), flags)) {
+            throwSaveError("Cannot replace file", target);
+        }
+    } catch (...) {
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        DeleteFileW(temp.c_str());
+        throw;
+    }
+}
+
+#else
+
+namespace {
+
+#ifdef IOV_MAX
+constexpr size_t kMaxRunsPerWrite = IOV_MAX;
+#else
+constexpr size_t kMaxRunsPerWrite = 1024;
+#endif
+
+/// Writes all runs with as few writev() calls as the kernel allows
+void writeRuns(int fd, const std::vector<std::string_view>& runs,
+               const std::filesystem::path& path) {
+    std::vector<iovec> vectors;
+    vectors.reserve(runs.size());
+    for (std::string_view run : runs) {
+        if (!run.empty()) {
+            vectors.push_back(iovec{const_cast<char*>(run.data()), run.size()});
+        }
+    }
+
+    size_t first = 0;
+    while (first < vectors.size()) {
+        const size_t count = std::min(vectors.size() - first, kMaxRunsPerWrite);
+        const ssize_t written = ::writev(fd, vectors.data() + first, static_cast<int>(count));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throwSaveError("Cannot write file", path);
+        }
+
+        // Skip the runs written completely; trim one written partially
+        size_t left = static_cast<size_t>(written);
+        while (left > 0 && left >= vectors[first].iov_len) {
+            left -= vectors[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + left;
+            vectors[first].iov_len -= left;
+        }
+    }
+}
+
+void syncFile(int fd, const std::filesystem::path& path) {
+#if defined(__linux__)
+    const int result = ::fdatasync(fd);
+#else
+    const int result = ::fsync(fd);
+#endif
+    if (result != 0) {
+        throwSaveError("Cannot sync file", path);
+    }
+}
+
+/// Makes the rename durable. Best effort: some file systems cannot sync
+/// a directory, and the file itself is already in place
+void syncDirectory(const std::filesystem::path& directory) {
+    const std::filesystem::path name = directory.empty() ? "." : directory;
+    const int fd = ::open(name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // anonymous namespace
+
+void writeFileAtomically(const std::filesystem::path& path,
+                         const std::vector<std::string_view>& runs,
+                         const SaveOptions& options) {
+    const std::filesystem::path target = resolveTarget(path);
+
+    std::filesystem::path temp;
+    int fd = -1;
+    for (unsigned attempt = 0; fd < 0; ++attempt) {
+        temp = temporaryPath(target, static_cast<unsigned long>(::getpid()));
+        fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0 && (errno != EEXIST || attempt + 1 == kMaxAttempts)) {
+            throwSaveError("Cannot create temporary file", temp);
+        }
+    }
+
+    try {
+        // Keep the permissions of the file being replaced
+        struct stat existing {};
+        if (::stat(target.c_str(), &existing) == 0 &&
+            ::fchmod(fd, existing.st_mode & 07777) != 0) {
+            throwSaveError("Cannot set permissions", temp);
+        }
+
+        writeRuns(fd, runs, temp);
+        if (options.sync) {
+            syncFile(fd, temp);
+        }
+        const int closed = ::close(fd);
+        fd = -1;
+        if (closed != 0) {
+            throwSaveError("Cannot write file", temp);
+        }
+
+        if (::rename(temp.c_str(), target.c_str()) != 0) {
+            throwSaveError("Cannot replace file", target);
+        }
+    } catch (...) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        ::unlink(temp.c_str());
+        throw;
+    }
+
+    if (options.sync) {
+        syncDirectory(target.parent_path());
+    }
+}
+
+#endif
+
+// =============================================================================
+// Documents
+// =============================================================================
+
+void saveDocument(const IDocumentModel& model, const std::filesystem::path& path,
+                  const SaveOptions& options) {
+    std::vector<std::string_view> runs;
+    model.visitChunks(0, model.length(), [&](std::string_view run) {
+        runs.push_back(run);
+    });
+    writeFileAtomically(path, runs, options);
+}
+
+} // namespace mdeditor
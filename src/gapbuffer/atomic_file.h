@@ -0,0 +1,65 @@
+// =============================================================================
+// atomic_file.h - Vectored Save with Atomic Replace
+// =============================================================================
+//
+// saveDocument() writes a document model to disk straight from its storage:
+// the runs visitChunks() yields (a GapBuffer's two segments, a PieceTable's
+// pieces) are handed to the kernel as one gather list, so saving never
+// assembles the text in memory.
+//
+// ATOMIC REPLACE:
+// ---------------
+// The text goes to a temporary file next to the target, which is then
+// renamed over it. Readers of the target see either the old or the new
+// contents, never a partial file, and a failed save leaves the old file in
+// place (the temporary file is removed). An existing target's permission
+// bits are kept; a symbolic link is followed and its target replaced.
+//
+// DURABILITY:
+// -----------
+// With SaveOptions::sync (the default) the temporary file is synced before
+// the rename and the directory after it, so the new contents survive a
+// crash once the call returns. Without it the replace is still atomic for
+// running processes, but a crash may lose it.
+//
+// PLATFORMS:
+// ----------
+// POSIX: writev() in batches of at most IOV_MAX runs (one call for a
+// GapBuffer), fdatasync()/fsync(), rename(). Windows: WriteFile() per run,
+// FlushFileBuffers(), MoveFileExW(MOVEFILE_REPLACE_EXISTING).
+//
+// =============================================================================
+
+#ifndef MDEDITOR_ATOMIC_FILE_H
+#define MDEDITOR_ATOMIC_FILE_H
+
+#include "document_model.h"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+/// How writeFileAtomically() and saveDocument() make the new file durable.
+struct SaveOptions {
+    bool sync = true;   ///< Sync file and directory before returning (see DURABILITY)
+};
+
+/// Replaces the file at path with the concatenation of runs (see ATOMIC
+/// REPLACE). Nothing is copied: the runs are written in place.
+/// @throws std::runtime_error if the file cannot be written, synced or
+///         renamed; the previous file is left unchanged
+void writeFileAtomically(const std::filesystem::path& path,
+                         const std::vector<std::string_view>& runs,
+                         const SaveOptions& options = {});
+
+/// Replaces the file at path with the text of model, written from the
+/// model's own storage.
+/// @throws std::runtime_error as writeFileAtomically()
+void saveDocument(const IDocumentModel& model, const std::filesystem::path& path,
+                  const SaveOptions& options = {});
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_ATOMIC_FILE_H
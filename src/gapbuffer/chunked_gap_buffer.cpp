@@ -0,0 +1,656 @@
+// =============================================================================
+// chunked_gap_buffer.cpp - Chunked Gap Buffer Text Model Implementation
+// =============================================================================
+
+#include "chunked_gap_buffer.h"
+#include "edit_helpers.h"
+#include "mapped_file.h"
+#include "newline_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace mdeditor {
+
+namespace {
+
+/// Text bytes per chunk when chunks are created, leaving room to type
+constexpr size_t kChunkFill = ChunkedGapBuffer::kChunkSize / 4 * 3;
+
+/// Chunks below this size are merged with a neighbour when possible
+constexpr size_t kChunkMinFill = ChunkedGapBuffer::kChunkSize / 4;
+
+/// Smallest allocation for a chunk that has to grow
+constexpr size_t kMinChunkCapacity = 256;
+
+/// Lowest set bit of a Fenwick index
+inline size_t lowBit(size_t index) noexcept {
+    return index & (~index + 1);
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Chunk
+// =============================================================================
+
+void ChunkedGapBuffer::Chunk::materialize() {
+    if (mapped == nullptr) {
+        return;
+    }
+    data.reset(new char[gapStart]);
+    std::memcpy(data.get(), mapped, gapStart);
+    capacity = gapStart;
+    mapped = nullptr;
+    gapEnd = gapStart;
+}
+
+void ChunkedGapBuffer::Chunk::makeWritable() {
+    materialize();
+    if (data.use_count() > 1) {
+        reallocate(capacity);
+        return;
+    }
+    // Pairs with the release of the last other reference, so a snapshot's
+    // reads happen before our writes
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+void ChunkedGapBuffer::Chunk::moveGapTo(size_t position) {
+    if (position == gapStart) {
+        return;
+    }
+    makeWritable();
+    if (position < gapStart) {
+        const size_t shiftSize = gapStart - position;
+        std::memmove(data.get() + gapEnd - shiftSize, data.get() + position, shiftSize);
+        gapEnd -= shiftSize;
+        gapStart = position;
+    } else {
+        const size_t shiftSize = position - gapStart;
+        std::memmove(data.get() + gapStart, data.get() + gapEnd, shiftSize);
+        gapStart += shiftSize;
+        gapEnd += shiftSize;
+    }
+}
+
+void ChunkedGapBuffer::Chunk::ensureGap(size_t needed) {
+    if (gapEnd - gapStart >= needed) {
+        return;
+    }
+    materialize();
+
+    // Double like GapBuffer, but never past the chunk size limit
+    const size_t required = size() + needed;
+    const size_t doubled = std::max(capacity * 2, kMinChunkCapacity);
+    reallocate(std::max(std::min(doubled, kChunkSize), required));
+}
+
+void ChunkedGapBuffer::Chunk::reallocate(size_t newCapacity) {
+    const size_t textAfterGap = capacity - gapEnd;
+
+    std::shared_ptr<char[]> newData(new char[newCapacity]);
+    if (gapStart > 0) {
+        std::memcpy(newData.get(), data.get(), gapStart);
+    }
+    if (textAfterGap > 0) {
+        std::memcpy(newData.get() + newCapacity - textAfterGap, data.get() + gapEnd, textAfterGap);
+    }
+    data = std::move(newData);
+    capacity = newCapacity;
+    gapEnd = newCapacity - textAfterGap;
+}
+
+void ChunkedGapBuffer::Chunk::insert(size_t position, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    makeWritable();
+    ensureGap(text.size());
+    moveGapTo(position);
+    std::memcpy(data.get() + gapStart, text.data(), text.size());
+    gapStart += text.size();
+    newlines += simd::countNewlines(text);
+}
+
+void ChunkedGapBuffer::Chunk::erase(size_t position, size_t len) {
+    materialize();
+    moveGapTo(position);
+    newlines -= simd::countNewlines(std::string_view(data.get() + gapEnd, len));
+    gapEnd += len;
+}
+
+// =============================================================================
+// PrefixSums
+// =============================================================================
+
+void ChunkedGapBuffer::PrefixSums::assign(const std::vector<size_t>& values) {
+    // Linear-time build: push each partial sum to its parent once
+    const size_t count = values.size();
+    tree_.assign(count + 1, 0);
+    for (size_t i = 1; i <= count; ++i) {
+        tree_[i] += values[i - 1];
+        const size_t parent = i + lowBit(i);
+        if (parent <= count) {
+            tree_[parent] += tree_[i];
+        }
+    }
+}
+
+void ChunkedGapBuffer::PrefixSums::add(size_t index, size_t delta) noexcept {
+    for (size_t i = index + 1; i < tree_.size(); i += lowBit(i)) {
+        tree_[i] += delta;
+    }
+}
+
+void ChunkedGapBuffer::PrefixSums::subtract(size_t index, size_t delta) noexcept {
+    for (size_t i = index + 1; i < tree_.size(); i += lowBit(i)) {
+        tree_[i] -= delta;
+    }
+}
+
+size_t ChunkedGapBuffer::PrefixSums::prefix(size_t count) const noexcept {
+    size_t sum = 0;
+    for (size_t i = count; i > 0; i -= lowBit(i)) {
+        sum += tree_[i];
+    }
+    return sum;
+}
+
+size_t ChunkedGapBuffer::PrefixSums::find(size_t& value) const noexcept {
+    const size_t count = tree_.empty() ? 0 : tree_.size() - 1;
+    size_t step = 1;
+    while (step * 2 <= count) {
+        step *= 2;
+    }
+
+    // Descend to the largest index whose prefix sum does not exceed value
+    size_t index = 0;
+    for (; count > 0 && step > 0; step /= 2) {
+        if (index + step <= count && tree_[index + step] <= value) {
+            index += step;
+            value -= tree_[index];
+        }
+    }
+    return index;
+}
+
+// =============================================================================
+// Loading Content
+// =============================================================================
+
+void ChunkedGapBuffer::loadFromString(std::string_view text) {
+    clear();
+    replaceChunks(0, 0, text);
+}
+
+void ChunkedGapBuffer::loadFromFile(const std::filesystem::path& path) {
+    // Map first so a failure leaves the buffer untouched
+    auto mapping = std::make_shared<const MappedFile>(path);
+    clear();
+    mapping_ = std::move(mapping);
+
+    // Chunks point into the mapping; nothing is read until first access
+    const std::string_view text = mapping_->view();
+    const size_t pieces = (text.size() + kChunkFill - 1) / kChunkFill;
+    chunks_.resize(pieces);
+    size_t consumed = 0;
+    for (size_t i = 0; i < pieces; ++i) {
+        const size_t pieceSize = (text.size() - consumed) / (pieces - i);
+        Chunk& chunk = chunks_[i];
+        chunk.mapped = text.data() + consumed;
+        chunk.gapStart = pieceSize;
+        chunk.gapEnd = pieceSize;
+        consumed += pieceSize;
+    }
+    length_ = text.size();
+    lineCountsPending_ = true;
+    rebuildPrefixSums();
+}
+
+void ChunkedGapBuffer::clear() {
+    std::vector<Chunk>().swap(chunks_);
+    std::string().swap(flat_);
+    pendingPatches_.clear();
+    ++version_;
+    mapping_.reset();
+    length_ = 0;
+    newlines_ = 0;
+    lineCountsPending_ = false;
+    rebuildPrefixSums();
+}
+
+// =============================================================================
+// Retrieving Content
+// =============================================================================
+
+std::string ChunkedGapBuffer::getText() const {
+    return getText(0, length_);
+}
+
+std::string ChunkedGapBuffer::getText(size_t start, size_t len) const {
+    std::string result;
+    if (start < length_) {
+        result.reserve(std::min(len, length_ - start));
+    }
+
+    forEachChunk(start, len, [&result](std::string_view chunk) {
+        result.append(chunk);
+    });
+
+    return result;
+}
+
+size_t ChunkedGapBuffer::length() const noexcept {
+    return length_;
+}
+
+bool ChunkedGapBuffer::empty() const noexcept {
+    return length_ == 0;
+}
+
+// =============================================================================
+// Capacity Management
+// =============================================================================
+
+size_t ChunkedGapBuffer::capacity() const noexcept {
+    size_t total = 0;
+    for (const Chunk& chunk : chunks_) {
+        total += chunk.capacity;
+    }
+    return total;
+}
+
+size_t ChunkedGapBuffer::chunkCount() const noexcept {
+    return chunks_.size();
+}
+
+void ChunkedGapBuffer::shrinkToFit() {
+    for (Chunk& chunk : chunks_) {
+        if (chunk.gapEnd > chunk.gapStart) {
+            chunk.reallocate(chunk.size());
+        }
+    }
+    chunks_.shrink_to_fit();
+    std::string().swap(flat_);
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+std::string_view ChunkedGapBuffer::contiguousView() {
+    if (chunks_.size() == 1) {
+        Chunk& chunk = chunks_.front();
+        chunk.moveGapTo(chunk.size());
+        return chunk.before();
+    }
+    flat_ = getText();
+    return flat_;
+}
+
+void ChunkedGapBuffer::visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const {
+    forEachChunk(start, len, fn);
+}
+
+DocumentSnapshot ChunkedGapBuffer::snapshot() const {
+    std::vector<std::string_view> runs;
+    std::vector<std::shared_ptr<const void>> owners;
+    runs.reserve(chunks_.size() * 2);
+    owners.reserve(chunks_.size() + 1);
+    if (mapping_) {
+        owners.push_back(mapping_);
+    }
+
+    // Chunks copy their storage before writing while it is shared, so the
+    // runs stay valid and unchanged
+    for (const Chunk& chunk : chunks_) {
+        runs.push_back(chunk.before());
+        runs.push_back(chunk.after());
+        if (chunk.data) {
+            owners.push_back(chunk.data);
+        }
+    }
+    return DocumentSnapshot(std::move(runs), std::move(owners), version_);
+}
+
+uint64_t ChunkedGapBuffer::version() const noexcept {
+    return version_;
+}
+
+ChunkedGapBuffer::ConstIterator ChunkedGapBuffer::begin() const noexcept {
+    return iteratorAt(0);
+}
+
+ChunkedGapBuffer::ConstIterator ChunkedGapBuffer::end() const noexcept {
+    return ConstIterator(&chunks_, chunks_.size(), nullptr);
+}
+
+ChunkedGapBuffer::ConstIterator ChunkedGapBuffer::iteratorAt(size_t offset) const noexcept {
+    if (offset >= length_) {
+        return end();
+    }
+    const Location loc = locate(offset);
+    const Chunk& chunk = chunks_[loc.chunk];
+    const size_t physical = (loc.offset < chunk.gapStart)
+        ? loc.offset
+        : loc.offset + (chunk.gapEnd - chunk.gapStart);
+    return ConstIterator(&chunks_, loc.chunk, chunk.base() + physical);
+}
+
+// =============================================================================
+// Editing Operations
+// =============================================================================
+
+void ChunkedGapBuffer::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    offset = std::min(offset, length_);
+    ensureLineCounts();
+    insertText(offset, text);
+    ++version_;
+    pendingPatches_.append(offset, {}, text);
+}
+
+void ChunkedGapBuffer::erase(size_t offset, size_t len) {
+    if (offset >= length_ || len == 0) {
+        return;
+    }
+
+    len = std::min(len, length_ - offset);
+    ensureLineCounts();
+    const std::string erasedText = getText(offset, len);
+    eraseText(offset, len);
+    ++version_;
+    pendingPatches_.append(offset, erasedText, {});
+}
+
+void ChunkedGapBuffer::applyPatch(const Patch& patch) {
+    applyEdits({Edit{patch.start, patch.removedLength, patch.insertedText}});
+}
+
+void ChunkedGapBuffer::applyEdits(const std::vector<Edit>& edits) {
+    const std::vector<Edit> sorted =
+        detail::sortedEdits(edits, length_, "ChunkedGapBuffer::applyEdits");
+    ensureLineCounts();
+
+    // Each edit only touches its own chunks, so applying them one by one
+    // keeps the cost proportional to the edits, not the text
+    size_t insertedSoFar = 0;
+    size_t removedSoFar = 0;
+    for (const Edit& edit : sorted) {
+        const size_t position = edit.start + insertedSoFar - removedSoFar;
+        const std::string removed = getText(position, edit.removedLength);
+        if (edit.removedLength > 0) {
+            eraseText(position, edit.removedLength);
+        }
+        if (!edit.insertedText.empty()) {
+            insertText(position, edit.insertedText);
+        }
+        ++version_;
+        pendingPatches_.append(position, removed, edit.insertedText);
+        insertedSoFar += edit.insertedText.size();
+        removedSoFar += edit.removedLength;
+    }
+}
+
+// =============================================================================
+// Line/Offset Mapping
+// =============================================================================
+
+size_t ChunkedGapBuffer::lineFromOffset(size_t offset) const {
+    if (chunks_.empty()) {
+        return 0;
+    }
+
+    ensureLineCounts();
+
+    // Newlines in earlier chunks, plus those before offset in its chunk
+    const Location loc = locate(std::min(offset, length_));
+    const Chunk& chunk = chunks_[loc.chunk];
+    const std::string_view before = chunk.before();
+    size_t line = lines_.prefix(loc.chunk);
+    if (loc.offset <= before.size()) {
+        line += simd::countNewlines(before.substr(0, loc.offset));
+    } else {
+        line += simd::countNewlines(before) +
+                simd::countNewlines(chunk.after().substr(0, loc.offset - before.size()));
+    }
+    return line;
+}
+
+size_t ChunkedGapBuffer::offsetFromLine(size_t line, size_t column) const {
+    if (line == 0 && column == 0) {
+        return 0;
+    }
+
+    ensureLineCounts();
+    size_t offset = 0;
+    if (line > 0) {
+        // Line N starts one past the (N-1)th newline
+        size_t newlineIndex = line - 1;
+        if (newlineIndex >= newlines_) {
+            offset = length_;  // Past the last line
+        } else {
+            const size_t index = lines_.find(newlineIndex);
+            const Chunk& chunk = chunks_[index];
+            const std::string_view before = chunk.before();
+            size_t position = simd::findNthNewline(before, newlineIndex);
+            if (position == std::string_view::npos) {
+                newlineIndex -= simd::countNewlines(before);
+                position = before.size() + simd::findNthNewline(chunk.after(), newlineIndex);
+            }
+            offset = bytes_.prefix(index) + position + 1;
+        }
+    }
+
+    // Add column offset (clamped to text length)
+    return std::min(offset + column, length_);
+}
+
+size_t ChunkedGapBuffer::lineCount() const {
+    if (empty()) {
+        return 0;
+    }
+    ensureLineCounts();
+    return 1 + newlines_;
+}
+
+// =============================================================================
+// Patch Management
+// =============================================================================
+
+std::vector<Patch> ChunkedGapBuffer::flushPatches() {
+    return pendingPatches_.flush();
+}
+
+void ChunkedGapBuffer::drainPatches(const PatchVisitor& fn) {
+    pendingPatches_.drain(fn);
+}
+
+bool ChunkedGapBuffer::hasPendingPatches() const noexcept {
+    return !pendingPatches_.empty();
+}
+
+// =============================================================================
+// Internal Implementation
+// =============================================================================
+
+ChunkedGapBuffer::Location ChunkedGapBuffer::locate(size_t offset) const noexcept {
+    if (chunks_.empty()) {
+        return Location{0, 0};
+    }
+    if (offset >= length_) {
+        return Location{chunks_.size() - 1, chunks_.back().size()};
+    }
+    const size_t index = bytes_.find(offset);
+    return Location{index, offset};
+}
+
+void ChunkedGapBuffer::replaceChunks(size_t first, size_t last, std::string_view text) {
+    for (size_t i = first; i < last; ++i) {
+        length_ -= chunks_[i].size();
+        newlines_ -= chunks_[i].newlines;
+    }
+
+    // Spread the text evenly over as few chunks as the fill target allows
+    const size_t pieces = (text.size() + kChunkFill - 1) / kChunkFill;
+    std::vector<Chunk> created(pieces);
+    size_t consumed = 0;
+    for (size_t i = 0; i < pieces; ++i) {
+        const size_t pieceSize = (text.size() - consumed) / (pieces - i);
+        const std::string_view piece = text.substr(consumed, pieceSize);
+        Chunk& chunk = created[i];
+        chunk.data.reset(new char[piece.size()]);
+        std::memcpy(chunk.data.get(), piece.data(), piece.size());
+        chunk.capacity = piece.size();
+        chunk.gapStart = piece.size();
+        chunk.gapEnd = piece.size();
+        chunk.newlines = simd::countNewlines(piece);
+        consumed += pieceSize;
+    }
+    length_ += text.size();
+    newlines_ += simd::countNewlines(text);
+
+    chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(first),
+                  chunks_.begin() + static_cast<std::ptrdiff_t>(last));
+    chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(first),
+                   std::make_move_iterator(created.begin()),
+                   std::make_move_iterator(created.end()));
+    rebuildPrefixSums();
+}
+
+void ChunkedGapBuffer::insertText(size_t offset, std::string_view text) {
+    if (chunks_.empty()) {
+        replaceChunks(0, 0, text);
+        return;
+    }
+
+    const Location loc = locate(offset);
+    Chunk& chunk = chunks_[loc.chunk];
+
+    // Common case: the chunk has room, only its own gap moves
+    if (chunk.size() + text.size() <= kChunkSize) {
+        const size_t oldNewlines = chunk.newlines;
+        chunk.insert(loc.offset, text);
+        const size_t addedNewlines = chunk.newlines - oldNewlines;
+        bytes_.add(loc.chunk, text.size());
+        lines_.add(loc.chunk, addedNewlines);
+        length_ += text.size();
+        newlines_ += addedNewlines;
+        return;
+    }
+
+    // Split: re-chunk the chunk's text with the insertion in the middle
+    chunk.moveGapTo(loc.offset);
+    std::string combined;
+    combined.reserve(chunk.size() + text.size());
+    combined.append(chunk.before());
+    combined.append(text);
+    combined.append(chunk.after());
+    replaceChunks(loc.chunk, loc.chunk + 1, combined);
+}
+
+void ChunkedGapBuffer::eraseText(size_t offset, size_t len) {
+    const Location loc = locate(offset);
+
+    // Single-chunk erase that keeps the chunk: point updates only
+    Chunk& chunk = chunks_[loc.chunk];
+    if (len < chunk.size() - loc.offset || (loc.offset > 0 && len == chunk.size() - loc.offset)) {
+        const size_t oldNewlines = chunk.newlines;
+        chunk.erase(loc.offset, len);
+        const size_t removedNewlines = oldNewlines - chunk.newlines;
+        bytes_.subtract(loc.chunk, len);
+        lines_.subtract(loc.chunk, removedNewlines);
+        length_ -= len;
+        newlines_ -= removedNewlines;
+        if (mergeUnderfull(loc.chunk)) {
+            rebuildPrefixSums();
+        }
+        return;
+    }
+
+    // Spans chunks or empties one: trim the ends, drop the chunks in between
+    size_t index = loc.chunk;
+    size_t local = loc.offset;
+    size_t remaining = len;
+    while (remaining > 0) {
+        Chunk& current = chunks_[index];
+        const size_t take = std::min(remaining, current.size() - local);
+        const size_t oldNewlines = current.newlines;
+        current.erase(local, take);
+        length_ -= take;
+        newlines_ -= oldNewlines - current.newlines;
+        remaining -= take;
+        local = 0;
+        ++index;
+    }
+
+    const auto firstTouched = chunks_.begin() + static_cast<std::ptrdiff_t>(loc.chunk);
+    const auto lastTouched = chunks_.begin() + static_cast<std::ptrdiff_t>(index);
+    chunks_.erase(std::remove_if(firstTouched, lastTouched,
+                                 [](const Chunk& c) { return c.size() == 0; }),
+                  lastTouched);
+    if (!chunks_.empty()) {
+        mergeUnderfull(std::min(loc.chunk, chunks_.size() - 1));
+    }
+    rebuildPrefixSums();
+}
+
+bool ChunkedGapBuffer::mergeUnderfull(size_t index) {
+    if (chunks_.size() < 2 || chunks_[index].size() >= kChunkMinFill) {
+        return false;
+    }
+
+    // Prefer the following chunk; merged chunks stay below the fill target
+    // so the next insertion does not split them again
+    size_t left = index;
+    if (index + 1 == chunks_.size() ||
+        chunks_[index].size() + chunks_[index + 1].size() > kChunkFill) {
+        if (index == 0 || chunks_[index - 1].size() + chunks_[index].size() > kChunkFill) {
+            return false;
+        }
+        left = index - 1;
+    }
+
+    Chunk& target = chunks_[left];
+    const Chunk& source = chunks_[left + 1];
+    target.moveGapTo(target.size());
+    target.insert(target.size(), source.before());
+    target.insert(target.size(), source.after());
+    chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(left + 1));
+    return true;
+}
+
+void ChunkedGapBuffer::rebuildPrefixSums() {
+    std::vector<size_t> sizes(chunks_.size());
+    std::vector<size_t> newlineCounts(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        sizes[i] = chunks_[i].size();
+        newlineCounts[i] = chunks_[i].newlines;
+    }
+    bytes_.assign(sizes);
+    lines_.assign(newlineCounts);
+}
+
+void ChunkedGapBuffer::ensureLineCounts() const {
+    if (!lineCountsPending_) {
+        return;
+    }
+
+    std::vector<size_t> newlineCounts(chunks_.size());
+    newlines_ = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        const Chunk& chunk = chunks_[i];
+        chunk.newlines = simd::countNewlines(chunk.before()) + simd::countNewlines(chunk.after());
+        newlineCounts[i] = chunk.newlines;
+        newlines_ += chunk.newlines;
+    }
+    lines_.assign(newlineCounts);
+    lineCountsPending_ = false;
+}
+
+} // namespace mdeditor
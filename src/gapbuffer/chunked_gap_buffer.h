@@ -0,0 +1,453 @@
+// =============================================================================
+// chunked_gap_buffer.h - Chunked Gap Buffer Text Model
+// =============================================================================
+//
+// ChunkedGapBuffer stores the text as a sequence of small gap buffers
+// ("chunks") of at most kChunkSize bytes each, instead of one contiguous
+// allocation. It implements IDocumentModel like GapBuffer and is meant for
+// very large files, where a single buffer has to memmove up to the whole
+// file when the gap jumps and needs twice the memory while growing.
+//
+// COST MODEL:
+// -----------
+// An edit touches only the chunks its range overlaps: moving a chunk's gap
+// or splitting a full chunk costs at most kChunkSize bytes of copying.
+// Chunks are located through prefix sums of their byte and newline counts
+// (Fenwick trees), so finding the chunk for an offset or line is O(log n) in
+// the number of chunks. When chunks are split, merged or removed the prefix
+// sums are rebuilt, which is O(number of chunks) but happens at most once
+// per kChunkSize / 4 bytes of edits at one spot.
+//
+// Offsets, line semantics and patches are exactly those of GapBuffer; see
+// gap_buffer.h. lineFromOffset() and offsetFromLine() additionally scan
+// within one chunk (SIMD, at most kChunkSize bytes).
+//
+// FILE LOADING:
+// -------------
+// loadFromFile() memory-maps the file and creates chunks that point into the
+// mapping. A chunk copies its text only when it is first edited, so opening
+// a huge file and editing a few places allocates a few chunks. Newline
+// counts are computed on the first line query or edit.
+//
+// SNAPSHOTS:
+// ----------
+// Chunk storage is reference-counted and copy-on-write. snapshot() shares
+// every chunk (O(number of chunks), no text is copied); afterwards the first
+// write to a chunk the snapshot still holds copies that chunk (at most
+// kChunkSize bytes). Copies of the whole buffer share chunks the same way.
+// Snapshots may be read from other threads while the buffer is edited.
+//
+// ZERO-COPY READS:
+// ----------------
+// forEachChunk() and ConstIterator read in place (two runs per chunk).
+// contiguousView() can only avoid a copy while the text fits in one chunk;
+// otherwise it assembles the text in an internal string.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_CHUNKED_GAP_BUFFER_H
+#define MDEDITOR_CHUNKED_GAP_BUFFER_H
+
+#include "document_model.h"
+#include "patch_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+class MappedFile;
+
+// =============================================================================
+// ChunkedGapBuffer - Gap buffer split into bounded chunks
+// =============================================================================
+/// ChunkedGapBuffer keeps the text in gap-buffered chunks of at most
+/// kChunkSize bytes, bounding the work of any single edit by the chunk size.
+class ChunkedGapBuffer : public IDocumentModel {
+public:
+    /// Maximum number of text bytes held by one chunk.
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    class ConstIterator;
+    using const_iterator = ConstIterator;
+
+    // -------------------------------------------------------------------------
+    // Construction / Destruction
+    // -------------------------------------------------------------------------
+
+    /// Constructs an empty buffer (no chunks are allocated until text arrives).
+    ChunkedGapBuffer() = default;
+
+    ~ChunkedGapBuffer() override = default;
+
+    /// Copies share chunk storage; each side copies a chunk when it first
+    /// writes to it.
+    ChunkedGapBuffer(const ChunkedGapBuffer& other) = default;
+    ChunkedGapBuffer& operator=(const ChunkedGapBuffer& other) = default;
+    ChunkedGapBuffer(ChunkedGapBuffer&& other) noexcept = default;
+    ChunkedGapBuffer& operator=(ChunkedGapBuffer&& other) noexcept = default;
+
+    // -------------------------------------------------------------------------
+    // Loading Content
+    // -------------------------------------------------------------------------
+
+    /// Loads content from a string, replacing any existing content.
+    /// @param text The text to load into the buffer
+    void loadFromString(std::string_view text) override;
+
+    /// Loads a file by memory-mapping it, replacing any existing content.
+    /// Chunks copy their text from the mapping only when edited.
+    /// @param path The file to load
+    /// @throws std::runtime_error if the file cannot be opened or mapped;
+    ///         the buffer is left unchanged
+    void loadFromFile(const std::filesystem::path& path) override;
+
+    /// Clears all content from the buffer and releases the chunks.
+    void clear() override;
+
+    // -------------------------------------------------------------------------
+    // Retrieving Content
+    // -------------------------------------------------------------------------
+
+    /// Returns the entire text content as a string.
+    [[nodiscard]] std::string getText() const override;
+
+    /// Returns a substring of the text content.
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to retrieve
+    /// @return The requested substring (clamped to valid range)
+    [[nodiscard]] std::string getText(size_t start, size_t len) const override;
+
+    /// Returns the total length of the text in bytes.
+    [[nodiscard]] size_t length() const noexcept override;
+
+    /// Returns true if the buffer contains no text.
+    [[nodiscard]] bool empty() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Capacity Management
+    // -------------------------------------------------------------------------
+
+    /// Returns the bytes allocated for text and gaps across all chunks
+    /// (chunks still served from a file mapping allocate nothing).
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    /// Returns the number of chunks currently holding text.
+    [[nodiscard]] size_t chunkCount() const noexcept;
+
+    /// Releases the gap of every chunk.
+    void shrinkToFit();
+
+    // -------------------------------------------------------------------------
+    // Zero-Copy Access
+    // -------------------------------------------------------------------------
+
+    /// Calls fn(std::string_view) for each contiguous run of a byte range,
+    /// in order (up to two runs per chunk the range overlaps).
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to visit
+    /// @note Range is clamped like getText(start, len); empty runs are skipped
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+
+    /// forEachChunk() behind the IDocumentModel interface.
+    void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override;
+
+    /// Returns the whole text as one view. Zero-copy while the text fits in
+    /// one chunk; otherwise copies it into an internal string that stays
+    /// valid until the next edit or call.
+    [[nodiscard]] std::string_view contiguousView() override;
+
+    /// Returns a snapshot sharing the chunks (O(number of chunks)).
+    [[nodiscard]] DocumentSnapshot snapshot() const override;
+
+    /// Returns the document version (see IDocumentModel::version()).
+    [[nodiscard]] uint64_t version() const noexcept override;
+
+    /// Byte iterators over the text, skipping gaps and chunk boundaries.
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    /// Returns an iterator to the byte at offset (clamped to length()).
+    [[nodiscard]] ConstIterator iteratorAt(size_t offset) const noexcept;
+
+    // -------------------------------------------------------------------------
+    // Editing Operations
+    // -------------------------------------------------------------------------
+
+    /// Inserts text at the specified byte offset.
+    /// @note Offset is clamped to [0, length()]
+    void insert(size_t offset, std::string_view text) override;
+
+    /// Erases a range of bytes from the buffer.
+    /// @note Range is clamped to valid buffer bounds
+    void erase(size_t offset, size_t len) override;
+
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText as a single patch.
+    void applyPatch(const Patch& patch) override;
+
+    /// Applies a batch of non-overlapping edits, left to right, with the
+    /// same contract as IDocumentModel::applyEdits.
+    /// @throws std::invalid_argument if two edits overlap; the buffer is
+    ///         left unchanged
+    void applyEdits(const std::vector<Edit>& edits) override;
+
+    // -------------------------------------------------------------------------
+    // Line/Offset Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the 0-indexed line number containing the given byte offset.
+    /// @note O(log chunks + kChunkSize)
+    [[nodiscard]] size_t lineFromOffset(size_t offset) const override;
+
+    /// Returns the byte offset of position (line, column).
+    /// @note Returns end of buffer if line is past last line
+    /// @note O(log chunks + kChunkSize)
+    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const override;
+
+    /// Returns the total number of lines (at least 1 for non-empty buffer).
+    /// @note O(1)
+    [[nodiscard]] size_t lineCount() const override;
+
+    // -------------------------------------------------------------------------
+    // Patch Management
+    // -------------------------------------------------------------------------
+
+    /// Returns and clears the accumulated patches since last flush.
+    [[nodiscard]] std::vector<Patch> flushPatches() override;
+
+    /// Calls fn for each accumulated patch, then clears them (no copies).
+    void drainPatches(const PatchVisitor& fn) override;
+
+    /// Returns true if there are unflushed patches.
+    [[nodiscard]] bool hasPendingPatches() const noexcept override;
+
+private:
+    /// One gap-buffered piece of the text, with its own newline count.
+    /// A chunk loaded from a file points into the mapping (with an empty gap
+    /// at its end) until it is first edited. data may be shared with copies
+    /// and snapshots; it is copied before any write while shared.
+    struct Chunk {
+        std::shared_ptr<char[]> data;    ///< [text before gap][gap][text after gap]
+        size_t capacity = 0;             ///< Size of data in bytes
+        const char* mapped = nullptr;    ///< Unedited text in the file mapping
+        size_t gapStart = 0;
+        size_t gapEnd = 0;
+        mutable size_t newlines = 0;     ///< Number of '\n' (deferred after loadFromFile)
+
+        /// Storage the gap offsets refer to
+        [[nodiscard]] const char* base() const noexcept {
+            return mapped ? mapped : data.get();
+        }
+        [[nodiscard]] size_t extent() const noexcept {
+            return mapped ? gapEnd : capacity;
+        }
+        [[nodiscard]] size_t size() const noexcept {
+            return extent() - (gapEnd - gapStart);
+        }
+        [[nodiscard]] std::string_view before() const noexcept {
+            return std::string_view(base(), gapStart);
+        }
+        [[nodiscard]] std::string_view after() const noexcept {
+            return std::string_view(base() + gapEnd, extent() - gapEnd);
+        }
+
+        void materialize();
+        /// Materializes and unshares data so it can be written
+        void makeWritable();
+        void moveGapTo(size_t position);
+        void ensureGap(size_t needed);
+        void reallocate(size_t newCapacity);
+        void insert(size_t position, std::string_view text);
+        void erase(size_t position, size_t len);
+    };
+
+    /// Fenwick tree over per-chunk counts: O(log n) update and search
+    class PrefixSums {
+    public:
+        void assign(const std::vector<size_t>& values);
+        void add(size_t index, size_t delta) noexcept;
+        void subtract(size_t index, size_t delta) noexcept;
+        /// Sum of the first count entries
+        [[nodiscard]] size_t prefix(size_t count) const noexcept;
+        /// Index i with prefix(i) <= value < prefix(i + 1); value -= prefix(i).
+        /// Returns the number of entries when value >= the total.
+        [[nodiscard]] size_t find(size_t& value) const noexcept;
+    private:
+        std::vector<size_t> tree_;  ///< 1-based Fenwick array
+    };
+
+    /// Position of a byte inside the chunk sequence
+    struct Location {
+        size_t chunk;
+        size_t offset;
+    };
+
+    /// Finds the chunk holding offset; offset == length() maps to the end of
+    /// the last chunk
+    [[nodiscard]] Location locate(size_t offset) const noexcept;
+
+    /// Replaces chunks [first, last) with chunks holding text
+    void replaceChunks(size_t first, size_t last, std::string_view text);
+
+    /// Inserts without recording a patch
+    void insertText(size_t offset, std::string_view text);
+
+    /// Erases without recording a patch
+    void eraseText(size_t offset, size_t len);
+
+    /// Merges the chunk at index with a neighbour if both are underfull
+    /// @return true if the chunk sequence changed
+    bool mergeUnderfull(size_t index);
+
+    /// Rebuilds the byte and newline prefix sums from the chunks
+    void rebuildPrefixSums();
+
+    /// Counts newlines of all chunks if deferred by loadFromFile()
+    void ensureLineCounts() const;
+
+    std::vector<Chunk> chunks_;          ///< Chunks in text order, none empty
+    PrefixSums bytes_;                   ///< Prefix sums of chunk sizes
+    size_t length_ = 0;                  ///< Total text bytes
+    std::string flat_;                   ///< Backing store for contiguousView()
+    PatchLog pendingPatches_;            ///< Unflushed edit patches
+    uint64_t version_ = 0;               ///< Bumped by every edit and clear
+    std::shared_ptr<const MappedFile> mapping_;  ///< Backs chunks loaded from a file
+
+    // Mutable only so deferred counts can be computed by a const query
+    mutable PrefixSums lines_;           ///< Prefix sums of chunk newline counts
+    mutable size_t newlines_ = 0;        ///< Total '\n' count
+    mutable bool lineCountsPending_ = false;  ///< Counts not computed yet (mapped file)
+};
+
+// =============================================================================
+// ChunkedGapBuffer::ConstIterator - Bidirectional byte iterator
+// =============================================================================
+/// Walks the text byte by byte, jumping over each chunk's gap and on to the
+/// next chunk. Invalidated by any edit.
+class ChunkedGapBuffer::ConstIterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char*;
+    using reference = const char&;
+
+    ConstIterator() = default;
+
+    reference operator*() const noexcept { return *pos_; }
+    pointer operator->() const noexcept { return pos_; }
+
+    ConstIterator& operator++() noexcept {
+        const Chunk& chunk = (*chunks_)[chunk_];
+        ++pos_;
+        if (pos_ == chunk.base() + chunk.gapStart) {
+            pos_ = chunk.base() + chunk.gapEnd;
+        }
+        if (pos_ == chunk.base() + chunk.extent()) {
+            ++chunk_;
+            pos_ = firstByte(*chunks_, chunk_);
+        }
+        return *this;
+    }
+
+    ConstIterator operator++(int) noexcept {
+        ConstIterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    ConstIterator& operator--() noexcept {
+        if (chunk_ == chunks_->size() ||
+            pos_ == firstByte(*chunks_, chunk_)) {
+            --chunk_;
+            const Chunk& previous = (*chunks_)[chunk_];
+            pos_ = previous.base() + previous.extent();
+        }
+        const Chunk& chunk = (*chunks_)[chunk_];
+        if (pos_ == chunk.base() + chunk.gapEnd) {
+            pos_ = chunk.base() + chunk.gapStart;
+        }
+        --pos_;
+        return *this;
+    }
+
+    ConstIterator operator--(int) noexcept {
+        ConstIterator copy = *this;
+        --*this;
+        return copy;
+    }
+
+    friend bool operator==(const ConstIterator& a, const ConstIterator& b) noexcept {
+        return a.chunk_ == b.chunk_ && a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const ConstIterator& a, const ConstIterator& b) noexcept {
+        return !(a == b);
+    }
+
+private:
+    friend class ChunkedGapBuffer;
+
+    ConstIterator(const std::vector<Chunk>* chunks, size_t chunk, const char* pos) noexcept
+        : chunks_(chunks)
+        , chunk_(chunk)
+        , pos_(pos) {}
+
+    /// First text byte of a chunk, or nullptr past the last chunk
+    static const char* firstByte(const std::vector<Chunk>& chunks, size_t index) noexcept {
+        if (index >= chunks.size()) {
+            return nullptr;
+        }
+        const Chunk& chunk = chunks[index];
+        return chunk.base() + (chunk.gapStart > 0 ? 0 : chunk.gapEnd);
+    }
+
+    const std::vector<Chunk>* chunks_ = nullptr;
+    size_t chunk_ = 0;          ///< chunks_->size() for end()
+    const char* pos_ = nullptr; ///< nullptr for end()
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void ChunkedGapBuffer::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    if (start >= length_) {
+        return;
+    }
+    len = std::min(len, length_ - start);
+
+    Location loc = locate(start);
+    while (len > 0) {
+        const Chunk& chunk = chunks_[loc.chunk];
+        for (std::string_view run : {chunk.before(), chunk.after()}) {
+            if (loc.offset >= run.size()) {
+                loc.offset -= run.size();
+                continue;
+            }
+            const size_t take = std::min(len, run.size() - loc.offset);
+            fn(run.substr(loc.offset, take));
+            loc.offset = 0;
+            len -= take;
+            if (len == 0) {
+                return;
+            }
+        }
+        ++loc.chunk;
+        loc.offset = 0;
+    }
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_CHUNKED_GAP_BUFFER_H
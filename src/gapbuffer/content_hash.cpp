@@ -0,0 +1,319 @@
+// =============================================================================
+// content_hash.cpp - Incrementally Maintained Content Digest Implementation
+// =============================================================================
+
+#include "content_hash.h"
+
+#include <algorithm>
+#include <array>
+
+namespace mdeditor {
+
+namespace {
+
+constexpr uint64_t kModulus = (uint64_t{1} << 61) - 1;
+
+/// Fixed odd base below the modulus
+constexpr uint64_t kBase = 0x0DB3F1A4C2E5967Bu;
+
+/// Reduces x (< 2^64) modulo 2^61 - 1
+constexpr uint64_t reduce(uint64_t x) noexcept {
+    x = (x & kModulus) + (x >> 61);
+    return x >= kModulus ? x - kModulus : x;
+}
+
+/// a * b modulo 2^61 - 1, for a, b < 2^61
+inline uint64_t mulMod(uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 Wide;
+    const Wide product = static_cast<Wide>(a) * b;
+    return reduce(static_cast<uint64_t>(product & kModulus) + static_cast<uint64_t>(product >> 61));
+#else
+    // 2^62 = 2 and 2^61 = 1 modulo 2^61 - 1
+    constexpr uint64_t kLow31 = (uint64_t{1} << 31) - 1;
+    constexpr uint64_t kLow30 = (uint64_t{1} << 30) - 1;
+    const uint64_t aHigh = a >> 31;
+    const uint64_t aLow = a & kLow31;
+    const uint64_t bHigh = b >> 31;
+    const uint64_t bLow = b & kLow31;
+    const uint64_t middle = aLow * bHigh + aHigh * bLow;
+    return reduce(aHigh * bHigh * 2 + (middle >> 30) + ((middle & kLow30) << 31) + aLow * bLow);
+#endif
+}
+
+uint64_t powMod(uint64_t base, size_t exponent) noexcept {
+    uint64_t result = 1;
+    for (; exponent > 0; exponent >>= 1) {
+        if (exponent & 1) {
+            result = mulMod(result, base);
+        }
+        base = mulMod(base, base);
+    }
+    return result;
+}
+
+/// Bytes hashed per step of hashBytes()
+constexpr size_t kBlock = 8;
+
+/// base^0 .. base^kBlock
+std::array<uint64_t, kBlock + 1> makePowers() noexcept {
+    std::array<uint64_t, kBlock + 1> powers{};
+    powers[0] = 1;
+    for (size_t i = 1; i <= kBlock; ++i) {
+        powers[i] = mulMod(powers[i - 1], kBase);
+    }
+    return powers;
+}
+
+const std::array<uint64_t, kBlock + 1> kPowers = makePowers();
+
+/// Extends hash by the bytes of text (Horner's rule; a byte counts as
+/// its value + 1). Eight bytes are combined per step with independent
+/// multiplications, so the dependent chain is one multiplication per block.
+uint64_t hashBytes(uint64_t hash, std::string_view text) noexcept {
+    size_t i = 0;
+    for (; i + kBlock <= text.size(); i += kBlock) {
+        // Eight terms below 2^61 cannot overflow 64 bits
+        uint64_t block = 0;
+        for (size_t j = 0; j < kBlock; ++j) {
+            const uint64_t byte = static_cast<unsigned char>(text[i + j]);
+            block += mulMod(byte + 1, kPowers[kBlock - 1 - j]);
+        }
+        hash = reduce(mulMod(hash, kPowers[kBlock]) + reduce(block));
+    }
+    for (; i < text.size(); ++i) {
+        hash = reduce(mulMod(hash, kBase) + static_cast<unsigned char>(text[i]) + 1);
+    }
+    return hash;
+}
+
+/// Appends text to a chunk list, filling the last chunk up to kChunkSize.
+/// Powers are left for the caller to set.
+template <typename Node>
+void appendChunked(std::vector<Node>& chunks, std::string_view text) {
+    while (!text.empty()) {
+        if (chunks.empty() || chunks.back().bytes >= ContentHash::kChunkSize) {
+            chunks.emplace_back();
+        }
+        const size_t take = std::min(text.size(), ContentHash::kChunkSize - chunks.back().bytes);
+        chunks.back().hash = hashBytes(chunks.back().hash, text.substr(0, take));
+        chunks.back().bytes += take;
+        text.remove_prefix(take);
+    }
+}
+
+template <typename Node>
+Node combine(const Node& left, const Node& right) noexcept {
+    Node node;
+    node.bytes = left.bytes + right.bytes;
+    node.hash = reduce(mulMod(left.hash, right.power) + right.hash);
+    node.power = mulMod(left.power, right.power);
+    return node;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Building and Updating
+// =============================================================================
+
+ContentHash::Digest ContentHash::digestOf(std::string_view text) noexcept {
+    return Digest{hashBytes(0, text), text.size()};
+}
+
+bool ContentHash::valid() const noexcept {
+    return valid_;
+}
+
+void ContentHash::rebuild(const IDocumentModel& text) {
+    chunks_.clear();
+    text.visitChunks(0, text.length(), [this](std::string_view piece) {
+        appendChunked(chunks_, piece);
+    });
+    for (Node& chunk : chunks_) {
+        chunk.power = powMod(kBase, chunk.bytes);
+    }
+    rebuildTree();
+    valid_ = true;
+}
+
+void ContentHash::reset() noexcept {
+    chunks_.clear();
+    tree_.clear();
+    dirty_.clear();
+    leaves_ = 0;
+    valid_ = false;
+}
+
+void ContentHash::recordEdit(size_t offset, size_t removedLength, size_t insertedLength) {
+    if (!valid_) {
+        return;
+    }
+    // An edit the hashes cannot place means they are out of sync; rebuild later
+    const size_t total = tree_[1].bytes;
+    if (offset > total || removedLength > total - offset) {
+        reset();
+        return;
+    }
+
+    if (removedLength > 0) {
+        // Shrink the chunks the removed range covers, in pre-edit coordinates
+        const Location first = locate(offset);
+        size_t chunkStart = first.start;
+        size_t position = offset;
+        bool emptied = false;
+        for (size_t chunk = first.chunk; removedLength > 0; ++chunk) {
+            const size_t chunkEnd = chunkStart + chunks_[chunk].bytes;
+            const size_t take = std::min(removedLength, chunkEnd - position);
+            chunks_[chunk].bytes -= take;
+            markDirty(chunk);
+            emptied |= chunks_[chunk].bytes == 0;
+            removedLength -= take;
+            position += take;
+            chunkStart = chunkEnd;
+        }
+        if (emptied) {
+            chunks_.erase(std::remove_if(chunks_.begin(), chunks_.end(),
+                                         [](const Node& c) { return c.bytes == 0; }),
+                          chunks_.end());
+            rebuildTree();
+        }
+    }
+
+    if (insertedLength > 0) {
+        if (chunks_.empty()) {
+            chunks_.emplace_back();
+            chunks_.back().bytes = insertedLength;
+            chunks_.back().dirty = true;
+            rebuildTree();
+        } else {
+            // At the very end the text joins the last chunk
+            const size_t chunk = offset == tree_[1].bytes ? chunks_.size() - 1 : locate(offset).chunk;
+            chunks_[chunk].bytes += insertedLength;
+            markDirty(chunk);
+        }
+    }
+}
+
+ContentHash::Digest ContentHash::digest(const IDocumentModel& text) {
+    if (!valid_) {
+        rebuild(text);
+    }
+    if (!dirty_.empty()) {
+        rehashDirty(text);
+    }
+    return Digest{tree_[1].hash, tree_[1].bytes};
+}
+
+// =============================================================================
+// Chunk Maintenance
+// =============================================================================
+
+ContentHash::Location ContentHash::locate(size_t offset) const noexcept {
+    size_t node = 1;
+    size_t start = 0;
+    while (node < leaves_) {
+        const size_t left = 2 * node;
+        if (offset < start + tree_[left].bytes) {
+            node = left;
+        } else {
+            start += tree_[left].bytes;
+            node = left + 1;
+        }
+    }
+    return Location{node - leaves_, start};
+}
+
+size_t ContentHash::startOf(size_t index) const noexcept {
+    size_t start = 0;
+    for (size_t node = leaves_ + index; node > 1; node /= 2) {
+        if (node & 1) {
+            start += tree_[node - 1].bytes;
+        }
+    }
+    return start;
+}
+
+void ContentHash::markDirty(size_t index) {
+    if (!chunks_[index].dirty) {
+        chunks_[index].dirty = true;
+        dirty_.push_back(index);
+    }
+    // Keeps the sizes in the tree current for locate(); hashes wait for digest()
+    updateLeaf(index);
+}
+
+void ContentHash::rehashDirty(const IDocumentModel& text) {
+    std::sort(dirty_.begin(), dirty_.end());
+
+    // Find the starts before any split changes the layout
+    std::vector<size_t> starts;
+    starts.reserve(dirty_.size());
+    for (const size_t index : dirty_) {
+        starts.push_back(startOf(index));
+    }
+
+    // Back to front, so splitting a chunk leaves the indices before it valid
+    bool split = false;
+    for (size_t i = dirty_.size(); i-- > 0;) {
+        const size_t index = dirty_[i];
+        if (chunks_[index].bytes <= 2 * kChunkSize) {
+            Node& chunk = chunks_[index];
+            chunk.hash = 0;
+            text.visitChunks(starts[i], chunk.bytes, [&chunk](std::string_view piece) {
+                chunk.hash = hashBytes(chunk.hash, piece);
+            });
+            chunk.power = powMod(kBase, chunk.bytes);
+            chunk.dirty = false;
+            if (!split) {
+                updateLeaf(index);
+            }
+            continue;
+        }
+
+        std::vector<Node> pieces;
+        text.visitChunks(starts[i], chunks_[index].bytes, [&pieces](std::string_view piece) {
+            appendChunked(pieces, piece);
+        });
+        for (Node& piece : pieces) {
+            piece.power = powMod(kBase, piece.bytes);
+        }
+        chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(index));
+        chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(index),
+                       pieces.begin(), pieces.end());
+        split = true;
+    }
+
+    dirty_.clear();
+    if (split) {
+        rebuildTree();
+    }
+}
+
+void ContentHash::updateLeaf(size_t index) noexcept {
+    size_t node = leaves_ + index;
+    tree_[node] = chunks_[index];
+    for (node /= 2; node >= 1; node /= 2) {
+        tree_[node] = combine(tree_[2 * node], tree_[2 * node + 1]);
+    }
+}
+
+void ContentHash::rebuildTree() {
+    leaves_ = 1;
+    while (leaves_ < chunks_.size()) {
+        leaves_ *= 2;
+    }
+    tree_.assign(2 * leaves_, Node{});
+    dirty_.clear();
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        tree_[leaves_ + i] = chunks_[i];
+        if (chunks_[i].dirty) {
+            dirty_.push_back(i);
+        }
+    }
+    for (size_t node = leaves_ - 1; node >= 1; --node) {
+        tree_[node] = combine(tree_[2 * node], tree_[2 * node + 1]);
+    }
+}
+
+} // namespace mdeditor
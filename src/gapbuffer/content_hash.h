@@ -0,0 +1,127 @@
+// =============================================================================
+// content_hash.h - Incrementally Maintained Content Digest
+// =============================================================================
+//
+// ContentHash answers "is the text the same as before?" (e.g. as when last
+// saved) by comparing two digests instead of two copies of the document.
+//
+// DIGEST:
+// -------
+// The digest is a polynomial hash of the bytes modulo the Mersenne prime
+// 2^61 - 1, plus the length. It depends only on the text, not on how it was
+// edited: undoing every change since a save gives back the saved digest.
+// Two different texts collide with probability about length / 2^61. The
+// hash is not cryptographic; do not use it against adversarial input.
+//
+// STRUCTURE:
+// ----------
+// The text is divided into chunks of about kChunkSize bytes, each with its
+// own hash. A segment tree combines them in document order:
+//   hash(A + B) = hash(A) * base^|B| + hash(B)
+// so the root is the hash of the whole text however it is chunked.
+//
+// UPDATES:
+// --------
+// recordEdit() only adjusts the chunk sizes and marks the chunks it touched;
+// it does not read the text. The next digest() rehashes those chunks from
+// the document (O(kChunkSize) each) and recombines their paths to the root
+// (O(log n)). A chunk that grows past twice kChunkSize is split when it is
+// rehashed.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_CONTENT_HASH_H
+#define MDEDITOR_CONTENT_HASH_H
+
+#include "document_model.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+/// Per-chunk content hashes combined into one digest of the document.
+class ContentHash {
+public:
+    /// Target chunk size in bytes.
+    static constexpr size_t kChunkSize = 4096;
+
+    /// Fingerprint of a text: equal texts have equal digests.
+    struct Digest {
+        uint64_t hash = 0;
+        size_t bytes = 0;
+
+        friend bool operator==(const Digest& a, const Digest& b) noexcept {
+            return a.hash == b.hash && a.bytes == b.bytes;
+        }
+        friend bool operator!=(const Digest& a, const Digest& b) noexcept {
+            return !(a == b);
+        }
+    };
+
+    /// Returns the digest of text, as digest() would for a document holding it.
+    [[nodiscard]] static Digest digestOf(std::string_view text) noexcept;
+
+    /// Returns true once built (and until reset()).
+    [[nodiscard]] bool valid() const noexcept;
+
+    /// Hashes the current text. O(n); later edits use recordEdit().
+    void rebuild(const IDocumentModel& text);
+
+    /// Drops the hashes; valid() becomes false.
+    void reset() noexcept;
+
+    /// Records that removedLength bytes at offset were replaced by
+    /// insertedLength bytes. No-op unless valid().
+    void recordEdit(size_t offset, size_t removedLength, size_t insertedLength);
+
+    /// Returns the digest of text, which must be the document the hashes
+    /// describe (builds them if not valid()).
+    /// @note O(log n) plus O(kChunkSize) per chunk edited since the last call
+    [[nodiscard]] Digest digest(const IDocumentModel& text);
+
+private:
+    /// A chunk, or a range of chunks in the tree
+    struct Node {
+        size_t bytes = 0;
+        uint64_t hash = 0;
+        uint64_t power = 1;       ///< base^bytes
+        bool dirty = false;       ///< Chunk edited, hash and power stale
+    };
+
+    /// A chunk found by locate() and the byte offset where it starts
+    struct Location {
+        size_t chunk;
+        size_t start;
+    };
+
+    /// Finds the chunk holding offset (< total bytes)
+    [[nodiscard]] Location locate(size_t offset) const noexcept;
+
+    /// Returns the byte offset where chunk index starts
+    [[nodiscard]] size_t startOf(size_t index) const noexcept;
+
+    /// Marks chunk index as edited
+    void markDirty(size_t index);
+
+    /// Rehashes the edited chunks, splitting oversized ones
+    void rehashDirty(const IDocumentModel& text);
+
+    /// Copies chunk index into the tree and recombines its ancestors
+    void updateLeaf(size_t index) noexcept;
+
+    /// Rebuilds the tree from chunks_ (and the dirty list from their flags)
+    void rebuildTree();
+
+    std::vector<Node> chunks_;     ///< In document order, none empty
+    std::vector<Node> tree_;       ///< Segment tree; leaves at [leaves_, 2 * leaves_)
+    std::vector<size_t> dirty_;    ///< Chunks with dirty set
+    size_t leaves_ = 0;            ///< Leaf count (a power of two)
+    bool valid_ = false;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_CONTENT_HASH_H
@@ -0,0 +1,59 @@
+// =============================================================================
+// document_model.cpp - Document Snapshot Implementation
+// =============================================================================
+
+#include "document_model.h"
+
+namespace mdeditor {
+
+// =============================================================================
+// DocumentSnapshot
+// =============================================================================
+
+DocumentSnapshot::DocumentSnapshot(std::vector<std::string_view> runs,
+                                   std::vector<std::shared_ptr<const void>> owners,
+                                   uint64_t version)
+    : owners_(std::move(owners))
+    , version_(version) {
+    runs_.reserve(runs.size());
+    for (std::string_view run : runs) {
+        if (!run.empty()) {
+            runs_.push_back(run);
+            length_ += run.size();
+        }
+    }
+}
+
+DocumentSnapshot DocumentSnapshot::fromString(std::string text, uint64_t version) {
+    auto owner = std::make_shared<const std::string>(std::move(text));
+    return DocumentSnapshot({std::string_view(*owner)}, {owner}, version);
+}
+
+uint64_t DocumentSnapshot::version() const noexcept {
+    return version_;
+}
+
+size_t DocumentSnapshot::length() const noexcept {
+    return length_;
+}
+
+bool DocumentSnapshot::empty() const noexcept {
+    return length_ == 0;
+}
+
+std::string DocumentSnapshot::getText() const {
+    return getText(0, length_);
+}
+
+std::string DocumentSnapshot::getText(size_t start, size_t len) const {
+    std::string result;
+    if (start < length_) {
+        result.reserve(std::min(len, length_ - start));
+    }
+    forEachChunk(start, len, [&result](std::string_view run) {
+        result.append(run);
+    });
+    return result;
+}
+
+} // namespace mdeditor
@@ -0,0 +1,301 @@
+// =============================================================================
+// document_model.h - Text Document Model Interface
+// =============================================================================
+//
+// IDocumentModel is the contract shared by the text storage backends:
+//
+//   - GapBuffer         one buffer with a movable gap (default)
+//   - ChunkedGapBuffer  64 KB gap-buffered chunks, for very large files
+//   - MultiGapBuffer    a few gaps in one buffer, one per edit site
+//   - PieceTable        original + append-only add buffer, O(1) file loads
+//
+// All offsets are UTF-8 byte offsets and all backends record identical,
+// coalesced, invertible patches, so callers (UndoHistory, DocumentController)
+// can switch backends without behavioural changes.
+//
+// SNAPSHOTS:
+// ----------
+// snapshot() returns a DocumentSnapshot: an immutable, self-contained view of
+// the text at that moment that stays valid (and unchanged) while the model
+// keeps being edited. Snapshots share the model's storage where they can and
+// are safe to read from other threads, e.g. to parse or search in the
+// background while typing continues. Each carries the model's version(),
+// which changes with every edit, so a worker can tell whether its result is
+// stale. How much a snapshot costs depends on the backend; see each
+// backend's snapshot() documentation.
+//
+// USAGE:
+// ------
+//   std::unique_ptr<IDocumentModel> doc = std::make_unique<PieceTable>();
+//   doc->loadFromFile("notes.md");
+//   doc->insert(0, "# Title\n");
+//   DocumentSnapshot saved = doc->snapshot();
+//
+// =============================================================================
+
+#ifndef MDEDITOR_DOCUMENT_MODEL_H
+#define MDEDITOR_DOCUMENT_MODEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+// =============================================================================
+// Patch - Represents a single edit operation
+// =============================================================================
+/// A Patch captures an edit operation for undo/redo, synchronization, or CRDT.
+/// It records what was removed and what was inserted. Patches produced by
+/// the document models carry the removed bytes as well, so they can be inverted.
+struct Patch {
+    size_t start;                      ///< Byte offset where the edit occurred
+    size_t removedLength;              ///< Number of bytes removed (0 for pure insert)
+    std::string insertedText;          ///< Text that was inserted (empty for pure delete)
+    std::string removedText;           ///< Text that was removed (empty if not captured)
+    std::chrono::steady_clock::time_point timestamp;  ///< When the patch was created
+
+    Patch() : start(0), removedLength(0), timestamp(std::chrono::steady_clock::now()) {}
+    
+    Patch(size_t start_, size_t removedLen, std::string_view inserted)
+        : start(start_)
+        , removedLength(removedLen)
+        , insertedText(inserted)
+        , timestamp(std::chrono::steady_clock::now()) {}
+
+    Patch(size_t start_, std::string_view removed, std::string_view inserted)
+        : start(start_)
+        , removedLength(removed.size())
+        , insertedText(inserted)
+        , removedText(removed)
+        , timestamp(std::chrono::steady_clock::now()) {}
+
+    /// Returns true if removedText holds all removed bytes.
+    [[nodiscard]] bool isInvertible() const noexcept {
+        return removedText.size() == removedLength;
+    }
+
+    /// Returns the patch that undoes this one (requires isInvertible()).
+    [[nodiscard]] Patch inverted() const {
+        Patch inverse(start, insertedText, removedText);
+        inverse.timestamp = timestamp;
+        return inverse;
+    }
+};
+
+// =============================================================================
+// PatchView - A pending patch without owning its text
+// =============================================================================
+/// The fields of a Patch, with the text viewed in place. Handed out by
+/// IDocumentModel::drainPatches(); the views are valid only during the call.
+struct PatchView {
+    size_t start;                      ///< Byte offset where the edit occurred
+    size_t removedLength;              ///< Number of bytes removed
+    std::string_view insertedText;     ///< Text that was inserted
+    std::string_view removedText;      ///< Text that was removed
+    std::chrono::steady_clock::time_point timestamp;  ///< When the patch was last extended
+};
+
+// =============================================================================
+// Edit - One replacement in a batch passed to IDocumentModel::applyEdits
+// =============================================================================
+/// An Edit replaces removedLength bytes at start with insertedText. All edits
+/// of a batch use offsets into the text as it was BEFORE the batch.
+struct Edit {
+    size_t start;                  ///< Byte offset in the pre-batch text
+    size_t removedLength;          ///< Number of bytes to remove (0 for pure insert)
+    std::string_view insertedText; ///< Text to insert (must outlive the call)
+};
+
+// =============================================================================
+// DocumentSnapshot - Immutable view of a document's text
+// =============================================================================
+/// A DocumentSnapshot is a sequence of text runs plus shared ownership of the
+/// storage behind them. Copies share the same storage. A snapshot never
+/// changes after construction, so it may be read by several threads at once.
+class DocumentSnapshot {
+public:
+    /// Constructs an empty snapshot.
+    DocumentSnapshot() = default;
+
+    /// Constructs a snapshot from text runs and the owners keeping them alive.
+    /// @param runs Text in order; the bytes must never change while owned
+    /// @param owners Shared owners of the storage the runs point into
+    /// @param version Version of the document the runs show
+    DocumentSnapshot(std::vector<std::string_view> runs,
+                     std::vector<std::shared_ptr<const void>> owners,
+                     uint64_t version = 0);
+
+    /// Constructs a snapshot that owns a copy of text.
+    static DocumentSnapshot fromString(std::string text, uint64_t version = 0);
+
+    /// Returns the version of the document this snapshot was taken at.
+    [[nodiscard]] uint64_t version() const noexcept;
+
+    /// Returns the length of the text in bytes.
+    [[nodiscard]] size_t length() const noexcept;
+
+    /// Returns true if the snapshot holds no text.
+    [[nodiscard]] bool empty() const noexcept;
+
+    /// Returns the entire text as a string.
+    [[nodiscard]] std::string getText() const;
+
+    /// Returns a substring of the text (clamped to the valid range).
+    [[nodiscard]] std::string getText(size_t start, size_t len) const;
+
+    /// Calls fn(std::string_view) for each contiguous run of a byte range.
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+
+private:
+    std::vector<std::string_view> runs_;               ///< Non-empty runs in order
+    std::vector<std::shared_ptr<const void>> owners_;  ///< Keep the runs alive
+    size_t length_ = 0;                                ///< Sum of run sizes
+    uint64_t version_ = 0;                             ///< IDocumentModel::version()
+};
+
+// =============================================================================
+// IDocumentModel - Abstract interface for text storage backends
+// =============================================================================
+/// Interface for text models used by the editor.
+/// Out-of-range offsets and lengths are clamped, never rejected.
+class IDocumentModel {
+public:
+    /// Receives one contiguous run of text; see visitChunks()
+    using ChunkVisitor = std::function<void(std::string_view)>;
+
+    /// Receives one pending patch; see drainPatches()
+    using PatchVisitor = std::function<void(const PatchView&)>;
+
+    virtual ~IDocumentModel() = default;
+
+    // -------------------------------------------------------------------------
+    // Loading Content
+    // -------------------------------------------------------------------------
+
+    /// Replaces the content with text and clears pending patches.
+    virtual void loadFromString(std::string_view text) = 0;
+
+    /// Replaces the content with a file's bytes and clears pending patches.
+    /// @throws std::runtime_error if the file cannot be read; the model is
+    ///         left unchanged
+    virtual void loadFromFile(const std::filesystem::path& path) = 0;
+
+    /// Removes all content and pending patches.
+    virtual void clear() = 0;
+
+    // -------------------------------------------------------------------------
+    // Retrieving Content
+    // -------------------------------------------------------------------------
+
+    /// Returns the entire text content as a string.
+    [[nodiscard]] virtual std::string getText() const = 0;
+
+    /// Returns a substring of the text content (clamped to valid range).
+    [[nodiscard]] virtual std::string getText(size_t start, size_t len) const = 0;
+
+    /// Returns the total length of the text in bytes.
+    [[nodiscard]] virtual size_t length() const noexcept = 0;
+
+    /// Returns true if the model contains no text.
+    [[nodiscard]] virtual bool empty() const noexcept = 0;
+
+    /// Calls fn for each contiguous run of a byte range, in order, without
+    /// copying (clamped like getText(start, len); empty runs are skipped).
+    virtual void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const = 0;
+
+    /// Returns the whole text as one view, valid until the next edit.
+    /// Backends copy into an internal buffer when the text is not contiguous.
+    [[nodiscard]] virtual std::string_view contiguousView() = 0;
+
+    /// Returns an immutable snapshot of the current text.
+    [[nodiscard]] virtual DocumentSnapshot snapshot() const = 0;
+
+    /// Returns a counter that increases with every edit, load and clear.
+    /// Equal versions of one model mean equal text.
+    [[nodiscard]] virtual uint64_t version() const noexcept = 0;
+
+    // -------------------------------------------------------------------------
+    // Editing Operations
+    // -------------------------------------------------------------------------
+
+    /// Inserts text at the specified byte offset.
+    virtual void insert(size_t offset, std::string_view text) = 0;
+
+    /// Erases a range of bytes.
+    virtual void erase(size_t offset, size_t len) = 0;
+
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText, recording it as one patch.
+    virtual void applyPatch(const Patch& patch) = 0;
+
+    /// Applies a batch of non-overlapping edits given in pre-batch offsets.
+    /// @throws std::invalid_argument if two edits overlap; the model is
+    ///         left unchanged
+    virtual void applyEdits(const std::vector<Edit>& edits) = 0;
+
+    // -------------------------------------------------------------------------
+    // Line/Offset Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the 0-indexed line number containing the given byte offset.
+    [[nodiscard]] virtual size_t lineFromOffset(size_t offset) const = 0;
+
+    /// Returns the byte offset of (line, column), clamped to the text.
+    [[nodiscard]] virtual size_t offsetFromLine(size_t line, size_t column = 0) const = 0;
+
+    /// Returns the number of lines (0 when empty, else 1 + newline count).
+    [[nodiscard]] virtual size_t lineCount() const = 0;
+
+    // -------------------------------------------------------------------------
+    // Patch Management
+    // -------------------------------------------------------------------------
+
+    /// Returns and clears the accumulated patches since last flush.
+    [[nodiscard]] virtual std::vector<Patch> flushPatches() = 0;
+
+    /// Calls fn for each accumulated patch in order, then clears them, like
+    /// flushPatches() but without copying the text out (no allocations).
+    virtual void drainPatches(const PatchVisitor& fn) = 0;
+
+    /// Returns true if there are unflushed patches.
+    [[nodiscard]] virtual bool hasPendingPatches() const noexcept = 0;
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void DocumentSnapshot::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    if (start >= length_) {
+        return;
+    }
+    len = std::min(len, length_ - start);
+
+    for (std::string_view run : runs_) {
+        if (start >= run.size()) {
+            start -= run.size();
+            continue;
+        }
+        const size_t take = std::min(len, run.size() - start);
+        fn(run.substr(start, take));
+        len -= take;
+        if (len == 0) {
+            return;
+        }
+        start = 0;
+    }
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_DOCUMENT_MODEL_H
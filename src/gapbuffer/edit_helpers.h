@@ -0,0 +1,55 @@
+// =============================================================================
+// edit_helpers.h - Shared Editing Helpers (internal)
+// =============================================================================
+//
+// Helpers shared by the text stores (including PieceTree in src/piecetree)
+// so they validate edit batches identically (patches are recorded through
+// PatchLog). Not part of the public interface.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_EDIT_HELPERS_H
+#define MDEDITOR_EDIT_HELPERS_H
+
+#include "document_model.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+namespace detail {
+
+/// Clamps edits to a text of textLen bytes, drops no-ops and orders them by
+/// start (stable, so inserts sharing an offset keep the caller's order).
+/// @throws std::invalid_argument if two edits overlap
+inline std::vector<Edit> sortedEdits(const std::vector<Edit>& edits, size_t textLen,
+                                     const char* caller) {
+    std::vector<Edit> sorted;
+    sorted.reserve(edits.size());
+    for (const Edit& edit : edits) {
+        const size_t start = std::min(edit.start, textLen);
+        const size_t removed = std::min(edit.removedLength, textLen - start);
+        if (removed == 0 && edit.insertedText.empty()) {
+            continue;
+        }
+        sorted.push_back(Edit{start, removed, edit.insertedText});
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Edit& a, const Edit& b) { return a.start < b.start; });
+    
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        if (sorted[i - 1].start + sorted[i - 1].removedLength > sorted[i].start) {
+            throw std::invalid_argument(std::string(caller) + ": overlapping edits");
+        }
+    }
+    return sorted;
+}
+
+} // namespace detail
+} // namespace mdeditor
+
+#endif // MDEDITOR_EDIT_HELPERS_H
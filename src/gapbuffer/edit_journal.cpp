@@ -0,0 +1,419 @@
+// =============================================================================
+// edit_journal.cpp - Append-Only Binary Edit Journal Implementation
+// =============================================================================
+
+#include "edit_journal.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace mdeditor {
+
+namespace {
+
+constexpr std::string_view kMagic = "MDEDJNL2";
+
+/// Upper bound of an encoded varint (64-bit value)
+constexpr size_t kMaxVarintBytes = 10;
+
+[[noreturn]] void throwJournalError(const char* what, const std::filesystem::path& path) {
+    throw std::runtime_error(std::string(what) + ": " + path.string());
+}
+
+// -----------------------------------------------------------------------------
+// Encoding
+// -----------------------------------------------------------------------------
+
+/// CRC-32 (IEEE 802.3, reflected), table driven
+uint32_t crc32(std::string_view bytes) noexcept {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1u) ? 0xEDB88320u : 0u);
+            }
+            entries[i] = crc;
+        }
+        return entries;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (const char c : bytes) {
+        crc = table[(crc ^ static_cast<unsigned char>(c)) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+size_t varintSize(uint64_t value) noexcept {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putFixed32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFFu));
+    }
+}
+
+void putFixed64(std::string& out, uint64_t value) {
+    putFixed32(out, static_cast<uint32_t>(value));
+    putFixed32(out, static_cast<uint32_t>(value >> 32));
+}
+
+/// Length and hash of the text a journal applies to, as stored in the header
+std::string encodeBase(const IDocumentModel& base) {
+    ContentHash hash;
+    hash.rebuild(base);
+    const ContentHash::Digest digest = hash.digest(base);
+    std::string encoded;
+    putVarint(encoded, digest.bytes);
+    putFixed64(encoded, digest.hash);
+    return encoded;
+}
+
+// -----------------------------------------------------------------------------
+// Decoding
+// -----------------------------------------------------------------------------
+
+/// Reads a varint from the front of in; false if truncated or overlong
+bool getVarint(std::string_view& in, uint64_t& value) noexcept {
+    value = 0;
+    for (size_t i = 0; i < in.size() && i < kMaxVarintBytes; ++i) {
+        const auto byte = static_cast<unsigned char>(in[i]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            in.remove_prefix(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool getFixed32(std::string_view& in, uint32_t& value) noexcept {
+    if (in.size() < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    in.remove_prefix(4);
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Platform File Access
+// =============================================================================
+
+#ifdef _WIN32
+
+namespace {
+
+HANDLE toHandle(std::intptr_t file) noexcept {
+    return reinterpret_cast<HANDLE>(file);
+}
+
+} // anonymous namespace
+
+EditJournal::EditJournal(const std::filesystem::path& path, const IDocumentModel& base,
+                         Options options)
+    : path_(path)
+    , options_(options) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throwJournalError("Cannot create journal", path);
+    }
+    file_ = reinterpret_cast<std::intptr_t>(file);
+    try {
+        writeHeader(base);
+    } catch (...) {
+        CloseHandle(file);
+        throw;
+    }
+}
+
+EditJournal::~EditJournal() {
+    try {
+        commit();
+    } catch (...) {
+        // Nothing sensible to do while closing; the journal stays valid up
+        // to the last successful commit
+    }
+    CloseHandle(toHandle(file_));
+}
+
+void EditJournal::write(std::string_view bytes) {
+    while (!bytes.empty()) {
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(bytes.size(), 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(toHandle(file_), bytes.data(), chunk, &written, nullptr)) {
+            throwJournalError("Cannot write journal", path_);
+        }
+        bytes.remove_prefix(written);
+    }
+}
+
+void EditJournal::sync() {
+    if (!FlushFileBuffers(toHandle(file_))) {
+        throwJournalError("Cannot sync journal", path_);
+    }
+}
+
+void EditJournal::truncate(uint64_t size) {
+    LARGE_INTEGER offset{};
+    offset.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(toHandle(file_), offset, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(toHandle(file_))) {
+        throwJournalError("Cannot truncate journal", path_);
+    }
+}
+
+#else
+
+EditJournal::EditJournal(const std::filesystem::path& path, const IDocumentModel& base,
+                         Options options)
+    : path_(path)
+    , options_(options) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throwJournalError("Cannot create journal", path);
+    }
+    file_ = fd;
+    try {
+        writeHeader(base);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+EditJournal::~EditJournal() {
+    try {
+        commit();
+    } catch (...) {
+        // Nothing sensible to do while closing; the journal stays valid up
+        // to the last successful commit
+    }
+    ::close(static_cast<int>(file_));
+}
+
+void EditJournal::write(std::string_view bytes) {
+    while (!bytes.empty()) {
+        const ssize_t written = ::write(static_cast<int>(file_), bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwJournalError("Cannot write journal", path_);
+        }
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+void EditJournal::sync() {
+#if defined(__linux__)
+    const int result = ::fdatasync(static_cast<int>(file_));
+#else
+    const int result = ::fsync(static_cast<int>(file_));
+#endif
+    if (result != 0) {
+        throwJournalError("Cannot sync journal", path_);
+    }
+}
+
+void EditJournal::truncate(uint64_t size) {
+    // O_APPEND: the next write lands at the new end
+    if (::ftruncate(static_cast<int>(file_), static_cast<off_t>(size)) != 0) {
+        throwJournalError("Cannot truncate journal", path_);
+    }
+}
+
+#endif
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+EditJournal::EditJournal(const std::filesystem::path& path, const IDocumentModel& base)
+    : EditJournal(path, base, Options{}) {}
+
+// =============================================================================
+// Writing
+// =============================================================================
+
+void EditJournal::encode(size_t start, size_t removedLength, std::string_view inserted) {
+    const size_t bodyLength = varintSize(start) + varintSize(removedLength) + inserted.size();
+    putVarint(pending_, bodyLength);
+    const size_t bodyStart = pending_.size();
+    putVarint(pending_, start);
+    putVarint(pending_, removedLength);
+    pending_.append(inserted);
+    putFixed32(pending_, crc32(std::string_view(pending_).substr(bodyStart, bodyLength)));
+}
+
+void EditJournal::append(const Patch& patch) {
+    encode(patch.start, patch.removedLength, patch.insertedText);
+    maybeCommit();
+}
+
+void EditJournal::append(const PatchView& patch) {
+    encode(patch.start, patch.removedLength, patch.insertedText);
+    maybeCommit();
+}
+
+void EditJournal::append(const std::vector<Patch>& patches) {
+    for (const Patch& patch : patches) {
+        encode(patch.start, patch.removedLength, patch.insertedText);
+    }
+    maybeCommit();
+}
+
+void EditJournal::maybeCommit() {
+    if (pending_.size() >= options_.groupCommitBytes ||
+        std::chrono::steady_clock::now() - lastCommit_ >= options_.groupCommitInterval) {
+        commit();
+    }
+}
+
+void EditJournal::commit() {
+    if (failed_) {
+        throwJournalError("Journal holds a failed commit; reset it", path_);
+    }
+    if (pending_.empty()) {
+        return;
+    }
+    try {
+        write(pending_);
+        sync();
+    } catch (...) {
+        // Drop what reached the file, so the retry writes each record once
+        try {
+            truncate(committedBytes_);
+        } catch (...) {
+            failed_ = true;
+        }
+        throw;
+    }
+    committedBytes_ += pending_.size();
+    pending_.clear();
+    lastCommit_ = std::chrono::steady_clock::now();
+}
+
+void EditJournal::writeHeader(const IDocumentModel& base) {
+    const std::string encoded = encodeBase(base);
+    std::string header(kMagic);
+    header += encoded;
+    putFixed32(header, crc32(encoded));
+
+    failed_ = true;     // Until a complete header is on disk
+    truncate(0);
+    write(header);
+    sync();
+    failed_ = false;
+    committedBytes_ = header.size();
+    lastCommit_ = std::chrono::steady_clock::now();
+}
+
+void EditJournal::reset(const IDocumentModel& saved) {
+    pending_.clear();
+    writeHeader(saved);
+}
+
+size_t EditJournal::pendingBytes() const noexcept {
+    return pending_.size();
+}
+
+uint64_t EditJournal::committedBytes() const noexcept {
+    return committedBytes_;
+}
+
+// =============================================================================
+// Recovery
+// =============================================================================
+
+EditJournal::Recovery EditJournal::recover(const std::filesystem::path& path,
+                                           IDocumentModel& model) {
+    const MappedFile file(path);
+    std::string_view in = file.view();
+
+    // Header
+    if (in.substr(0, kMagic.size()) != kMagic) {
+        throwJournalError("Not an edit journal", path);
+    }
+    in.remove_prefix(kMagic.size());
+    const std::string_view baseBytes = in;
+    uint64_t baseLength = 0;
+    uint32_t headerChecksum = 0;
+    if (!getVarint(in, baseLength) || in.size() < 8) {
+        throwJournalError("Corrupt journal header", path);
+    }
+    in.remove_prefix(8);    // baseHash
+    const std::string_view base = baseBytes.substr(0, baseBytes.size() - in.size());
+    if (!getFixed32(in, headerChecksum) || headerChecksum != crc32(base)) {
+        throwJournalError("Corrupt journal header", path);
+    }
+    if (baseLength != model.length() || base != encodeBase(model)) {
+        throwJournalError("Journal was written for a different file", path);
+    }
+
+    // Records, up to the first torn or corrupt one
+    Recovery recovery;
+    while (!in.empty()) {
+        std::string_view record = in;
+        uint64_t bodyLength = 0;
+        uint32_t checksum = 0;
+        if (!getVarint(record, bodyLength) || bodyLength > record.size()) {
+            recovery.complete = false;
+            break;
+        }
+        std::string_view body = record.substr(0, static_cast<size_t>(bodyLength));
+        record.remove_prefix(body.size());
+        if (!getFixed32(record, checksum) || checksum != crc32(body)) {
+            recovery.complete = false;
+            break;
+        }
+
+        uint64_t start = 0;
+        uint64_t removedLength = 0;
+        if (!getVarint(body, start) || !getVarint(body, removedLength) ||
+            start > model.length() || removedLength > model.length() - start) {
+            recovery.complete = false;
+            break;
+        }
+        model.applyPatch(Patch(static_cast<size_t>(start), static_cast<size_t>(removedLength), body));
+        ++recovery.patchesApplied;
+        in = record;
+    }
+    return recovery;
+}
+
+} // namespace mdeditor
@@ -0,0 +1,170 @@
+// =============================================================================
+// edit_journal.h - Append-Only Binary Edit Journal for Crash Recovery
+// =============================================================================
+//
+// EditJournal appends the patches flushed from a document model to a compact
+// binary log next to the document. After a crash, recover() replays the log
+// onto the last saved file, so making edits durable costs O(size of the
+// edits) instead of rewriting the whole file.
+//
+// FORMAT:
+// -------
+//   header:  "MDEDJNL2" | varint baseLength | baseHash (8 bytes) | crc32
+//   record:  varint bodyLength | body | crc32 of body
+//   body:    varint start | varint removedLength | insertedText bytes
+// Varints are unsigned LEB128 (7 bits per byte); fixed-width fields are
+// little endian. baseLength and baseHash are the ContentHash digest of the
+// saved file the journal applies to. recover() refuses any other base, so a
+// crash between saving and reset() cannot replay saved edits onto the new
+// file even when the save kept its length. Removed text is not stored:
+// replay only needs the positions.
+//
+// GROUP COMMIT:
+// -------------
+// append() encodes records into memory. They are written and synced with
+// one fsync (fdatasync where available) when groupCommitBytes accumulate,
+// when groupCommitInterval has passed since the last commit, or on
+// commit(). Call commit() from an idle timer so a quiet editor does not hold
+// edits in memory; at most the uncommitted records are lost in a crash.
+// A failed commit truncates the file back to the last successful commit and
+// keeps the records buffered, so a retry writes them exactly once. If even
+// the truncation fails, the journal refuses further commits until reset().
+//
+// TORN WRITES:
+// ------------
+// A crash can leave a partial last record. recover() stops at the first
+// record that is truncated or fails its checksum and applies everything
+// before it.
+//
+// USAGE:
+// ------
+//   if (std::filesystem::exists(journalPath)) {
+//       buffer.loadFromFile(documentPath);
+//       EditJournal::recover(journalPath, buffer);
+//   }
+//   EditJournal journal(journalPath, buffer);
+//   ...
+//   journal.append(buffer.flushPatches());
+//   ...
+//   saveDocument(buffer, documentPath);
+//   journal.reset(buffer);            // The saved file is the new base
+//
+// =============================================================================
+
+#ifndef MDEDITOR_EDIT_JOURNAL_H
+#define MDEDITOR_EDIT_JOURNAL_H
+
+#include "content_hash.h"
+#include "document_model.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+/// Writes patches to an append-only, checksummed log and replays it.
+class EditJournal {
+public:
+    /// When buffered records are committed.
+    struct Options {
+        size_t groupCommitBytes = 64 * 1024;                   ///< Commit once this much is buffered
+        std::chrono::milliseconds groupCommitInterval{250};    ///< Max age of the last commit
+    };
+
+    /// Result of replaying a journal.
+    struct Recovery {
+        size_t patchesApplied = 0;   ///< Records replayed onto the model
+        bool complete = true;        ///< false if a torn or corrupt tail was skipped
+    };
+
+    /// Creates (or truncates) the journal at path for base, the text of the
+    /// saved file. Recover an existing journal before opening it.
+    /// @throws std::runtime_error if the file cannot be created or written
+    EditJournal(const std::filesystem::path& path, const IDocumentModel& base);
+
+    /// Same, with explicit group commit options.
+    EditJournal(const std::filesystem::path& path, const IDocumentModel& base, Options options);
+
+    /// Commits buffered records (errors are ignored) and closes the file.
+    ~EditJournal();
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    // -------------------------------------------------------------------------
+    // Writing
+    // -------------------------------------------------------------------------
+
+    /// Buffers a record for the patch; may commit (see GROUP COMMIT).
+    /// @throws std::runtime_error if a commit fails
+    void append(const Patch& patch);
+
+    /// Buffers a record for the patch view (e.g. from drainPatches()).
+    void append(const PatchView& patch);
+
+    /// Buffers records for all patches, then applies the commit policy once.
+    void append(const std::vector<Patch>& patches);
+
+    /// Writes the buffered records and syncs them to disk.
+    /// @throws std::runtime_error if writing or syncing fails; the records
+    ///         stay buffered (see GROUP COMMIT)
+    void commit();
+
+    /// Empties the journal after a save: saved, the text just written, is
+    /// the new base. Buffered records are dropped.
+    /// @throws std::runtime_error if the file cannot be rewritten
+    void reset(const IDocumentModel& saved);
+
+    /// Returns the number of encoded bytes not yet committed.
+    [[nodiscard]] size_t pendingBytes() const noexcept;
+
+    /// Returns the number of bytes committed to the file (header included).
+    [[nodiscard]] uint64_t committedBytes() const noexcept;
+
+    // -------------------------------------------------------------------------
+    // Recovery
+    // -------------------------------------------------------------------------
+
+    /// Replays the journal at path onto model, which must hold the saved
+    /// file the journal was written for. Replayed edits become pending
+    /// patches of the model.
+    /// @throws std::runtime_error if the journal cannot be read, has no valid
+    ///         header, or belongs to a different base
+    static Recovery recover(const std::filesystem::path& path, IDocumentModel& model);
+
+private:
+    /// Encodes one record into pending_
+    void encode(size_t start, size_t removedLength, std::string_view inserted);
+
+    /// Commits if the group commit thresholds are reached
+    void maybeCommit();
+
+    /// Writes bytes at the end of the file
+    void write(std::string_view bytes);
+
+    /// Flushes written bytes to stable storage
+    void sync();
+
+    /// Cuts the file to size bytes; the next write goes at its end
+    void truncate(uint64_t size);
+
+    /// Truncates the file and writes a header for base
+    void writeHeader(const IDocumentModel& base);
+
+    std::filesystem::path path_;
+    Options options_;
+    std::intptr_t file_ = -1;       ///< File descriptor (POSIX) or HANDLE (Windows)
+    std::string pending_;           ///< Encoded, uncommitted records
+    uint64_t committedBytes_ = 0;
+    bool failed_ = false;           ///< The file may hold a partial commit
+    std::chrono::steady_clock::time_point lastCommit_;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_EDIT_JOURNAL_H
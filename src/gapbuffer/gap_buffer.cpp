@@ -3,14 +3,110 @@
 // =============================================================================
 
 #include "gap_buffer.h"
+#include "mapped_file.h"
+#include "newline_scan.h"
+#include "substring_scan.h"
+#include "utf8_scan.h"
+#include "edit_helpers.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
-#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Operation counters for stats(); compiled out unless built with
+// MD_GAPBUFFER_STATS
+#ifdef MD_GAPBUFFER_STATS
+#define MDEDITOR_COUNT(counter, amount) (stats_.counter += (amount))
+#else
+#define MDEDITOR_COUNT(counter, amount) ((void)0)
+#endif
 
 namespace mdeditor {
 
+using simd::forEachNewline;
+
+namespace {
+
+/// Allocates uninitialized storage; gap bytes are never read
+std::shared_ptr<char[]> allocateStorage(size_t capacity) {
+    return std::shared_ptr<char[]>(new char[capacity]);
+}
+
+/// Returns a private copy of the text runs of storage, same layout. Copies
+/// of a GapBuffer never share storage: both would type into the same gap.
+std::shared_ptr<char[]> copyStorage(const std::shared_ptr<char[]>& storage, size_t capacity,
+                                    size_t gapStart, size_t gapEnd) {
+    if (!storage) {
+        return nullptr;
+    }
+    std::shared_ptr<char[]> copy = allocateStorage(capacity);
+    std::memcpy(copy.get(), storage.get(), gapStart);
+    std::memcpy(copy.get() + gapEnd, storage.get() + gapEnd, capacity - gapEnd);
+    return copy;
+}
+
+/// Throws InvalidUtf8Error if text is not well-formed UTF-8
+void requireValidUtf8(std::string_view text, const char* caller) {
+    const size_t offset = simd::findInvalidUtf8(text);
+    if (offset != std::string_view::npos) {
+        throw InvalidUtf8Error(std::string(caller) + ": invalid UTF-8 at byte " +
+                               std::to_string(offset), offset);
+    }
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// InvalidUtf8Error
+// =============================================================================
+
+InvalidUtf8Error::InvalidUtf8Error(const std::string& what, size_t offset)
+    : std::invalid_argument(what)
+    , offset_(offset) {
+}
+
+size_t InvalidUtf8Error::offset() const noexcept {
+    return offset_;
+}
+
+// =============================================================================
+// WriteSection
+// =============================================================================
+
+class GapBuffer::WriteSection {
+public:
+    explicit WriteSection(GapBuffer& buffer) noexcept
+        : buffer_(buffer)
+        , state_(buffer.concurrent_.get()) {
+        if (state_ != nullptr && (state_->sequence.load(std::memory_order_relaxed) & 1) != 0) {
+            state_ = nullptr;  // Inside an enclosing section
+        }
+        if (state_ != nullptr) {
+            // Seqlock write side: odd sequence, then the edit's stores
+            state_->sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
+
+    ~WriteSection() {
+        if (state_ != nullptr) {
+            buffer_.publishLayout();
+            state_->sequence.fetch_add(1, std::memory_order_release);
+            buffer_.reclaimRetired();
+        }
+    }
+
+    WriteSection(const WriteSection&) = delete;
+    WriteSection& operator=(const WriteSection&) = delete;
+
+private:
+    GapBuffer& buffer_;
+    ConcurrentState* state_;
+};
+
 // =============================================================================
 // Construction / Destruction
 // =============================================================================
@@ -20,45 +116,113 @@ GapBuffer::GapBuffer()
 }
 
 GapBuffer::GapBuffer(size_t initialCapacity)
-    : buffer_(initialCapacity)
+    : GapBuffer(initialCapacity, std::pmr::get_default_resource()) {
+}
+
+GapBuffer::GapBuffer(size_t initialCapacity, std::pmr::memory_resource* patchUpstream)
+    : buffer_(allocateStorage(initialCapacity))
+    , capacity_(initialCapacity)
     , gapStart_(0)
-    , gapEnd_(initialCapacity) {
+    , gapEnd_(initialCapacity)
+    , pendingPatches_(patchUpstream) {
 }
 
 GapBuffer::GapBuffer(const GapBuffer& other)
-    : buffer_(other.buffer_)
+    : buffer_(copyStorage(other.buffer_, other.capacity_, other.gapStart_, other.gapEnd_))
+    , capacity_(other.capacity_)
     , gapStart_(other.gapStart_)
     , gapEnd_(other.gapEnd_)
-    , pendingPatches_(other.pendingPatches_) {
+    , pendingPatches_(other.pendingPatches_)
+    , shrinkPolicy_(other.shrinkPolicy_)
+    , mapping_(other.mapping_)
+    , version_(other.version_)
+    , linesBeforeGap_(other.linesBeforeGap_)
+    , linesAfterGap_(other.linesAfterGap_)
+    , lineIndexPending_(other.lineIndexPending_)
+    , utf16Index_(other.utf16Index_)
+    , textStats_(other.textStats_)
+    , utf8Validation_(other.utf8Validation_) {
 }
 
 GapBuffer& GapBuffer::operator=(const GapBuffer& other) {
     if (this != &other) {
-        buffer_ = other.buffer_;
+        WriteSection section(*this);
+        retire(std::move(buffer_));
+        retire(std::move(mapping_));
+        buffer_ = copyStorage(other.buffer_, other.capacity_, other.gapStart_, other.gapEnd_);
+        capacity_ = other.capacity_;
         gapStart_ = other.gapStart_;
         gapEnd_ = other.gapEnd_;
         pendingPatches_ = other.pendingPatches_;
+        shrinkPolicy_ = other.shrinkPolicy_;
+        mapping_ = other.mapping_;
+        version_ = other.version_;
+        linesBeforeGap_ = other.linesBeforeGap_;
+        linesAfterGap_ = other.linesAfterGap_;
+        lineIndexPending_ = other.lineIndexPending_;
+        utf16Index_ = other.utf16Index_;
+        textStats_ = other.textStats_;
+        utf8Validation_ = other.utf8Validation_;
     }
     return *this;
 }
 
 GapBuffer::GapBuffer(GapBuffer&& other) noexcept
     : buffer_(std::move(other.buffer_))
+    , capacity_(other.capacity_)
     , gapStart_(other.gapStart_)
     , gapEnd_(other.gapEnd_)
-    , pendingPatches_(std::move(other.pendingPatches_)) {
+    , pendingPatches_(std::move(other.pendingPatches_))
+    , shrinkPolicy_(other.shrinkPolicy_)
+    , mapping_(std::move(other.mapping_))
+    , version_(other.version_)
+    , linesBeforeGap_(std::move(other.linesBeforeGap_))
+    , linesAfterGap_(std::move(other.linesAfterGap_))
+    , lineIndexPending_(other.lineIndexPending_)
+    , utf16Index_(std::move(other.utf16Index_))
+    , textStats_(other.textStats_)
+    , utf8Validation_(other.utf8Validation_)
+    , cleanStart_(other.cleanStart_)
+    , cleanEnd_(other.cleanEnd_) {
+    other.capacity_ = 0;
     other.gapStart_ = 0;
     other.gapEnd_ = 0;
+    other.linesBeforeGap_.clear();
+    other.linesAfterGap_.clear();
+    other.lineIndexPending_ = false;
+    other.utf16Index_.reset();
+    other.textStats_.reset();
 }
 
 GapBuffer& GapBuffer::operator=(GapBuffer&& other) noexcept {
     if (this != &other) {
+        WriteSection section(*this);
+        retire(std::move(buffer_));
+        retire(std::move(mapping_));
         buffer_ = std::move(other.buffer_);
+        capacity_ = other.capacity_;
         gapStart_ = other.gapStart_;
         gapEnd_ = other.gapEnd_;
         pendingPatches_ = std::move(other.pendingPatches_);
+        shrinkPolicy_ = other.shrinkPolicy_;
+        mapping_ = std::move(other.mapping_);
+        version_ = other.version_;
+        linesBeforeGap_ = std::move(other.linesBeforeGap_);
+        linesAfterGap_ = std::move(other.linesAfterGap_);
+        lineIndexPending_ = other.lineIndexPending_;
+        utf16Index_ = std::move(other.utf16Index_);
+        textStats_ = other.textStats_;
+        utf8Validation_ = other.utf8Validation_;
+        cleanStart_ = other.cleanStart_;
+        cleanEnd_ = other.cleanEnd_;
+        other.capacity_ = 0;
         other.gapStart_ = 0;
         other.gapEnd_ = 0;
+        other.linesBeforeGap_.clear();
+        other.linesAfterGap_.clear();
+        other.lineIndexPending_ = false;
+        other.utf16Index_.reset();
+        other.textStats_.reset();
     }
     return *this;
 }
@@ -68,27 +232,89 @@ GapBuffer& GapBuffer::operator=(GapBuffer&& other) noexcept {
 // =============================================================================
 
 void GapBuffer::loadFromString(std::string_view text) {
+    if (utf8Validation_) {
+        requireValidUtf8(text, "GapBuffer::loadFromString");
+    }
+    WriteSection section(*this);
+    
     // Clear existing patches when loading new content
     pendingPatches_.clear();
+    retire(std::move(mapping_));
     
-    // Allocate buffer with room for gap
+    // Allocate buffer with room for gap; drop an oversized old allocation
+    // instead of keeping it around as gap. Storage still shared with a
+    // snapshot is never overwritten.
     const size_t newCapacity = std::max(text.size() + kMinGapSize, kDefaultCapacity);
-    buffer_.resize(newCapacity);
+    const bool oversized = capacity_ > newCapacity && shrinkPolicy_.enabled &&
+        capacity_ > shrinkPolicy_.minCapacity &&
+        capacity_ / std::max<size_t>(shrinkPolicy_.shrinkFactor, 1) > text.size();
+    if (oversized || capacity_ < newCapacity || isShared()) {
+        retire(std::move(buffer_));
+        buffer_ = allocateStorage(newCapacity);
+        MDEDITOR_COUNT(bytesAllocated, newCapacity);
+    }
+    capacity_ = newCapacity;
+    ++version_;
     
     // Copy text to beginning of buffer
     if (!text.empty()) {
-        std::memcpy(buffer_.data(), text.data(), text.size());
+        std::memcpy(buffer_.get(), text.data(), text.size());
     }
     
     // Gap starts after the text
     gapStart_ = text.size();
     gapEnd_ = newCapacity;
+    
+    rebuildLineIndex();
+    utf16Index_.reset();
+    textStats_.reset();
+}
+
+void GapBuffer::loadFromFile(const std::filesystem::path& path) {
+    // Map first so a failure leaves the buffer untouched
+    auto mapping = std::make_shared<const MappedFile>(path);
+    if (utf8Validation_) {
+        requireValidUtf8(mapping->view(), "GapBuffer::loadFromFile");
+    }
+    WriteSection section(*this);
+    
+    pendingPatches_.clear();
+    retire(std::move(mapping_));
+    mapping_ = std::move(mapping);
+    ++version_;
+    
+    // The buffer holds no text while mapped; the empty gap sits at the end
+    // of the mapped text so the line index reads it as "before the gap"
+    retire(std::move(buffer_));
+    capacity_ = 0;
+    gapStart_ = mapping_->size();
+    gapEnd_ = gapStart_;
+    
+    // Defer the line index: building it reads every page of the file
+    linesBeforeGap_.clear();
+    linesAfterGap_.clear();
+    lineIndexPending_ = true;
+    utf16Index_.reset();
+    textStats_.reset();
+}
+
+bool GapBuffer::isMapped() const noexcept {
+    return mapping_ != nullptr;
 }
 
 void GapBuffer::clear() {
+    WriteSection section(*this);
+    retire(std::move(mapping_));
+    ++version_;
     gapStart_ = 0;
-    gapEnd_ = buffer_.size();
+    gapEnd_ = capacity_;
     pendingPatches_.clear();
+    linesBeforeGap_.clear();
+    linesAfterGap_.clear();
+    lineIndexPending_ = false;
+    utf16Index_.reset();
+    textStats_.reset();
+    maybeShrink();
 }
 
 // =============================================================================
@@ -96,64 +322,146 @@ void GapBuffer::clear() {
 // =============================================================================
 
 std::string GapBuffer::getText() const {
-    std::string result;
-    result.reserve(length());
+    const Segments segs = segments();
     
-    // Append text before gap
-    result.append(buffer_.data(), gapStart_);
-    // Append text after gap
-    result.append(buffer_.data() + gapEnd_, buffer_.size() - gapEnd_);
+    std::string result;
+    result.reserve(segs.before.size() + segs.after.size());
+    result.append(segs.before);
+    result.append(segs.after);
     
     return result;
 }
 
 std::string GapBuffer::getText(size_t start, size_t len) const {
-    const size_t textLen = length();
-    
-    // Clamp to valid range
-    if (start >= textLen) {
-        return {};
-    }
-    len = std::min(len, textLen - start);
-    
-    if (len == 0) {
-        return {};
-    }
-    
     std::string result;
-    result.reserve(len);
-    
-    // Calculate how much is before and after the gap
-    const size_t beforeGapLen = gapStart_;
-    
-    if (start < beforeGapLen) {
-        // Some or all of the requested range is before the gap
-        const size_t endBeforeGap = std::min(start + len, beforeGapLen);
-        result.append(buffer_.data() + start, endBeforeGap - start);
-        
-        if (start + len > beforeGapLen) {
-            // Range continues after the gap
-            const size_t afterGapStart = gapEnd_;
-            const size_t afterGapLen = (start + len) - beforeGapLen;
-            result.append(buffer_.data() + afterGapStart, afterGapLen);
-        }
-    } else {
-        // Entirely after the gap
-        const size_t adjustedStart = gapEnd_ + (start - beforeGapLen);
-        result.append(buffer_.data() + adjustedStart, len);
+    if (start < length()) {
+        result.reserve(std::min(len, length() - start));
     }
     
+    forEachChunk(start, len, [&result](std::string_view chunk) {
+        result.append(chunk);
+    });
+    
     return result;
 }
 
 size_t GapBuffer::length() const noexcept {
-    return buffer_.size() - (gapEnd_ - gapStart_);
+    if (mapping_) {
+        return mapping_->size();
+    }
+    return capacity_ - (gapEnd_ - gapStart_);
 }
 
 bool GapBuffer::empty() const noexcept {
     return length() == 0;
 }
 
+// =============================================================================
+// Capacity Management
+// =============================================================================
+
+size_t GapBuffer::capacity() const noexcept {
+    return capacity_;
+}
+
+size_t GapBuffer::gapSize() const noexcept {
+    return gapEnd_ - gapStart_;
+}
+
+void GapBuffer::shrinkToFit() {
+    WriteSection section(*this);
+    if (mapping_) {
+        return;  // Nothing is allocated for mapped text
+    }
+    
+    const size_t target = length() + kMinGapSize;
+    if (target < capacity_) {
+        reallocate(target);
+    }
+    linesBeforeGap_.shrink_to_fit();
+    linesAfterGap_.shrink_to_fit();
+}
+
+void GapBuffer::setShrinkPolicy(const ShrinkPolicy& policy) {
+    WriteSection section(*this);
+    shrinkPolicy_ = policy;
+    maybeShrink();
+}
+
+const GapBuffer::ShrinkPolicy& GapBuffer::shrinkPolicy() const noexcept {
+    return shrinkPolicy_;
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+GapBuffer::Segments GapBuffer::segments() const noexcept {
+    if (mapping_) {
+        return Segments{mapping_->view(), {}};
+    }
+    return Segments{
+        std::string_view(buffer_.get(), gapStart_),
+        std::string_view(buffer_.get() + gapEnd_, capacity_ - gapEnd_)
+    };
+}
+
+std::string_view GapBuffer::contiguousView() {
+    if (mapping_) {
+        return mapping_->view();
+    }
+    WriteSection section(*this);
+    moveGapTo(length());
+    return std::string_view(buffer_.get(), gapStart_);
+}
+
+void GapBuffer::visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const {
+    forEachChunk(start, len, fn);
+}
+
+DocumentSnapshot GapBuffer::snapshot() const {
+    if (mapping_) {
+        return DocumentSnapshot({mapping_->view()}, {mapping_}, version_);
+    }
+    
+    // The snapshot owns the text runs; only the gap stays writable. If an
+    // older snapshot still shares the storage, the bytes typed since then
+    // are part of this one and leave the writable range as well.
+    if (isShared()) {
+        cleanStart_ = std::max(cleanStart_, gapStart_);
+        cleanEnd_ = std::max(cleanStart_, std::min(cleanEnd_, gapEnd_));
+    } else {
+        cleanStart_ = gapStart_;
+        cleanEnd_ = gapEnd_;
+    }
+    const Segments segs = segments();
+    return DocumentSnapshot({segs.before, segs.after}, {buffer_}, version_);
+}
+
+uint64_t GapBuffer::version() const noexcept {
+    return version_;
+}
+
+GapBuffer::ConstIterator GapBuffer::begin() const noexcept {
+    return iteratorAt(0);
+}
+
+GapBuffer::ConstIterator GapBuffer::end() const noexcept {
+    return iteratorAt(length());
+}
+
+GapBuffer::ConstIterator GapBuffer::iteratorAt(size_t offset) const noexcept {
+    offset = std::min(offset, length());
+    if (mapping_) {
+        const std::string_view text = mapping_->view();
+        const char* textEnd = text.data() + text.size();
+        return ConstIterator(text.data() + offset, textEnd, textEnd);
+    }
+    const char* base = buffer_.get();
+    const size_t physical = (offset < gapStart_) ? offset : offset + (gapEnd_ - gapStart_);
+    return ConstIterator(base + physical, base + gapStart_, base + gapEnd_);
+}
+
 // =============================================================================
 // Editing Operations
 // =============================================================================
@@ -165,6 +473,13 @@ void GapBuffer::insert(size_t offset, std::string_view text) {
     
     // Clamp offset to valid range
     offset = std::min(offset, length());
+    if (utf8Validation_) {
+        requireValidUtf8(text, "GapBuffer::insert");
+        offset = snapToBoundary(offset, false);
+    }
+    
+    WriteSection section(*this);
+    materialize();
     
     // Ensure we have enough space
     ensureGapCapacity(text.size());
@@ -173,11 +488,10 @@ void GapBuffer::insert(size_t offset, std::string_view text) {
     moveGapTo(offset);
     
     // Insert text into gap
-    std::memcpy(buffer_.data() + gapStart_, text.data(), text.size());
-    gapStart_ += text.size();
+    insertAtGap(text);
     
     // Record the patch
-    recordPatch(offset, 0, text);
+    recordPatch(offset, {}, text);
 }
 
 void GapBuffer::erase(size_t offset, size_t len) {
@@ -189,18 +503,84 @@ void GapBuffer::erase(size_t offset, size_t len) {
     
     // Clamp length to valid range
     len = std::min(len, textLen - offset);
+    if (utf8Validation_) {
+        const size_t end = snapToBoundary(offset + len, true);
+        offset = snapToBoundary(offset, false);
+        len = end - offset;
+    }
     
-    // Get the text being erased for the patch
-    std::string erasedText = getText(offset, len);
+    WriteSection section(*this);
+    materialize();
     
     // Move gap to deletion point
     moveGapTo(offset);
     
-    // Expand gap to cover deleted text
-    gapEnd_ += len;
+    // Expand gap to cover deleted text; the erased bytes stay readable in
+    // the gap until the next insertion
+    const std::string_view erasedText = eraseAfterGap(len);
     
     // Record the patch (with empty inserted text)
-    recordPatch(offset, len, "");
+    recordPatch(offset, erasedText, {});
+    
+    // Large deletions may leave most of the allocation unused
+    maybeShrink();
+}
+
+void GapBuffer::applyPatch(const Patch& patch) {
+    applyEdits({Edit{patch.start, patch.removedLength, patch.insertedText}});
+}
+
+void GapBuffer::applyEdits(const std::vector<Edit>& edits) {
+    const size_t textLen = length();
+    
+    // Clamp, order and validate before touching the buffer
+    std::vector<Edit> sorted = detail::sortedEdits(edits, textLen, "GapBuffer::applyEdits");
+    if (utf8Validation_) {
+        // Snapping can make edits inside one character overlap; check again
+        for (Edit& edit : sorted) {
+            requireValidUtf8(edit.insertedText, "GapBuffer::applyEdits");
+            const size_t start = snapToBoundary(edit.start, false);
+            if (edit.removedLength > 0) {
+                edit.removedLength = snapToBoundary(edit.start + edit.removedLength, true) - start;
+            }
+            edit.start = start;
+        }
+        sorted = detail::sortedEdits(sorted, textLen, "GapBuffer::applyEdits");
+    }
+    
+    // The gap must absorb the largest running surplus of inserted over
+    // removed bytes
+    std::ptrdiff_t surplus = 0;
+    std::ptrdiff_t requiredGap = 0;
+    for (const Edit& edit : sorted) {
+        surplus += static_cast<std::ptrdiff_t>(edit.insertedText.size()) -
+                   static_cast<std::ptrdiff_t>(edit.removedLength);
+        requiredGap = std::max(requiredGap, surplus);
+    }
+    if (sorted.empty()) {
+        return;
+    }
+    WriteSection section(*this);
+    materialize();
+    ensureGapCapacity(static_cast<size_t>(requiredGap));
+    
+    // Single sweep: after reaching the first edit the gap only moves right,
+    // so every byte between edits is moved at most once
+    size_t insertedSoFar = 0;
+    size_t removedSoFar = 0;
+    for (const Edit& edit : sorted) {
+        const size_t position = edit.start + insertedSoFar - removedSoFar;
+        moveGapTo(position);
+        const std::string_view removed = eraseAfterGap(edit.removedLength);
+        recordPatch(position, removed, edit.insertedText);
+        insertAtGap(edit.insertedText);
+        insertedSoFar += edit.insertedText.size();
+        removedSoFar += edit.removedLength;
+    }
+    
+    if (removedSoFar > insertedSoFar) {
+        maybeShrink();
+    }
 }
 
 // =============================================================================
@@ -208,32 +588,24 @@ void GapBuffer::erase(size_t offset, size_t len) {
 // =============================================================================
 
 size_t GapBuffer::lineFromOffset(size_t offset) const {
+    ensureLineIndex();
     const size_t textLen = length();
     offset = std::min(offset, textLen);
     
-    size_t line = 0;
-    size_t pos = 0;
-    
-    // Count newlines in text before gap
-    const size_t beforeGapLen = std::min(offset, gapStart_);
-    for (size_t i = 0; i < beforeGapLen; ++i) {
-        if (buffer_[i] == '\n') {
-            ++line;
-        }
-    }
-    pos = beforeGapLen;
-    
-    // If offset extends past the gap, count newlines after gap
-    if (offset > gapStart_) {
-        const size_t afterGapOffset = gapEnd_ + (offset - gapStart_);
-        for (size_t i = gapEnd_; i < afterGapOffset; ++i) {
-            if (buffer_[i] == '\n') {
-                ++line;
-            }
-        }
+    // Count newlines strictly before offset in the before-gap list
+    if (offset <= gapStart_) {
+        return static_cast<size_t>(
+            std::lower_bound(linesBeforeGap_.begin(), linesBeforeGap_.end(), offset)
+            - linesBeforeGap_.begin());
     }
     
-    return line;
+    // All before-gap newlines count; an after-gap newline at p counts when
+    // p < offset, i.e. when its distance from the end exceeds textLen - offset
+    const size_t keyLimit = textLen - offset;
+    const auto firstAfter = std::upper_bound(
+        linesAfterGap_.begin(), linesAfterGap_.end(), keyLimit);
+    return linesBeforeGap_.size() +
+           static_cast<size_t>(linesAfterGap_.end() - firstAfter);
 }
 
 size_t GapBuffer::offsetFromLine(size_t line, size_t column) const {
@@ -241,25 +613,21 @@ size_t GapBuffer::offsetFromLine(size_t line, size_t column) const {
         return 0;
     }
     
+    ensureLineIndex();
     const size_t textLen = length();
-    size_t currentLine = 0;
     size_t offset = 0;
     
-    // Search before gap
-    for (size_t i = 0; i < gapStart_ && currentLine < line; ++i) {
-        if (buffer_[i] == '\n') {
-            ++currentLine;
-        }
-        ++offset;
-    }
-    
-    // If we haven't found the line yet, search after gap
-    if (currentLine < line) {
-        for (size_t i = gapEnd_; i < buffer_.size() && currentLine < line; ++i) {
-            if (buffer_[i] == '\n') {
-                ++currentLine;
-            }
-            ++offset;
+    if (line > 0) {
+        // Line N starts one past the (N-1)th newline
+        const size_t newlineIndex = line - 1;
+        if (newlineIndex < linesBeforeGap_.size()) {
+            offset = linesBeforeGap_[newlineIndex] + 1;
+        } else if (newlineIndex - linesBeforeGap_.size() < linesAfterGap_.size()) {
+            const size_t fromGap = newlineIndex - linesBeforeGap_.size();
+            const size_t key = linesAfterGap_[linesAfterGap_.size() - 1 - fromGap];
+            offset = textLen - key + 1;
+        } else {
+            offset = textLen;  // Past the last line
         }
     }
     
@@ -271,24 +639,173 @@ size_t GapBuffer::lineCount() const {
     if (empty()) {
         return 0;
     }
+    ensureLineIndex();
     
-    size_t lines = 1;  // At least one line if not empty
-    
-    // Count newlines before gap
-    for (size_t i = 0; i < gapStart_; ++i) {
-        if (buffer_[i] == '\n') {
-            ++lines;
+    // At least one line if not empty, plus one per newline
+    return 1 + linesBeforeGap_.size() + linesAfterGap_.size();
+}
+
+// =============================================================================
+// UTF-16 / Code Point Mapping
+// =============================================================================
+
+size_t GapBuffer::utf16FromOffset(size_t offset) const {
+    ensureUtf16Index();
+    return utf16Index_.utf16FromOffset(*this, offset);
+}
+
+size_t GapBuffer::offsetFromUtf16(size_t utf16Offset) const {
+    ensureUtf16Index();
+    return utf16Index_.offsetFromUtf16(*this, utf16Offset);
+}
+
+size_t GapBuffer::codePointFromOffset(size_t offset) const {
+    ensureUtf16Index();
+    return utf16Index_.codePointFromOffset(*this, offset);
+}
+
+size_t GapBuffer::offsetFromCodePoint(size_t codePoint) const {
+    ensureUtf16Index();
+    return utf16Index_.offsetFromCodePoint(*this, codePoint);
+}
+
+size_t GapBuffer::utf16Length() const {
+    ensureUtf16Index();
+    return utf16Index_.totals().utf16Units;
+}
+
+// =============================================================================
+// Document Statistics
+// =============================================================================
+
+TextStats::Counts GapBuffer::textStats() const {
+    ensureTextStats();
+    return textStats_.totals();
+}
+
+// =============================================================================
+// Search
+// =============================================================================
+
+size_t GapBuffer::findNext(std::string_view pattern, size_t from, bool ignoreAsciiCase) const {
+    return findBefore(pattern, from, length(), ignoreAsciiCase);
+}
+
+std::vector<size_t> GapBuffer::findAll(std::string_view pattern, size_t start, size_t len,
+                                       bool ignoreAsciiCase) const {
+    std::vector<size_t> matches;
+    const size_t textLen = length();
+    if (pattern.empty() || start >= textLen) {
+        return matches;
+    }
+    const size_t end = start + std::min(len, textLen - start);
+    for (size_t match = findBefore(pattern, start, end, ignoreAsciiCase);
+         match != std::string_view::npos;
+         match = findBefore(pattern, match + pattern.size(), end, ignoreAsciiCase)) {
+        matches.push_back(match);
+    }
+    return matches;
+}
+
+size_t GapBuffer::findBefore(std::string_view pattern, size_t from, size_t end,
+                             bool ignoreAsciiCase) const {
+    constexpr size_t npos = std::string_view::npos;
+    end = std::min(end, length());
+    if (pattern.empty() || from >= end || pattern.size() > end - from) {
+        return npos;
+    }
+
+    // Runs clipped to [0, end); a match found in either lies inside it
+    const Segments segs = segments();
+    const std::string_view before = segs.before.substr(0, end);
+    const std::string_view after = segs.after.substr(0, end - before.size());
+    const size_t overlap = pattern.size() - 1;
+
+    // Entirely before the gap
+    if (from < before.size()) {
+        const size_t found = simd::findSubstring(before.substr(from), pattern, ignoreAsciiCase);
+        if (found != npos) {
+            return from + found;
+        }
+
+        // Starting before the gap and ending after it: search the window of
+        // the last and first pattern.size() - 1 bytes of the two runs
+        const size_t windowStart = std::max(from, before.size() - std::min(before.size(), overlap));
+        if (overlap > 0 && !after.empty() && windowStart < before.size()) {
+            std::string window(before.substr(windowStart));
+            window.append(after.substr(0, overlap));
+            const size_t straddle = simd::findSubstring(window, pattern, ignoreAsciiCase);
+            if (straddle != npos && windowStart + straddle < before.size()) {
+                return windowStart + straddle;
+            }
         }
     }
-    
-    // Count newlines after gap
-    for (size_t i = gapEnd_; i < buffer_.size(); ++i) {
-        if (buffer_[i] == '\n') {
-            ++lines;
+
+    // Entirely after the gap
+    const size_t afterFrom = std::max(from, before.size()) - before.size();
+    const size_t found = simd::findSubstring(after.substr(std::min(afterFrom, after.size())),
+                                             pattern, ignoreAsciiCase);
+    return found == npos ? npos : before.size() + afterFrom + found;
+}
+
+// =============================================================================
+// UTF-8 Validation
+// =============================================================================
+
+void GapBuffer::setUtf8Validation(bool enabled) {
+    if (enabled && !utf8Validation_) {
+        requireValidUtf8(contiguousView(), "GapBuffer::setUtf8Validation");
+    }
+    utf8Validation_ = enabled;
+}
+
+bool GapBuffer::utf8Validation() const noexcept {
+    return utf8Validation_;
+}
+
+size_t GapBuffer::snapToBoundary(size_t offset, bool forward) const noexcept {
+    const size_t textLen = length();
+    offset = std::min(offset, textLen);
+    if (offset == textLen) {
+        return offset;
+    }
+    // Valid text has at most three continuation bytes in a row
+    ConstIterator it = iteratorAt(offset);
+    for (int step = 0; step < 3 && simd::isContinuationByte(*it); ++step) {
+        if (forward) {
+            if (++offset == textLen) {
+                break;
+            }
+            ++it;
+        } else {
+            if (offset == 0) {
+                break;
+            }
+            --offset;
+            --it;
         }
     }
-    
-    return lines;
+    return offset;
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+bool GapBuffer::statsEnabled() noexcept {
+#ifdef MD_GAPBUFFER_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+GapBuffer::Stats GapBuffer::stats() const noexcept {
+    return stats_;
+}
+
+void GapBuffer::resetStats() noexcept {
+    stats_ = Stats{};
 }
 
 // =============================================================================
@@ -296,15 +813,115 @@ size_t GapBuffer::lineCount() const {
 // =============================================================================
 
 std::vector<Patch> GapBuffer::flushPatches() {
-    std::vector<Patch> result = std::move(pendingPatches_);
-    pendingPatches_.clear();
-    return result;
+    return pendingPatches_.flush();
+}
+
+void GapBuffer::drainPatches(const PatchVisitor& fn) {
+    pendingPatches_.drain(fn);
 }
 
 bool GapBuffer::hasPendingPatches() const noexcept {
     return !pendingPatches_.empty();
 }
 
+// =============================================================================
+// Concurrent Readers
+// =============================================================================
+
+void GapBuffer::setConcurrentReads(bool enabled) {
+    if (enabled && !concurrent_) {
+        concurrent_ = std::make_unique<ConcurrentState>();
+        publishLayout();
+    } else if (!enabled) {
+        concurrent_.reset();
+    }
+}
+
+bool GapBuffer::concurrentReads() const noexcept {
+    return concurrent_ != nullptr;
+}
+
+template <typename Read>
+auto GapBuffer::readStable(Read&& read) const {
+    ConcurrentState& state = *concurrent_;
+    
+    // Announce the epoch we read in; retry if the writer advanced it
+    // between the load and the announcement
+    uint64_t epoch = state.epoch.load(std::memory_order_seq_cst);
+    for (;;) {
+        state.readers[epoch & 1].fetch_add(1, std::memory_order_seq_cst);
+        const uint64_t current = state.epoch.load(std::memory_order_seq_cst);
+        if (current == epoch) {
+            break;
+        }
+        state.readers[epoch & 1].fetch_sub(1, std::memory_order_seq_cst);
+        epoch = current;
+    }
+    struct Leave {
+        std::atomic<size_t>& readers;
+        ~Leave() { readers.fetch_sub(1, std::memory_order_release); }
+    } leave{state.readers[epoch & 1]};
+    
+    for (;;) {
+        const uint64_t before = state.sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            std::this_thread::yield();  // An edit is in progress
+            continue;
+        }
+        
+        // Validate the layout before using it, so a torn layout is never
+        // dereferenced; the bytes it points to stay allocated (epoch)
+        const Segments segs{
+            std::string_view(state.before.load(std::memory_order_relaxed),
+                             state.beforeSize.load(std::memory_order_relaxed)),
+            std::string_view(state.after.load(std::memory_order_relaxed),
+                             state.afterSize.load(std::memory_order_relaxed))
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (state.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        
+        auto result = read(segs);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (state.sequence.load(std::memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
+
+std::string GapBuffer::readConcurrent(size_t start, size_t len) const {
+    if (!concurrent_) {
+        return getText(start, len);
+    }
+    return readStable([start, len](const Segments& segs) {
+        std::string result;
+        const size_t textLen = segs.before.size() + segs.after.size();
+        if (start >= textLen) {
+            return result;
+        }
+        const size_t end = start + std::min(len, textLen - start);
+        result.reserve(end - start);
+        if (start < segs.before.size()) {
+            result.append(segs.before.substr(start, end - start));
+        }
+        if (end > segs.before.size()) {
+            const size_t from = std::max(start, segs.before.size()) - segs.before.size();
+            result.append(segs.after.substr(from, end - segs.before.size() - from));
+        }
+        return result;
+    });
+}
+
+size_t GapBuffer::lengthConcurrent() const {
+    if (!concurrent_) {
+        return length();
+    }
+    return readStable([](const Segments& segs) {
+        return segs.before.size() + segs.after.size();
+    });
+}
+
 // =============================================================================
 // Internal Implementation
 // =============================================================================
@@ -315,23 +932,41 @@ void GapBuffer::moveGapTo(size_t position) {
     }
     
     const size_t gapSize = gapEnd_ - gapStart_;
+    const size_t textLen = length();
+    MDEDITOR_COUNT(gapMoves, 1);
     
     if (position < gapStart_) {
+        // Newlines in [position, gapStart_) move to the after-gap list
+        while (!linesBeforeGap_.empty() && linesBeforeGap_.back() >= position) {
+            linesAfterGap_.push_back(textLen - linesBeforeGap_.back());
+            linesBeforeGap_.pop_back();
+        }
+        
         // Move gap left: shift text right into the gap
         const size_t shiftSize = gapStart_ - position;
+        MDEDITOR_COUNT(bytesMoved, shiftSize);
+        makeWritable(gapEnd_ - shiftSize, gapEnd_);
         std::memmove(
-            buffer_.data() + gapEnd_ - shiftSize,
-            buffer_.data() + position,
+            buffer_.get() + gapEnd_ - shiftSize,
+            buffer_.get() + position,
             shiftSize
         );
         gapStart_ = position;
         gapEnd_ = position + gapSize;
     } else {
+        // Newlines in [gapStart_, position) move to the before-gap list
+        while (!linesAfterGap_.empty() && textLen - linesAfterGap_.back() < position) {
+            linesBeforeGap_.push_back(textLen - linesAfterGap_.back());
+            linesAfterGap_.pop_back();
+        }
+        
         // Move gap right: shift text left into the gap
         const size_t shiftSize = position - gapStart_;
+        MDEDITOR_COUNT(bytesMoved, shiftSize);
+        makeWritable(gapStart_, position);
         std::memmove(
-            buffer_.data() + gapStart_,
-            buffer_.data() + gapEnd_,
+            buffer_.get() + gapStart_,
+            buffer_.get() + gapEnd_,
             shiftSize
         );
         gapStart_ = position;
@@ -339,6 +974,28 @@ void GapBuffer::moveGapTo(size_t position) {
     }
 }
 
+void GapBuffer::insertAtGap(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    makeWritable(gapStart_, gapStart_ + text.size());
+    std::memcpy(buffer_.get() + gapStart_, text.data(), text.size());
+    indexInsertedLines(gapStart_, text);
+    gapStart_ += text.size();
+}
+
+std::string_view GapBuffer::eraseAfterGap(size_t len) {
+    // Erased newlines sit at the back of the after-gap list (distance from
+    // the old end in (textLen - gapStart_ - len, textLen - gapStart_])
+    const size_t erasedKeyFloor = length() - gapStart_ - len;
+    while (!linesAfterGap_.empty() && linesAfterGap_.back() > erasedKeyFloor) {
+        linesAfterGap_.pop_back();
+    }
+    const std::string_view erased(buffer_.get() + gapEnd_, len);
+    gapEnd_ += len;
+    return erased;
+}
+
 void GapBuffer::ensureGapCapacity(size_t requiredSize) {
     const size_t gapSize = gapEnd_ - gapStart_;
     if (gapSize >= requiredSize) {
@@ -346,7 +1003,7 @@ void GapBuffer::ensureGapCapacity(size_t requiredSize) {
     }
     
     // Calculate new capacity (at least double, or enough for required + min gap)
-    const size_t currentCapacity = buffer_.size();
+    const size_t currentCapacity = capacity_;
     const size_t needed = length() + requiredSize + kMinGapSize;
     const size_t newCapacity = std::max(currentCapacity * 2, needed);
     
@@ -354,50 +1011,202 @@ void GapBuffer::ensureGapCapacity(size_t requiredSize) {
 }
 
 void GapBuffer::grow(size_t minCapacity) {
-    const size_t oldCapacity = buffer_.size();
-    const size_t textAfterGap = oldCapacity - gapEnd_;
-    
-    // Resize buffer
-    buffer_.resize(minCapacity);
+    MDEDITOR_COUNT(grows, 1);
+    reallocate(minCapacity);
+}
+
+void GapBuffer::reallocate(size_t newCapacity) {
+    const size_t textAfterGap = capacity_ - gapEnd_;
     
-    // Move text after gap to end of new buffer
+    // Copy both runs into a fresh allocation; the old one is released
+    // entirely, or left to the snapshots still sharing it
+    std::shared_ptr<char[]> newBuffer = allocateStorage(newCapacity);
+    MDEDITOR_COUNT(bytesAllocated, newCapacity);
+    if (gapStart_ > 0) {
+        std::memcpy(newBuffer.get(), buffer_.get(), gapStart_);
+    }
     if (textAfterGap > 0) {
-        std::memmove(
-            buffer_.data() + minCapacity - textAfterGap,
-            buffer_.data() + gapEnd_,
+        std::memcpy(
+            newBuffer.get() + newCapacity - textAfterGap,
+            buffer_.get() + gapEnd_,
             textAfterGap
         );
     }
+    retire(std::move(buffer_));
+    buffer_ = std::move(newBuffer);
+    capacity_ = newCapacity;
     
     // Update gap end
-    gapEnd_ = minCapacity - textAfterGap;
+    gapEnd_ = newCapacity - textAfterGap;
 }
 
-void GapBuffer::recordPatch(size_t start, size_t removedLength, std::string_view inserted) {
-    // Simple coalescing: if the last patch is adjacent, try to merge
-    if (!pendingPatches_.empty()) {
-        Patch& last = pendingPatches_.back();
-        
-        // Check if this is a consecutive insert at the end of the last patch
-        if (removedLength == 0 && last.removedLength == 0 &&
-            start == last.start + last.insertedText.size()) {
-            last.insertedText.append(inserted);
-            last.timestamp = std::chrono::steady_clock::now();
-            return;
-        }
-        
-        // Check if this is a consecutive delete (backspace) before the last patch
-        if (inserted.empty() && last.insertedText.empty() &&
-            start + removedLength == last.start) {
-            last.start = start;
-            last.removedLength += removedLength;
-            last.timestamp = std::chrono::steady_clock::now();
-            return;
-        }
+bool GapBuffer::isShared() const noexcept {
+    if (buffer_.use_count() > 1) {
+        return true;
+    }
+    // Pairs with the release of the last snapshot's reference, so its reads
+    // happen before our next write
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return false;
+}
+
+void GapBuffer::makeWritable(size_t begin, size_t end) {
+    if (begin >= cleanStart_ && end <= cleanEnd_) {
+        return;  // Inside the gap every snapshot left alone
+    }
+    if (isShared()) {
+        reallocate(capacity_);
+    }
+}
+
+void GapBuffer::retire(std::shared_ptr<const void> storage) {
+    if (concurrent_ && storage) {
+        concurrent_->retired.emplace_back(
+            concurrent_->epoch.load(std::memory_order_relaxed), std::move(storage));
+    }
+}
+
+void GapBuffer::publishLayout() noexcept {
+    ConcurrentState& state = *concurrent_;
+    const Segments segs = segments();
+    state.before.store(segs.before.data(), std::memory_order_relaxed);
+    state.beforeSize.store(segs.before.size(), std::memory_order_relaxed);
+    state.after.store(segs.after.data(), std::memory_order_relaxed);
+    state.afterSize.store(segs.after.size(), std::memory_order_relaxed);
+}
+
+void GapBuffer::reclaimRetired() {
+    ConcurrentState& state = *concurrent_;
+    if (state.retired.empty()) {
+        return;
     }
     
-    // Cannot coalesce; create a new patch
-    pendingPatches_.emplace_back(start, removedLength, inserted);
+    // Readers are only ever in the current or the previous epoch. Once the
+    // previous epoch has no readers, advance; storage retired two epochs
+    // back can no longer be seen by anyone.
+    const uint64_t epoch = state.epoch.load(std::memory_order_relaxed);
+    if (state.readers[(epoch + 1) & 1].load(std::memory_order_seq_cst) == 0) {
+        state.epoch.store(epoch + 1, std::memory_order_seq_cst);
+    }
+    const uint64_t current = state.epoch.load(std::memory_order_relaxed);
+    auto expired = state.retired.begin();
+    while (expired != state.retired.end() && expired->first + 2 <= current) {
+        ++expired;
+    }
+    state.retired.erase(state.retired.begin(), expired);
 }
 
+void GapBuffer::maybeShrink() {
+    const ShrinkPolicy& policy = shrinkPolicy_;
+    const size_t currentCapacity = capacity_;
+    if (!policy.enabled || currentCapacity <= policy.minCapacity) {
+        return;
+    }
+    
+    // Hysteresis: only act once the text uses less than 1/shrinkFactor
+    const size_t textLen = length();
+    if (currentCapacity / std::max<size_t>(policy.shrinkFactor, 1) <= textLen) {
+        return;
+    }
+    
+    const size_t target = std::max(
+        textLen * std::max<size_t>(policy.targetFactor, 1) + kMinGapSize,
+        policy.minCapacity);
+    if (target < currentCapacity) {
+        reallocate(target);
+        linesBeforeGap_.shrink_to_fit();
+        linesAfterGap_.shrink_to_fit();
+    }
+}
+
+void GapBuffer::recordPatch(size_t start, std::string_view removed, std::string_view inserted) {
+    ++version_;
+    if (pendingPatches_.append(start, removed, inserted)) {
+        MDEDITOR_COUNT(patchesCoalesced, 1);
+    } else {
+        MDEDITOR_COUNT(patchesStarted, 1);
+    }
+    utf16Index_.recordEdit(start, removed, inserted);
+    
+    // The gap sits at the edit: its neighbours are the bytes around the gap
+    if (textStats_.valid()) {
+        const int before = start > 0 ? static_cast<unsigned char>(buffer_[start - 1])
+                                     : TextStats::kEdge;
+        const int after = gapEnd_ < capacity_ ? static_cast<unsigned char>(buffer_[gapEnd_])
+                                              : TextStats::kEdge;
+        textStats_.recordEdit(before, removed, inserted, after);
+    }
+}
+
+void GapBuffer::indexInsertedLines(size_t offset, std::string_view text) {
+    MDEDITOR_COUNT(lineScanBytes, text.size());
+    forEachNewline(text, [&](size_t pos) {
+        linesBeforeGap_.push_back(offset + pos);
+    });
+}
+
+void GapBuffer::rebuildLineIndex() const {
+    const Segments segs = segments();
+    
+    // Count first so each list is allocated exactly once
+    MDEDITOR_COUNT(lineScanBytes, 2 * (segs.before.size() + segs.after.size()));
+    linesBeforeGap_.clear();
+    linesAfterGap_.clear();
+    linesBeforeGap_.reserve(simd::countNewlines(segs.before));
+    linesAfterGap_.reserve(simd::countNewlines(segs.after));
+    
+    forEachNewline(segs.before, [&](size_t pos) {
+        linesBeforeGap_.push_back(pos);
+    });
+    
+    // After-gap newlines are stored as distances from the end, ascending,
+    // so collect them front to back and reverse
+    const size_t textLen = length();
+    forEachNewline(segs.after, [&](size_t pos) {
+        linesAfterGap_.push_back(textLen - (segs.before.size() + pos));
+    });
+    std::reverse(linesAfterGap_.begin(), linesAfterGap_.end());
+    lineIndexPending_ = false;
+}
+
+void GapBuffer::ensureLineIndex() const {
+    if (lineIndexPending_) {
+        rebuildLineIndex();
+    }
+}
+
+void GapBuffer::ensureUtf16Index() const {
+    if (!utf16Index_.valid()) {
+        utf16Index_.rebuild(*this);
+    }
+}
+
+void GapBuffer::ensureTextStats() const {
+    if (!textStats_.valid()) {
+        textStats_.rebuild(*this);
+    }
+}
+
+void GapBuffer::materialize() {
+    if (!mapping_) {
+        return;
+    }
+    
+    // Edits maintain the index incrementally, so it must exist first
+    ensureLineIndex();
+    
+    // Copy the mapped text with the gap at the end, matching the index
+    const std::string_view text = mapping_->view();
+    const size_t newCapacity = std::max(text.size() + kMinGapSize, kDefaultCapacity);
+    std::shared_ptr<char[]> newBuffer = allocateStorage(newCapacity);
+    MDEDITOR_COUNT(bytesAllocated, newCapacity);
+    if (!text.empty()) {
+        std::memcpy(newBuffer.get(), text.data(), text.size());
+    }
+    buffer_ = std::move(newBuffer);
+    capacity_ = newCapacity;
+    gapStart_ = text.size();
+    gapEnd_ = newCapacity;
+    retire(std::move(mapping_));
+}
 } // namespace mdeditor
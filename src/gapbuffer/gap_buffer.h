@@ -5,6 +5,7 @@
 // A gap buffer is a dynamic array with a "gap" (unused space) that can be
 // efficiently moved to any position, enabling fast local insertions and
 // deletions. This implementation is optimized for text editing use cases.
+// It is the default IDocumentModel backend (see document_model.h).
 //
 // UTF-8 BYTE OFFSET SEMANTICS:
 // ----------------------------
@@ -13,45 +14,155 @@
 //   - Multi-byte characters (e.g., emoji, non-ASCII) occupy multiple bytes
 //   - Inserting at an arbitrary byte offset may split a multi-byte character
 //   - Callers are responsible for ensuring offsets align to character boundaries
+//     (or enable UTF-8 validation, below)
 //   - Use a UTF-8 library for character-aware operations
 //
+// UTF-8 VALIDATION:
+// -----------------
+// setUtf8Validation(true) keeps the text well-formed UTF-8. Loaded and
+// inserted text is checked with the SIMD validator of utf8_scan.h and
+// rejected with an InvalidUtf8Error that carries the offset of the first bad
+// byte; nothing is modified. Edit offsets that fall inside a character are
+// snapped to its boundaries (insert positions and range starts backwards,
+// range ends forwards), which takes at most three byte reads.
+//
 // LINE MAPPING:
 // -------------
 // Lines are 0-indexed. Line boundaries are detected by '\n' (LF).
 // lineFromOffset returns the line number containing a given byte offset.
 // offsetFromLine returns the byte offset of the start of a given line.
 //
+// Newline positions are kept in a line-start index that mirrors the gap:
+// newlines before the gap are stored as absolute offsets, newlines after the
+// gap as distances from the end of the text. Edits at the gap only push or
+// pop at the back of either list, so the index is maintained from each
+// insert/erase delta. lineCount() is O(1); lineFromOffset() and
+// offsetFromLine() are O(log n) in the number of lines.
+//
+// UTF-16 AND CODE POINT OFFSETS:
+// ------------------------------
+// utf16FromOffset()/offsetFromUtf16() and codePointFromOffset()/
+// offsetFromCodePoint() translate byte offsets for Qt/QML, which count
+// UTF-16 code units. They use a Utf16Index (utf16_index.h) built on the
+// first such query and then updated from each edit's removed and inserted
+// bytes, so both directions are O(log n) and no edit rescans the document.
+//
+// DOCUMENT STATISTICS:
+// --------------------
+// textStats() returns character, word and line counts and reading time for
+// a status bar. A TextStats (text_stats.h) counts the text on the first
+// call; each edit then adjusts it from its bytes and the two bytes around
+// the gap, so live counts cost O(edit size) even on very large documents.
+//
+// SEARCH:
+// -------
+// findNext() and findAll() search the two runs around the gap in place with
+// the kernels of substring_scan.h, so a search copies nothing. A match that
+// straddles the gap is found by searching the pattern-length window around
+// it (at most 2 * (pattern size - 1) bytes, copied). Both can be limited to
+// a byte range, e.g. the visible part of the document while typing into a
+// search field.
+//
+// MEMORY:
+// -------
+// Capacity doubles when the gap runs out. After large deletions (erase,
+// applyEdits, clear, loadFromString) the ShrinkPolicy decides whether to
+// reallocate to a smaller buffer so memory goes back to the allocator/OS;
+// shrinkToFit() does so unconditionally. capacity() and gapSize() expose
+// the current layout.
+//
+// STATISTICS:
+// -----------
+// stats() returns operation counters: gap moves and the bytes they moved,
+// grow() calls, bytes of text storage allocated, patches coalesced or
+// started, and bytes scanned for newlines by the line index. Counting is
+// compiled in only with -D MD_GAPBUFFER_STATS=ON (statsEnabled()); otherwise
+// every counter stays zero and the edit paths carry no extra work. Counters
+// belong to one object: copies and moved-to buffers keep their own.
+//
+// FILE LOADING:
+// -------------
+// loadFromFile() memory-maps the file instead of reading it. Until the first
+// edit, all reads are served from the mapping and nothing is copied; the
+// line index is built on the first line query. The first edit copies the
+// text into the buffer once and releases the mapping. (ChunkedGapBuffer
+// copies only the chunks that are edited.)
+//
+// SNAPSHOTS:
+// ----------
+// snapshot() is O(1): the snapshot shares the buffer and keeps views of the
+// two text runs. While the buffer is shared, the gap as it was at snapshot
+// time stays writable, so typing and backspacing at the cursor copy nothing;
+// the first write that would overwrite bytes a snapshot can see (moving the
+// gap, or outgrowing it) copies the buffer once and edits the copy.
+// Snapshots may be read from other threads while the buffer is edited.
+//
+// CONCURRENT READERS:
+// -------------------
+// With setConcurrentReads(true), readConcurrent() and lengthConcurrent() may
+// be called from any number of other threads while one thread edits, with no
+// lock on either side. Every edit runs inside a seqlock write section: a
+// sequence counter is odd while the edit is in progress, and readers copy
+// the range optimistically and retry if the counter moved. Storage that an
+// edit replaces (growing, shrinking, loading) may still be in use by a
+// reader, so it is retired instead of freed and released by the writer
+// once every reader that could have seen it has finished (epoch-based
+// reclamation: readers announce the epoch they read in, and the writer
+// frees storage retired two epochs ago). Writers never wait for readers.
+// Bytes are copied with plain loads as in any seqlock; a copy that overlapped
+// an edit is discarded, never returned. All other members stay
+// single-threaded. For whole-document work prefer snapshot().
+//
+// ZERO-COPY READS:
+// ----------------
+// segments() exposes the text as the two contiguous runs before and after
+// the gap; forEachChunk() visits an arbitrary range the same way, and
+// ConstIterator walks bytes across the gap. Views and iterators are
+// invalidated by any edit. contiguousView() moves the gap to the end so the
+// whole text can be handed to APIs that need a single contiguous string.
+//
 // =============================================================================
 
 #ifndef MDEDITOR_GAP_BUFFER_H
 #define MDEDITOR_GAP_BUFFER_H
 
-#include <chrono>
+#include "document_model.h"
+#include "patch_log.h"
+#include "text_stats.h"
+#include "utf16_index.h"
+
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace mdeditor {
 
+class MappedFile;
+
 // =============================================================================
-// Patch - Represents a single edit operation
+// InvalidUtf8Error - Rejected input in UTF-8 validation mode
 // =============================================================================
-/// A Patch captures an edit operation for undo/redo, synchronization, or CRDT.
-/// It records what was removed (by length) and what was inserted (by content).
-struct Patch {
-    size_t start;                      ///< Byte offset where the edit occurred
-    size_t removedLength;              ///< Number of bytes removed (0 for pure insert)
-    std::string insertedText;          ///< Text that was inserted (empty for pure delete)
-    std::chrono::steady_clock::time_point timestamp;  ///< When the patch was created
-
-    Patch() : start(0), removedLength(0), timestamp(std::chrono::steady_clock::now()) {}
-    
-    Patch(size_t start_, size_t removedLen, std::string_view inserted)
-        : start(start_)
-        , removedLength(removedLen)
-        , insertedText(inserted)
-        , timestamp(std::chrono::steady_clock::now()) {}
+/// Thrown by a GapBuffer with UTF-8 validation enabled when loaded or
+/// inserted text is not well-formed UTF-8.
+class InvalidUtf8Error : public std::invalid_argument {
+public:
+    InvalidUtf8Error(const std::string& what, size_t offset);
+
+    /// Returns the byte offset of the first invalid sequence, relative to
+    /// the rejected text (the inserted text, or the whole loaded text).
+    [[nodiscard]] size_t offset() const noexcept;
+
+private:
+    size_t offset_;
 };
 
 // =============================================================================
@@ -60,8 +171,40 @@ struct Patch {
 /// GapBuffer implements a gap buffer data structure for efficient text editing.
 /// The buffer maintains a "gap" that can be moved to any position, allowing
 /// O(1) insertions and deletions at the gap position.
-class GapBuffer {
+class GapBuffer : public IDocumentModel {
 public:
+    /// The text as two contiguous runs: before and after the gap.
+    /// Either view may be empty. Invalidated by any edit.
+    struct Segments {
+        std::string_view before;
+        std::string_view after;
+    };
+
+    /// Controls automatic shrinking after text is removed. Uses hysteresis:
+    /// shrinking triggers only once capacity exceeds shrinkFactor * length(),
+    /// and then reallocates to targetFactor * length(), so alternating
+    /// growth and deletion does not reallocate back and forth.
+    struct ShrinkPolicy {
+        bool enabled = true;              ///< Shrink automatically after removals
+        size_t minCapacity = 64 * 1024;   ///< Never shrink automatically below this
+        size_t shrinkFactor = 4;          ///< Shrink when capacity > shrinkFactor * length
+        size_t targetFactor = 2;          ///< Shrink to targetFactor * length (+ min gap)
+    };
+
+    /// Operation counters (see STATISTICS).
+    struct Stats {
+        uint64_t gapMoves = 0;            ///< Edits that had to move the gap
+        uint64_t bytesMoved = 0;          ///< Bytes memmoved by gap moves
+        uint64_t grows = 0;               ///< Gap ran out: grow() calls
+        uint64_t bytesAllocated = 0;      ///< Text storage allocated (grow, shrink, load, copy-on-write)
+        uint64_t patchesCoalesced = 0;    ///< Edits merged into the previous pending patch
+        uint64_t patchesStarted = 0;      ///< Edits that started a new pending patch
+        uint64_t lineScanBytes = 0;       ///< Bytes scanned for newlines by the line index
+    };
+
+    class ConstIterator;
+    using const_iterator = ConstIterator;
+
     // -------------------------------------------------------------------------
     // Construction / Destruction
     // -------------------------------------------------------------------------
@@ -72,11 +215,16 @@ public:
     /// Constructs a GapBuffer with specified initial capacity.
     /// @param initialCapacity Initial buffer size in bytes
     explicit GapBuffer(size_t initialCapacity);
+
+    /// Same, with the upstream resource the pending patch log grows from
+    /// once it outgrows its arena (see PatchLog). Copies use the default.
+    GapBuffer(size_t initialCapacity, std::pmr::memory_resource* patchUpstream);
     
     /// Destructor - releases buffer memory
-    ~GapBuffer() = default;
+    ~GapBuffer() override = default;
     
-    // Rule of five - support move semantics
+    // Rule of five - support move semantics. Copies and moved-to buffers
+    // start with concurrent reads disabled.
     GapBuffer(const GapBuffer& other);
     GapBuffer& operator=(const GapBuffer& other);
     GapBuffer(GapBuffer&& other) noexcept;
@@ -88,10 +236,24 @@ public:
     
     /// Loads content from a string, replacing any existing content.
     /// @param text The text to load into the buffer
-    void loadFromString(std::string_view text);
+    /// @throws InvalidUtf8Error if UTF-8 validation is on and text is not
+    ///         valid UTF-8; the buffer is left unchanged
+    void loadFromString(std::string_view text) override;
+    
+    /// Loads a file by memory-mapping it, replacing any existing content.
+    /// Nothing is copied until the first edit.
+    /// @param path The file to load
+    /// @throws std::runtime_error if the file cannot be opened or mapped;
+    ///         the buffer is left unchanged
+    /// @throws InvalidUtf8Error if UTF-8 validation is on and the file is
+    ///         not valid UTF-8; the buffer is left unchanged
+    void loadFromFile(const std::filesystem::path& path) override;
+    
+    /// Returns true while the text is still served from a file mapping.
+    [[nodiscard]] bool isMapped() const noexcept;
     
     /// Clears all content from the buffer.
-    void clear();
+    void clear() override;
 
     // -------------------------------------------------------------------------
     // Retrieving Content
@@ -99,20 +261,77 @@ public:
     
     /// Returns the entire text content as a string.
     /// @return The complete text in the buffer
-    [[nodiscard]] std::string getText() const;
+    [[nodiscard]] std::string getText() const override;
     
     /// Returns a substring of the text content.
     /// @param start Byte offset to start from
     /// @param len Number of bytes to retrieve
     /// @return The requested substring (clamped to valid range)
-    [[nodiscard]] std::string getText(size_t start, size_t len) const;
+    [[nodiscard]] std::string getText(size_t start, size_t len) const override;
     
     /// Returns the total length of the text in bytes (excluding gap).
     /// @return Text length in bytes
-    [[nodiscard]] size_t length() const noexcept;
+    [[nodiscard]] size_t length() const noexcept override;
     
     /// Returns true if the buffer contains no text.
-    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool empty() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Capacity Management
+    // -------------------------------------------------------------------------
+    
+    /// Returns the allocated buffer size in bytes (text + gap).
+    [[nodiscard]] size_t capacity() const noexcept;
+    
+    /// Returns the current gap size in bytes.
+    [[nodiscard]] size_t gapSize() const noexcept;
+    
+    /// Reallocates to the text length plus a minimal gap, releasing the rest.
+    void shrinkToFit();
+    
+    /// Sets the policy applied after erase/applyEdits/clear/loadFromString.
+    void setShrinkPolicy(const ShrinkPolicy& policy);
+    
+    /// Returns the current shrink policy.
+    [[nodiscard]] const ShrinkPolicy& shrinkPolicy() const noexcept;
+
+    // -------------------------------------------------------------------------
+    // Zero-Copy Access
+    // -------------------------------------------------------------------------
+    
+    /// Returns views of the text before and after the gap (no copy).
+    [[nodiscard]] Segments segments() const noexcept;
+    
+    /// Calls fn(std::string_view) for each contiguous run of a byte range,
+    /// in order: at most two calls, one per side of the gap.
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to visit
+    /// @note Range is clamped like getText(start, len); empty runs are skipped
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+    
+    /// Calls fn for each run of a byte range (forEachChunk for callers that
+    /// only know the IDocumentModel interface).
+    void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override;
+    
+    /// Moves the gap to the end and returns the whole text as one view.
+    /// Costs one memmove of the text after the gap, but no allocation.
+    [[nodiscard]] std::string_view contiguousView() override;
+    
+    /// Returns a snapshot sharing the buffer (or the file mapping while the
+    /// text is still mapped). O(1); see SNAPSHOTS above for when an edit
+    /// copies the buffer.
+    [[nodiscard]] DocumentSnapshot snapshot() const override;
+    
+    /// Returns the document version (see IDocumentModel::version()).
+    [[nodiscard]] uint64_t version() const noexcept override;
+    
+    /// Byte iterators over the text, skipping the gap.
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+    
+    /// Returns an iterator to the byte at offset (clamped to length()).
+    [[nodiscard]] ConstIterator iteratorAt(size_t offset) const noexcept;
 
     // -------------------------------------------------------------------------
     // Editing Operations
@@ -122,13 +341,34 @@ public:
     /// @param offset Byte position to insert at (0 = beginning)
     /// @param text The text to insert
     /// @note Offset is clamped to [0, length()]
-    void insert(size_t offset, std::string_view text);
+    /// @throws InvalidUtf8Error if UTF-8 validation is on and text is not
+    ///         valid UTF-8 (offset snapping: see UTF-8 VALIDATION)
+    void insert(size_t offset, std::string_view text) override;
     
     /// Erases a range of bytes from the buffer.
     /// @param offset Byte position to start erasing
     /// @param len Number of bytes to erase
-    /// @note Range is clamped to valid buffer bounds
-    void erase(size_t offset, size_t len);
+    /// @note Range is clamped to valid buffer bounds (and widened to whole
+    ///       characters with UTF-8 validation on)
+    void erase(size_t offset, size_t len) override;
+    
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText as a single patch.
+    void applyPatch(const Patch& patch) override;
+    
+    /// Applies a batch of non-overlapping edits in one left-to-right pass.
+    /// The buffer grows at most once and every byte is moved at most once,
+    /// so k edits over n bytes cost O(n + inserted bytes) instead of O(k*n).
+    /// One patch per edit is recorded, in application order, with offsets
+    /// adjusted for the edits before it.
+    /// @param edits Edits in pre-batch coordinates, in any order
+    /// @throws std::invalid_argument if two edits overlap (edits sharing a
+    ///         start offset are allowed when at most the last removes text);
+    ///         the buffer is left unchanged
+    /// @throws InvalidUtf8Error if UTF-8 validation is on and an inserted
+    ///         text is not valid UTF-8; the buffer is left unchanged
+    /// @note Offsets and lengths are clamped (and snapped) like insert/erase
+    void applyEdits(const std::vector<Edit>& edits) override;
 
     // -------------------------------------------------------------------------
     // Line/Offset Mapping
@@ -137,18 +377,80 @@ public:
     /// Returns the 0-indexed line number containing the given byte offset.
     /// @param offset Byte offset to query
     /// @return Line number (0-indexed)
-    [[nodiscard]] size_t lineFromOffset(size_t offset) const;
+    /// @note O(log n) in the number of lines
+    [[nodiscard]] size_t lineFromOffset(size_t offset) const override;
     
     /// Returns the byte offset of the start of a line.
     /// @param line 0-indexed line number
     /// @param column Column offset within the line (in bytes)
     /// @return Byte offset of position (line, column)
     /// @note Returns end of buffer if line is past last line
-    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const;
+    /// @note O(log n) in the number of lines
+    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const override;
     
     /// Returns the total number of lines (at least 1 for non-empty buffer).
     /// @return Number of lines
-    [[nodiscard]] size_t lineCount() const;
+    /// @note O(1)
+    [[nodiscard]] size_t lineCount() const override;
+
+    // -------------------------------------------------------------------------
+    // UTF-16 / Code Point Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the UTF-16 code unit offset of a byte offset (clamped).
+    /// @note O(log n); an offset inside a character maps past it
+    [[nodiscard]] size_t utf16FromOffset(size_t offset) const;
+
+    /// Returns the byte offset of a UTF-16 code unit offset (clamped).
+    /// @note O(log n); an offset inside a surrogate pair maps to its start
+    [[nodiscard]] size_t offsetFromUtf16(size_t utf16Offset) const;
+
+    /// Returns the code point index of a byte offset (clamped).
+    [[nodiscard]] size_t codePointFromOffset(size_t offset) const;
+
+    /// Returns the byte offset of a code point index (clamped).
+    [[nodiscard]] size_t offsetFromCodePoint(size_t codePoint) const;
+
+    /// Returns the length of the text in UTF-16 code units.
+    [[nodiscard]] size_t utf16Length() const;
+
+    // -------------------------------------------------------------------------
+    // Document Statistics
+    // -------------------------------------------------------------------------
+
+    /// Returns character, word and line counts of the text.
+    /// @note O(n) on the first call, O(1) after; edits keep them current
+    [[nodiscard]] TextStats::Counts textStats() const;
+
+    // -------------------------------------------------------------------------
+    // Search
+    // -------------------------------------------------------------------------
+
+    /// Returns the offset of the first match of pattern starting at or after
+    /// from, or std::string_view::npos. An empty pattern never matches.
+    /// @param ignoreAsciiCase Match A-Z and a-z as equal
+    [[nodiscard]] size_t findNext(std::string_view pattern, size_t from = 0,
+                                  bool ignoreAsciiCase = false) const;
+
+    /// Returns the offsets of all non-overlapping matches of pattern that lie
+    /// entirely inside [start, start + len), in ascending order.
+    /// @note Range is clamped like getText(start, len)
+    [[nodiscard]] std::vector<size_t> findAll(std::string_view pattern, size_t start = 0,
+                                              size_t len = std::string_view::npos,
+                                              bool ignoreAsciiCase = false) const;
+
+    // -------------------------------------------------------------------------
+    // UTF-8 Validation
+    // -------------------------------------------------------------------------
+
+    /// Enables or disables UTF-8 validation (see UTF-8 VALIDATION).
+    /// Enabling it validates the current text once.
+    /// @throws InvalidUtf8Error if enabling and the current text is not
+    ///         valid UTF-8; validation stays off
+    void setUtf8Validation(bool enabled);
+
+    /// Returns true if UTF-8 validation is enabled.
+    [[nodiscard]] bool utf8Validation() const noexcept;
 
     // -------------------------------------------------------------------------
     // Patch Management
@@ -157,12 +459,66 @@ public:
     /// Returns and clears the accumulated patches since last flush.
     /// Patches are coalesced where possible (adjacent inserts/deletes).
     /// @return Vector of patches representing edits since last flush
-    [[nodiscard]] std::vector<Patch> flushPatches();
+    [[nodiscard]] std::vector<Patch> flushPatches() override;
+    
+    /// Calls fn for each accumulated patch, then clears them (no copies).
+    void drainPatches(const PatchVisitor& fn) override;
     
     /// Returns true if there are unflushed patches.
-    [[nodiscard]] bool hasPendingPatches() const noexcept;
+    [[nodiscard]] bool hasPendingPatches() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Statistics
+    // -------------------------------------------------------------------------
+
+    /// Returns true if this build counts operations (MD_GAPBUFFER_STATS).
+    [[nodiscard]] static bool statsEnabled() noexcept;
+
+    /// Returns the operation counters; all zero unless statsEnabled().
+    [[nodiscard]] Stats stats() const noexcept;
+
+    /// Sets all counters back to zero.
+    void resetStats() noexcept;
+
+    // -------------------------------------------------------------------------
+    // Concurrent Readers
+    // -------------------------------------------------------------------------
+
+    /// Enables or disables lock-free reads from other threads (see
+    /// CONCURRENT READERS). Disabling frees all retired storage.
+    /// @note Call only while no other thread is reading
+    void setConcurrentReads(bool enabled);
+
+    /// Returns true if concurrent reads are enabled.
+    [[nodiscard]] bool concurrentReads() const noexcept;
+
+    /// Copies a byte range (clamped like getText(start, len)). With
+    /// concurrent reads enabled, safe to call from any thread while the
+    /// owning thread edits; retries if an edit intervened, never blocks it.
+    [[nodiscard]] std::string readConcurrent(size_t start, size_t len) const;
+
+    /// Returns length(); thread-safe like readConcurrent().
+    [[nodiscard]] size_t lengthConcurrent() const;
 
 private:
+    /// Seqlock and epoch state for concurrent readers. Readers only touch
+    /// the atomics; retired is owned by the writer.
+    struct ConcurrentState {
+        std::atomic<uint64_t> sequence{0};         ///< Odd while an edit is in progress
+        std::atomic<const char*> before{nullptr};  ///< Published segments()
+        std::atomic<size_t> beforeSize{0};
+        std::atomic<const char*> after{nullptr};
+        std::atomic<size_t> afterSize{0};
+        std::atomic<uint64_t> epoch{0};          ///< Advanced only by the writer
+        std::atomic<size_t> readers[2] = {};     ///< Active readers per epoch parity
+        /// Replaced storage with the epoch it was retired in
+        std::vector<std::pair<uint64_t, std::shared_ptr<const void>>> retired;
+    };
+
+    /// Brackets an edit: makes the sequence odd, then publishes the new
+    /// layout and reclaims retired storage. Nested sections are no-ops.
+    class WriteSection;
+
     // -------------------------------------------------------------------------
     // Internal Implementation
     // -------------------------------------------------------------------------
@@ -176,20 +532,204 @@ private:
     /// Grows the buffer capacity
     void grow(size_t minCapacity);
     
+    /// Moves the text into a new allocation of newCapacity bytes
+    void reallocate(size_t newCapacity);
+    
+    /// Shrinks the allocation if the shrink policy says so
+    void maybeShrink();
+    
+    /// Copies text into the gap at gapStart_ (capacity already ensured)
+    void insertAtGap(std::string_view text);
+    
+    /// Removes len bytes directly after the gap by widening it.
+    /// @return View of the removed bytes (valid until the next insertion)
+    std::string_view eraseAfterGap(size_t len);
+    
     /// Records a patch for the edit history
-    void recordPatch(size_t start, size_t removedLength, std::string_view inserted);
+    void recordPatch(size_t start, std::string_view removed, std::string_view inserted);
+
+    /// Adds the newlines of text inserted at offset (gap already at offset)
+    void indexInsertedLines(size_t offset, std::string_view text);
+
+    /// Rebuilds the line-start index from the current content
+    void rebuildLineIndex() const;
+    
+    /// Builds the line-start index if it was deferred by loadFromFile()
+    void ensureLineIndex() const;
+    
+    /// findNext() limited to matches that end at or before end
+    [[nodiscard]] size_t findBefore(std::string_view pattern, size_t from, size_t end,
+                                    bool ignoreAsciiCase) const;
+
+    /// Moves offset (clamped) off a continuation byte: back to the lead
+    /// byte, or forward past the character if forward is set
+    [[nodiscard]] size_t snapToBoundary(size_t offset, bool forward) const noexcept;
+
+    /// Builds the UTF-16 index on first use
+    void ensureUtf16Index() const;
+
+    /// Counts the text for textStats() on first use
+    void ensureTextStats() const;
+
+    /// Copies mapped text into the buffer so it can be edited
+    void materialize();
+
+    /// Returns true if a snapshot still shares buffer_
+    [[nodiscard]] bool isShared() const noexcept;
+
+    /// Copies the buffer before bytes [begin, end) are written if a snapshot
+    /// can see them
+    void makeWritable(size_t begin, size_t end);
+
+    /// Keeps replaced storage alive for concurrent readers (no-op otherwise)
+    void retire(std::shared_ptr<const void> storage);
+
+    /// Stores the current layout for concurrent readers
+    void publishLayout() noexcept;
+
+    /// Advances the epoch if possible and frees storage no reader can see
+    void reclaimRetired();
+
+    /// Calls read(Segments) on a consistent published layout from any
+    /// thread, retrying until no edit intervened
+    template <typename Read>
+    auto readStable(Read&& read) const;
 
     // Buffer layout: [text before gap][...gap...][text after gap]
-    std::vector<char> buffer_;    ///< The underlying buffer
+    std::shared_ptr<char[]> buffer_;  ///< The underlying buffer, shared with snapshots
+    size_t capacity_;             ///< Size of buffer_ in bytes
     size_t gapStart_;             ///< Start index of the gap
     size_t gapEnd_;               ///< End index of the gap (one past last gap byte)
     
-    std::vector<Patch> pendingPatches_;  ///< Unflushed edit patches
+    PatchLog pendingPatches_;            ///< Unflushed edit patches
+    ShrinkPolicy shrinkPolicy_;          ///< When to give memory back
+    
+    /// Unedited file text (loadFromFile); buffer_ holds no text while set.
+    /// Shared so copies of a mapped buffer stay cheap.
+    std::shared_ptr<const MappedFile> mapping_;
+    uint64_t version_ = 0;               ///< Bumped by every edit and load
+
+    // Line-start index: [newlines before gap][newlines after gap]
+    // Both lists grow towards the gap, so edits only touch their back.
+    // Mutable only so a deferred index can be built by a const query.
+    mutable std::vector<size_t> linesBeforeGap_;  ///< Offsets of '\n' before the gap (ascending)
+    mutable std::vector<size_t> linesAfterGap_;   ///< length() - offset of '\n' after the gap (ascending)
+    mutable bool lineIndexPending_ = false;       ///< Index not built yet (mapped file)
+
+    /// Byte/UTF-16/code point index; built by the first query, then kept
+    /// current by recordPatch(). Mutable like the line index.
+    mutable Utf16Index utf16Index_;
+    /// Document statistics; built and kept current like utf16Index_
+    mutable TextStats textStats_;
+    bool utf8Validation_ = false;        ///< Reject invalid UTF-8, snap offsets
+    mutable Stats stats_;                ///< Counted only with MD_GAPBUFFER_STATS
+
+    // Writable part of buffer_ while snapshots share it: the intersection of
+    // the gaps at the time each snapshot was taken. Set by snapshot().
+    mutable size_t cleanStart_ = 0;
+    mutable size_t cleanEnd_ = 0;
+
+    /// Set while concurrent reads are enabled
+    std::unique_ptr<ConcurrentState> concurrent_;
     
     static constexpr size_t kDefaultCapacity = 4096;
     static constexpr size_t kMinGapSize = 256;
 };
 
+// =============================================================================
+// GapBuffer::ConstIterator - Bidirectional byte iterator across the gap
+// =============================================================================
+/// Points directly into the buffer and jumps over the gap when stepping, so
+/// dereferencing is a plain load. Invalidated by any edit.
+class GapBuffer::ConstIterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char*;
+    using reference = const char&;
+
+    ConstIterator() = default;
+
+    reference operator*() const noexcept { return *pos_; }
+    pointer operator->() const noexcept { return pos_; }
+
+    ConstIterator& operator++() noexcept {
+        if (++pos_ == gapBegin_) {
+            pos_ = gapEnd_;
+        }
+        return *this;
+    }
+
+    ConstIterator operator++(int) noexcept {
+        ConstIterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    ConstIterator& operator--() noexcept {
+        if (pos_ == gapEnd_) {
+            pos_ = gapBegin_;
+        }
+        --pos_;
+        return *this;
+    }
+
+    ConstIterator operator--(int) noexcept {
+        ConstIterator copy = *this;
+        --*this;
+        return copy;
+    }
+
+    friend bool operator==(const ConstIterator& a, const ConstIterator& b) noexcept {
+        return a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const ConstIterator& a, const ConstIterator& b) noexcept {
+        return a.pos_ != b.pos_;
+    }
+
+private:
+    friend class GapBuffer;
+
+    // The logical position at the gap is always represented by gapEnd
+    ConstIterator(const char* pos, const char* gapBegin, const char* gapEnd) noexcept
+        : pos_(pos == gapBegin ? gapEnd : pos)
+        , gapBegin_(gapBegin)
+        , gapEnd_(gapEnd) {}
+
+    const char* pos_ = nullptr;
+    const char* gapBegin_ = nullptr;
+    const char* gapEnd_ = nullptr;
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void GapBuffer::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    const size_t textLen = length();
+    if (start >= textLen) {
+        return;
+    }
+    len = std::min(len, textLen - start);
+    const Segments segs = segments();
+    
+    // Part of the range before the gap
+    if (start < segs.before.size() && len > 0) {
+        const size_t beforeLen = std::min(len, segs.before.size() - start);
+        fn(segs.before.substr(start, beforeLen));
+        start += beforeLen;
+        len -= beforeLen;
+    }
+    
+    // Part of the range after the gap
+    if (len > 0) {
+        fn(segs.after.substr(start - segs.before.size(), len));
+    }
+}
+
 } // namespace mdeditor
 
 #endif // MDEDITOR_GAP_BUFFER_H
@@ -0,0 +1,150 @@
+// =============================================================================
+// mapped_file.cpp - Read-Only Memory-Mapped File Implementation
+// =============================================================================
+
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mdeditor {
+
+namespace {
+
+[[noreturn]] void throwMapError(const char* what, const std::filesystem::path& path) {
+    throw std::runtime_error(std::string(what) + ": " + path.string());
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Construction / Destruction
+// =============================================================================
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throwMapError("Cannot open file", path);
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throwMapError("Cannot read file size", path);
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+
+    // Zero-length files cannot be mapped; they simply have an empty view
+    if (size_ > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            throwMapError("Cannot map file", path);
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);  // The view keeps the mapping alive
+        if (view == nullptr) {
+            throwMapError("Cannot map file", path);
+        }
+        data_ = static_cast<const char*>(view);
+    } else {
+        CloseHandle(file);
+    }
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throwMapError("Cannot open file", path);
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throwMapError("Cannot read file size", path);
+    }
+    size_ = static_cast<size_t>(info.st_size);
+
+    // Zero-length files cannot be mapped; they simply have an empty view
+    if (size_ > 0) {
+        void* view = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps the file referenced
+        if (view == MAP_FAILED) {
+            throwMapError("Cannot map file", path);
+        }
+        data_ = static_cast<const char*>(view);
+    } else {
+        ::close(fd);
+    }
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_)
+    , size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+// =============================================================================
+// Access
+// =============================================================================
+
+std::string_view MappedFile::view() const noexcept {
+    return std::string_view(data_, size_);
+}
+
+size_t MappedFile::size() const noexcept {
+    return size_;
+}
+
+} // namespace mdeditor
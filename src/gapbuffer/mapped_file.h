@@ -0,0 +1,57 @@
+// =============================================================================
+// mapped_file.h - Read-Only Memory-Mapped File
+// =============================================================================
+//
+// MappedFile maps a whole file read-only into memory and exposes it as a
+// std::string_view. Pages are read lazily by the OS on first access, so
+// opening even a multi-gigabyte file costs almost no time or resident
+// memory until its contents are actually touched.
+//
+// The mapping reflects the file on disk: if another process truncates the
+// file while it is mapped, reading past the new end faults. Text stores
+// therefore copy the regions they edit and keep the mapping only for
+// unedited text.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_MAPPED_FILE_H
+#define MDEDITOR_MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace mdeditor {
+
+/// RAII owner of a read-only file mapping.
+class MappedFile {
+public:
+    /// Maps the file at path.
+    /// @throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::filesystem::path& path);
+
+    /// Unmaps the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /// Returns the file contents (empty for an empty file).
+    [[nodiscard]] std::string_view view() const noexcept;
+
+    /// Returns the file size in bytes.
+    [[nodiscard]] size_t size() const noexcept;
+
+private:
+    /// Releases the mapping, if any
+    void unmap() noexcept;
+
+    const char* data_ = nullptr;  ///< Start of the mapping (nullptr if empty)
+    size_t size_ = 0;             ///< Mapped bytes
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_MAPPED_FILE_H
@@ -0,0 +1,620 @@
+// =============================================================================
+// multi_gap_buffer.cpp - Gap Buffer with Several Gaps Implementation
+// =============================================================================
+
+#include "multi_gap_buffer.h"
+#include "edit_helpers.h"
+#include "mapped_file.h"
+#include "newline_scan.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+namespace mdeditor {
+
+namespace {
+
+/// Allocates uninitialized storage; gap bytes are never read
+std::shared_ptr<char[]> allocateStorage(size_t capacity) {
+    return std::shared_ptr<char[]>(new char[capacity]);
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+MultiGapBuffer::MultiGapBuffer(size_t gapCount)
+    : gapCount_(std::clamp<size_t>(gapCount, 1, kMaxGapCount)) {}
+
+MultiGapBuffer::MultiGapBuffer(const MultiGapBuffer& other)
+    : capacity_(other.capacity_)
+    , length_(other.length_)
+    , gapCount_(other.gapCount_)
+    , gaps_(other.gaps_)
+    , useCounter_(other.useCounter_)
+    , runLines_(other.runLines_)
+    , newlines_(other.newlines_)
+    , pendingPatches_(other.pendingPatches_)
+    , version_(other.version_) {
+    // Same layout, text runs only
+    if (other.buffer_) {
+        buffer_ = allocateStorage(capacity_);
+        for (size_t run = 0; run < runLines_.size(); ++run) {
+            std::memcpy(buffer_.get() + runBegin(run), other.buffer_.get() + runBegin(run),
+                        runEnd(run) - runBegin(run));
+        }
+    }
+}
+
+MultiGapBuffer& MultiGapBuffer::operator=(const MultiGapBuffer& other) {
+    if (this != &other) {
+        MultiGapBuffer copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+MultiGapBuffer::MultiGapBuffer(MultiGapBuffer&& other) noexcept
+    : buffer_(std::move(other.buffer_))
+    , capacity_(other.capacity_)
+    , length_(other.length_)
+    , gapCount_(other.gapCount_)
+    , gaps_(std::move(other.gaps_))
+    , useCounter_(other.useCounter_)
+    , runLines_(std::move(other.runLines_))
+    , newlines_(other.newlines_)
+    , pendingPatches_(std::move(other.pendingPatches_))
+    , version_(other.version_)
+    , clean_(std::move(other.clean_)) {
+    other.clear();
+}
+
+MultiGapBuffer& MultiGapBuffer::operator=(MultiGapBuffer&& other) noexcept {
+    if (this != &other) {
+        buffer_ = std::move(other.buffer_);
+        capacity_ = other.capacity_;
+        length_ = other.length_;
+        gapCount_ = other.gapCount_;
+        gaps_ = std::move(other.gaps_);
+        useCounter_ = other.useCounter_;
+        runLines_ = std::move(other.runLines_);
+        newlines_ = other.newlines_;
+        pendingPatches_ = std::move(other.pendingPatches_);
+        version_ = other.version_;
+        flat_.clear();
+        clean_ = std::move(other.clean_);
+        other.clear();
+    }
+    return *this;
+}
+
+// =============================================================================
+// Loading Content
+// =============================================================================
+
+void MultiGapBuffer::loadFromString(std::string_view text) {
+    clear();
+    if (text.empty()) {
+        return;
+    }
+
+    ensureLayout();
+    capacity_ = text.size() + gaps_.size() * kMinGapSize;
+    buffer_ = allocateStorage(capacity_);
+    std::memcpy(buffer_.get(), text.data(), text.size());
+    length_ = text.size();
+
+    // All gaps after the text, in one run
+    size_t position = text.size();
+    for (Gap& gap : gaps_) {
+        gap.start = position;
+        position += kMinGapSize;
+        gap.end = position;
+    }
+
+    std::deque<size_t>& lines = runLines_.front();
+    simd::forEachNewline(text, [&](size_t pos) {
+        lines.push_back(pos);
+    });
+    newlines_ = lines.size();
+}
+
+void MultiGapBuffer::loadFromFile(const std::filesystem::path& path) {
+    // Map first so a failure leaves the buffer untouched
+    const MappedFile file(path);
+    loadFromString(file.view());
+}
+
+void MultiGapBuffer::clear() {
+    buffer_.reset();
+    capacity_ = 0;
+    length_ = 0;
+    gaps_.clear();
+    useCounter_ = 0;
+    runLines_.clear();
+    newlines_ = 0;
+    pendingPatches_.clear();
+    ++version_;
+    removed_.clear();
+    std::string().swap(flat_);
+    clean_.clear();
+}
+
+// =============================================================================
+// Retrieving Content
+// =============================================================================
+
+std::string MultiGapBuffer::getText() const {
+    return getText(0, length_);
+}
+
+std::string MultiGapBuffer::getText(size_t start, size_t len) const {
+    std::string result;
+    if (start < length_) {
+        result.reserve(std::min(len, length_ - start));
+    }
+    forEachChunk(start, len, [&](std::string_view run) {
+        result.append(run);
+    });
+    return result;
+}
+
+size_t MultiGapBuffer::length() const noexcept {
+    return length_;
+}
+
+bool MultiGapBuffer::empty() const noexcept {
+    return length_ == 0;
+}
+
+// =============================================================================
+// Gaps and Capacity
+// =============================================================================
+
+size_t MultiGapBuffer::gapCount() const noexcept {
+    return gapCount_;
+}
+
+std::vector<size_t> MultiGapBuffer::gapOffsets() const {
+    std::vector<size_t> offsets(gapCount_, 0);
+    for (size_t i = 0; i < gaps_.size(); ++i) {
+        offsets[i] = gapOffset(i);
+    }
+    return offsets;
+}
+
+size_t MultiGapBuffer::capacity() const noexcept {
+    return capacity_;
+}
+
+void MultiGapBuffer::shrinkToFit() {
+    if (!gaps_.empty()) {
+        reallocate(std::vector<size_t>(gaps_.size(), kMinGapSize));
+    }
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+void MultiGapBuffer::visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const {
+    forEachChunk(start, len, fn);
+}
+
+std::string_view MultiGapBuffer::contiguousView() {
+    size_t runs = 0;
+    std::string_view last;
+    forEachChunk(0, length_, [&](std::string_view run) {
+        ++runs;
+        last = run;
+    });
+    if (runs <= 1) {
+        return last;
+    }
+
+    // Moving every gap to the end would also give up the edit sites
+    flat_.clear();
+    flat_.reserve(length_);
+    forEachChunk(0, length_, [&](std::string_view run) {
+        flat_.append(run);
+    });
+    return flat_;
+}
+
+DocumentSnapshot MultiGapBuffer::snapshot() const {
+    // Only bytes inside the gaps of every live snapshot may still be written
+    if (isShared()) {
+        std::vector<std::pair<size_t, size_t>> still;
+        for (const auto& [begin, end] : clean_) {
+            for (const Gap& gap : gaps_) {
+                const size_t from = std::max(begin, gap.start);
+                const size_t to = std::min(end, gap.end);
+                if (from < to) {
+                    still.emplace_back(from, to);
+                }
+            }
+        }
+        clean_ = std::move(still);
+    } else {
+        clean_.clear();
+        for (const Gap& gap : gaps_) {
+            clean_.emplace_back(gap.start, gap.end);
+        }
+    }
+
+    std::vector<std::string_view> runs;
+    runs.reserve(runLines_.size());
+    forEachChunk(0, length_, [&](std::string_view run) {
+        runs.push_back(run);
+    });
+    return DocumentSnapshot(std::move(runs), {buffer_}, version_);
+}
+
+uint64_t MultiGapBuffer::version() const noexcept {
+    return version_;
+}
+
+// =============================================================================
+// Editing Operations
+// =============================================================================
+
+void MultiGapBuffer::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, length_);
+
+    ensureLayout();
+    insertAtGap(gapFor(offset), text);
+    ++version_;
+    pendingPatches_.append(offset, {}, text);
+}
+
+void MultiGapBuffer::erase(size_t offset, size_t len) {
+    if (offset >= length_ || len == 0) {
+        return;
+    }
+    len = std::min(len, length_ - offset);
+
+    removed_.clear();
+    eraseAfterGap(gapFor(offset), len);
+    ++version_;
+    pendingPatches_.append(offset, removed_, {});
+}
+
+void MultiGapBuffer::applyPatch(const Patch& patch) {
+    applyEdits({Edit{patch.start, patch.removedLength, patch.insertedText}});
+}
+
+void MultiGapBuffer::applyEdits(const std::vector<Edit>& edits) {
+    // Clamp, order and validate before touching the buffer
+    const std::vector<Edit> sorted =
+        detail::sortedEdits(edits, length_, "MultiGapBuffer::applyEdits");
+    if (sorted.empty()) {
+        return;
+    }
+
+    // One gap walks the batch left to right, as GapBuffer's single gap would
+    ensureLayout();
+    size_t gap = gapFor(sorted.front().start);
+    size_t insertedSoFar = 0;
+    size_t removedSoFar = 0;
+    for (const Edit& edit : sorted) {
+        const size_t position = edit.start + insertedSoFar - removedSoFar;
+        gap = relocateGap(gap, position);
+        removed_.clear();
+        gap = eraseAfterGap(gap, edit.removedLength);
+        insertAtGap(gap, edit.insertedText);
+        ++version_;
+        pendingPatches_.append(position, removed_, edit.insertedText);
+        insertedSoFar += edit.insertedText.size();
+        removedSoFar += edit.removedLength;
+    }
+}
+
+// =============================================================================
+// Line/Offset Mapping
+// =============================================================================
+
+size_t MultiGapBuffer::lineFromOffset(size_t offset) const {
+    offset = std::min(offset, length_);
+
+    // Count newlines strictly before offset
+    size_t line = 0;
+    size_t position = 0;
+    for (size_t run = 0; run < runLines_.size(); ++run) {
+        const std::deque<size_t>& lines = runLines_[run];
+        const size_t size = runEnd(run) - runBegin(run);
+        if (offset < position + size || run + 1 == runLines_.size()) {
+            const size_t physical = runBegin(run) + (offset - position);
+            return line + static_cast<size_t>(
+                std::lower_bound(lines.begin(), lines.end(), physical) - lines.begin());
+        }
+        line += lines.size();
+        position += size;
+    }
+    return line;
+}
+
+size_t MultiGapBuffer::offsetFromLine(size_t line, size_t column) const {
+    size_t offset = length_;  // Past the last line
+
+    if (line == 0) {
+        offset = 0;
+    } else {
+        // Line N starts one past the (N-1)th newline
+        size_t remaining = line - 1;
+        size_t position = 0;
+        for (size_t run = 0; run < runLines_.size(); ++run) {
+            const std::deque<size_t>& lines = runLines_[run];
+            if (remaining < lines.size()) {
+                offset = position + (lines[remaining] - runBegin(run)) + 1;
+                break;
+            }
+            remaining -= lines.size();
+            position += runEnd(run) - runBegin(run);
+        }
+    }
+
+    // Add column offset (clamped to text length)
+    return std::min(offset + column, length_);
+}
+
+size_t MultiGapBuffer::lineCount() const {
+    if (empty()) {
+        return 0;
+    }
+    return 1 + newlines_;
+}
+
+// =============================================================================
+// Patch Management
+// =============================================================================
+
+std::vector<Patch> MultiGapBuffer::flushPatches() {
+    return pendingPatches_.flush();
+}
+
+void MultiGapBuffer::drainPatches(const PatchVisitor& fn) {
+    pendingPatches_.drain(fn);
+}
+
+bool MultiGapBuffer::hasPendingPatches() const noexcept {
+    return !pendingPatches_.empty();
+}
+
+// =============================================================================
+// Internal Implementation
+// =============================================================================
+
+size_t MultiGapBuffer::runBegin(size_t index) const noexcept {
+    return index == 0 ? 0 : gaps_[index - 1].end;
+}
+
+size_t MultiGapBuffer::runEnd(size_t index) const noexcept {
+    return index < gaps_.size() ? gaps_[index].start : capacity_;
+}
+
+size_t MultiGapBuffer::gapOffset(size_t index) const noexcept {
+    size_t offset = gaps_[index].start;
+    for (size_t i = 0; i < index; ++i) {
+        offset -= gaps_[i].size();
+    }
+    return offset;
+}
+
+void MultiGapBuffer::ensureLayout() {
+    if (gaps_.empty()) {
+        gaps_.assign(gapCount_, Gap{});
+        runLines_.assign(gapCount_ + 1, {});
+    }
+}
+
+size_t MultiGapBuffer::gapFor(size_t offset) {
+    ++useCounter_;
+
+    std::array<size_t, kMaxGapCount> distance{};
+    size_t chosen = 0;
+    for (size_t i = 0; i < gaps_.size(); ++i) {
+        const size_t position = gapOffset(i);
+        distance[i] = position > offset ? position - offset : offset - position;
+        if (distance[i] < distance[chosen]) {
+            chosen = i;
+        }
+    }
+
+    // Too far from every gap: a new site takes the least recently used gap
+    // (the nearest of those never used, at first)
+    if (distance[chosen] > kSiteDistance) {
+        for (size_t i = 0; i < gaps_.size(); ++i) {
+            if (gaps_[i].lastUse < gaps_[chosen].lastUse ||
+                (gaps_[i].lastUse == gaps_[chosen].lastUse && distance[i] < distance[chosen])) {
+                chosen = i;
+            }
+        }
+    }
+
+    chosen = relocateGap(chosen, offset);
+    gaps_[chosen].lastUse = useCounter_;
+    return chosen;
+}
+
+size_t MultiGapBuffer::relocateGap(size_t index, size_t offset) {
+    // Step over the gaps in the way: close up to each, then trade places
+    while (index + 1 < gaps_.size() && offset > gapOffset(index + 1)) {
+        shiftGap(index, gapOffset(index + 1));
+        swapAdjacentGaps(index);
+        ++index;
+    }
+    while (index > 0 && offset < gapOffset(index - 1)) {
+        shiftGap(index, gapOffset(index - 1));
+        swapAdjacentGaps(index - 1);
+        --index;
+    }
+    shiftGap(index, offset);
+    return index;
+}
+
+void MultiGapBuffer::shiftGap(size_t index, size_t offset) {
+    const size_t position = gapOffset(index);
+    if (offset == position) {
+        return;
+    }
+
+    std::deque<size_t>& before = runLines_[index];
+    std::deque<size_t>& after = runLines_[index + 1];
+    if (offset < position) {
+        // Text before the gap moves to its end
+        const size_t count = position - offset;
+        makeWritable(gaps_[index].end - count, gaps_[index].end);
+        Gap& gap = gaps_[index];
+        std::memmove(buffer_.get() + gap.end - count, buffer_.get() + gap.start - count, count);
+        while (!before.empty() && before.back() >= gap.start - count) {
+            after.push_front(before.back() + gap.size());
+            before.pop_back();
+        }
+        gap.start -= count;
+        gap.end -= count;
+    } else {
+        // Text after the gap moves to its start
+        const size_t count = offset - position;
+        makeWritable(gaps_[index].start, gaps_[index].start + count);
+        Gap& gap = gaps_[index];
+        std::memmove(buffer_.get() + gap.start, buffer_.get() + gap.end, count);
+        while (!after.empty() && after.front() < gap.end + count) {
+            before.push_back(after.front() - gap.size());
+            after.pop_front();
+        }
+        gap.start += count;
+        gap.end += count;
+    }
+}
+
+void MultiGapBuffer::swapAdjacentGaps(size_t index) noexcept {
+    // The run between the two is empty, so only the boundaries change
+    Gap& first = gaps_[index];
+    Gap& second = gaps_[index + 1];
+    const Gap moving = first;
+    first = Gap{moving.start, moving.start + second.size(), second.lastUse};
+    second = Gap{first.end, first.end + moving.size(), moving.lastUse};
+}
+
+size_t MultiGapBuffer::eraseAfterGap(size_t index, size_t len) {
+    while (len > 0) {
+        const size_t available = runEnd(index + 1) - gaps_[index].end;
+        if (available == 0) {
+            // The next gap follows directly: carry on behind it
+            swapAdjacentGaps(index);
+            ++index;
+            continue;
+        }
+
+        Gap& gap = gaps_[index];
+        const size_t take = std::min(len, available);
+        removed_.append(buffer_.get() + gap.end, take);
+        std::deque<size_t>& after = runLines_[index + 1];
+        while (!after.empty() && after.front() < gap.end + take) {
+            after.pop_front();
+            --newlines_;
+        }
+        gap.end += take;
+        length_ -= take;
+        len -= take;
+    }
+    return index;
+}
+
+void MultiGapBuffer::insertAtGap(size_t index, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    if (gaps_[index].size() < text.size()) {
+        grow(index, text.size());
+    }
+    makeWritable(gaps_[index].start, gaps_[index].start + text.size());
+
+    Gap& gap = gaps_[index];
+    std::memcpy(buffer_.get() + gap.start, text.data(), text.size());
+    std::deque<size_t>& before = runLines_[index];
+    simd::forEachNewline(text, [&](size_t pos) {
+        before.push_back(gap.start + pos);
+        ++newlines_;
+    });
+    gap.start += text.size();
+    length_ += text.size();
+}
+
+void MultiGapBuffer::grow(size_t index, size_t needed) {
+    // Free space about the text size: half for this gap, half for the rest
+    const size_t spare = std::max(length_, kMinGapSize * gaps_.size());
+    const size_t others = gaps_.size() - 1;
+    std::vector<size_t> sizes(gaps_.size(), others > 0 ? spare / 2 / others : 0);
+    sizes[index] = needed + (others > 0 ? spare / 2 : spare);
+    reallocate(sizes);
+}
+
+void MultiGapBuffer::reallocate(const std::vector<size_t>& gapSizes) {
+    size_t newCapacity = length_;
+    for (size_t size : gapSizes) {
+        newCapacity += size;
+    }
+
+    // Copy the runs into a fresh allocation; the old one is released
+    // entirely, or left to the snapshots still sharing it
+    std::shared_ptr<char[]> storage = allocateStorage(newCapacity);
+    const std::vector<Gap> old = gaps_;
+    size_t position = 0;
+    for (size_t run = 0; run < runLines_.size(); ++run) {
+        const size_t begin = run == 0 ? 0 : old[run - 1].end;
+        const size_t end = run < old.size() ? old[run].start : capacity_;
+        if (end > begin) {
+            std::memcpy(storage.get() + position, buffer_.get() + begin, end - begin);
+        }
+        for (size_t& line : runLines_[run]) {
+            line = line - begin + position;
+        }
+        position += end - begin;
+
+        if (run < gaps_.size()) {
+            gaps_[run].start = position;
+            position += gapSizes[run];
+            gaps_[run].end = position;
+        }
+    }
+
+    buffer_ = std::move(storage);
+    capacity_ = newCapacity;
+    clean_.clear();
+}
+
+void MultiGapBuffer::makeWritable(size_t begin, size_t end) {
+    for (const auto& [cleanBegin, cleanEnd] : clean_) {
+        if (begin >= cleanBegin && end <= cleanEnd) {
+            return;  // Inside a gap every snapshot left alone
+        }
+    }
+    if (isShared()) {
+        std::vector<size_t> sizes;
+        sizes.reserve(gaps_.size());
+        for (const Gap& gap : gaps_) {
+            sizes.push_back(gap.size());
+        }
+        reallocate(sizes);
+    }
+}
+
+bool MultiGapBuffer::isShared() const noexcept {
+    if (buffer_.use_count() > 1) {
+        return true;
+    }
+    // Pairs with the release of the last snapshot's reference, so its reads
+    // happen before our next write
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return false;
+}
+
+} // namespace mdeditor
@@ -0,0 +1,343 @@
+// =============================================================================
+// multi_gap_buffer.h - Gap Buffer with Several Gaps
+// =============================================================================
+//
+// MultiGapBuffer is a gap buffer that keeps a small number of gaps (2-8,
+// default kDefaultGapCount) in one allocation instead of one:
+//
+//   [text][gap 0][text][gap 1][text] ... [gap k-1][text]
+//
+// With a single gap, alternating edits in two distant places (a heading at
+// the top and notes at the bottom, or two split views) move the gap across
+// all the text between them on every switch. Here each place keeps a gap of
+// its own, so switching between up to gapCount() places moves nothing.
+//
+// EDIT SITES:
+// -----------
+// An edit within kSiteDistance bytes of a gap uses that gap: it moves the
+// gap over at most kSiteDistance bytes, like a single gap would. An edit
+// further away from every gap starts a new site and takes the least
+// recently used gap; gaps that were never used are taken first. Moving a
+// gap past another gap shifts the text between them and leaves the other
+// gap's position unchanged, so a reassignment costs what one move of a
+// single gap would, once, instead of on every switch.
+//
+// MEMORY:
+// -------
+// Gaps start at kMinGapSize bytes each. When a gap runs out, the buffer is
+// reallocated with free space about the size of the text: half of it goes
+// to the gap being written, the rest is shared by the others. Erased bytes
+// widen a gap and are kept; shrinkToFit() gives them back.
+//
+// LINE MAPPING:
+// -------------
+// The newline positions of each run of text between two gaps are kept in a
+// deque, as physical buffer positions. Edits at a gap push or pop at the
+// ends of its two neighbouring runs, and moving a gap transfers the
+// newlines of the bytes it moves, so the index never needs a rescan.
+// lineCount() is O(1); lineFromOffset() and offsetFromLine() are
+// O(gapCount() + log n).
+//
+// SNAPSHOTS:
+// ----------
+// snapshot() is O(gapCount()): it shares the buffer and views the runs.
+// While shared, writes into the gaps as they were at snapshot time need no
+// copy; the first write to a byte a snapshot can see copies the buffer
+// once. Copies of the whole buffer get their own storage, as with GapBuffer.
+//
+// Offsets, line semantics and patches are exactly those of GapBuffer; see
+// gap_buffer.h.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_MULTI_GAP_BUFFER_H
+#define MDEDITOR_MULTI_GAP_BUFFER_H
+
+#include "document_model.h"
+#include "patch_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mdeditor {
+
+// =============================================================================
+// MultiGapBuffer - Gap buffer with one gap per edit site
+// =============================================================================
+/// MultiGapBuffer keeps several gaps in one buffer and assigns them to edit
+/// sites least recently used first, so alternating edits in distant places
+/// do not move the text between them.
+class MultiGapBuffer : public IDocumentModel {
+public:
+    /// Number of gaps of a default-constructed buffer.
+    static constexpr size_t kDefaultGapCount = 4;
+
+    /// Largest supported number of gaps.
+    static constexpr size_t kMaxGapCount = 8;
+
+    /// Edits this close to a gap (in bytes) reuse it instead of starting a
+    /// new site.
+    static constexpr size_t kSiteDistance = 16 * 1024;
+
+    /// Initial size of each gap.
+    static constexpr size_t kMinGapSize = 256;
+
+    // -------------------------------------------------------------------------
+    // Construction / Destruction
+    // -------------------------------------------------------------------------
+
+    /// Constructs an empty buffer with gapCount gaps (clamped to
+    /// [1, kMaxGapCount]). Nothing is allocated until text arrives.
+    explicit MultiGapBuffer(size_t gapCount = kDefaultGapCount);
+
+    ~MultiGapBuffer() override = default;
+
+    /// Copies get their own storage (both would write into the same gaps
+    /// otherwise). A moved-from buffer is empty.
+    MultiGapBuffer(const MultiGapBuffer& other);
+    MultiGapBuffer& operator=(const MultiGapBuffer& other);
+    MultiGapBuffer(MultiGapBuffer&& other) noexcept;
+    MultiGapBuffer& operator=(MultiGapBuffer&& other) noexcept;
+
+    // -------------------------------------------------------------------------
+    // Loading Content
+    // -------------------------------------------------------------------------
+
+    /// Loads content from a string, replacing any existing content. All
+    /// gaps start at the end of the text.
+    /// @param text The text to load into the buffer
+    void loadFromString(std::string_view text) override;
+
+    /// Loads a file, replacing any existing content.
+    /// @param path The file to load
+    /// @throws std::runtime_error if the file cannot be opened or mapped;
+    ///         the buffer is left unchanged
+    void loadFromFile(const std::filesystem::path& path) override;
+
+    /// Clears all content from the buffer and releases the storage.
+    void clear() override;
+
+    // -------------------------------------------------------------------------
+    // Retrieving Content
+    // -------------------------------------------------------------------------
+
+    /// Returns the entire text content as a string.
+    [[nodiscard]] std::string getText() const override;
+
+    /// Returns a substring of the text content.
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to retrieve
+    /// @return The requested substring (clamped to valid range)
+    [[nodiscard]] std::string getText(size_t start, size_t len) const override;
+
+    /// Returns the total length of the text in bytes (excluding gaps).
+    [[nodiscard]] size_t length() const noexcept override;
+
+    /// Returns true if the buffer contains no text.
+    [[nodiscard]] bool empty() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Gaps and Capacity
+    // -------------------------------------------------------------------------
+
+    /// Returns the number of gaps.
+    [[nodiscard]] size_t gapCount() const noexcept;
+
+    /// Returns the text offset of each gap, in text order.
+    [[nodiscard]] std::vector<size_t> gapOffsets() const;
+
+    /// Returns the allocated buffer size in bytes (text + gaps).
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    /// Reallocates to the text length plus kMinGapSize per gap.
+    void shrinkToFit();
+
+    // -------------------------------------------------------------------------
+    // Zero-Copy Access
+    // -------------------------------------------------------------------------
+
+    /// Calls fn(std::string_view) for each contiguous run of a byte range,
+    /// in order (at most gapCount() + 1 runs).
+    /// @note Range is clamped like getText(start, len); empty runs are skipped
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+
+    /// forEachChunk() behind the IDocumentModel interface.
+    void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override;
+
+    /// Returns the whole text as one view. Zero-copy while all text sits in
+    /// one run; otherwise copies it into an internal string that stays valid
+    /// until the next edit or call. The gaps stay where they are.
+    [[nodiscard]] std::string_view contiguousView() override;
+
+    /// Returns a snapshot sharing the buffer (O(gapCount())).
+    [[nodiscard]] DocumentSnapshot snapshot() const override;
+
+    /// Returns the document version (see IDocumentModel::version()).
+    [[nodiscard]] uint64_t version() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Editing Operations
+    // -------------------------------------------------------------------------
+
+    /// Inserts text at the specified byte offset.
+    /// @note Offset is clamped to [0, length()]
+    void insert(size_t offset, std::string_view text) override;
+
+    /// Erases a range of bytes from the buffer.
+    /// @note Range is clamped to valid buffer bounds
+    void erase(size_t offset, size_t len) override;
+
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText as a single patch.
+    void applyPatch(const Patch& patch) override;
+
+    /// Applies a batch of non-overlapping edits, left to right, with the
+    /// same contract as IDocumentModel::applyEdits. The whole batch uses one
+    /// gap, so k edits over n bytes move at most n bytes.
+    /// @throws std::invalid_argument if two edits overlap; the buffer is
+    ///         left unchanged
+    void applyEdits(const std::vector<Edit>& edits) override;
+
+    // -------------------------------------------------------------------------
+    // Line/Offset Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the 0-indexed line number containing the given byte offset.
+    /// @note O(gapCount() + log n)
+    [[nodiscard]] size_t lineFromOffset(size_t offset) const override;
+
+    /// Returns the byte offset of position (line, column).
+    /// @note Returns end of buffer if line is past last line
+    /// @note O(gapCount())
+    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const override;
+
+    /// Returns the total number of lines (at least 1 for non-empty buffer).
+    /// @note O(1)
+    [[nodiscard]] size_t lineCount() const override;
+
+    // -------------------------------------------------------------------------
+    // Patch Management
+    // -------------------------------------------------------------------------
+
+    /// Returns and clears the accumulated patches since last flush.
+    [[nodiscard]] std::vector<Patch> flushPatches() override;
+
+    /// Calls fn for each accumulated patch, then clears them (no copies).
+    void drainPatches(const PatchVisitor& fn) override;
+
+    /// Returns true if there are unflushed patches.
+    [[nodiscard]] bool hasPendingPatches() const noexcept override;
+
+private:
+    /// One gap: a physical byte range of buffer_
+    struct Gap {
+        size_t start = 0;
+        size_t end = 0;
+        uint64_t lastUse = 0;        ///< Edit counter at the last use; 0 never used
+
+        [[nodiscard]] size_t size() const noexcept { return end - start; }
+    };
+
+    /// Physical start of run index (the text before gap index)
+    [[nodiscard]] size_t runBegin(size_t index) const noexcept;
+
+    /// Physical end of run index
+    [[nodiscard]] size_t runEnd(size_t index) const noexcept;
+
+    /// Text offset of gap index
+    [[nodiscard]] size_t gapOffset(size_t index) const noexcept;
+
+    /// Creates the gaps and runs on first use (the buffer allocates lazily)
+    void ensureLayout();
+
+    /// Picks the gap for an edit at offset (see EDIT SITES) and moves it
+    /// there; returns its index
+    size_t gapFor(size_t offset);
+
+    /// Moves gap index to offset, past other gaps if needed; returns its
+    /// new index
+    size_t relocateGap(size_t index, size_t offset);
+
+    /// Moves gap index to offset between its neighbouring gaps
+    void shiftGap(size_t index, size_t offset);
+
+    /// Exchanges gap index with the physically adjacent gap index + 1
+    void swapAdjacentGaps(size_t index) noexcept;
+
+    /// Erases len bytes after gap index by widening it, appending them to
+    /// removed_; returns the gap's index
+    size_t eraseAfterGap(size_t index, size_t len);
+
+    /// Copies text into gap index, growing the buffer if needed
+    void insertAtGap(size_t index, std::string_view text);
+
+    /// Reallocates so gap index holds at least needed bytes
+    void grow(size_t index, size_t needed);
+
+    /// Copies the text into a new buffer with the given gap sizes
+    void reallocate(const std::vector<size_t>& gapSizes);
+
+    /// Copies the buffer before bytes [begin, end) are written if a snapshot
+    /// can see them
+    void makeWritable(size_t begin, size_t end);
+
+    /// Returns true if a snapshot still shares buffer_
+    [[nodiscard]] bool isShared() const noexcept;
+
+    std::shared_ptr<char[]> buffer_;     ///< Runs and gaps, shared with snapshots
+    size_t capacity_ = 0;                ///< Size of buffer_ in bytes
+    size_t length_ = 0;                  ///< Total text bytes
+    size_t gapCount_ = kDefaultGapCount;
+    std::vector<Gap> gaps_;              ///< In buffer order; empty until text arrives
+    uint64_t useCounter_ = 0;            ///< Advanced by every gapFor()
+
+    /// Physical positions of '\n' in each run (gaps_.size() + 1 runs)
+    std::vector<std::deque<size_t>> runLines_;
+    size_t newlines_ = 0;                ///< Total '\n' count
+
+    PatchLog pendingPatches_;            ///< Unflushed edit patches
+    uint64_t version_ = 0;               ///< Bumped by every edit and clear
+    std::string removed_;                ///< Bytes removed by the current edit
+    std::string flat_;                   ///< Backing store for contiguousView()
+
+    // Writable parts of buffer_ while snapshots share it: the gaps every
+    // snapshot was taken with. Set by snapshot().
+    mutable std::vector<std::pair<size_t, size_t>> clean_;
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void MultiGapBuffer::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    if (start >= length_) {
+        return;
+    }
+    len = std::min(len, length_ - start);
+
+    for (size_t run = 0; run < runLines_.size() && len > 0; ++run) {
+        const size_t size = runEnd(run) - runBegin(run);
+        if (start >= size) {
+            start -= size;
+            continue;
+        }
+        const size_t take = std::min(len, size - start);
+        fn(std::string_view(buffer_.get() + runBegin(run) + start, take));
+        len -= take;
+        start = 0;
+    }
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_MULTI_GAP_BUFFER_H
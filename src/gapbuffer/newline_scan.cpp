@@ -0,0 +1,357 @@
+// =============================================================================
+// newline_scan.cpp - Vectorized Newline Scanning Kernels Implementation
+// =============================================================================
+//
+// The SIMD variants are compiled with per-function target attributes so the
+// library itself does not require -mavx2 / -mavx512bw; the CPU is checked at
+// runtime before any of them is called.
+//
+// =============================================================================
+
+#include "newline_scan.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MDEDITOR_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MDEDITOR_TARGET(features)
+#else
+#include <cpuid.h>
+#define MDEDITOR_TARGET(features) __attribute__((target(features)))
+#endif
+#else
+#define MDEDITOR_SIMD_X86 0
+#endif
+
+namespace mdeditor {
+namespace simd {
+
+namespace {
+
+constexpr size_t kNotFound = std::string_view::npos;
+
+// =============================================================================
+// Scalar kernels
+// =============================================================================
+
+size_t countScalar(const char* data, size_t len) noexcept {
+    size_t count = 0;
+    for (size_t i = 0; i < len; ++i) {
+        count += (data[i] == '\n');
+    }
+    return count;
+}
+
+size_t findNthScalar(const char* data, size_t len, size_t n) noexcept {
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') {
+            if (n == 0) {
+                return i;
+            }
+            --n;
+        }
+    }
+    return kNotFound;
+}
+
+#if MDEDITOR_SIMD_X86
+
+// =============================================================================
+// Bit helpers
+// =============================================================================
+
+inline unsigned popcount64(uint64_t value) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned>((value * 0x0101010101010101ULL) >> 56);
+#else
+    return static_cast<unsigned>(__builtin_popcountll(value));
+#endif
+}
+
+inline unsigned countTrailingZeros64(uint64_t value) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+/// Returns the bit index of the nth set bit; requires n < popcount(mask).
+inline unsigned nthSetBit(uint64_t mask, size_t n) noexcept {
+    for (; n > 0; --n) {
+        mask &= mask - 1;
+    }
+    return countTrailingZeros64(mask);
+}
+
+/// Finishes a findNth scan in the scalar tail starting at offset.
+inline size_t findNthTail(const char* data, size_t len, size_t offset, size_t n) noexcept {
+    const size_t found = findNthScalar(data + offset, len - offset, n);
+    return found == kNotFound ? kNotFound : offset + found;
+}
+
+// =============================================================================
+// SSE2 kernels (x86-64 baseline)
+// =============================================================================
+
+size_t countSse2(const char* data, size_t len) noexcept {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (len - i >= 16) {
+        // Byte counters overflow after 255 blocks; fold them with SAD first
+        const size_t blocks = std::min<size_t>((len - i) / 16, 255);
+        __m128i counters = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, newline));
+        }
+        const __m128i sums = _mm_sad_epu8(counters, zero);
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+
+    return count + countScalar(data + i, len - i);
+}
+
+size_t findNthSse2(const char* data, size_t len, size_t n) noexcept {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; len - i >= 16; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const auto mask = static_cast<uint64_t>(
+            static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline))));
+        if (mask != 0) {
+            const unsigned found = popcount64(mask);
+            if (n < found) {
+                return i + nthSetBit(mask, n);
+            }
+            n -= found;
+        }
+    }
+
+    return findNthTail(data, len, i, n);
+}
+
+// =============================================================================
+// AVX2 kernels
+// =============================================================================
+
+MDEDITOR_TARGET("avx2,popcnt")
+size_t countAvx2(const char* data, size_t len) noexcept {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (len - i >= 32) {
+        const size_t blocks = std::min<size_t>((len - i) / 32, 255);
+        __m256i counters = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, newline));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_sad_epu8(counters, zero));
+        count += static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+
+    return count + countSse2(data + i, len - i);
+}
+
+MDEDITOR_TARGET("avx2,popcnt")
+size_t findNthAvx2(const char* data, size_t len, size_t n) noexcept {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; len - i >= 32; i += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const auto mask = static_cast<uint64_t>(
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline))));
+        if (mask != 0) {
+            const unsigned found = popcount64(mask);
+            if (n < found) {
+                return i + nthSetBit(mask, n);
+            }
+            n -= found;
+        }
+    }
+
+    const size_t found = findNthSse2(data + i, len - i, n);
+    return found == kNotFound ? kNotFound : i + found;
+}
+
+// =============================================================================
+// AVX-512BW kernels
+// =============================================================================
+
+MDEDITOR_TARGET("avx512f,avx512bw,popcnt")
+size_t countAvx512(const char* data, size_t len) noexcept {
+    const __m512i newline = _mm512_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; len - i >= 64; i += 64) {
+        const __m512i chunk = _mm512_loadu_si512(data + i);
+        count += popcount64(_mm512_cmpeq_epi8_mask(chunk, newline));
+    }
+
+    return count + countAvx2(data + i, len - i);
+}
+
+MDEDITOR_TARGET("avx512f,avx512bw,popcnt")
+size_t findNthAvx512(const char* data, size_t len, size_t n) noexcept {
+    const __m512i newline = _mm512_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; len - i >= 64; i += 64) {
+        const __m512i chunk = _mm512_loadu_si512(data + i);
+        const uint64_t mask = _mm512_cmpeq_epi8_mask(chunk, newline);
+        if (mask != 0) {
+            const unsigned found = popcount64(mask);
+            if (n < found) {
+                return i + nthSetBit(mask, n);
+            }
+            n -= found;
+        }
+    }
+
+    const size_t found = findNthAvx2(data + i, len - i, n);
+    return found == kNotFound ? kNotFound : i + found;
+}
+
+// =============================================================================
+// CPU detection
+// =============================================================================
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int r = 0; r < 4; ++r) {
+        regs[r] = static_cast<uint32_t>(info[r]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t readXcr0() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+Level detectCpuLevel() noexcept {
+    uint32_t regs[4] = {};
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    if (!osxsave || maxLeaf < 7) {
+        return Level::SSE2;
+    }
+
+    // The OS must save YMM (and for AVX-512, opmask/ZMM) state on switches
+    const uint64_t xcr0 = readXcr0();
+    const bool ymmEnabled = (xcr0 & 0x06) == 0x06;
+    const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(7, 0, regs);
+    const bool avx2 = (regs[1] & (1u << 5)) != 0;
+    const bool avx512f = (regs[1] & (1u << 16)) != 0;
+    const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+
+    if (zmmEnabled && avx512f && avx512bw) {
+        return Level::AVX512;
+    }
+    if (ymmEnabled && avx2) {
+        return Level::AVX2;
+    }
+    return Level::SSE2;
+}
+
+#else  // !MDEDITOR_SIMD_X86
+
+Level detectCpuLevel() noexcept {
+    return Level::Scalar;
+}
+
+#endif // MDEDITOR_SIMD_X86
+
+/// Clamps a requested level to what the CPU supports.
+Level clampLevel(Level level) noexcept {
+    return std::min(level, detectedLevel());
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+Level detectedLevel() noexcept {
+    static const Level level = detectCpuLevel();
+    return level;
+}
+
+const char* levelName(Level level) noexcept {
+    switch (level) {
+        case Level::Scalar: return "Scalar";
+        case Level::SSE2:   return "SSE2";
+        case Level::AVX2:   return "AVX2";
+        case Level::AVX512: return "AVX512";
+    }
+    return "Unknown";
+}
+
+size_t countNewlines(std::string_view text) noexcept {
+    return countNewlines(text, detectedLevel());
+}
+
+size_t countNewlines(std::string_view text, Level level) noexcept {
+    switch (clampLevel(level)) {
+#if MDEDITOR_SIMD_X86
+        case Level::AVX512: return countAvx512(text.data(), text.size());
+        case Level::AVX2:   return countAvx2(text.data(), text.size());
+        case Level::SSE2:   return countSse2(text.data(), text.size());
+#endif
+        default:            return countScalar(text.data(), text.size());
+    }
+}
+
+size_t findNthNewline(std::string_view text, size_t n) noexcept {
+    return findNthNewline(text, n, detectedLevel());
+}
+
+size_t findNthNewline(std::string_view text, size_t n, Level level) noexcept {
+    switch (clampLevel(level)) {
+#if MDEDITOR_SIMD_X86
+        case Level::AVX512: return findNthAvx512(text.data(), text.size(), n);
+        case Level::AVX2:   return findNthAvx2(text.data(), text.size(), n);
+        case Level::SSE2:   return findNthSse2(text.data(), text.size(), n);
+#endif
+        default:            return findNthScalar(text.data(), text.size(), n);
+    }
+}
+
+} // namespace simd
+} // namespace mdeditor
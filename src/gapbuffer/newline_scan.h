@@ -0,0 +1,70 @@
+// =============================================================================
+// newline_scan.h - Vectorized Newline Scanning Kernels
+// =============================================================================
+//
+// Small kernel layer for the two scans the text model needs: counting '\n'
+// bytes in a range and locating the Nth '\n'. Each kernel has a scalar
+// implementation plus SSE2, AVX2 and AVX-512BW variants on x86-64.
+//
+// DISPATCH:
+// ---------
+// The widest instruction set supported by the running CPU is detected once
+// (via cpuid) on first use. SSE2 is the x86-64 baseline; other architectures
+// always use the scalar kernels. Callers can also request a specific level,
+// which is clamped to what the CPU supports (used by tests and benchmarks).
+//
+// =============================================================================
+
+#ifndef MDEDITOR_NEWLINE_SCAN_H
+#define MDEDITOR_NEWLINE_SCAN_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace mdeditor {
+namespace simd {
+
+/// Instruction set used by a kernel, from narrowest to widest.
+enum class Level {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+/// Returns the widest level supported by the running CPU.
+[[nodiscard]] Level detectedLevel() noexcept;
+
+/// Returns a printable name for a level (e.g., "AVX2").
+[[nodiscard]] const char* levelName(Level level) noexcept;
+
+/// Counts '\n' bytes in text using the detected level.
+[[nodiscard]] size_t countNewlines(std::string_view text) noexcept;
+
+/// Counts '\n' bytes in text using the given level (clamped to the CPU).
+[[nodiscard]] size_t countNewlines(std::string_view text, Level level) noexcept;
+
+/// Returns the index of the nth '\n' (0-indexed) in text, using the
+/// detected level, or std::string_view::npos if text has n or fewer newlines.
+[[nodiscard]] size_t findNthNewline(std::string_view text, size_t n) noexcept;
+
+/// Same as findNthNewline(text, n) using the given level (clamped to the CPU).
+[[nodiscard]] size_t findNthNewline(std::string_view text, size_t n, Level level) noexcept;
+
+/// Calls fn(index) for each '\n' in text, in ascending order.
+template <typename Fn>
+void forEachNewline(std::string_view text, Fn&& fn) {
+    size_t base = 0;
+    size_t pos = findNthNewline(text, 0);
+    while (pos != std::string_view::npos) {
+        fn(base + pos);
+        base += pos + 1;
+        text.remove_prefix(pos + 1);
+        pos = findNthNewline(text, 0);
+    }
+}
+
+} // namespace simd
+} // namespace mdeditor
+
+#endif // MDEDITOR_NEWLINE_SCAN_H
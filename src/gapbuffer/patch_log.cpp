@@ -0,0 +1,211 @@
+// =============================================================================
+// patch_log.cpp - Arena-Backed Pending Patch Log Implementation
+// =============================================================================
+
+#include "patch_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory_resource>
+
+namespace mdeditor {
+
+namespace {
+
+/// Initial side buffer sizes; together with the records they fit the
+/// arena's initial block
+constexpr size_t kInitialRecords = 64;
+constexpr size_t kInitialInserted = 4 * 1024;
+constexpr size_t kInitialRemoved = 4 * 1024;
+
+std::chrono::steady_clock::rep now() noexcept {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Arena
+// =============================================================================
+
+/// The arena's initial block, the resource carving it up, and the log's
+/// containers. Never moved: the resource points into the block.
+struct PatchLog::Arena {
+    alignas(std::max_align_t) std::byte block[kArenaSize];
+    std::pmr::monotonic_buffer_resource resource;
+    std::pmr::vector<Record> records{&resource};
+    std::pmr::vector<char> inserted{&resource};   ///< Grows at the end
+    char* removed = nullptr;                       ///< Bytes fill [end - removedSize, end)
+    size_t removedCapacity = 0;
+    size_t removedSize = 0;
+
+    explicit Arena(std::pmr::memory_resource* upstream)
+        : resource(block, sizeof(block), upstream) {
+        reserve();
+    }
+
+    /// Sizes the containers for a typical flush interval
+    void reserve() {
+        records.reserve(kInitialRecords);
+        inserted.reserve(kInitialInserted);
+        removed = static_cast<char*>(resource.allocate(kInitialRemoved, 1));
+        removedCapacity = kInitialRemoved;
+    }
+
+    /// Drops the contents and rewinds the resource to the initial block
+    void rewind() noexcept {
+        // The containers must let go of arena memory before it is released
+        std::pmr::vector<Record>(&resource).swap(records);
+        std::pmr::vector<char>(&resource).swap(inserted);
+        removed = nullptr;
+        removedCapacity = 0;
+        removedSize = 0;
+        resource.release();
+        reserve();
+    }
+
+    [[nodiscard]] const char* removedEnd() const noexcept {
+        return removed + removedCapacity;
+    }
+};
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+PatchLog::PatchLog() = default;
+
+PatchLog::~PatchLog() = default;
+
+PatchLog::PatchLog(std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {}
+
+PatchLog::PatchLog(const PatchLog& other) {
+    *this = other;
+}
+
+PatchLog& PatchLog::operator=(const PatchLog& other) {
+    if (this != &other) {
+        clear();
+        // Re-append record by record; appended copies never coalesce
+        // because the source already merged everything mergeable
+        other.forEach([this](const PatchView& patch) {
+            append(patch.start, patch.removedText, patch.insertedText);
+            arena_->records.back().timestamp = patch.timestamp.time_since_epoch().count();
+        });
+    }
+    return *this;
+}
+
+PatchLog::PatchLog(PatchLog&& other) noexcept = default;
+
+PatchLog& PatchLog::operator=(PatchLog&& other) noexcept = default;
+
+// =============================================================================
+// Recording
+// =============================================================================
+
+bool PatchLog::append(size_t start, std::string_view removed, std::string_view inserted) {
+    if (!arena_) {
+        arena_ = std::make_unique<Arena>(upstream_);
+    }
+    Arena& arena = *arena_;
+
+    if (!arena.records.empty()) {
+        Record& last = arena.records.back();
+
+        // Consecutive insert at the end of the last patch; its bytes are the
+        // tail of the inserted buffer
+        if (removed.empty() && last.removedLength == 0 &&
+            start == last.start + last.insertedLength) {
+            arena.inserted.insert(arena.inserted.end(), inserted.begin(), inserted.end());
+            last.insertedLength += inserted.size();
+            last.timestamp = now();
+            return true;
+        }
+
+        // Consecutive delete (backspace) before the last patch; its bytes
+        // are the front of the removed buffer
+        if (inserted.empty() && last.insertedLength == 0 &&
+            start + removed.size() == last.start) {
+            prependRemoved(removed);
+            last.start = start;
+            last.removedFront = arena.removedSize;
+            last.removedLength += removed.size();
+            last.timestamp = now();
+            return true;
+        }
+    }
+
+    // Cannot coalesce; create a new patch
+    const size_t insertedOffset = arena.inserted.size();
+    arena.inserted.insert(arena.inserted.end(), inserted.begin(), inserted.end());
+    prependRemoved(removed);
+    arena.records.push_back(Record{start, insertedOffset, inserted.size(),
+                                   arena.removedSize, removed.size(), now()});
+    return false;
+}
+
+void PatchLog::prependRemoved(std::string_view removed) {
+    Arena& arena = *arena_;
+    if (removed.empty()) {
+        return;
+    }
+    if (arena.removedCapacity - arena.removedSize < removed.size()) {
+        // Move the bytes to the end of a larger block; records address them
+        // from the end, so they stay valid
+        const size_t capacity = std::max(arena.removedCapacity * 2,
+                                         arena.removedSize + removed.size());
+        char* block = static_cast<char*>(arena.resource.allocate(capacity, 1));
+        std::memcpy(block + capacity - arena.removedSize,
+                    arena.removedEnd() - arena.removedSize, arena.removedSize);
+        arena.removed = block;
+        arena.removedCapacity = capacity;
+    }
+    arena.removedSize += removed.size();
+    std::memcpy(arena.removed + arena.removedCapacity - arena.removedSize,
+                removed.data(), removed.size());
+}
+
+// =============================================================================
+// Reading
+// =============================================================================
+
+bool PatchLog::empty() const noexcept {
+    return !arena_ || arena_->records.empty();
+}
+
+size_t PatchLog::size() const noexcept {
+    return arena_ ? arena_->records.size() : 0;
+}
+
+PatchView PatchLog::at(size_t index) const noexcept {
+    const Arena& arena = *arena_;
+    const Record& record = arena.records[index];
+    return PatchView{
+        record.start,
+        record.removedLength,
+        std::string_view(arena.inserted.data() + record.insertedOffset, record.insertedLength),
+        std::string_view(arena.removedEnd() - record.removedFront, record.removedLength),
+        std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(record.timestamp))
+    };
+}
+
+std::vector<Patch> PatchLog::flush() {
+    std::vector<Patch> patches;
+    patches.reserve(size());
+    drain([&patches](const PatchView& view) {
+        patches.emplace_back(view.start, view.removedText, view.insertedText);
+        patches.back().timestamp = view.timestamp;
+    });
+    return patches;
+}
+
+void PatchLog::clear() noexcept {
+    if (arena_ && !arena_->records.empty()) {
+        arena_->rewind();
+    }
+}
+
+} // namespace mdeditor
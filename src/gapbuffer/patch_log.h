@@ -0,0 +1,140 @@
+// =============================================================================
+// patch_log.h - Arena-Backed Pending Patch Log
+// =============================================================================
+//
+// PatchLog holds the patches a document model has recorded since the last
+// flush. It replaces a std::vector<Patch>, where every keystroke allocated
+// a Patch with its own strings and coalescing reallocated them.
+//
+// LAYOUT:
+// -------
+// Everything lives in one monotonic arena (std::pmr) with an initial block
+// of kArenaSize bytes:
+//   - records: one compact Record per patch (offsets, lengths, timestamp)
+//   - inserted bytes: one side buffer that only grows at its end, so typing
+//     forward extends the last record in place
+//   - removed bytes: one side buffer that only grows at its front, so
+//     backspacing extends the last record in place
+// Records refer to their bytes by offset and length. Clearing the log
+// releases the arena back to its initial block, so a typing session that
+// flushes regularly never allocates after the first keystroke. Growth past
+// the initial block comes from an upstream memory resource (the default
+// resource unless one is given).
+//
+// READING:
+// --------
+// drain() hands each patch to a callback as a PatchView (string_views into
+// the arena) and clears the log without copying; flush() builds owning
+// Patch objects for callers that keep them (e.g. UndoHistory).
+//
+// Each appended edit reads the steady clock once; coalesced edits update
+// the timestamp of the record they extend.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_PATCH_LOG_H
+#define MDEDITOR_PATCH_LOG_H
+
+#include "document_model.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+// =============================================================================
+// PatchLog - Pending patches in a monotonic arena
+// =============================================================================
+/// Records coalesced, invertible patches without per-edit allocations.
+class PatchLog {
+public:
+    /// Size of the arena's initial block (allocated on the first append).
+    static constexpr size_t kArenaSize = 16 * 1024;
+
+    PatchLog();
+    ~PatchLog();
+
+    /// Creates a log whose arena grows from upstream (which must outlive
+    /// the log). Copies use the default resource, as std::pmr containers do.
+    explicit PatchLog(std::pmr::memory_resource* upstream);
+
+    PatchLog(const PatchLog& other);
+    PatchLog& operator=(const PatchLog& other);
+    PatchLog(PatchLog&& other) noexcept;
+    PatchLog& operator=(PatchLog&& other) noexcept;
+
+    /// Records an edit, merging it into the last patch when it continues it
+    /// (typing forward or backspacing).
+    /// @return true if the edit was merged, false if it started a new patch
+    bool append(size_t start, std::string_view removed, std::string_view inserted);
+
+    /// Returns true if no patch is pending.
+    [[nodiscard]] bool empty() const noexcept;
+
+    /// Returns the number of pending patches.
+    [[nodiscard]] size_t size() const noexcept;
+
+    /// Returns pending patch index (< size()). The views are valid until the
+    /// next append() or clear().
+    [[nodiscard]] PatchView at(size_t index) const noexcept;
+
+    /// Calls fn(const PatchView&) for each pending patch in order.
+    template <typename Fn>
+    void forEach(Fn&& fn) const;
+
+    /// Calls fn for each pending patch, then clears the log.
+    template <typename Fn>
+    void drain(Fn&& fn);
+
+    /// Returns the pending patches as owning Patch objects and clears the log.
+    [[nodiscard]] std::vector<Patch> flush();
+
+    /// Drops all pending patches and rewinds the arena.
+    void clear() noexcept;
+
+private:
+    /// One patch; its bytes live in the arena's side buffers
+    struct Record {
+        size_t start;                ///< Byte offset of the edit
+        size_t insertedOffset;       ///< First inserted byte in the inserted buffer
+        size_t insertedLength;
+        size_t removedFront;         ///< Distance of the first removed byte from
+                                     ///< the end of the removed buffer
+        size_t removedLength;
+        std::chrono::steady_clock::rep timestamp;  ///< steady_clock ticks
+    };
+
+    struct Arena;
+
+    /// Prepends bytes to the removed buffer
+    void prependRemoved(std::string_view removed);
+
+    std::unique_ptr<Arena> arena_;  ///< Created on the first append
+    std::pmr::memory_resource* upstream_ = std::pmr::get_default_resource();
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void PatchLog::forEach(Fn&& fn) const {
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i) {
+        fn(at(i));
+    }
+}
+
+template <typename Fn>
+void PatchLog::drain(Fn&& fn) {
+    forEach(fn);
+    clear();
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_PATCH_LOG_H
@@ -0,0 +1,465 @@
+// =============================================================================
+// piece_table.cpp - Piece Table Text Model Implementation
+// =============================================================================
+
+#include "piece_table.h"
+#include "edit_helpers.h"
+#include "mapped_file.h"
+#include "newline_scan.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mdeditor {
+
+// =============================================================================
+// Buffer
+// =============================================================================
+
+const char* PieceTable::Buffer::data() const noexcept {
+    return block ? block.get() : mapping->view().data();
+}
+
+std::shared_ptr<const void> PieceTable::Buffer::owner() const noexcept {
+    if (block) {
+        return block;
+    }
+    return mapping;
+}
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+PieceTable::PieceTable(const PieceTable& other)
+    : buffers_(other.buffers_)
+    , pieces_(other.pieces_)
+    , length_(other.length_)
+    , pendingPatches_(other.pendingPatches_)
+    , version_(other.version_)
+    , newlines_(other.newlines_)
+    , lineIndexPending_(other.lineIndexPending_) {
+    sealBlocks();
+}
+
+PieceTable& PieceTable::operator=(const PieceTable& other) {
+    if (this != &other) {
+        buffers_ = other.buffers_;
+        pieces_ = other.pieces_;
+        addBlock_ = kNoBlock;
+        length_ = other.length_;
+        flat_.clear();
+        pendingPatches_ = other.pendingPatches_;
+        version_ = other.version_;
+        newlines_ = other.newlines_;
+        lineIndexPending_ = other.lineIndexPending_;
+        sealBlocks();
+    }
+    return *this;
+}
+
+// =============================================================================
+// Loading Content
+// =============================================================================
+
+void PieceTable::loadFromString(std::string_view text) {
+    clear();
+    if (text.empty()) {
+        return;
+    }
+
+    Buffer original;
+    original.block.reset(new char[text.size()]);
+    std::memcpy(original.block.get(), text.data(), text.size());
+    original.size = text.size();
+    original.capacity = text.size();
+    original.newlines.reserve(simd::countNewlines(text));
+    simd::forEachNewline(text, [&](size_t pos) {
+        original.newlines.push_back(pos);
+    });
+
+    newlines_ = original.newlines.size();
+    length_ = text.size();
+    pieces_.push_back(Piece{0, 0, text.size(), newlines_});
+    buffers_.push_back(std::move(original));
+}
+
+void PieceTable::loadFromFile(const std::filesystem::path& path) {
+    // Map first so a failure leaves the table untouched
+    auto mapping = std::make_shared<const MappedFile>(path);
+
+    clear();
+    if (mapping->size() == 0) {
+        return;
+    }
+
+    Buffer original;
+    original.size = mapping->size();
+    original.capacity = mapping->size();
+    original.mapping = std::move(mapping);
+
+    // Defer the newline scan: it reads every page of the file
+    length_ = original.size;
+    pieces_.push_back(Piece{0, 0, original.size, 0});
+    buffers_.push_back(std::move(original));
+    lineIndexPending_ = true;
+}
+
+void PieceTable::clear() {
+    buffers_.clear();
+    pieces_.clear();
+    addBlock_ = kNoBlock;
+    length_ = 0;
+    std::string().swap(flat_);
+    pendingPatches_.clear();
+    ++version_;
+    newlines_ = 0;
+    lineIndexPending_ = false;
+}
+
+// =============================================================================
+// Retrieving Content
+// =============================================================================
+
+std::string PieceTable::getText() const {
+    return getText(0, length_);
+}
+
+std::string PieceTable::getText(size_t start, size_t len) const {
+    std::string result;
+    if (start < length_) {
+        result.reserve(std::min(len, length_ - start));
+    }
+    forEachChunk(start, len, [&](std::string_view run) {
+        result.append(run);
+    });
+    return result;
+}
+
+size_t PieceTable::length() const noexcept {
+    return length_;
+}
+
+bool PieceTable::empty() const noexcept {
+    return length_ == 0;
+}
+
+size_t PieceTable::pieceCount() const noexcept {
+    return pieces_.size();
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+void PieceTable::visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const {
+    forEachChunk(start, len, fn);
+}
+
+std::string_view PieceTable::contiguousView() {
+    if (pieces_.empty()) {
+        return {};
+    }
+    if (pieces_.size() == 1) {
+        return pieceText(pieces_.front());
+    }
+
+    flat_.clear();
+    flat_.reserve(length_);
+    forEachChunk(0, length_, [&](std::string_view run) {
+        flat_.append(run);
+    });
+    return flat_;
+}
+
+DocumentSnapshot PieceTable::snapshot() const {
+    std::vector<std::string_view> runs;
+    runs.reserve(pieces_.size());
+    std::vector<bool> referenced(buffers_.size(), false);
+    for (const Piece& piece : pieces_) {
+        runs.push_back(pieceText(piece));
+        referenced[piece.buffer] = true;
+    }
+
+    // Bytes below each buffer's size are never rewritten, so sharing the
+    // buffers keeps the runs valid and unchanged
+    std::vector<std::shared_ptr<const void>> owners;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        if (referenced[i]) {
+            owners.push_back(buffers_[i].owner());
+        }
+    }
+    return DocumentSnapshot(std::move(runs), std::move(owners), version_);
+}
+
+uint64_t PieceTable::version() const noexcept {
+    return version_;
+}
+
+// =============================================================================
+// Editing Operations
+// =============================================================================
+
+void PieceTable::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, length_);
+    insertText(offset, text);
+    ++version_;
+    pendingPatches_.append(offset, {}, text);
+}
+
+void PieceTable::erase(size_t offset, size_t len) {
+    if (offset >= length_ || len == 0) {
+        return;
+    }
+    len = std::min(len, length_ - offset);
+
+    const std::string removed = getText(offset, len);
+    eraseText(offset, len);
+    ++version_;
+    pendingPatches_.append(offset, removed, {});
+}
+
+void PieceTable::applyPatch(const Patch& patch) {
+    applyEdits({Edit{patch.start, patch.removedLength, patch.insertedText}});
+}
+
+void PieceTable::applyEdits(const std::vector<Edit>& edits) {
+    // Clamp, order and validate before touching the pieces
+    const std::vector<Edit> sorted = detail::sortedEdits(edits, length_, "PieceTable::applyEdits");
+
+    size_t insertedSoFar = 0;
+    size_t removedSoFar = 0;
+    for (const Edit& edit : sorted) {
+        const size_t position = edit.start + insertedSoFar - removedSoFar;
+        const std::string removed = getText(position, edit.removedLength);
+        eraseText(position, edit.removedLength);
+        insertText(position, edit.insertedText);
+        ++version_;
+        pendingPatches_.append(position, removed, edit.insertedText);
+        insertedSoFar += edit.insertedText.size();
+        removedSoFar += edit.removedLength;
+    }
+}
+
+// =============================================================================
+// Line/Offset Mapping
+// =============================================================================
+
+size_t PieceTable::lineFromOffset(size_t offset) const {
+    ensureLineIndex();
+    offset = std::min(offset, length_);
+
+    // Count newlines strictly before offset
+    size_t line = 0;
+    size_t position = 0;
+    for (const Piece& piece : pieces_) {
+        if (position + piece.length > offset) {
+            return line + countNewlines(piece.buffer, piece.start, offset - position);
+        }
+        line += piece.newlines;
+        position += piece.length;
+    }
+    return line;
+}
+
+size_t PieceTable::offsetFromLine(size_t line, size_t column) const {
+    if (line == 0 && column == 0) {
+        return 0;
+    }
+
+    ensureLineIndex();
+    size_t offset = length_;  // Past the last line
+
+    if (line == 0) {
+        offset = 0;
+    } else {
+        // Line N starts one past the (N-1)th newline
+        size_t remaining = line - 1;
+        size_t position = 0;
+        for (const Piece& piece : pieces_) {
+            if (remaining < piece.newlines) {
+                const std::vector<size_t>& newlines = buffers_[piece.buffer].newlines;
+                const auto first = std::lower_bound(newlines.begin(), newlines.end(), piece.start);
+                offset = position + (first[remaining] - piece.start) + 1;
+                break;
+            }
+            remaining -= piece.newlines;
+            position += piece.length;
+        }
+    }
+
+    // Add column offset (clamped to text length)
+    return std::min(offset + column, length_);
+}
+
+size_t PieceTable::lineCount() const {
+    if (empty()) {
+        return 0;
+    }
+    ensureLineIndex();
+    return 1 + newlines_;
+}
+
+// =============================================================================
+// Patch Management
+// =============================================================================
+
+std::vector<Patch> PieceTable::flushPatches() {
+    return pendingPatches_.flush();
+}
+
+void PieceTable::drainPatches(const PatchVisitor& fn) {
+    pendingPatches_.drain(fn);
+}
+
+bool PieceTable::hasPendingPatches() const noexcept {
+    return !pendingPatches_.empty();
+}
+
+// =============================================================================
+// Internal Implementation
+// =============================================================================
+
+PieceTable::Location PieceTable::locate(size_t offset) const noexcept {
+    size_t position = 0;
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        if (offset < position + pieces_[i].length) {
+            return Location{i, offset - position};
+        }
+        position += pieces_[i].length;
+    }
+    return Location{pieces_.size(), 0};
+}
+
+std::string_view PieceTable::pieceText(const Piece& piece) const noexcept {
+    return std::string_view(buffers_[piece.buffer].data() + piece.start, piece.length);
+}
+
+size_t PieceTable::countNewlines(size_t buffer, size_t start, size_t len) const noexcept {
+    // Empty for the original while its scan is deferred; ensureLineIndex()
+    // recounts every piece afterwards
+    const std::vector<size_t>& newlines = buffers_[buffer].newlines;
+    const auto first = std::lower_bound(newlines.begin(), newlines.end(), start);
+    const auto last = std::lower_bound(first, newlines.end(), start + len);
+    return static_cast<size_t>(last - first);
+}
+
+size_t PieceTable::splitAt(size_t offset) {
+    const Location loc = locate(offset);
+    if (loc.offset == 0) {
+        return loc.piece;
+    }
+
+    Piece& left = pieces_[loc.piece];
+    Piece right{left.buffer, left.start + loc.offset, left.length - loc.offset, 0};
+    right.newlines = countNewlines(right.buffer, right.start, right.length);
+    left.length = loc.offset;
+    left.newlines = countNewlines(left.buffer, left.start, left.length);
+
+    pieces_.insert(pieces_.begin() + static_cast<std::ptrdiff_t>(loc.piece) + 1, right);
+    return loc.piece + 1;
+}
+
+PieceTable::Piece PieceTable::append(std::string_view text) {
+    size_t index = addBlock_;
+    if (text.size() > kAddBlockSize) {
+        // Large inserts get a block of their own so the current block keeps
+        // its free space
+        index = buffers_.size();
+        buffers_.emplace_back();
+        buffers_.back().block.reset(new char[text.size()]);
+        buffers_.back().capacity = text.size();
+    } else if (index == kNoBlock ||
+               buffers_[index].capacity - buffers_[index].size < text.size()) {
+        index = buffers_.size();
+        buffers_.emplace_back();
+        buffers_.back().block.reset(new char[kAddBlockSize]);
+        buffers_.back().capacity = kAddBlockSize;
+        addBlock_ = index;
+    }
+
+    Buffer& buffer = buffers_[index];
+    const size_t start = buffer.size;
+    std::memcpy(buffer.block.get() + start, text.data(), text.size());
+    buffer.size += text.size();
+
+    const size_t before = buffer.newlines.size();
+    simd::forEachNewline(text, [&](size_t pos) {
+        buffer.newlines.push_back(start + pos);
+    });
+    return Piece{index, start, text.size(), buffer.newlines.size() - before};
+}
+
+void PieceTable::insertText(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    const Piece piece = append(text);
+    length_ += piece.length;
+    newlines_ += piece.newlines;
+
+    const size_t index = splitAt(offset);
+
+    // Typing forward lands right after the previous insert: grow its piece
+    if (index > 0) {
+        Piece& previous = pieces_[index - 1];
+        if (previous.buffer == piece.buffer &&
+            previous.start + previous.length == piece.start) {
+            previous.length += piece.length;
+            previous.newlines += piece.newlines;
+            return;
+        }
+    }
+    pieces_.insert(pieces_.begin() + static_cast<std::ptrdiff_t>(index), piece);
+}
+
+void PieceTable::eraseText(size_t offset, size_t len) {
+    if (len == 0) {
+        return;
+    }
+
+    const size_t first = splitAt(offset);
+    const size_t last = splitAt(offset + len);
+    for (size_t i = first; i < last; ++i) {
+        length_ -= pieces_[i].length;
+        newlines_ -= pieces_[i].newlines;
+    }
+    pieces_.erase(pieces_.begin() + static_cast<std::ptrdiff_t>(first),
+                  pieces_.begin() + static_cast<std::ptrdiff_t>(last));
+}
+
+void PieceTable::ensureLineIndex() const {
+    if (!lineIndexPending_) {
+        return;
+    }
+
+    const Buffer& original = buffers_.front();
+    const std::string_view text(original.data(), original.size);
+    original.newlines.reserve(simd::countNewlines(text));
+    simd::forEachNewline(text, [&](size_t pos) {
+        original.newlines.push_back(pos);
+    });
+
+    // Counts of pieces over the original were taken while its list was empty
+    newlines_ = 0;
+    for (const Piece& piece : pieces_) {
+        piece.newlines = countNewlines(piece.buffer, piece.start, piece.length);
+        newlines_ += piece.newlines;
+    }
+    lineIndexPending_ = false;
+}
+
+void PieceTable::sealBlocks() noexcept {
+    // The source keeps appending past each block's size; bytes below it are
+    // shared and never rewritten
+    for (Buffer& buffer : buffers_) {
+        buffer.capacity = buffer.size;
+    }
+    addBlock_ = kNoBlock;
+}
+
+} // namespace mdeditor
@@ -0,0 +1,301 @@
+// =============================================================================
+// piece_table.h - Piece Table Text Model
+// =============================================================================
+//
+// A piece table never moves text that is already stored. The document is a
+// sequence of "pieces", each naming a range of one of two kinds of buffer:
+//
+//   - the ORIGINAL buffer: the loaded text, read-only (for loadFromFile()
+//     it is the memory-mapped file itself, so loading is O(1))
+//   - ADD blocks: append-only blocks of kAddBlockSize bytes that receive
+//     every inserted byte (an insert larger than a block gets its own block)
+//
+// An insert appends to the current add block and splices one piece into
+// the sequence; an erase only shortens or drops pieces. Typing at one spot
+// extends the same piece instead of adding a new one.
+//
+// COST MODEL:
+// -----------
+// Pieces are kept in a flat vector and located by a linear walk, so edits
+// and line queries are O(number of pieces) plus a binary search inside one
+// piece; no text bytes are copied. This is a good fit for documents edited
+// in a moderate number of places; PieceTree (src/piecetree) keeps the pieces
+// in a balanced tree for heavily edited documents.
+//
+// LINE MAPPING:
+// -------------
+// Each buffer keeps the sorted offsets of its '\n' bytes, and each piece
+// caches its newline count, so counting the newlines of any part of a piece
+// is a binary search. The original buffer's list is built on the first line
+// query after loadFromFile(); edits before that do not read the file.
+//
+// SNAPSHOTS:
+// ----------
+// Stored bytes never change, so snapshot() just returns views of the pieces
+// plus shared ownership of the buffers they point into: O(pieces), no copy.
+//
+// Offsets, line semantics and patches are exactly those of GapBuffer; see
+// gap_buffer.h.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_PIECE_TABLE_H
+#define MDEDITOR_PIECE_TABLE_H
+
+#include "document_model.h"
+#include "patch_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+class MappedFile;
+
+// =============================================================================
+// PieceTable - Original + append-only add buffer text model
+// =============================================================================
+/// PieceTable stores edits as pieces over immutable buffers, so no edit ever
+/// moves existing text.
+class PieceTable : public IDocumentModel {
+public:
+    /// Size of each append-only add block.
+    static constexpr size_t kAddBlockSize = 64 * 1024;
+
+    // -------------------------------------------------------------------------
+    // Construction / Destruction
+    // -------------------------------------------------------------------------
+
+    /// Constructs an empty table (no buffers are allocated until text arrives).
+    PieceTable() = default;
+
+    ~PieceTable() override = default;
+
+    /// Copies share the stored buffers; neither copy appends to a block
+    /// the other one can see.
+    PieceTable(const PieceTable& other);
+    PieceTable& operator=(const PieceTable& other);
+    PieceTable(PieceTable&& other) noexcept = default;
+    PieceTable& operator=(PieceTable&& other) noexcept = default;
+
+    // -------------------------------------------------------------------------
+    // Loading Content
+    // -------------------------------------------------------------------------
+
+    /// Loads content from a string (copied once into the original buffer).
+    /// @param text The text to load
+    void loadFromString(std::string_view text) override;
+
+    /// Loads a file by memory-mapping it as the original buffer. O(1): the
+    /// file is not read until its text or lines are queried.
+    /// @param path The file to load
+    /// @throws std::runtime_error if the file cannot be opened or mapped;
+    ///         the table is left unchanged
+    void loadFromFile(const std::filesystem::path& path) override;
+
+    /// Clears all content and releases the buffers.
+    void clear() override;
+
+    // -------------------------------------------------------------------------
+    // Retrieving Content
+    // -------------------------------------------------------------------------
+
+    /// Returns the entire text content as a string.
+    [[nodiscard]] std::string getText() const override;
+
+    /// Returns a substring of the text content.
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to retrieve
+    /// @return The requested substring (clamped to valid range)
+    [[nodiscard]] std::string getText(size_t start, size_t len) const override;
+
+    /// Returns the total length of the text in bytes.
+    [[nodiscard]] size_t length() const noexcept override;
+
+    /// Returns true if the table contains no text.
+    [[nodiscard]] bool empty() const noexcept override;
+
+    /// Returns the number of pieces the text is split into.
+    [[nodiscard]] size_t pieceCount() const noexcept;
+
+    // -------------------------------------------------------------------------
+    // Zero-Copy Access
+    // -------------------------------------------------------------------------
+
+    /// Calls fn(std::string_view) for each contiguous run of a byte range,
+    /// in order (one run per piece the range overlaps).
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to visit
+    /// @note Range is clamped like getText(start, len); empty runs are skipped
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+
+    /// forEachChunk() behind the IDocumentModel interface.
+    void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override;
+
+    /// Returns the whole text as one view. Zero-copy while the text is a
+    /// single piece; otherwise copies it into an internal string that stays
+    /// valid until the next edit or call.
+    [[nodiscard]] std::string_view contiguousView() override;
+
+    /// Returns a snapshot sharing the buffers (O(pieces), no text copied).
+    [[nodiscard]] DocumentSnapshot snapshot() const override;
+
+    /// Returns the document version (see IDocumentModel::version()).
+    [[nodiscard]] uint64_t version() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Editing Operations
+    // -------------------------------------------------------------------------
+
+    /// Inserts text at the specified byte offset.
+    /// @note Offset is clamped to [0, length()]
+    void insert(size_t offset, std::string_view text) override;
+
+    /// Erases a range of bytes.
+    /// @note Range is clamped to valid bounds
+    void erase(size_t offset, size_t len) override;
+
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText as a single patch.
+    void applyPatch(const Patch& patch) override;
+
+    /// Applies a batch of non-overlapping edits, left to right, with the
+    /// same contract as IDocumentModel::applyEdits.
+    /// @throws std::invalid_argument if two edits overlap; the table is
+    ///         left unchanged
+    void applyEdits(const std::vector<Edit>& edits) override;
+
+    // -------------------------------------------------------------------------
+    // Line/Offset Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the 0-indexed line number containing the given byte offset.
+    /// @note O(pieces + log n)
+    [[nodiscard]] size_t lineFromOffset(size_t offset) const override;
+
+    /// Returns the byte offset of position (line, column).
+    /// @note Returns end of text if line is past last line
+    /// @note O(pieces + log n)
+    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const override;
+
+    /// Returns the total number of lines (at least 1 for non-empty text).
+    /// @note O(1)
+    [[nodiscard]] size_t lineCount() const override;
+
+    // -------------------------------------------------------------------------
+    // Patch Management
+    // -------------------------------------------------------------------------
+
+    /// Returns and clears the accumulated patches since last flush.
+    [[nodiscard]] std::vector<Patch> flushPatches() override;
+
+    /// Calls fn for each accumulated patch, then clears them (no copies).
+    void drainPatches(const PatchVisitor& fn) override;
+
+    /// Returns true if there are unflushed patches.
+    [[nodiscard]] bool hasPendingPatches() const noexcept override;
+
+private:
+    /// Immutable (original) or append-only (add block) text storage.
+    /// Bytes below size never change once written.
+    struct Buffer {
+        std::shared_ptr<char[]> block;               ///< Add block or copied original
+        std::shared_ptr<const MappedFile> mapping;   ///< Mapped original
+        size_t size = 0;                             ///< Bytes written
+        size_t capacity = 0;                         ///< Bytes that may be written
+        mutable std::vector<size_t> newlines;        ///< Sorted '\n' offsets below size
+
+        [[nodiscard]] const char* data() const noexcept;
+        [[nodiscard]] std::shared_ptr<const void> owner() const noexcept;
+    };
+
+    /// A range [start, start + length) of one buffer
+    struct Piece {
+        size_t buffer;
+        size_t start;
+        size_t length;
+        mutable size_t newlines;  ///< Number of '\n' in the range
+    };
+
+    /// Position of a byte inside the piece sequence
+    struct Location {
+        size_t piece;   ///< pieces_.size() for the end of the text
+        size_t offset;  ///< Offset within the piece
+    };
+
+    static constexpr size_t kNoBlock = static_cast<size_t>(-1);
+
+    /// Finds the piece holding offset; a piece boundary maps to the start of
+    /// the following piece
+    [[nodiscard]] Location locate(size_t offset) const noexcept;
+
+    /// Returns the text of a piece
+    [[nodiscard]] std::string_view pieceText(const Piece& piece) const noexcept;
+
+    /// Number of '\n' in [start, start + len) of a buffer
+    [[nodiscard]] size_t countNewlines(size_t buffer, size_t start, size_t len) const noexcept;
+
+    /// Splits the piece holding offset so that a piece starts there
+    /// @return Index of the piece starting at offset
+    size_t splitAt(size_t offset);
+
+    /// Appends text to an add block and returns a piece over it
+    Piece append(std::string_view text);
+
+    /// Inserts without recording a patch
+    void insertText(size_t offset, std::string_view text);
+
+    /// Erases without recording a patch
+    void eraseText(size_t offset, size_t len);
+
+    /// Builds the original buffer's newline list if deferred by loadFromFile()
+    void ensureLineIndex() const;
+
+    /// Stops this table from appending to blocks it shares with a copy
+    void sealBlocks() noexcept;
+
+    std::vector<Buffer> buffers_;        ///< [0] is the original when loaded
+    std::vector<Piece> pieces_;          ///< Pieces in text order, none empty
+    size_t addBlock_ = kNoBlock;         ///< Add block receiving small inserts
+    size_t length_ = 0;                  ///< Total text bytes
+    std::string flat_;                   ///< Backing store for contiguousView()
+    PatchLog pendingPatches_;            ///< Unflushed edit patches
+    uint64_t version_ = 0;               ///< Bumped by every edit and clear
+
+    // Mutable only so deferred counts can be computed by a const query
+    mutable size_t newlines_ = 0;        ///< Total '\n' count
+    mutable bool lineIndexPending_ = false;  ///< Original not scanned yet (mapped file)
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void PieceTable::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    if (start >= length_) {
+        return;
+    }
+    len = std::min(len, length_ - start);
+
+    Location loc = locate(start);
+    while (len > 0) {
+        const std::string_view run = pieceText(pieces_[loc.piece]);
+        const size_t take = std::min(len, run.size() - loc.offset);
+        fn(run.substr(loc.offset, take));
+        len -= take;
+        ++loc.piece;
+        loc.offset = 0;
+    }
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_PIECE_TABLE_H
@@ -0,0 +1,1193 @@
+// =============================================================================
+// regex_search.cpp - Streaming Regex Search Implementation
+// =============================================================================
+//
+// Pipeline: Parser (pattern -> AST) -> Thompson construction (AST -> NFA of
+// byte-set, split and assertion nodes) -> lazy DFA (computeTransition(),
+// one state at a time) -> Searcher (runs the DFA over chunks and tracks
+// start registers).
+//
+// Assertions are kept as pending threads in DFA states and resolved at the
+// next transition, when both the previous byte (stored in the state) and
+// the next byte (the transition's input) are known.
+//
+// =============================================================================
+
+#include "regex_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <tuple>
+#include <utility>
+
+namespace mdeditor {
+
+namespace {
+
+/// Transition slot for "no more input"
+constexpr unsigned kEndOfInput = 256;
+constexpr size_t kTableWidth = kEndOfInput + 1;
+
+/// Bytes read per visitChunks() call, so a search can stop early
+constexpr size_t kWindow = 64 * 1024;
+
+/// Limits on compiled pattern size
+constexpr size_t kMaxNodes = 20000;
+constexpr int kMaxRepeat = 1000;
+
+// Context bits: class of the bytes before and after a position
+constexpr uint8_t kPrevWord = 1;
+constexpr uint8_t kPrevLineStart = 2;   // After '\n' or at the start of the text
+constexpr uint8_t kNextWord = 4;
+constexpr uint8_t kNextLineEnd = 8;     // Before '\n' or at the end of the text
+
+bool isWordByte(unsigned byte) noexcept {
+    return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') ||
+           (byte >= '0' && byte <= '9') || byte == '_';
+}
+
+/// Context bits for the byte before a position
+uint8_t prevFlagsOf(unsigned byte) noexcept {
+    if (byte == kEndOfInput) {
+        return kPrevLineStart;
+    }
+    return static_cast<uint8_t>((isWordByte(byte) ? kPrevWord : 0) |
+                                (byte == '\n' ? kPrevLineStart : 0));
+}
+
+/// Context bits for the byte after a position
+uint8_t nextFlagsOf(unsigned byte) noexcept {
+    if (byte == kEndOfInput) {
+        return kNextLineEnd;
+    }
+    return static_cast<uint8_t>((isWordByte(byte) ? kNextWord : 0) |
+                                (byte == '\n' ? kNextLineEnd : 0));
+}
+
+using ByteSet = std::bitset<256>;
+
+ByteSet byteRange(unsigned low, unsigned high) {
+    ByteSet set;
+    for (unsigned b = low; b <= high; ++b) {
+        set.set(b);
+    }
+    return set;
+}
+
+/// Adds the other case of every ASCII letter in set
+ByteSet foldAsciiCase(ByteSet set) {
+    for (unsigned b = 'a'; b <= 'z'; ++b) {
+        if (set.test(b) || set.test(b - ('a' - 'A'))) {
+            set.set(b);
+            set.set(b - ('a' - 'A'));
+        }
+    }
+    return set;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// RegexError
+// =============================================================================
+
+RegexError::RegexError(const std::string& what, size_t position)
+    : std::invalid_argument(what)
+    , position_(position) {
+}
+
+size_t RegexError::position() const noexcept {
+    return position_;
+}
+
+// =============================================================================
+// Parser - Pattern to AST
+// =============================================================================
+
+class Regex::Parser {
+public:
+    struct Ast {
+        enum class Kind : uint8_t { Empty, Bytes, Concat, Alternate, Repeat, Assert };
+        Kind kind = Kind::Empty;
+        ByteSet bytes;
+        Assertion assertion = Assertion::LineStart;
+        int min = 0;
+        int max = -1;   ///< -1: unbounded
+        std::vector<Ast> children;
+    };
+
+    Parser(std::string_view pattern, bool ignoreAsciiCase)
+        : pattern_(pattern)
+        , ignoreAsciiCase_(ignoreAsciiCase) {}
+
+    Ast parse() {
+        Ast ast = parseAlternation();
+        if (pos_ < pattern_.size()) {
+            fail("unmatched ')'");
+        }
+        return ast;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        fail(message, pos_);
+    }
+
+    [[noreturn]] static void fail(const std::string& message, size_t position) {
+        throw RegexError("Regex: " + message + " at offset " + std::to_string(position), position);
+    }
+
+    bool atEnd() const noexcept { return pos_ >= pattern_.size(); }
+    char peek() const noexcept { return pattern_[pos_]; }
+
+    // -------------------------------------------------------------------------
+    // AST builders
+    // -------------------------------------------------------------------------
+
+    static Ast node(Ast::Kind kind) {
+        Ast ast;
+        ast.kind = kind;
+        return ast;
+    }
+
+    static Ast bytesNode(const ByteSet& set) {
+        Ast ast = node(Ast::Kind::Bytes);
+        ast.bytes = set;
+        return ast;
+    }
+
+    static Ast assertNode(Assertion assertion) {
+        Ast ast = node(Ast::Kind::Assert);
+        ast.assertion = assertion;
+        return ast;
+    }
+
+    static Ast sequence(std::vector<Ast> items) {
+        if (items.size() == 1) {
+            return std::move(items.front());
+        }
+        Ast ast = node(Ast::Kind::Concat);
+        ast.children = std::move(items);
+        return ast;
+    }
+
+    static Ast alternation(std::vector<Ast> branches) {
+        if (branches.size() == 1) {
+            return std::move(branches.front());
+        }
+        Ast ast = node(Ast::Kind::Alternate);
+        ast.children = std::move(branches);
+        return ast;
+    }
+
+    /// One literal byte, case-folded if requested
+    Ast literalByte(unsigned char byte) const {
+        ByteSet set;
+        set.set(byte);
+        return bytesNode(ignoreAsciiCase_ ? foldAsciiCase(set) : set);
+    }
+
+    /// Any multi-byte UTF-8 sequence (lead byte plus continuations)
+    static Ast anyMultiByte() {
+        const ByteSet continuation = byteRange(0x80, 0xBF);
+        std::vector<Ast> branches;
+        for (const auto& [low, high, length] : {std::tuple<unsigned, unsigned, int>{0xC0, 0xDF, 1},
+                                                 {0xE0, 0xEF, 2}, {0xF0, 0xF7, 3}}) {
+            std::vector<Ast> items{bytesNode(byteRange(low, high))};
+            for (int i = 0; i < length; ++i) {
+                items.push_back(bytesNode(continuation));
+            }
+            branches.push_back(sequence(std::move(items)));
+        }
+        return alternation(std::move(branches));
+    }
+
+    /// A class: ASCII bytes, optionally any non-ASCII character, and
+    /// specific non-ASCII characters
+    static Ast classNode(const ByteSet& ascii, bool anyNonAscii,
+                         std::vector<std::string> sequences) {
+        std::vector<Ast> branches;
+        if (ascii.any()) {
+            branches.push_back(bytesNode(ascii));
+        }
+        if (anyNonAscii) {
+            branches.push_back(anyMultiByte());
+        }
+        for (const std::string& sequence : sequences) {
+            std::vector<Ast> items;
+            for (const char c : sequence) {
+                ByteSet set;
+                set.set(static_cast<unsigned char>(c));
+                items.push_back(bytesNode(set));
+            }
+            branches.push_back(Parser::sequence(std::move(items)));
+        }
+        if (branches.empty()) {
+            // Matches nothing: an empty byte set
+            return bytesNode(ByteSet{});
+        }
+        return alternation(std::move(branches));
+    }
+
+    // -------------------------------------------------------------------------
+    // Grammar
+    // -------------------------------------------------------------------------
+
+    Ast parseAlternation() {
+        std::vector<Ast> branches;
+        branches.push_back(parseConcat());
+        while (!atEnd() && peek() == '|') {
+            ++pos_;
+            branches.push_back(parseConcat());
+        }
+        return alternation(std::move(branches));
+    }
+
+    Ast parseConcat() {
+        std::vector<Ast> items;
+        while (!atEnd() && peek() != '|' && peek() != ')') {
+            items.push_back(parseRepeat());
+        }
+        if (items.empty()) {
+            return node(Ast::Kind::Empty);
+        }
+        return sequence(std::move(items));
+    }
+
+    Ast parseRepeat() {
+        Ast atom = parseAtom();
+        const size_t quantifier = pos_;
+        int min = 0;
+        int max = -1;
+        if (!parseQuantifier(min, max)) {
+            return atom;
+        }
+        if (atom.kind == Ast::Kind::Assert) {
+            fail("nothing to repeat", quantifier);
+        }
+        if (!atEnd() && (peek() == '?' || peek() == '*' || peek() == '+')) {
+            fail("lazy and possessive quantifiers are not supported");
+        }
+        Ast repeat = node(Ast::Kind::Repeat);
+        repeat.min = min;
+        repeat.max = max;
+        repeat.children.push_back(std::move(atom));
+        return repeat;
+    }
+
+    /// Parses a quantifier if one follows
+    bool parseQuantifier(int& min, int& max) {
+        if (atEnd()) {
+            return false;
+        }
+        switch (peek()) {
+            case '*': ++pos_; min = 0; max = -1; return true;
+            case '+': ++pos_; min = 1; max = -1; return true;
+            case '?': ++pos_; min = 0; max = 1; return true;
+            case '{': return parseCountedQuantifier(min, max);
+            default:  return false;
+        }
+    }
+
+    /// {m}, {m,} or {m,n}; anything else leaves '{' to be a literal
+    bool parseCountedQuantifier(int& min, int& max) {
+        size_t p = pos_ + 1;
+        auto number = [&](int& value) {
+            const size_t begin = p;
+            value = 0;
+            while (p < pattern_.size() && pattern_[p] >= '0' && pattern_[p] <= '9') {
+                value = std::min(value * 10 + (pattern_[p] - '0'), kMaxRepeat + 1);
+                ++p;
+            }
+            return p > begin;
+        };
+        if (!number(min)) {
+            return false;
+        }
+        max = min;
+        if (p < pattern_.size() && pattern_[p] == ',') {
+            ++p;
+            if (!number(max)) {
+                max = -1;
+            }
+        }
+        if (p >= pattern_.size() || pattern_[p] != '}') {
+            return false;
+        }
+        if (min > kMaxRepeat || max > kMaxRepeat) {
+            fail("repetition count above " + std::to_string(kMaxRepeat));
+        }
+        if (max != -1 && max < min) {
+            fail("invalid repetition range");
+        }
+        pos_ = p + 1;
+        return true;
+    }
+
+    Ast parseAtom() {
+        const char c = peek();
+        switch (c) {
+            case '(': {
+                ++pos_;
+                if (!atEnd() && peek() == '?') {
+                    if (pos_ + 1 < pattern_.size() && pattern_[pos_ + 1] == ':') {
+                        pos_ += 2;
+                    } else {
+                        fail("lookaround and group flags are not supported");
+                    }
+                }
+                Ast inner = parseAlternation();
+                if (atEnd() || peek() != ')') {
+                    fail("missing ')'");
+                }
+                ++pos_;
+                return inner;
+            }
+            case '[':
+                ++pos_;
+                return parseClass();
+            case '.':
+                ++pos_;
+                return classNode(byteRange(0x00, 0x7F) & ~byteRange('\n', '\n'), true, {});
+            case '^':
+                ++pos_;
+                return assertNode(Assertion::LineStart);
+            case '$':
+                ++pos_;
+                return assertNode(Assertion::LineEnd);
+            case '\\':
+                ++pos_;
+                return parseEscape();
+            case '*':
+            case '+':
+            case '?':
+                fail("nothing to repeat");
+            default: {
+                int min = 0;
+                int max = 0;
+                const size_t save = pos_;
+                if (c == '{' && parseCountedQuantifier(min, max)) {
+                    pos_ = save;
+                    fail("nothing to repeat");
+                }
+                return parseLiteral();
+            }
+        }
+    }
+
+    /// A literal character: one byte, or a whole UTF-8 sequence so that a
+    /// quantifier repeats the character
+    Ast parseLiteral() {
+        const std::string sequence = takeCharacter();
+        if (sequence.size() == 1) {
+            return literalByte(static_cast<unsigned char>(sequence[0]));
+        }
+        return classNode(ByteSet{}, false, {sequence});
+    }
+
+    /// Consumes one UTF-8 character (lead byte plus continuation bytes)
+    std::string takeCharacter() {
+        const size_t begin = pos_++;
+        while (!atEnd() && (static_cast<unsigned char>(peek()) & 0xC0u) == 0x80u &&
+               pos_ - begin < 4) {
+            ++pos_;
+        }
+        return std::string(pattern_.substr(begin, pos_ - begin));
+    }
+
+    /// Class escapes shared by both contexts: \d \w \s and negations.
+    /// Returns false if c is not one of them.
+    static bool classEscape(char c, ByteSet& ascii, bool& anyNonAscii) {
+        ByteSet set;
+        switch (c) {
+            case 'd': case 'D': set = byteRange('0', '9'); break;
+            case 'w': case 'W':
+                set = byteRange('a', 'z') | byteRange('A', 'Z') | byteRange('0', '9');
+                set.set('_');
+                break;
+            case 's': case 'S':
+                set = byteRange('\t', '\r');
+                set.set(' ');
+                break;
+            default:
+                return false;
+        }
+        if (c >= 'a') {
+            ascii |= set;
+        } else {
+            ascii |= byteRange(0x00, 0x7F) & ~set;
+            anyNonAscii = true;
+        }
+        return true;
+    }
+
+    /// Escapes that stand for one byte; returns -1 for anything else
+    int byteEscape(char c) {
+        switch (c) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            case 'x': {
+                auto hex = [](char h) {
+                    if (h >= '0' && h <= '9') return h - '0';
+                    if (h >= 'a' && h <= 'f') return h - 'a' + 10;
+                    if (h >= 'A' && h <= 'F') return h - 'A' + 10;
+                    return -1;
+                };
+                if (pos_ + 2 > pattern_.size() || hex(pattern_[pos_]) < 0 ||
+                    hex(pattern_[pos_ + 1]) < 0) {
+                    fail("\\x needs two hex digits");
+                }
+                const int value = hex(pattern_[pos_]) * 16 + hex(pattern_[pos_ + 1]);
+                pos_ += 2;
+                return value;
+            }
+            default:
+                break;
+        }
+        const auto byte = static_cast<unsigned char>(c);
+        if ((byte >= '0' && byte <= '9')) {
+            fail("backreferences are not supported");
+        }
+        if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z')) {
+            fail(std::string("unknown escape \\") + c);
+        }
+        return byte;   // Escaped punctuation (or a non-ASCII byte) is literal
+    }
+
+    Ast parseEscape() {
+        if (atEnd()) {
+            fail("trailing backslash");
+        }
+        const char c = pattern_[pos_++];
+        if (c == 'b') {
+            return assertNode(Assertion::WordBoundary);
+        }
+        if (c == 'B') {
+            return assertNode(Assertion::NotWordBoundary);
+        }
+        ByteSet ascii;
+        bool anyNonAscii = false;
+        if (classEscape(c, ascii, anyNonAscii)) {
+            return classNode(ascii, anyNonAscii, {});
+        }
+        return literalByte(static_cast<unsigned char>(byteEscape(c)));
+    }
+
+    /// One class member for ranges: an ASCII byte, or -1 for a non-ASCII
+    /// character (returned in sequence)
+    int classMember(std::string& sequence) {
+        if (peek() == '\\') {
+            ++pos_;
+            if (atEnd()) {
+                fail("unterminated class");
+            }
+            return byteEscape(pattern_[pos_++]);
+        }
+        sequence = takeCharacter();
+        return sequence.size() == 1 ? static_cast<unsigned char>(sequence[0]) : -1;
+    }
+
+    Ast parseClass() {
+        bool negate = false;
+        if (!atEnd() && peek() == '^') {
+            negate = true;
+            ++pos_;
+        }
+        ByteSet ascii;
+        bool anyNonAscii = false;
+        std::vector<std::string> sequences;
+        size_t firstSequence = 0;
+        bool first = true;
+
+        while (true) {
+            if (atEnd()) {
+                fail("unterminated class");
+            }
+            if (peek() == ']' && !first) {
+                ++pos_;
+                break;
+            }
+            first = false;
+
+            if (peek() == '\\' && pos_ + 1 < pattern_.size() &&
+                classEscape(pattern_[pos_ + 1], ascii, anyNonAscii)) {
+                pos_ += 2;
+                continue;
+            }
+            const size_t memberStart = pos_;
+            std::string sequence;
+            const int low = classMember(sequence);
+            const bool range = pos_ + 1 < pattern_.size() && peek() == '-' &&
+                               pattern_[pos_ + 1] != ']';
+            if (range) {
+                ++pos_;
+                std::string highSequence;
+                const int high = classMember(highSequence);
+                if (low < 0 || high < 0 || low > 0x7F || high > 0x7F) {
+                    fail("class ranges must be ASCII", memberStart);
+                }
+                if (low > high) {
+                    fail("invalid class range", memberStart);
+                }
+                ascii |= byteRange(static_cast<unsigned>(low), static_cast<unsigned>(high));
+            } else if (low >= 0) {
+                ascii.set(static_cast<unsigned>(low));
+            } else {
+                if (sequences.empty()) {
+                    firstSequence = memberStart;
+                }
+                sequences.push_back(std::move(sequence));
+            }
+        }
+
+        if (ignoreAsciiCase_) {
+            ascii = foldAsciiCase(ascii);
+        }
+        if (negate) {
+            if (!sequences.empty()) {
+                fail("negated classes with non-ASCII characters are not supported", firstSequence);
+            }
+            ascii = byteRange(0x00, 0x7F) & ~ascii;
+            anyNonAscii = !anyNonAscii;
+        }
+        return classNode(ascii, anyNonAscii, std::move(sequences));
+    }
+
+    std::string_view pattern_;
+    bool ignoreAsciiCase_;
+    size_t pos_ = 0;
+};
+
+// =============================================================================
+// Compilation - AST to Thompson NFA
+// =============================================================================
+
+namespace {
+
+/// Partially built NFA: entry node and unconnected exits (node, second branch)
+struct Fragment {
+    int start = -1;
+    std::vector<std::pair<int, bool>> exits;
+};
+
+} // anonymous namespace
+
+Regex::Regex(std::string_view pattern, bool ignoreAsciiCase) {
+    using Ast = Parser::Ast;
+    const Ast ast = Parser(pattern, ignoreAsciiCase).parse();
+
+    auto addNode = [&](Node::Kind kind) {
+        if (nodes_.size() >= kMaxNodes) {
+            throw RegexError("Regex: pattern is too large", pattern.size());
+        }
+        nodes_.push_back(Node{kind});
+        return static_cast<int>(nodes_.size() - 1);
+    };
+    auto connect = [&](const Fragment& from, int target) {
+        for (const auto& [node, second] : from.exits) {
+            (second ? nodes_[node].out1 : nodes_[node].out) = target;
+        }
+    };
+    auto single = [&](Node::Kind kind) {
+        const int node = addNode(kind);
+        return Fragment{node, {{node, false}}};
+    };
+    auto chain = [&](Fragment& acc, Fragment next) {
+        if (acc.start < 0) {
+            acc = std::move(next);
+        } else {
+            connect(acc, next.start);
+            acc.exits = std::move(next.exits);
+        }
+    };
+
+    std::function<Fragment(const Ast&)> compile = [&](const Ast& ast) -> Fragment {
+        switch (ast.kind) {
+            case Ast::Kind::Empty:
+                return single(Node::Kind::Empty);
+            case Ast::Kind::Bytes: {
+                Fragment fragment = single(Node::Kind::Bytes);
+                nodes_[fragment.start].byteSet = static_cast<uint32_t>(byteSets_.size());
+                byteSets_.push_back(ast.bytes);
+                return fragment;
+            }
+            case Ast::Kind::Assert: {
+                Fragment fragment = single(Node::Kind::Assert);
+                nodes_[fragment.start].assertion = ast.assertion;
+                return fragment;
+            }
+            case Ast::Kind::Concat: {
+                Fragment acc;
+                for (const Ast& child : ast.children) {
+                    chain(acc, compile(child));
+                }
+                return acc;
+            }
+            case Ast::Kind::Alternate: {
+                // Split chain: split(first, split(second, ...))
+                std::vector<Fragment> branches;
+                for (const Ast& child : ast.children) {
+                    branches.push_back(compile(child));
+                }
+                Fragment result;
+                result.start = branches.back().start;
+                for (size_t i = branches.size() - 1; i-- > 0;) {
+                    const int split = addNode(Node::Kind::Split);
+                    nodes_[split].out = branches[i].start;
+                    nodes_[split].out1 = result.start;
+                    result.start = split;
+                }
+                for (Fragment& branch : branches) {
+                    result.exits.insert(result.exits.end(), branch.exits.begin(), branch.exits.end());
+                }
+                return result;
+            }
+            case Ast::Kind::Repeat: {
+                const Ast& child = ast.children.front();
+                Fragment acc;
+                for (int i = 0; i < ast.min; ++i) {
+                    chain(acc, compile(child));
+                }
+                if (ast.max < 0) {
+                    // Loop: split -> child -> split, exit through the split
+                    const int split = addNode(Node::Kind::Split);
+                    const Fragment body = compile(child);
+                    nodes_[split].out = body.start;
+                    connect(body, split);
+                    chain(acc, Fragment{split, {{split, true}}});
+                } else {
+                    for (int i = ast.min; i < ast.max; ++i) {
+                        const int split = addNode(Node::Kind::Split);
+                        Fragment body = compile(child);
+                        nodes_[split].out = body.start;
+                        body.start = split;
+                        body.exits.emplace_back(split, true);
+                        chain(acc, std::move(body));
+                    }
+                }
+                return acc.start >= 0 ? acc : single(Node::Kind::Empty);
+            }
+        }
+        return single(Node::Kind::Empty);
+    };
+
+    const Fragment fragment = compile(ast);
+    connect(fragment, addNode(Node::Kind::Match));
+    startNode_ = fragment.start;
+    visited_.assign(nodes_.size(), 0);
+
+    // States only distinguish the previous byte's class if an assertion
+    // looks at it
+    for (const Node& node : nodes_) {
+        if (node.kind == Node::Kind::Assert) {
+            contextMask_ |= node.assertion == Assertion::LineStart ? kPrevLineStart
+                          : node.assertion == Assertion::LineEnd   ? 0
+                                                                    : kPrevWord;
+        }
+    }
+}
+
+size_t Regex::cachedStates() const noexcept {
+    return states_.size();
+}
+
+// =============================================================================
+// Lazy DFA Construction
+// =============================================================================
+
+void Regex::closure(int start, uint32_t source, const uint8_t* context,
+                    std::vector<Thread>& threads) {
+    // Depth-first in branch order, so threads keep their priority
+    std::vector<int> stack{start};
+    while (!stack.empty()) {
+        const int id = stack.back();
+        stack.pop_back();
+        if (visited_[id] == generation_) {
+            continue;
+        }
+        visited_[id] = generation_;
+        const Node& node = nodes_[id];
+        switch (node.kind) {
+            case Node::Kind::Split:
+                stack.push_back(node.out1);
+                stack.push_back(node.out);
+                break;
+            case Node::Kind::Empty:
+                stack.push_back(node.out);
+                break;
+            case Node::Kind::Assert:
+                if (context == nullptr) {
+                    threads.push_back(Thread{id, source});
+                } else {
+                    const uint8_t ctx = *context;
+                    bool holds = false;
+                    switch (node.assertion) {
+                        case Assertion::LineStart:       holds = (ctx & kPrevLineStart) != 0; break;
+                        case Assertion::LineEnd:         holds = (ctx & kNextLineEnd) != 0; break;
+                        case Assertion::WordBoundary:    holds = ((ctx & kPrevWord) != 0) != ((ctx & kNextWord) != 0); break;
+                        case Assertion::NotWordBoundary: holds = ((ctx & kPrevWord) != 0) == ((ctx & kNextWord) != 0); break;
+                    }
+                    if (holds) {
+                        stack.push_back(node.out);
+                    }
+                }
+                break;
+            case Node::Kind::Bytes:
+            case Node::Kind::Match:
+                threads.push_back(Thread{id, source});
+                break;
+        }
+    }
+}
+
+int Regex::intern(const std::vector<Thread>& threads, uint8_t prevFlags, bool seeking) {
+    std::string key;
+    key.reserve(2 + threads.size() * sizeof(int));
+    key.push_back(static_cast<char>(prevFlags));
+    key.push_back(static_cast<char>(seeking));
+    for (const Thread& thread : threads) {
+        key.append(reinterpret_cast<const char*>(&thread.node), sizeof(int));
+    }
+    const auto [it, inserted] = stateIndex_.try_emplace(std::move(key), static_cast<int>(states_.size()));
+    if (inserted) {
+        DfaState state;
+        state.nodes.reserve(threads.size());
+        for (const Thread& thread : threads) {
+            state.nodes.push_back(thread.node);
+        }
+        state.prevFlags = prevFlags;
+        state.seeking = seeking;
+        states_.push_back(std::move(state));
+        table_.resize(states_.size() * kTableWidth, -1);
+        idleTable_.resize(states_.size() * kTableWidth, -1);
+    }
+    return it->second;
+}
+
+int Regex::computeTransition(int stateIndex, unsigned byte) {
+    auto nextGeneration = [this] {
+        if (++generation_ == 0) {
+            std::fill(visited_.begin(), visited_.end(), 0);
+            generation_ = 1;
+        }
+    };
+    const std::vector<int> carried = states_[stateIndex].nodes;
+    const uint8_t prevFlags = states_[stateIndex].prevFlags;
+    const bool seeking = states_[stateIndex].seeking;
+    const auto newThread = static_cast<uint32_t>(carried.size());
+
+    // Live threads plus, while seeking, a thread starting here (lowest priority)
+    nextGeneration();
+    std::vector<Thread> live;
+    for (size_t rank = 0; rank < carried.size(); ++rank) {
+        visited_[carried[rank]] = generation_;
+        live.push_back(Thread{carried[rank], static_cast<uint32_t>(rank)});
+    }
+    if (seeking) {
+        closure(startNode_, newThread, nullptr, live);
+    }
+
+    // Resolve pending assertions now that the next byte is known
+    nextGeneration();
+    const uint8_t context = static_cast<uint8_t>(prevFlags | nextFlagsOf(byte));
+    std::vector<Thread> resolved;
+    for (const Thread& thread : live) {
+        if (nodes_[thread.node].kind == Node::Kind::Assert) {
+            closure(thread.node, thread.source, &context, resolved);
+        } else if (visited_[thread.node] != generation_) {
+            visited_[thread.node] = generation_;
+            resolved.push_back(thread);
+        }
+    }
+
+    Transition transition;
+    for (const Thread& thread : resolved) {
+        if (nodes_[thread.node].kind == Node::Kind::Match) {
+            transition.matchRank = static_cast<int>(thread.source);
+            break;
+        }
+    }
+
+    if (byte != kEndOfInput) {
+        nextGeneration();
+        std::vector<Thread> next;
+        for (const Thread& thread : resolved) {
+            const Node& node = nodes_[thread.node];
+            if (node.kind == Node::Kind::Bytes && byteSets_[node.byteSet].test(byte)) {
+                closure(node.out, thread.source, nullptr, next);
+            }
+        }
+        transition.sources.reserve(next.size());
+        transition.identity = next.size() <= carried.size();
+        for (size_t j = 0; j < next.size(); ++j) {
+            transition.sources.push_back(next[j].source);
+            transition.identity = transition.identity && next[j].source == j;
+        }
+        transition.target = intern(next, prevFlagsOf(byte) & contextMask_, seeking);
+    }
+
+    const size_t slot = static_cast<size_t>(stateIndex) * kTableWidth + byte;
+    if (byte != kEndOfInput && transition.matchRank < 0 && transition.sources.empty() &&
+        states_[transition.target].skipByte < 0) {
+        idleTable_[slot] = transition.target * static_cast<int>(kTableWidth);
+    }
+    transitions_.push_back(std::move(transition));
+    const int index = static_cast<int>(transitions_.size() - 1);
+    table_[slot] = index;
+    return index;
+}
+
+int Regex::skipByte(int stateIndex) {
+    if (states_[stateIndex].skipByte != -2) {
+        return states_[stateIndex].skipByte;
+    }
+    if (states_.size() + kTableWidth > kMaxStates) {
+        return -1;   // Not enough room to compute every transition; retry later
+    }
+    int only = -1;
+    for (unsigned byte = 0; byte < kEndOfInput; ++byte) {
+        int index = table_[static_cast<size_t>(stateIndex) * kTableWidth + byte];
+        if (index < 0) {
+            index = computeTransition(stateIndex, byte);
+        }
+        const Transition& transition = transitions_[index];
+        const bool stays = transition.target == stateIndex && transition.matchRank < 0 &&
+                           transition.sources.empty();
+        if (!stays) {
+            if (only >= 0) {
+                only = -1;
+                break;
+            }
+            only = static_cast<int>(byte);
+        }
+    }
+    states_[stateIndex].skipByte = only;
+    if (only >= 0) {
+        // Leave the idle loop on entering this state, so the search skips
+        const int row = stateIndex * static_cast<int>(kTableWidth);
+        std::replace(idleTable_.begin(), idleTable_.end(), row, -1);
+    }
+    return only;
+}
+
+int Regex::flushCache(int keep) {
+    DfaState kept = std::move(states_[keep]);
+    states_.clear();
+    transitions_.clear();
+    table_.clear();
+    idleTable_.clear();
+    stateIndex_.clear();
+    std::vector<Thread> threads;
+    for (const int node : kept.nodes) {
+        threads.push_back(Thread{node, 0});
+    }
+    return intern(threads, kept.prevFlags, kept.seeking);
+}
+
+// =============================================================================
+// Searcher - Runs the DFA over chunks
+// =============================================================================
+
+class Regex::Searcher {
+public:
+    Searcher(Regex& regex, size_t from, uint8_t prevFlags)
+        : regex_(regex)
+        , position_(from)
+        , state_(regex.intern({}, prevFlags, true)) {}
+
+    /// Searcher that keeps going after a match and appends every match to
+    /// matches (see FIND ALL)
+    Searcher(Regex& regex, size_t from, uint8_t prevFlags, std::vector<Match>& matches)
+        : Searcher(regex, from, prevFlags) {
+        matches_ = &matches;
+    }
+
+    /// Consumes the next bytes of the range; returns true once the match
+    /// is decided (no live thread can change it)
+    bool feed(std::string_view chunk) {
+        const char* p = chunk.data();
+        const char* const end = p + chunk.size();
+        while (p < end) {
+            if (registers_.empty()) {
+                const int skip = regex_.skipByte(state_);
+                if (skip >= 0) {
+                    const void* hit = std::memchr(p, skip, static_cast<size_t>(end - p));
+                    const char* next = hit ? static_cast<const char*>(hit) : end;
+                    position_ += static_cast<size_t>(next - p);
+                    p = next;
+                    if (p == end) {
+                        break;
+                    }
+                }
+                // Cheapest path: no registers to update, one load per byte
+                const int* const idle = regex_.idleTable_.data();
+                const char* const begin = p;
+                int row = state_ * static_cast<int>(kTableWidth);
+                for (int next; p < end && (next = idle[row + static_cast<unsigned char>(*p)]) >= 0; ++p) {
+                    row = next;
+                }
+                state_ = row / static_cast<int>(kTableWidth);
+                position_ += static_cast<size_t>(p - begin);
+                if (p == end) {
+                    break;
+                }
+            }
+
+            const unsigned byte = static_cast<unsigned char>(*p++);
+            const Transition* transition = &transitionOn(byte);
+            if (transition->matchRank >= 0) {
+                const size_t start = registerOf(static_cast<uint32_t>(transition->matchRank));
+                if (matches_ == nullptr) {
+                    recordMatch(start);
+                } else if (addPending(start)) {
+                    transition = &transitionOn(byte);   // From the pruned state
+                }
+            }
+            if (transition->identity) {
+                registers_.resize(transition->sources.size());
+            } else {
+                scratch_.resize(transition->sources.size());
+                for (size_t j = 0; j < scratch_.size(); ++j) {
+                    scratch_[j] = registerOf(transition->sources[j]);
+                }
+                registers_.swap(scratch_);
+            }
+            state_ = transition->target;
+            ++position_;
+
+            if (matches_ != nullptr) {
+                emitDecided();
+                continue;
+            }
+            if (committed_) {
+                dropLaterThreads();
+            }
+            if (registers_.empty() && !regex_.states_[state_].seeking) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Settles matches that end where the range ends. nextByte is the byte
+    /// after the range, or kEndOfInput.
+    void finish(unsigned nextByte) {
+        const Transition& transition = transitionOn(nextByte);
+        if (transition.matchRank >= 0) {
+            const size_t start = registerOf(static_cast<uint32_t>(transition.matchRank));
+            if (matches_ == nullptr) {
+                recordMatch(start);
+            } else {
+                addPending(start);
+            }
+        }
+        if (matches_ != nullptr) {
+            matches_->insert(matches_->end(), pending_.begin(), pending_.end());
+            pending_.clear();
+        }
+    }
+
+    [[nodiscard]] std::optional<Match> result() const {
+        if (!found_) {
+            return std::nullopt;
+        }
+        return Match{bestStart_, bestEnd_ - bestStart_};
+    }
+
+private:
+    const Transition& transitionOn(unsigned byte) {
+        int index = regex_.table_[static_cast<size_t>(state_) * kTableWidth + byte];
+        if (index < 0) {
+            if (regex_.states_.size() >= kMaxStates) {
+                state_ = regex_.flushCache(state_);
+            }
+            index = regex_.computeTransition(state_, byte);
+        }
+        return regex_.transitions_[index];
+    }
+
+    /// Start of the thread with the given rank; the rank past the last
+    /// thread is the thread starting at the current position
+    size_t registerOf(uint32_t rank) const noexcept {
+        return rank < registers_.size() ? registers_[rank] : position_;
+    }
+
+    void recordMatch(size_t start) {
+        if (!found_ || start < bestStart_) {
+            found_ = true;
+            bestStart_ = start;
+            bestEnd_ = position_;
+            committed_ = true;    // Threads starting later can no longer win
+        } else if (start == bestStart_) {
+            bestEnd_ = position_;
+        }
+    }
+
+    /// Stops seeking and drops threads that start after the best match
+    void dropLaterThreads() {
+        committed_ = false;
+        if (regex_.states_.size() >= kMaxStates) {
+            state_ = regex_.flushCache(state_);
+        }
+        const std::vector<int>& nodes = regex_.states_[state_].nodes;
+        std::vector<Thread> kept;
+        size_t count = 0;
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            if (registers_[j] <= bestStart_) {
+                kept.push_back(Thread{nodes[j], 0});
+                registers_[count++] = registers_[j];
+            }
+        }
+        registers_.resize(count);
+        state_ = regex_.intern(kept, regex_.states_[state_].prevFlags, false);
+    }
+
+    /// Records a match from start to here among the pending ones (see FIND
+    /// ALL); returns true if it dropped threads, changing state_
+    bool addPending(size_t start) {
+        // The first pending match starting at or after start is replaced,
+        // and every later one overlaps the new match
+        const auto replaced = std::lower_bound(
+            pending_.begin(), pending_.end(), start,
+            [](const Match& match, size_t offset) { return match.start < offset; });
+        const Match* previous = replaced != pending_.begin() ? &*(replaced - 1)
+                              : !matches_->empty()        ? &matches_->back()
+                                                          : nullptr;
+        if (start == position_ && previous != nullptr &&
+            start == previous->start + previous->length) {
+            return false;   // No empty match right after a match
+        }
+        pending_.erase(replaced, pending_.end());
+        pending_.push_back(Match{start, position_ - start});
+
+        // Threads starting inside the match can no longer start one
+        const auto inside = [&](size_t offset) { return offset > start && offset < position_; };
+        if (std::none_of(registers_.begin(), registers_.end(), inside)) {
+            return false;
+        }
+        if (regex_.states_.size() >= kMaxStates) {
+            state_ = regex_.flushCache(state_);
+        }
+        const std::vector<int>& nodes = regex_.states_[state_].nodes;
+        std::vector<Thread> kept;
+        size_t count = 0;
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            if (!inside(registers_[j])) {
+                kept.push_back(Thread{nodes[j], 0});
+                registers_[count++] = registers_[j];
+            }
+        }
+        registers_.resize(count);
+        state_ = regex_.intern(kept, regex_.states_[state_].prevFlags, true);
+        return true;
+    }
+
+    /// Moves out the pending matches that no live thread can still replace.
+    /// Threads are ordered by start, so the first one decides
+    void emitDecided() {
+        while (!pending_.empty() &&
+               (registers_.empty() || registers_.front() > pending_.front().start)) {
+            matches_->push_back(pending_.front());
+            pending_.pop_front();
+        }
+    }
+
+    Regex& regex_;
+    size_t position_;
+    int state_;
+    std::vector<size_t> registers_;   ///< Start position of each live thread
+    std::vector<size_t> scratch_;
+    bool found_ = false;
+    bool committed_ = false;          ///< A new best match needs dropLaterThreads()
+    size_t bestStart_ = 0;
+    size_t bestEnd_ = 0;
+    std::vector<Match>* matches_ = nullptr;   ///< Set when finding all matches
+    std::deque<Match> pending_;               ///< Matches some live thread may replace
+};
+
+// =============================================================================
+// Search
+// =============================================================================
+
+unsigned Regex::byteAt(const Source& source, size_t offset) {
+    unsigned byte = kEndOfInput;
+    source.visit(offset, 1, [&byte](std::string_view chunk) {
+        byte = static_cast<unsigned char>(chunk[0]);
+    });
+    return byte;
+}
+
+std::optional<Regex::Match> Regex::search(const Source& source, size_t from, size_t end) {
+    const uint8_t prevFlags = prevFlagsOf(from == 0 ? kEndOfInput : byteAt(source, from - 1));
+    Searcher searcher(*this, from, static_cast<uint8_t>(prevFlags & contextMask_));
+    bool decided = false;
+    for (size_t pos = from; pos < end && !decided; pos += kWindow) {
+        source.visit(pos, std::min(kWindow, end - pos), [&](std::string_view chunk) {
+            if (!decided) {
+                decided = searcher.feed(chunk);
+            }
+        });
+    }
+    if (!decided) {
+        searcher.finish(end < source.length ? byteAt(source, end) : kEndOfInput);
+    }
+    return searcher.result();
+}
+
+std::vector<Regex::Match> Regex::searchAll(const Source& source, size_t start, size_t end) {
+    std::vector<Match> matches;
+    const uint8_t prevFlags = prevFlagsOf(start == 0 ? kEndOfInput : byteAt(source, start - 1));
+    Searcher searcher(*this, start, static_cast<uint8_t>(prevFlags & contextMask_), matches);
+    for (size_t pos = start; pos < end; pos += kWindow) {
+        source.visit(pos, std::min(kWindow, end - pos), [&](std::string_view chunk) {
+            searcher.feed(chunk);
+        });
+    }
+    searcher.finish(end < source.length ? byteAt(source, end) : kEndOfInput);
+    return matches;
+}
+
+std::optional<Regex::Match> Regex::findNext(const IDocumentModel& text, size_t from) {
+    const Source source{text.length(), [&text](size_t start, size_t len,
+                                               const IDocumentModel::ChunkVisitor& fn) {
+        text.visitChunks(start, len, fn);
+    }};
+    if (from > source.length) {
+        return std::nullopt;
+    }
+    return search(source, from, source.length);
+}
+
+std::vector<Regex::Match> Regex::findAll(const IDocumentModel& text, size_t start, size_t len) {
+    const Source source{text.length(), [&text](size_t offset, size_t count,
+                                               const IDocumentModel::ChunkVisitor& fn) {
+        text.visitChunks(offset, count, fn);
+    }};
+    start = std::min(start, source.length);
+    return searchAll(source, start, start + std::min(len, source.length - start));
+}
+
+std::optional<Regex::Match> Regex::findNext(std::string_view text, size_t from) {
+    const Source source{text.size(), [text](size_t start, size_t len,
+                                            const IDocumentModel::ChunkVisitor& fn) {
+        fn(text.substr(start, len));
+    }};
+    if (from > source.length) {
+        return std::nullopt;
+    }
+    return search(source, from, source.length);
+}
+
+std::vector<Regex::Match> Regex::findAll(std::string_view text) {
+    const Source source{text.size(), [text](size_t start, size_t len,
+                                            const IDocumentModel::ChunkVisitor& fn) {
+        fn(text.substr(start, len));
+    }};
+    return searchAll(source, 0, source.length);
+}
+
+} // namespace mdeditor
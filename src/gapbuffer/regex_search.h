@@ -0,0 +1,213 @@
+// =============================================================================
+// regex_search.h - Streaming Regex Search over Document Chunks
+// =============================================================================
+//
+// Regex compiles a pattern to a byte-level Thompson NFA and searches with a
+// lazy DFA built from it on demand. The text is read through
+// IDocumentModel::visitChunks() in windows, so a search runs directly over a
+// GapBuffer's two segments, a PieceTable's pieces or a PieceTree's nodes and
+// never materializes the document.
+//
+// LAZY DFA:
+// ---------
+// A DFA state is the ordered list of NFA states alive at a position. States
+// and their transitions are created the first time a search needs them and
+// cached in the Regex, so once the cache is warm every input byte costs one
+// table lookup. The cache is capped at kMaxStates; when it fills it is
+// flushed and rebuilt as the search goes on, which bounds memory for
+// patterns whose full DFA would explode. While no thread is live and a
+// single byte is the only way forward (the first byte of a literal, '\n'
+// for a pattern starting with ^), the search skips to it with memchr().
+//
+// MATCH POSITIONS:
+// ----------------
+// Matches are leftmost-longest (POSIX): the match starting first wins, and
+// of those the longest. Threads in a DFA state are kept ordered by start
+// position, and the start positions live in one register per thread that
+// each transition permutes. A search therefore costs O(n * k) for n bytes,
+// where k is the number of simultaneously live threads (bounded by the
+// pattern size and usually 1-3).
+//
+// FIND ALL:
+// ---------
+// findAll() is one pass that keeps starting threads after a match is found.
+// A match stays pending while a thread that could replace it (an earlier
+// start, or a longer match from the same start) is alive. Threads starting
+// inside a pending match are dropped, and later pending matches are
+// discarded when an earlier one grows over them. Each byte is read once.
+//
+// SYNTAX:
+// -------
+//   abc é        literals (UTF-8 text matches byte for byte)
+//   .            any character except '\n' (a whole UTF-8 sequence)
+//   [a-z_] [^"]  classes; ranges must be ASCII, [^...] matches non-ASCII too
+//   \d \w \s     ASCII digit, word and space classes (\D \W \S negated)
+//   \n \t \r \f \v \\ \. ...   escapes
+//   (...) (?:...)  grouping (there are no captures)
+//   a|b  * + ?  {m} {m,} {m,n}
+//   ^ $          start and end of a line
+//   \b \B        ASCII word boundary and its negation
+// Backreferences, lookaround and lazy quantifiers are rejected with a
+// RegexError.
+//
+// A Regex is not thread-safe: searching updates its cache. Use one per
+// thread.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_REGEX_SEARCH_H
+#define MDEDITOR_REGEX_SEARCH_H
+
+#include "document_model.h"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mdeditor {
+
+// =============================================================================
+// RegexError - Invalid or unsupported pattern
+// =============================================================================
+/// Thrown by Regex for a pattern it cannot compile.
+class RegexError : public std::invalid_argument {
+public:
+    RegexError(const std::string& what, size_t position);
+
+    /// Returns the byte offset in the pattern where the problem was found.
+    [[nodiscard]] size_t position() const noexcept;
+
+private:
+    size_t position_;
+};
+
+// =============================================================================
+// Regex - Lazy-DFA regular expression search
+// =============================================================================
+class Regex {
+public:
+    /// Maximum number of cached DFA states before the cache is flushed.
+    static constexpr size_t kMaxStates = 2048;
+
+    /// A match as a byte range of the searched text.
+    struct Match {
+        size_t start;
+        size_t length;
+    };
+
+    /// Compiles pattern (see SYNTAX).
+    /// @param ignoreAsciiCase Match A-Z and a-z as equal
+    /// @throws RegexError if the pattern is malformed, unsupported or too large
+    explicit Regex(std::string_view pattern, bool ignoreAsciiCase = false);
+
+    /// Returns the first match starting at or after from, or std::nullopt.
+    [[nodiscard]] std::optional<Match> findNext(const IDocumentModel& text, size_t from = 0);
+
+    /// Returns all non-overlapping matches inside [start, start + len), in
+    /// order. An empty match is never reported right after another match.
+    /// @note Range is clamped like getText(start, len); ^, $, \b and \B see
+    ///       the text around the range
+    [[nodiscard]] std::vector<Match> findAll(const IDocumentModel& text, size_t start = 0,
+                                             size_t len = std::string_view::npos);
+
+    /// findNext() over a contiguous string.
+    [[nodiscard]] std::optional<Match> findNext(std::string_view text, size_t from = 0);
+
+    /// findAll() over a contiguous string.
+    [[nodiscard]] std::vector<Match> findAll(std::string_view text);
+
+    /// Returns the number of DFA states currently cached.
+    [[nodiscard]] size_t cachedStates() const noexcept;
+
+private:
+    /// Zero-width assertions
+    enum class Assertion : uint8_t { LineStart, LineEnd, WordBoundary, NotWordBoundary };
+
+    /// Thompson NFA node
+    struct Node {
+        enum class Kind : uint8_t { Bytes, Split, Empty, Assert, Match };
+        Kind kind;
+        Assertion assertion = Assertion::LineStart;
+        uint32_t byteSet = 0;   ///< Index into byteSets_ (Kind::Bytes)
+        int out = -1;
+        int out1 = -1;          ///< Second branch (Kind::Split)
+    };
+
+    /// A thread during DFA construction: NFA node and source register
+    struct Thread {
+        int node;
+        uint32_t source;
+    };
+
+    /// Cached transition on one input byte (or the end of the range)
+    struct Transition {
+        int target = -1;                ///< DFA state after the byte
+        int matchRank = -1;             ///< Lowest thread that matches before the byte
+        bool identity = false;          ///< sources[j] == j: registers only truncate
+        std::vector<uint32_t> sources;  ///< Register of each target thread
+    };
+
+    /// Cached DFA state
+    struct DfaState {
+        std::vector<int> nodes;         ///< Live NFA nodes, earliest start first
+        uint8_t prevFlags = 0;          ///< Class of the byte before the position
+        bool seeking = true;            ///< Still starting new threads
+        int skipByte = -2;              ///< Only byte leaving an idle state; -1 none, -2 unknown
+    };
+
+    /// Input of a search: total length and a chunk reader
+    struct Source {
+        size_t length;
+        std::function<void(size_t, size_t, const IDocumentModel::ChunkVisitor&)> visit;
+    };
+
+    class Parser;
+    class Searcher;
+
+    [[nodiscard]] std::optional<Match> search(const Source& source, size_t from, size_t end);
+    [[nodiscard]] std::vector<Match> searchAll(const Source& source, size_t start, size_t end);
+
+    /// Returns the byte at offset of source
+    [[nodiscard]] static unsigned byteAt(const Source& source, size_t offset);
+
+    /// Appends the epsilon closure of node to threads; with context set,
+    /// assertions are evaluated, otherwise kept as pending threads
+    void closure(int node, uint32_t source, const uint8_t* context, std::vector<Thread>& threads);
+
+    /// Returns the state for a thread list, creating it if needed
+    int intern(const std::vector<Thread>& threads, uint8_t prevFlags, bool seeking);
+
+    /// Computes the transition of state on byte (or kEndOfInput)
+    int computeTransition(int state, unsigned byte);
+
+    /// Returns the only byte that leaves a state without live threads, or
+    /// -1 if there are several (see DfaState::skipByte)
+    int skipByte(int state);
+
+    /// Clears the DFA cache, keeping one state alive; returns its new index
+    int flushCache(int keep);
+
+    std::vector<Node> nodes_;
+    std::vector<std::bitset<256>> byteSets_;
+    int startNode_ = 0;
+    uint8_t contextMask_ = 0;          ///< Context bits the pattern's assertions read
+
+    std::vector<DfaState> states_;
+    std::vector<Transition> transitions_;
+    std::vector<int> table_;           ///< Transition index per state and byte (+ end), or -1
+    std::vector<int> idleTable_;       ///< Target row (state * 257) if no thread lives or matches, else -1
+    std::unordered_map<std::string, int> stateIndex_;
+    std::vector<uint32_t> visited_;    ///< Closure marks, by generation
+    uint32_t generation_ = 0;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_REGEX_SEARCH_H
@@ -0,0 +1,225 @@
+// =============================================================================
+// substring_scan.cpp - Vectorized Substring Search Kernels Implementation
+// =============================================================================
+//
+// Each SIMD kernel runs the first/last byte filter while both loads fit in
+// the text and leaves the remaining positions to the scalar kernel.
+// Per-function target attributes keep the library free of -mavx2.
+//
+// =============================================================================
+
+#include "substring_scan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MDEDITOR_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MDEDITOR_TARGET(features)
+#else
+#define MDEDITOR_TARGET(features) __attribute__((target(features)))
+#endif
+#else
+#define MDEDITOR_SIMD_X86 0
+#endif
+
+namespace mdeditor {
+namespace simd {
+
+namespace {
+
+constexpr size_t kNotFound = std::string_view::npos;
+
+constexpr char toLowerAscii(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+constexpr char toUpperAscii(char c) noexcept {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+}
+
+/// Compares n bytes, folding ASCII case if asked
+bool equalBytes(const char* a, const char* b, size_t n, bool ignoreAsciiCase) noexcept {
+    if (!ignoreAsciiCase) {
+        return std::memcmp(a, b, n) == 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (toLowerAscii(a[i]) != toLowerAscii(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// Scalar kernel
+// =============================================================================
+
+/// Searches positions from offset on; pattern is not empty
+size_t findScalar(const char* data, size_t len, std::string_view pattern, size_t offset,
+                  bool ignoreAsciiCase) noexcept {
+    const std::string_view text(data, len);
+    if (!ignoreAsciiCase) {
+        return text.find(pattern, offset);
+    }
+    const size_t m = pattern.size();
+    const char first = toLowerAscii(pattern[0]);
+    for (size_t i = offset; m <= len && i <= len - m; ++i) {
+        if (toLowerAscii(data[i]) == first && equalBytes(data + i, pattern.data(), m, true)) {
+            return i;
+        }
+    }
+    return kNotFound;
+}
+
+#if MDEDITOR_SIMD_X86
+
+inline unsigned countTrailingZeros64(uint64_t value) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+/// The byte values each end of the pattern may take (equal unless ignoring
+/// case and the byte is a letter)
+struct PatternEnds {
+    char firstA;
+    char firstB;
+    char lastA;
+    char lastB;
+};
+
+PatternEnds patternEnds(std::string_view pattern, bool ignoreAsciiCase) noexcept {
+    const char first = pattern.front();
+    const char last = pattern.back();
+    if (!ignoreAsciiCase) {
+        return PatternEnds{first, first, last, last};
+    }
+    return PatternEnds{toLowerAscii(first), toUpperAscii(first),
+                       toLowerAscii(last), toUpperAscii(last)};
+}
+
+// =============================================================================
+// SSE2 kernel (x86-64 baseline)
+// =============================================================================
+
+size_t findSse2(const char* data, size_t len, std::string_view pattern,
+                bool ignoreAsciiCase) noexcept {
+    const size_t m = pattern.size();
+    const PatternEnds ends = patternEnds(pattern, ignoreAsciiCase);
+    const __m128i firstA = _mm_set1_epi8(ends.firstA);
+    const __m128i firstB = _mm_set1_epi8(ends.firstB);
+    const __m128i lastA = _mm_set1_epi8(ends.lastA);
+    const __m128i lastB = _mm_set1_epi8(ends.lastB);
+    size_t i = 0;
+
+    for (; m - 1 + 16 <= len && i <= len - (m - 1 + 16); i += 16) {
+        const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + m - 1));
+        const __m128i headMatch = _mm_or_si128(_mm_cmpeq_epi8(head, firstA), _mm_cmpeq_epi8(head, firstB));
+        const __m128i tailMatch = _mm_or_si128(_mm_cmpeq_epi8(tail, lastA), _mm_cmpeq_epi8(tail, lastB));
+        uint32_t candidates = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(headMatch, tailMatch)));
+        while (candidates != 0) {
+            const size_t position = i + countTrailingZeros64(candidates);
+            if (equalBytes(data + position, pattern.data(), m, ignoreAsciiCase)) {
+                return position;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+    return findScalar(data, len, pattern, i, ignoreAsciiCase);
+}
+
+// =============================================================================
+// AVX2 kernel
+// =============================================================================
+
+/// Per-byte match mask of the 32 positions starting at at; the B variants
+/// are compared only when ignoring case
+template <bool Fold>
+MDEDITOR_TARGET("avx2")
+inline __m256i candidatesAvx2(const char* at, size_t m, __m256i firstA, __m256i firstB,
+                              __m256i lastA, __m256i lastB) noexcept {
+    const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+    const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at + m - 1));
+    __m256i headMatch = _mm256_cmpeq_epi8(head, firstA);
+    __m256i tailMatch = _mm256_cmpeq_epi8(tail, lastA);
+    if (Fold) {
+        headMatch = _mm256_or_si256(headMatch, _mm256_cmpeq_epi8(head, firstB));
+        tailMatch = _mm256_or_si256(tailMatch, _mm256_cmpeq_epi8(tail, lastB));
+    }
+    return _mm256_and_si256(headMatch, tailMatch);
+}
+
+template <bool Fold>
+MDEDITOR_TARGET("avx2")
+size_t findAvx2(const char* data, size_t len, std::string_view pattern) noexcept {
+    const size_t m = pattern.size();
+    const PatternEnds ends = patternEnds(pattern, Fold);
+    const __m256i firstA = _mm256_set1_epi8(ends.firstA);
+    const __m256i firstB = _mm256_set1_epi8(ends.firstB);
+    const __m256i lastA = _mm256_set1_epi8(ends.lastA);
+    const __m256i lastB = _mm256_set1_epi8(ends.lastB);
+    size_t i = 0;
+
+    // Two blocks per step: candidates are rare, so one test covers 64 positions
+    for (; m - 1 + 64 <= len && i <= len - (m - 1 + 64); i += 64) {
+        const __m256i low = candidatesAvx2<Fold>(data + i, m, firstA, firstB, lastA, lastB);
+        const __m256i high = candidatesAvx2<Fold>(data + i + 32, m, firstA, firstB, lastA, lastB);
+        const __m256i any = _mm256_or_si256(low, high);
+        if (_mm256_testz_si256(any, any)) {
+            continue;
+        }
+        uint64_t candidates = static_cast<uint32_t>(_mm256_movemask_epi8(low)) |
+            (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32);
+        while (candidates != 0) {
+            const size_t position = i + countTrailingZeros64(candidates);
+            if (equalBytes(data + position, pattern.data(), m, Fold)) {
+                return position;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+    return findScalar(data, len, pattern, i, Fold);
+}
+
+#endif // MDEDITOR_SIMD_X86
+
+} // anonymous namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+size_t findSubstring(std::string_view text, std::string_view pattern,
+                     bool ignoreAsciiCase) noexcept {
+    return findSubstring(text, pattern, ignoreAsciiCase, detectedLevel());
+}
+
+size_t findSubstring(std::string_view text, std::string_view pattern,
+                     bool ignoreAsciiCase, Level level) noexcept {
+    if (pattern.empty() || pattern.size() > text.size()) {
+        return kNotFound;
+    }
+    switch (std::min(level, detectedLevel())) {
+#if MDEDITOR_SIMD_X86
+        case Level::AVX512:
+        case Level::AVX2:
+            return ignoreAsciiCase ? findAvx2<true>(text.data(), text.size(), pattern)
+                                   : findAvx2<false>(text.data(), text.size(), pattern);
+        case Level::SSE2:   return findSse2(text.data(), text.size(), pattern, ignoreAsciiCase);
+#endif
+        default:            return findScalar(text.data(), text.size(), pattern, 0, ignoreAsciiCase);
+    }
+}
+
+} // namespace simd
+} // namespace mdeditor
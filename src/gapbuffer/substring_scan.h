@@ -0,0 +1,48 @@
+// =============================================================================
+// substring_scan.h - Vectorized Substring Search Kernels
+// =============================================================================
+//
+// Finds the first occurrence of a pattern in a byte range, optionally
+// ignoring ASCII case (A-Z match a-z; other bytes, including UTF-8
+// sequences, must match exactly).
+//
+// FILTER:
+// -------
+// The SIMD kernels compare the pattern's first and last bytes against two
+// overlapping loads (text[i..] and text[i + m - 1..]) and AND the results,
+// so one vector step tests 16 or 32 candidate positions and only positions
+// whose first and last bytes both match are verified byte by byte. For
+// natural-language text this rejects nearly every position in the filter.
+// Ignoring case compares each end against both of its case variants.
+// Pathological inputs (a pattern like "aaab" in a run of 'a') degrade to
+// O(n * m) verification.
+//
+// Kernels use the same levels and runtime dispatch as newline_scan.h.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_SUBSTRING_SCAN_H
+#define MDEDITOR_SUBSTRING_SCAN_H
+
+#include "newline_scan.h"
+
+#include <cstddef>
+#include <string_view>
+
+namespace mdeditor {
+namespace simd {
+
+/// Returns the offset of the first occurrence of pattern in text, or
+/// std::string_view::npos. An empty pattern never matches.
+[[nodiscard]] size_t findSubstring(std::string_view text, std::string_view pattern,
+                                   bool ignoreAsciiCase = false) noexcept;
+
+/// Same as findSubstring(text, pattern, ignoreAsciiCase) using the given
+/// level (clamped to the CPU).
+[[nodiscard]] size_t findSubstring(std::string_view text, std::string_view pattern,
+                                   bool ignoreAsciiCase, Level level) noexcept;
+
+} // namespace simd
+} // namespace mdeditor
+
+#endif // MDEDITOR_SUBSTRING_SCAN_H
@@ -0,0 +1,104 @@
+// =============================================================================
+// text_stats.cpp - Incrementally Maintained Document Statistics Implementation
+// =============================================================================
+
+#include "text_stats.h"
+#include "newline_scan.h"
+#include "utf8_scan.h"
+
+namespace mdeditor {
+
+namespace {
+
+constexpr bool isSpace(int byte) noexcept {
+    return byte == ' ' || (byte >= '\t' && byte <= '\r');
+}
+
+/// Counts word starts in text preceded by the byte previous (kEdge counts
+/// as a space), and updates previous to the last byte of text
+size_t countWordStarts(std::string_view text, int& previous) noexcept {
+    size_t starts = 0;
+    bool afterSpace = previous == TextStats::kEdge || isSpace(previous);
+    for (const char c : text) {
+        const bool space = isSpace(static_cast<unsigned char>(c));
+        starts += static_cast<size_t>(afterSpace && !space);
+        afterSpace = space;
+    }
+    if (!text.empty()) {
+        previous = static_cast<unsigned char>(text.back());
+    }
+    return starts;
+}
+
+/// Word starts inside text and at the byte after it, given its neighbours
+size_t wordStartsAround(int before, std::string_view text, int after) noexcept {
+    int previous = before;
+    size_t starts = countWordStarts(text, previous);
+    if (after != TextStats::kEdge) {
+        const char next = static_cast<char>(after);
+        starts += countWordStarts(std::string_view(&next, 1), previous);
+    }
+    return starts;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Counts
+// =============================================================================
+
+size_t TextStats::Counts::readingMinutes(size_t wordsPerMinute) const noexcept {
+    if (wordsPerMinute == 0) {
+        return 0;
+    }
+    return (words + wordsPerMinute - 1) / wordsPerMinute;
+}
+
+// =============================================================================
+// Building and Updating
+// =============================================================================
+
+bool TextStats::valid() const noexcept {
+    return valid_;
+}
+
+void TextStats::rebuild(const IDocumentModel& text) {
+    reset();
+    int previous = kEdge;
+    text.visitChunks(0, text.length(), [&](std::string_view piece) {
+        bytes_ += piece.size();
+        characters_ += simd::countUtf8(piece).codePoints;
+        newlines_ += simd::countNewlines(piece);
+        words_ += countWordStarts(piece, previous);
+    });
+    valid_ = true;
+}
+
+void TextStats::reset() noexcept {
+    bytes_ = 0;
+    characters_ = 0;
+    words_ = 0;
+    newlines_ = 0;
+    valid_ = false;
+}
+
+void TextStats::recordEdit(int before, std::string_view removed, std::string_view inserted,
+                           int after) {
+    if (!valid_) {
+        return;
+    }
+
+    // Add the inserted side first so no count dips below zero
+    bytes_ = bytes_ + inserted.size() - removed.size();
+    characters_ = characters_ + simd::countUtf8(inserted).codePoints -
+                  simd::countUtf8(removed).codePoints;
+    newlines_ = newlines_ + simd::countNewlines(inserted) - simd::countNewlines(removed);
+    words_ = words_ + wordStartsAround(before, inserted, after) -
+             wordStartsAround(before, removed, after);
+}
+
+TextStats::Counts TextStats::totals() const noexcept {
+    return Counts{bytes_, characters_, words_, bytes_ == 0 ? 0 : newlines_ + 1};
+}
+
+} // namespace mdeditor
@@ -0,0 +1,83 @@
+// =============================================================================
+// text_stats.h - Incrementally Maintained Document Statistics
+// =============================================================================
+//
+// TextStats keeps the figures a status bar shows (characters, words, lines,
+// reading time) current as the document is edited, without rescanning it.
+//
+// DEFINITIONS:
+// ------------
+//   - characters: code points, counted at their lead byte (utf8_scan.h)
+//   - words: maximal runs of bytes that are not ASCII whitespace (space,
+//     \t, \n, \v, \f, \r), as `wc -w` counts them
+//   - lines: as IDocumentModel::lineCount(), 0 for an empty document and
+//     otherwise one more than the number of '\n'
+//
+// UPDATES:
+// --------
+// A word is counted at its first byte: a non-space byte whose predecessor
+// is a space (or the start of the text). An edit can only create or remove
+// word starts inside the edited range and at the byte right after it, so
+// recordEdit() needs the removed and inserted bytes plus one byte of
+// context on either side. Keeping the counts current costs O(edit size).
+//
+// =============================================================================
+
+#ifndef MDEDITOR_TEXT_STATS_H
+#define MDEDITOR_TEXT_STATS_H
+
+#include "document_model.h"
+
+#include <cstddef>
+#include <string_view>
+
+namespace mdeditor {
+
+/// Character, word and line counts maintained from each edit.
+class TextStats {
+public:
+    /// Reading speed assumed by Counts::readingMinutes().
+    static constexpr size_t kWordsPerMinute = 200;
+
+    /// Context byte for an edit at the start or end of the document.
+    static constexpr int kEdge = -1;
+
+    /// The statistics of a whole document (see DEFINITIONS).
+    struct Counts {
+        size_t bytes = 0;
+        size_t characters = 0;
+        size_t words = 0;
+        size_t lines = 0;
+
+        /// Returns the reading time in minutes, rounded up (0 if no words).
+        [[nodiscard]] size_t readingMinutes(size_t wordsPerMinute = kWordsPerMinute) const noexcept;
+    };
+
+    /// Returns true once built (and until reset()).
+    [[nodiscard]] bool valid() const noexcept;
+
+    /// Counts the current text. O(n), once; later edits use recordEdit().
+    void rebuild(const IDocumentModel& text);
+
+    /// Drops the counts; valid() becomes false.
+    void reset() noexcept;
+
+    /// Updates the counts for an edit that replaced removed with inserted.
+    /// before and after are the bytes next to the edit (unchanged by it),
+    /// or kEdge at the start or end of the document. No-op unless valid().
+    void recordEdit(int before, std::string_view removed, std::string_view inserted, int after);
+
+    /// Returns the statistics of the whole text.
+    [[nodiscard]] Counts totals() const noexcept;
+
+private:
+    size_t bytes_ = 0;
+    size_t characters_ = 0;
+    size_t words_ = 0;
+    size_t newlines_ = 0;
+    bool valid_ = false;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_TEXT_STATS_H
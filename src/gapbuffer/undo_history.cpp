@@ -0,0 +1,178 @@
+// =============================================================================
+// undo_history.cpp - Memory-Bounded Undo/Redo History Implementation
+// =============================================================================
+
+#include "undo_history.h"
+
+namespace mdeditor {
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+UndoHistory::UndoHistory()
+    : UndoHistory(Options{}) {
+}
+
+UndoHistory::UndoHistory(Options options)
+    : options_(options) {
+}
+
+// =============================================================================
+// Recording
+// =============================================================================
+
+void UndoHistory::record(const std::vector<Patch>& patches) {
+    for (const Patch& patch : patches) {
+        record(patch);
+    }
+}
+
+void UndoHistory::record(const Patch& patch) {
+    if (!patch.isInvertible()) {
+        // Earlier steps can't be reached past a patch we can't revert
+        clear();
+        return;
+    }
+
+    // A new edit makes the redo branch unreachable
+    for (const Transaction& step : redoStack_) {
+        bytes_ -= step.bytes;
+    }
+    redoStack_.clear();
+
+    if (sealed_ || undoStack_.empty() || !continuesLastStep(patch)) {
+        undoStack_.emplace_back();
+        sealed_ = false;
+    }
+
+    Transaction& step = undoStack_.back();
+    const size_t cost = patchCost(patch);
+    step.patches.push_back(patch);
+    step.bytes += cost;
+    bytes_ += cost;
+
+    enforceBudget();
+}
+
+void UndoHistory::sealTransaction() noexcept {
+    sealed_ = true;
+}
+
+// =============================================================================
+// Undo / Redo
+// =============================================================================
+
+bool UndoHistory::canUndo() const noexcept {
+    return !undoStack_.empty();
+}
+
+bool UndoHistory::canRedo() const noexcept {
+    return !redoStack_.empty();
+}
+
+std::vector<Patch> UndoHistory::undo(IDocumentModel& buffer) {
+    // Commit in-flight edits so they are the step being undone
+    record(buffer.flushPatches());
+    if (undoStack_.empty()) {
+        return {};
+    }
+
+    Transaction step = std::move(undoStack_.back());
+    undoStack_.pop_back();
+    apply(buffer, step.patches, true);
+    redoStack_.push_back(std::move(step));
+    sealed_ = true;
+
+    return buffer.flushPatches();
+}
+
+std::vector<Patch> UndoHistory::redo(IDocumentModel& buffer) {
+    // Pending edits would invalidate the redo branch
+    record(buffer.flushPatches());
+    if (redoStack_.empty()) {
+        return {};
+    }
+
+    Transaction step = std::move(redoStack_.back());
+    redoStack_.pop_back();
+    apply(buffer, step.patches, false);
+    undoStack_.push_back(std::move(step));
+    sealed_ = true;
+
+    return buffer.flushPatches();
+}
+
+// =============================================================================
+// Introspection
+// =============================================================================
+
+size_t UndoHistory::undoDepth() const noexcept {
+    return undoStack_.size();
+}
+
+size_t UndoHistory::redoDepth() const noexcept {
+    return redoStack_.size();
+}
+
+size_t UndoHistory::memoryUsage() const noexcept {
+    return bytes_;
+}
+
+void UndoHistory::clear() noexcept {
+    undoStack_.clear();
+    redoStack_.clear();
+    bytes_ = 0;
+    sealed_ = true;
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+size_t UndoHistory::patchCost(const Patch& patch) noexcept {
+    return sizeof(Patch) + patch.insertedText.size() + patch.removedText.size();
+}
+
+bool UndoHistory::continuesLastStep(const Patch& patch) const noexcept {
+    const Patch& last = undoStack_.back().patches.back();
+
+    if (patch.timestamp - last.timestamp > options_.groupInterval) {
+        return false;
+    }
+
+    const bool typingForward = patch.start == last.start + last.insertedText.size();
+    const bool backspacing = patch.start + patch.removedLength == last.start;
+    const bool deletingForward = patch.start == last.start && patch.insertedText.empty();
+    return typingForward || backspacing || deletingForward;
+}
+
+void UndoHistory::apply(IDocumentModel& buffer, const std::vector<Patch>& patches, bool inverse) {
+    if (inverse) {
+        for (auto it = patches.rbegin(); it != patches.rend(); ++it) {
+            buffer.erase(it->start, it->insertedText.size());
+            buffer.insert(it->start, it->removedText);
+        }
+    } else {
+        for (const Patch& patch : patches) {
+            buffer.erase(patch.start, patch.removedLength);
+            buffer.insert(patch.start, patch.insertedText);
+        }
+    }
+}
+
+void UndoHistory::enforceBudget() {
+    while (bytes_ > options_.byteBudget && !undoStack_.empty()) {
+        bytes_ -= undoStack_.front().bytes;
+        undoStack_.pop_front();
+    }
+    while (bytes_ > options_.byteBudget && !redoStack_.empty()) {
+        bytes_ -= redoStack_.front().bytes;
+        redoStack_.pop_front();
+    }
+    if (undoStack_.empty()) {
+        sealed_ = true;
+    }
+}
+
+} // namespace mdeditor
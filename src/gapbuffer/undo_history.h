@@ -0,0 +1,142 @@
+// =============================================================================
+// undo_history.h - Memory-Bounded Undo/Redo History
+// =============================================================================
+//
+// UndoHistory records the invertible patches flushed from a document model
+// (any IDocumentModel) and replays them backwards (undo) or forwards (redo).
+// No text snapshots are kept: each step costs O(size of its patches).
+//
+// TRANSACTIONS:
+// -------------
+// Consecutive patches are grouped into one undo step when they arrive within
+// groupInterval of each other AND touch adjacent positions (typing forward,
+// backspacing, or deleting forward at the same spot). sealTransaction()
+// forces the next patch into a new step, e.g. after a cursor jump or save.
+//
+// MEMORY BUDGET:
+// --------------
+// The history counts the text held by its patches plus a fixed per-patch
+// overhead. When the total exceeds byteBudget, the oldest undo steps are
+// dropped first, then the redo steps furthest from the current state.
+//
+// USAGE:
+// ------
+//   GapBuffer buffer;
+//   UndoHistory history;
+//   buffer.insert(0, "Hello");
+//   history.record(buffer.flushPatches());
+//   history.undo(buffer);   // buffer is empty again
+//   history.redo(buffer);   // "Hello"
+//
+// =============================================================================
+
+#ifndef MDEDITOR_UNDO_HISTORY_H
+#define MDEDITOR_UNDO_HISTORY_H
+
+#include "document_model.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace mdeditor {
+
+/// UndoHistory groups patches into transactions and applies their inverses.
+class UndoHistory {
+public:
+    /// Tuning knobs for grouping and memory use.
+    struct Options {
+        size_t byteBudget = 16 * 1024 * 1024;                ///< Max bytes retained
+        std::chrono::milliseconds groupInterval{1000};       ///< Max pause within a step
+    };
+
+    /// Constructs a history with default options.
+    UndoHistory();
+
+    /// Constructs a history with the given options.
+    explicit UndoHistory(Options options);
+
+    // -------------------------------------------------------------------------
+    // Recording
+    // -------------------------------------------------------------------------
+
+    /// Records patches (typically from IDocumentModel::flushPatches()).
+    /// Recording a new edit discards the redo steps.
+    /// @note Patches that are not invertible end the history: everything
+    ///       recorded so far is dropped, since it can no longer be reached.
+    void record(const std::vector<Patch>& patches);
+
+    /// Records a single patch.
+    void record(const Patch& patch);
+
+    /// Makes the next recorded patch start a new undo step.
+    void sealTransaction() noexcept;
+
+    // -------------------------------------------------------------------------
+    // Undo / Redo
+    // -------------------------------------------------------------------------
+
+    /// Returns true if there is a step to undo.
+    [[nodiscard]] bool canUndo() const noexcept;
+
+    /// Returns true if there is a step to redo.
+    [[nodiscard]] bool canRedo() const noexcept;
+
+    /// Reverts the most recent step. Pending patches of the buffer are
+    /// recorded first so no edit is lost.
+    /// @param buffer The buffer the patches were recorded from
+    /// @return The patches applied to the buffer (for downstream consumers;
+    ///         they are not recorded as new edits)
+    std::vector<Patch> undo(IDocumentModel& buffer);
+
+    /// Re-applies the most recently undone step.
+    /// @param buffer The buffer the patches were recorded from
+    /// @return The patches applied to the buffer
+    std::vector<Patch> redo(IDocumentModel& buffer);
+
+    // -------------------------------------------------------------------------
+    // Introspection
+    // -------------------------------------------------------------------------
+
+    /// Returns the number of undo steps available.
+    [[nodiscard]] size_t undoDepth() const noexcept;
+
+    /// Returns the number of redo steps available.
+    [[nodiscard]] size_t redoDepth() const noexcept;
+
+    /// Returns the bytes currently counted against the budget.
+    [[nodiscard]] size_t memoryUsage() const noexcept;
+
+    /// Drops all undo and redo steps.
+    void clear() noexcept;
+
+private:
+    /// One undo step: patches in application order
+    struct Transaction {
+        std::vector<Patch> patches;
+        size_t bytes = 0;
+    };
+
+    /// Bytes a patch is charged against the budget
+    static size_t patchCost(const Patch& patch) noexcept;
+
+    /// Returns true if patch continues the last patch of the open step
+    bool continuesLastStep(const Patch& patch) const noexcept;
+
+    /// Applies patches to the buffer (inverted and in reverse when undoing)
+    static void apply(IDocumentModel& buffer, const std::vector<Patch>& patches, bool inverse);
+
+    /// Drops the oldest steps until memoryUsage() fits the budget
+    void enforceBudget();
+
+    Options options_;
+    std::deque<Transaction> undoStack_;   ///< Oldest at front
+    std::deque<Transaction> redoStack_;   ///< Next redo at back
+    size_t bytes_ = 0;
+    bool sealed_ = true;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_UNDO_HISTORY_H
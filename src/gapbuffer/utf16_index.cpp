@@ -0,0 +1,271 @@
+// =============================================================================
+// utf16_index.cpp - UTF-8 Byte / UTF-16 / Code Point Offset Index Implementation
+// =============================================================================
+
+#include "utf16_index.h"
+#include "utf8_scan.h"
+
+#include <algorithm>
+
+namespace mdeditor {
+
+namespace {
+
+using Counts = Utf16Index::Counts;
+
+/// Bytes skipped per kernel call while scanning a chunk
+constexpr size_t kScanBlock = 64;
+
+Counts countOf(std::string_view text) noexcept {
+    const simd::Utf8Counts counts = simd::countUtf8(text);
+    return Counts{text.size(), counts.codePoints, counts.utf16Units};
+}
+
+void addTo(Counts& target, const Counts& delta) noexcept {
+    target.bytes += delta.bytes;
+    target.codePoints += delta.codePoints;
+    target.utf16Units += delta.utf16Units;
+}
+
+/// Additive inverse in modular arithmetic, so addTo() can subtract
+Counts negated(const Counts& counts) noexcept {
+    return Counts{0 - counts.bytes, 0 - counts.codePoints, 0 - counts.utf16Units};
+}
+
+/// Appends text to a chunk list, filling the last chunk up to kChunkSize
+void appendChunked(std::vector<Counts>& chunks, std::string_view text) {
+    while (!text.empty()) {
+        if (chunks.empty() || chunks.back().bytes >= Utf16Index::kChunkSize) {
+            chunks.emplace_back();
+        }
+        const size_t take = std::min(text.size(), Utf16Index::kChunkSize - chunks.back().bytes);
+        addTo(chunks.back(), countOf(text.substr(0, take)));
+        text.remove_prefix(take);
+    }
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Building and Updating
+// =============================================================================
+
+bool Utf16Index::valid() const noexcept {
+    return valid_;
+}
+
+void Utf16Index::rebuild(const IDocumentModel& text) {
+    chunks_.clear();
+    text.visitChunks(0, text.length(), [this](std::string_view piece) {
+        appendChunked(chunks_, piece);
+    });
+    rebuildTree();
+    valid_ = true;
+}
+
+void Utf16Index::reset() noexcept {
+    chunks_.clear();
+    tree_.clear();
+    totals_ = Counts{};
+    valid_ = false;
+}
+
+void Utf16Index::recordEdit(size_t offset, std::string_view removed, std::string_view inserted) {
+    if (!valid_) {
+        return;
+    }
+    // An edit the index cannot place means it is out of sync; rebuild later
+    if (offset > totals_.bytes || removed.size() > totals_.bytes - offset) {
+        reset();
+        return;
+    }
+
+    if (!removed.empty()) {
+        // Subtract the removed bytes chunk by chunk, in pre-edit coordinates
+        const Location first = descend(&Counts::bytes, offset);
+        size_t chunkStart = first.before.bytes;
+        size_t position = offset;
+        bool emptied = false;
+        for (size_t chunk = first.chunk; !removed.empty(); ++chunk) {
+            const size_t chunkEnd = chunkStart + chunks_[chunk].bytes;
+            const size_t take = std::min(removed.size(), chunkEnd - position);
+            add(chunk, negated(countOf(removed.substr(0, take))));
+            emptied |= chunks_[chunk].bytes == 0;
+            removed.remove_prefix(take);
+            position += take;
+            chunkStart = chunkEnd;
+        }
+        if (emptied) {
+            chunks_.erase(std::remove_if(chunks_.begin(), chunks_.end(),
+                                         [](const Counts& c) { return c.bytes == 0; }),
+                          chunks_.end());
+            rebuildTree();
+        }
+    }
+
+    if (!inserted.empty()) {
+        if (chunks_.empty()) {
+            chunks_.push_back(countOf(inserted));
+            rebuildTree();
+        } else {
+            // At the very end the text joins the last chunk
+            const size_t chunk = offset == totals_.bytes
+                ? chunks_.size() - 1
+                : descend(&Counts::bytes, offset).chunk;
+            add(chunk, countOf(inserted));
+        }
+    }
+}
+
+Utf16Index::Counts Utf16Index::totals() const noexcept {
+    return totals_;
+}
+
+// =============================================================================
+// Lookups
+// =============================================================================
+
+size_t Utf16Index::utf16FromOffset(const IDocumentModel& text, size_t offset) {
+    return convert(text, &Counts::bytes, offset, &Counts::utf16Units);
+}
+
+size_t Utf16Index::offsetFromUtf16(const IDocumentModel& text, size_t utf16Offset) {
+    return convert(text, &Counts::utf16Units, utf16Offset, &Counts::bytes);
+}
+
+size_t Utf16Index::codePointFromOffset(const IDocumentModel& text, size_t offset) {
+    return convert(text, &Counts::bytes, offset, &Counts::codePoints);
+}
+
+size_t Utf16Index::offsetFromCodePoint(const IDocumentModel& text, size_t codePoint) {
+    return convert(text, &Counts::codePoints, codePoint, &Counts::bytes);
+}
+
+size_t Utf16Index::convert(const IDocumentModel& text, Unit from, size_t target, Unit to) {
+    if (target >= totals_.*from) {
+        return totals_.*to;
+    }
+    const Location location = locate(text, from, target);
+    if (from != &Counts::bytes) {
+        return scanChunk(text, location, from, target);
+    }
+
+    // Count from the chunk start up to the offset
+    Counts counts;
+    text.visitChunks(location.before.bytes, target - location.before.bytes,
+                     [&counts](std::string_view piece) {
+        addTo(counts, countOf(piece));
+    });
+    return location.before.*to + counts.*to;
+}
+
+Utf16Index::Location Utf16Index::locate(const IDocumentModel& text, Unit unit, size_t target) {
+    Location location = descend(unit, target);
+    if (chunks_[location.chunk].bytes > 2 * kChunkSize) {
+        split(text, location.chunk, location.before.bytes);
+        location = descend(unit, target);
+    }
+    return location;
+}
+
+Utf16Index::Location Utf16Index::descend(Unit unit, size_t target) const noexcept {
+    const size_t count = chunks_.size();
+    size_t step = 1;
+    while (step * 2 <= count) {
+        step *= 2;
+    }
+
+    Location location{0, Counts{}};
+    for (; step > 0; step /= 2) {
+        const size_t next = location.chunk + step;
+        if (next <= count && location.before.*unit + tree_[next].*unit <= target) {
+            location.chunk = next;
+            addTo(location.before, tree_[next]);
+        }
+    }
+    return location;
+}
+
+size_t Utf16Index::scanChunk(const IDocumentModel& text, const Location& location,
+                             Unit unit, size_t target) const {
+    const bool utf16 = unit == &Counts::utf16Units;
+    size_t reached = location.before.*unit;
+    size_t pieceStart = location.before.bytes;
+    size_t found = std::string_view::npos;
+
+    text.visitChunks(location.before.bytes, chunks_[location.chunk].bytes,
+                     [&](std::string_view piece) {
+        if (found != std::string_view::npos) {
+            return;
+        }
+        // Skip whole blocks with the kernels, then walk the block that
+        // holds the target byte by byte
+        size_t i = 0;
+        while (piece.size() - i >= kScanBlock) {
+            const simd::Utf8Counts block = simd::countUtf8(piece.substr(i, kScanBlock));
+            const size_t units = utf16 ? block.utf16Units : block.codePoints;
+            if (reached + units > target) {
+                break;
+            }
+            reached += units;
+            i += kScanBlock;
+        }
+        for (; i < piece.size(); ++i) {
+            const auto byte = static_cast<unsigned char>(piece[i]);
+            if ((byte & 0xC0u) == 0x80u) {
+                continue;
+            }
+            const size_t units = (utf16 && byte >= 0xF0u) ? 2 : 1;
+            if (reached + units > target) {
+                found = pieceStart + i;
+                return;
+            }
+            reached += units;
+        }
+        pieceStart += piece.size();
+    });
+
+    // The target is inside the chunk by construction; stay safe otherwise
+    return found != std::string_view::npos
+        ? found
+        : location.before.bytes + chunks_[location.chunk].bytes;
+}
+
+// =============================================================================
+// Chunk Maintenance
+// =============================================================================
+
+void Utf16Index::split(const IDocumentModel& text, size_t index, size_t chunkStart) {
+    std::vector<Counts> pieces;
+    text.visitChunks(chunkStart, chunks_[index].bytes, [&pieces](std::string_view piece) {
+        appendChunked(pieces, piece);
+    });
+    chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(index));
+    chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(index), pieces.begin(), pieces.end());
+    rebuildTree();
+}
+
+void Utf16Index::add(size_t index, const Counts& delta) noexcept {
+    addTo(chunks_[index], delta);
+    addTo(totals_, delta);
+    for (size_t i = index + 1; i < tree_.size(); i += i & (0 - i)) {
+        addTo(tree_[i], delta);
+    }
+}
+
+void Utf16Index::rebuildTree() {
+    // O(n) construction: each node passes its sum on to its parent
+    const size_t count = chunks_.size();
+    tree_.assign(count + 1, Counts{});
+    totals_ = Counts{};
+    for (size_t i = 1; i <= count; ++i) {
+        addTo(tree_[i], chunks_[i - 1]);
+        addTo(totals_, chunks_[i - 1]);
+        const size_t parent = i + (i & (0 - i));
+        if (parent <= count) {
+            addTo(tree_[parent], tree_[i]);
+        }
+    }
+}
+
+} // namespace mdeditor
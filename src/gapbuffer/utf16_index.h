@@ -0,0 +1,131 @@
+// =============================================================================
+// utf16_index.h - UTF-8 Byte / UTF-16 / Code Point Offset Index
+// =============================================================================
+//
+// The text models address text in UTF-8 bytes; Qt and QML count UTF-16 code
+// units, and some consumers count code points. Utf16Index maps between the
+// three in O(log n) without converting the document.
+//
+// STRUCTURE:
+// ----------
+// The document is divided into chunks of about kChunkSize bytes. Each chunk
+// stores its byte, code point and UTF-16 unit counts, and a Fenwick tree
+// over the chunks gives prefix sums of all three. A lookup finds the chunk
+// in O(log n) and then counts inside that one chunk with the SIMD kernels
+// of utf8_scan.h. Chunk boundaries need not fall between characters: a
+// character is counted at its lead byte.
+//
+// UPDATES:
+// --------
+// recordEdit() adjusts the counts from the removed and inserted bytes
+// alone, so keeping the index current costs O(edit size + log n) and never
+// reads the document. A chunk that grows past twice kChunkSize is split the
+// next time a lookup lands in it.
+//
+// ROUNDING:
+// ---------
+// A byte offset inside a multi-byte character maps to the position after
+// that character; a UTF-16 offset between the halves of a surrogate pair
+// maps to the start of the character.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_UTF16_INDEX_H
+#define MDEDITOR_UTF16_INDEX_H
+
+#include "document_model.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+/// Incrementally maintained byte <-> UTF-16 <-> code point mapping.
+class Utf16Index {
+public:
+    /// Target chunk size in bytes.
+    static constexpr size_t kChunkSize = 4096;
+
+    /// Size of a range in each unit.
+    struct Counts {
+        size_t bytes = 0;
+        size_t codePoints = 0;
+        size_t utf16Units = 0;
+    };
+
+    /// Returns true once built (and until reset()).
+    [[nodiscard]] bool valid() const noexcept;
+
+    /// Builds the index from the current text.
+    void rebuild(const IDocumentModel& text);
+
+    /// Drops the index; valid() becomes false.
+    void reset() noexcept;
+
+    /// Updates the counts for an edit that replaced removed with inserted
+    /// at byte offset. No-op unless valid().
+    void recordEdit(size_t offset, std::string_view removed, std::string_view inserted);
+
+    /// Returns the size of the whole text in each unit.
+    [[nodiscard]] Counts totals() const noexcept;
+
+    // -------------------------------------------------------------------------
+    // Lookups (text must be the document the index describes)
+    // -------------------------------------------------------------------------
+
+    /// Returns the UTF-16 offset of a byte offset (clamped to the end).
+    [[nodiscard]] size_t utf16FromOffset(const IDocumentModel& text, size_t offset);
+
+    /// Returns the byte offset of a UTF-16 offset (clamped to the end).
+    [[nodiscard]] size_t offsetFromUtf16(const IDocumentModel& text, size_t utf16Offset);
+
+    /// Returns the code point index of a byte offset (clamped to the end).
+    [[nodiscard]] size_t codePointFromOffset(const IDocumentModel& text, size_t offset);
+
+    /// Returns the byte offset of a code point index (clamped to the end).
+    [[nodiscard]] size_t offsetFromCodePoint(const IDocumentModel& text, size_t codePoint);
+
+private:
+    /// One of the Counts fields
+    using Unit = size_t Counts::*;
+
+    /// A chunk found by locate() with the counts of everything before it
+    struct Location {
+        size_t chunk;
+        Counts before;
+    };
+
+    /// Maps position target in unit from to unit to
+    size_t convert(const IDocumentModel& text, Unit from, size_t target, Unit to);
+
+    /// Finds the chunk holding position target (< totals() in unit),
+    /// splitting it first if it is oversized
+    Location locate(const IDocumentModel& text, Unit unit, size_t target);
+
+    /// Fenwick descent: the chunk after the last prefix in unit <= target
+    [[nodiscard]] Location descend(Unit unit, size_t target) const noexcept;
+
+    /// Returns the byte offset where position target (in unit, code points
+    /// or UTF-16) falls inside the located chunk
+    [[nodiscard]] size_t scanChunk(const IDocumentModel& text, const Location& location,
+                                   Unit unit, size_t target) const;
+
+    /// Replaces chunk index with pieces of about kChunkSize bytes
+    void split(const IDocumentModel& text, size_t index, size_t chunkStart);
+
+    /// Adds delta to chunk index (modular arithmetic: removals wrap)
+    void add(size_t index, const Counts& delta) noexcept;
+
+    /// Rebuilds the Fenwick tree and totals from chunks_
+    void rebuildTree();
+
+    std::vector<Counts> chunks_;   ///< Per-chunk counts, in document order
+    std::vector<Counts> tree_;     ///< Fenwick tree over chunks_ (1-based)
+    Counts totals_;
+    bool valid_ = false;
+};
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_UTF16_INDEX_H
@@ -0,0 +1,406 @@
+// =============================================================================
+// utf8_scan.cpp - Vectorized UTF-8 Counting and Validation Kernels
+// =============================================================================
+//
+// Each counting kernel classifies bytes with two compares (continuation
+// byte, 4-byte lead) and accumulates both in byte counters, like the newline
+// kernels. The validation kernels share one scalar walker, which also pins
+// down the exact offset once a vector block has failed.
+// Per-function target attributes keep the library free of -mavx2.
+//
+// =============================================================================
+
+#include "utf8_scan.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MDEDITOR_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MDEDITOR_TARGET(features)
+#else
+#define MDEDITOR_TARGET(features) __attribute__((target(features)))
+#endif
+#else
+#define MDEDITOR_SIMD_X86 0
+#endif
+
+namespace mdeditor {
+namespace simd {
+
+namespace {
+
+/// Byte-wise counts before converting to code points and UTF-16 units
+struct ByteClasses {
+    size_t continuations = 0;   ///< 10xxxxxx
+    size_t fourByteLeads = 0;   ///< 11110xxx (and invalid 11111xxx)
+};
+
+Utf8Counts toCounts(size_t bytes, ByteClasses classes) noexcept {
+    const size_t codePoints = bytes - classes.continuations;
+    return Utf8Counts{codePoints, codePoints + classes.fourByteLeads};
+}
+
+// =============================================================================
+// Scalar kernel
+// =============================================================================
+
+ByteClasses classifyScalar(const char* data, size_t len) noexcept {
+    ByteClasses classes;
+    for (size_t i = 0; i < len; ++i) {
+        const auto byte = static_cast<unsigned char>(data[i]);
+        classes.continuations += ((byte & 0xC0u) == 0x80u);
+        classes.fourByteLeads += (byte >= 0xF0u);
+    }
+    return classes;
+}
+
+/// Result of the validation kernels for valid input
+constexpr size_t kValid = std::string_view::npos;
+
+/// Checks the sequences that start in [i, stop); i must be a sequence
+/// boundary and is left after the last sequence checked. Returns the start
+/// of the first bad sequence, or kValid.
+size_t walkScalar(const char* data, size_t len, size_t& i, size_t stop) noexcept {
+    while (i < len && i < stop) {
+        const auto lead = static_cast<unsigned char>(data[i]);
+        if (lead < 0x80u) {
+            ++i;
+            continue;
+        }
+
+        // Sequence length and the allowed range of the first continuation
+        // byte, which rules out overlong forms, surrogates and > U+10FFFF
+        size_t continuations = 0;
+        unsigned char low = 0x80u;
+        unsigned char high = 0xBFu;
+        if (lead >= 0xC2u && lead <= 0xDFu) {
+            continuations = 1;
+        } else if (lead >= 0xE0u && lead <= 0xEFu) {
+            continuations = 2;
+            low = (lead == 0xE0u) ? 0xA0u : 0x80u;
+            high = (lead == 0xEDu) ? 0x9Fu : 0xBFu;
+        } else if (lead >= 0xF0u && lead <= 0xF4u) {
+            continuations = 3;
+            low = (lead == 0xF0u) ? 0x90u : 0x80u;
+            high = (lead == 0xF4u) ? 0x8Fu : 0xBFu;
+        } else {
+            return i;
+        }
+
+        if (len - i <= continuations) {
+            return i;
+        }
+        for (size_t k = 1; k <= continuations; ++k) {
+            const auto byte = static_cast<unsigned char>(data[i + k]);
+            if (byte < low || byte > high) {
+                return i;
+            }
+            low = 0x80u;
+            high = 0xBFu;
+        }
+        i += continuations + 1;
+    }
+    return kValid;
+}
+
+/// Returns the start of the first bad sequence at or after start, or kValid
+size_t validateScalar(const char* data, size_t len, size_t start) noexcept {
+    return walkScalar(data, len, start, len);
+}
+
+/// Backs up from offset over at most three continuation bytes to the lead
+/// byte of the sequence that contains it
+size_t sequenceStart(const char* data, size_t offset) noexcept {
+    size_t start = offset;
+    while (start > 0 && offset - start < 3 && isContinuationByte(data[start])) {
+        --start;
+    }
+    return start;
+}
+
+#if MDEDITOR_SIMD_X86
+
+inline unsigned popcount64(uint64_t value) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned>((value * 0x0101010101010101ULL) >> 56);
+#else
+    return static_cast<unsigned>(__builtin_popcountll(value));
+#endif
+}
+
+// =============================================================================
+// SSE2 kernel (x86-64 baseline)
+// =============================================================================
+
+ByteClasses classifySse2(const char* data, size_t len) noexcept {
+    // As signed bytes, continuation bytes are exactly those below -64
+    const __m128i continuationLimit = _mm_set1_epi8(-64);
+    const __m128i leadBits = _mm_set1_epi8(static_cast<char>(0xF0));
+    const __m128i zero = _mm_setzero_si128();
+    ByteClasses classes;
+    size_t i = 0;
+
+    while (len - i >= 16) {
+        // Byte counters overflow after 255 blocks; fold them with SAD first
+        const size_t blocks = std::min<size_t>((len - i) / 16, 255);
+        __m128i continuations = zero;
+        __m128i fourByteLeads = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            continuations = _mm_sub_epi8(continuations, _mm_cmpgt_epi8(continuationLimit, chunk));
+            fourByteLeads = _mm_sub_epi8(fourByteLeads,
+                _mm_cmpeq_epi8(_mm_and_si128(chunk, leadBits), leadBits));
+        }
+        const __m128i continuationSums = _mm_sad_epu8(continuations, zero);
+        const __m128i leadSums = _mm_sad_epu8(fourByteLeads, zero);
+        classes.continuations += static_cast<size_t>(_mm_cvtsi128_si32(continuationSums)) +
+                                 static_cast<size_t>(_mm_extract_epi16(continuationSums, 4));
+        classes.fourByteLeads += static_cast<size_t>(_mm_cvtsi128_si32(leadSums)) +
+                                 static_cast<size_t>(_mm_extract_epi16(leadSums, 4));
+    }
+
+    const ByteClasses tail = classifyScalar(data + i, len - i);
+    classes.continuations += tail.continuations;
+    classes.fourByteLeads += tail.fourByteLeads;
+    return classes;
+}
+
+// =============================================================================
+// AVX2 kernel
+// =============================================================================
+
+MDEDITOR_TARGET("avx2")
+ByteClasses classifyAvx2(const char* data, size_t len) noexcept {
+    const __m256i continuationLimit = _mm256_set1_epi8(-64);
+    const __m256i leadBits = _mm256_set1_epi8(static_cast<char>(0xF0));
+    const __m256i zero = _mm256_setzero_si256();
+    ByteClasses classes;
+    size_t i = 0;
+
+    while (len - i >= 32) {
+        const size_t blocks = std::min<size_t>((len - i) / 32, 255);
+        __m256i continuations = zero;
+        __m256i fourByteLeads = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            continuations = _mm256_sub_epi8(continuations,
+                _mm256_cmpgt_epi8(continuationLimit, chunk));
+            fourByteLeads = _mm256_sub_epi8(fourByteLeads,
+                _mm256_cmpeq_epi8(_mm256_and_si256(chunk, leadBits), leadBits));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_sad_epu8(continuations, zero));
+        classes.continuations += static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_sad_epu8(fourByteLeads, zero));
+        classes.fourByteLeads += static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+
+    const ByteClasses tail = classifySse2(data + i, len - i);
+    classes.continuations += tail.continuations;
+    classes.fourByteLeads += tail.fourByteLeads;
+    return classes;
+}
+
+// =============================================================================
+// AVX-512BW kernel
+// =============================================================================
+
+MDEDITOR_TARGET("avx512f,avx512bw,popcnt")
+ByteClasses classifyAvx512(const char* data, size_t len) noexcept {
+    const __m512i continuationLimit = _mm512_set1_epi8(-64);
+    const __m512i leadLimit = _mm512_set1_epi8(static_cast<char>(0xF0));
+    ByteClasses classes;
+    size_t i = 0;
+
+    for (; len - i >= 64; i += 64) {
+        const __m512i chunk = _mm512_loadu_si512(data + i);
+        classes.continuations += popcount64(_mm512_cmplt_epi8_mask(chunk, continuationLimit));
+        classes.fourByteLeads += popcount64(_mm512_cmpge_epu8_mask(chunk, leadLimit));
+    }
+
+    const ByteClasses tail = classifyAvx2(data + i, len - i);
+    classes.continuations += tail.continuations;
+    classes.fourByteLeads += tail.fourByteLeads;
+    return classes;
+}
+
+// =============================================================================
+// Validation kernels
+// =============================================================================
+
+size_t validateSse2(const char* data, size_t len) noexcept {
+    // Skip ASCII blocks; walk everything else with the scalar validator up
+    // to the next block boundary it reaches
+    size_t i = 0;
+    while (len - i >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(chunk) == 0) {
+            i += 16;
+            continue;
+        }
+        // Stops after the sequence that crosses the block boundary
+        const size_t error = walkScalar(data, len, i, i + 16);
+        if (error != kValid) {
+            return error;
+        }
+    }
+    return validateScalar(data, len, i);
+}
+
+/// Keiser-Lemire byte-pair classification: a 32-byte lane of error bits
+MDEDITOR_TARGET("avx2")
+inline __m256i classifyPairsAvx2(__m256i input, __m256i previous) noexcept {
+    // Error classes (one bit each) a pair of consecutive bytes can exhibit
+    constexpr char kTooShort = 1 << 0;      // Lead not followed by continuation
+    constexpr char kTooLong = 1 << 1;       // ASCII followed by continuation
+    constexpr char kOverlong3 = 1 << 2;
+    constexpr char kTooLarge = 1 << 3;
+    constexpr char kSurrogate = 1 << 4;
+    constexpr char kOverlong2 = 1 << 5;
+    constexpr char kTooLarge1000 = 1 << 6;
+    constexpr char kOverlong4 = 1 << 6;
+    constexpr char kTwoConts = static_cast<char>(1 << 7);
+    constexpr char kCarry = kTooShort | kTooLong | kTwoConts;
+
+    const __m256i byte1HighTable = _mm256_setr_epi8(
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+    const __m256i byte1LowTable = _mm256_setr_epi8(
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry, kCarry,
+        kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry, kCarry,
+        kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000);
+    const __m256i byte2HighTable = _mm256_setr_epi8(
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort);
+
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    // The bytes 1, 2 and 3 positions earlier, across the lane boundary
+    const __m256i carried = _mm256_permute2x128_si256(previous, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, carried, 15);
+    const __m256i prev2 = _mm256_alignr_epi8(input, carried, 14);
+    const __m256i prev3 = _mm256_alignr_epi8(input, carried, 13);
+
+    const __m256i byte1High = _mm256_shuffle_epi8(byte1HighTable,
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble));
+    const __m256i byte1Low = _mm256_shuffle_epi8(byte1LowTable,
+        _mm256_and_si256(prev1, lowNibble));
+    const __m256i byte2High = _mm256_shuffle_epi8(byte2HighTable,
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble));
+    const __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    // Third and fourth bytes of 3- and 4-byte sequences must be continuations
+    const __m256i thirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m256i fourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m256i must23 = _mm256_and_si256(_mm256_or_si256(thirdByte, fourthByte),
+                                            _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+MDEDITOR_TARGET("avx2")
+size_t validateAvx2(const char* data, size_t len) noexcept {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i previous = zero;
+    size_t i = 0;
+
+    for (; len - i >= 32; i += 32) {
+        const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i error = zero;
+        if (_mm256_movemask_epi8(input) == 0) {
+            // All ASCII: only a sequence cut off at the end of the previous
+            // block can be wrong (its lead is one of the last three bytes)
+            const __m256i lastBytes = _mm256_permute2x128_si256(previous, previous, 0x11);
+            const __m256i limits = _mm256_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1),
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+            error = _mm256_subs_epu8(lastBytes, limits);
+        } else {
+            error = classifyPairsAvx2(input, previous);
+        }
+        if (!_mm256_testz_si256(error, error)) {
+            // The first bad sequence starts in this block or is cut off at
+            // the end of the previous one; the scalar walker finds it
+            return validateScalar(data, len, i > 0 ? sequenceStart(data, i - 1) : 0);
+        }
+        previous = input;
+    }
+
+    // Re-check the sequence that crosses into the tail with the tail itself
+    return validateScalar(data, len, i > 0 ? sequenceStart(data, i - 1) : 0);
+}
+
+#endif // MDEDITOR_SIMD_X86
+
+} // anonymous namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+Utf8Counts countUtf8(std::string_view text) noexcept {
+    return countUtf8(text, detectedLevel());
+}
+
+Utf8Counts countUtf8(std::string_view text, Level level) noexcept {
+    switch (std::min(level, detectedLevel())) {
+#if MDEDITOR_SIMD_X86
+        case Level::AVX512: return toCounts(text.size(), classifyAvx512(text.data(), text.size()));
+        case Level::AVX2:   return toCounts(text.size(), classifyAvx2(text.data(), text.size()));
+        case Level::SSE2:   return toCounts(text.size(), classifySse2(text.data(), text.size()));
+#endif
+        default:            return toCounts(text.size(), classifyScalar(text.data(), text.size()));
+    }
+}
+
+size_t findInvalidUtf8(std::string_view text) noexcept {
+    return findInvalidUtf8(text, detectedLevel());
+}
+
+size_t findInvalidUtf8(std::string_view text, Level level) noexcept {
+    switch (std::min(level, detectedLevel())) {
+#if MDEDITOR_SIMD_X86
+        case Level::AVX512:
+        case Level::AVX2:   return validateAvx2(text.data(), text.size());
+        case Level::SSE2:   return validateSse2(text.data(), text.size());
+#endif
+        default:            return validateScalar(text.data(), text.size(), 0);
+    }
+}
+
+} // namespace simd
+} // namespace mdeditor
@@ -0,0 +1,68 @@
+// =============================================================================
+// utf8_scan.h - Vectorized UTF-8 Counting and Validation Kernels
+// =============================================================================
+//
+// Counts what a UTF-8 byte range amounts to in other encodings: code points
+// (every byte that is not a continuation byte 10xxxxxx starts one) and
+// UTF-16 code units (one per code point, plus one more for each 4-byte lead
+// 11110xxx, which becomes a surrogate pair). Each count is attributed to
+// the lead byte, so counts of adjacent ranges add up even when a range
+// boundary splits a sequence.
+//
+// Malformed input is counted byte-wise by the same rules; it is not
+// validated by the counting kernels.
+//
+// VALIDATION:
+// -----------
+// findInvalidUtf8() checks well-formed UTF-8 (RFC 3629: no overlong forms,
+// no surrogates, nothing above U+10FFFF, no truncated sequences) and
+// reports where the first bad sequence starts. The AVX2 kernel is the
+// lookup-table algorithm of Keiser and Lemire ("Validating UTF-8 In Less
+// Than One Instruction Per Byte", 2021), which classifies every byte pair
+// with three 16-entry shuffles; the SSE2 kernel skips ASCII 16 bytes at a
+// time and walks other runs. When a vector block fails, the scalar walker
+// resumes at that block to find the exact offset.
+//
+// Kernels use the same levels and runtime dispatch as newline_scan.h.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_UTF8_SCAN_H
+#define MDEDITOR_UTF8_SCAN_H
+
+#include "newline_scan.h"
+
+#include <cstddef>
+#include <string_view>
+
+namespace mdeditor {
+namespace simd {
+
+/// Code points and UTF-16 code units in a UTF-8 byte range.
+struct Utf8Counts {
+    size_t codePoints = 0;
+    size_t utf16Units = 0;
+};
+
+/// Counts code points and UTF-16 units in text using the detected level.
+[[nodiscard]] Utf8Counts countUtf8(std::string_view text) noexcept;
+
+/// Same as countUtf8(text) using the given level (clamped to the CPU).
+[[nodiscard]] Utf8Counts countUtf8(std::string_view text, Level level) noexcept;
+
+/// Returns the offset of the first byte of the first invalid or truncated
+/// sequence in text, or std::string_view::npos if text is valid UTF-8.
+[[nodiscard]] size_t findInvalidUtf8(std::string_view text) noexcept;
+
+/// Same as findInvalidUtf8(text) using the given level (clamped to the CPU).
+[[nodiscard]] size_t findInvalidUtf8(std::string_view text, Level level) noexcept;
+
+/// Returns true if byte is a UTF-8 continuation byte (10xxxxxx).
+[[nodiscard]] constexpr bool isContinuationByte(char byte) noexcept {
+    return (static_cast<unsigned char>(byte) & 0xC0u) == 0x80u;
+}
+
+} // namespace simd
+} // namespace mdeditor
+
+#endif // MDEDITOR_UTF8_SCAN_H
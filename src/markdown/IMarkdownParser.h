@@ -33,6 +33,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace mdeditor {
 
@@ -46,9 +47,9 @@ public:
     virtual ~IMarkdownParser() = default;
 
     /// Renders markdown text to HTML.
-    /// @param markdown The markdown source text
+    /// @param markdown The markdown source text (only read during the call)
     /// @return HTML representation of the markdown
-    [[nodiscard]] virtual std::string renderToHtml(const std::string& markdown) const = 0;
+    [[nodiscard]] virtual std::string renderToHtml(std::string_view markdown) const = 0;
 
     /// Returns the name of this parser implementation.
     /// @return Parser implementation name (e.g., "FallbackRenderer", "CMarkAdapter")
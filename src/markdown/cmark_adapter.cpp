@@ -22,7 +22,7 @@ CMarkAdapter::CMarkAdapter(int options)
     }
 }
 
-std::string CMarkAdapter::renderToHtml(const std::string& markdown) const {
+std::string CMarkAdapter::renderToHtml(std::string_view markdown) const {
     // Parse markdown to AST
     cmark_node* document = cmark_parse_document(
         markdown.data(),
@@ -40,7 +40,7 @@ public:
     ~CMarkAdapter() override = default;
 
     /// Renders markdown to HTML using cmark.
-    [[nodiscard]] std::string renderToHtml(const std::string& markdown) const override;
+    [[nodiscard]] std::string renderToHtml(std::string_view markdown) const override;
 
     /// Returns "CMarkAdapter".
     [[nodiscard]] std::string parserName() const override { return "CMarkAdapter"; }
@@ -6,24 +6,61 @@
 #include "html_utils.h"
 
 #include <algorithm>
-#include <regex>
-#include <sstream>
 
 namespace mdeditor {
 
 namespace {
 
+/// Walks the lines of a text as views into it, '\n'-terminated (same
+/// splitting as std::getline). Nothing is copied.
+class LineCursor {
+public:
+    explicit LineCursor(std::string_view text) : text_(text) {}
+
+    /// Sets line to the next line without its terminator; false at the end
+    bool next(std::string_view& line) {
+        if (pos_ >= text_.size()) return false;
+        
+        size_t end = text_.find('\n', pos_);
+        if (end == std::string_view::npos) end = text_.size();
+        
+        line = text_.substr(pos_, end - pos_);
+        pos_ = end + 1;
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+/// The source text from the start of first to the end of last (views into
+/// the same text, first not after last)
+std::string_view span(std::string_view first, std::string_view last) {
+    return std::string_view(first.data(), static_cast<size_t>(last.data() + last.size() - first.data()));
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
 /// Trims leading and trailing whitespace
-std::string trim(const std::string& str) {
+std::string_view trim(std::string_view str) {
     const auto start = str.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) return "";
+    if (start == std::string_view::npos) return {};
     const auto end = str.find_last_not_of(" \t\r\n");
     return str.substr(start, end - start + 1);
 }
 
-/// Checks if a line is a horizontal rule
-bool isHorizontalRule(const std::string& line) {
-    std::string trimmed = trim(line);
+/// Returns the offset after up to 3 leading spaces
+size_t skipIndent(std::string_view line) {
+    size_t i = 0;
+    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+    return i;
+}
+
+/// Checks if a (trimmed) line is a horizontal rule
+bool isHorizontalRule(std::string_view trimmed) {
     if (trimmed.length() < 3) return false;
     
     char ruleChar = trimmed[0];
@@ -38,9 +75,8 @@ bool isHorizontalRule(const std::string& line) {
 }
 
 /// Checks if a line starts a fenced code block and returns fence info
-bool isFencedCodeStart(const std::string& line, std::string& language, char& fenceChar, size_t& fenceLen) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;  // Up to 3 spaces
+bool isFencedCodeStart(std::string_view line, std::string_view& language, char& fenceChar, size_t& fenceLen) {
+    size_t i = skipIndent(line);
     
     if (i >= line.size()) return false;
     
@@ -54,24 +90,19 @@ bool isFencedCodeStart(const std::string& line, std::string& language, char& fen
     if (fenceLen < 3) return false;
     
     // Extract language (if present, before any backticks)
-    language = "";
     while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) ++i;
     
     size_t langStart = i;
     while (i < line.size() && line[i] != ' ' && line[i] != '\t' && 
            line[i] != '`' && line[i] != '\n' && line[i] != '\r') ++i;
     
-    if (i > langStart) {
-        language = line.substr(langStart, i - langStart);
-    }
-    
+    language = line.substr(langStart, i - langStart);
     return true;
 }
 
 /// Checks if a line ends a fenced code block
-bool isFencedCodeEnd(const std::string& line, char fenceChar, size_t minLen) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+bool isFencedCodeEnd(std::string_view line, char fenceChar, size_t minLen) {
+    size_t i = skipIndent(line);
     
     if (i >= line.size() || line[i] != fenceChar) return false;
     
@@ -95,9 +126,8 @@ bool isFencedCodeEnd(const std::string& line, char fenceChar, size_t minLen) {
 }
 
 /// Returns heading level (1-6) or 0 if not a heading
-int getHeadingLevel(const std::string& line) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+int getHeadingLevel(std::string_view line) {
+    size_t i = skipIndent(line);
     
     int level = 0;
     while (i < line.size() && line[i] == '#' && level < 6) {
@@ -114,13 +144,12 @@ int getHeadingLevel(const std::string& line) {
 }
 
 /// Extracts heading content (without # prefix)
-std::string getHeadingContent(const std::string& line) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+std::string_view getHeadingContent(std::string_view line) {
+    size_t i = skipIndent(line);
     while (i < line.size() && line[i] == '#') ++i;
     while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) ++i;
     
-    std::string content = line.substr(i);
+    std::string_view content = line.substr(i);
     
     // Remove trailing # and whitespace
     size_t end = content.size();
@@ -132,9 +161,8 @@ std::string getHeadingContent(const std::string& line) {
 }
 
 /// Checks if line is an unordered list item
-bool isUnorderedListItem(const std::string& line, std::string& content) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+bool isUnorderedListItem(std::string_view line, std::string_view& content) {
+    size_t i = skipIndent(line);
     
     if (i >= line.size()) return false;
     
@@ -150,13 +178,12 @@ bool isUnorderedListItem(const std::string& line, std::string& content) {
 }
 
 /// Checks if line is an ordered list item
-bool isOrderedListItem(const std::string& line, std::string& content) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+bool isOrderedListItem(std::string_view line, std::string_view& content) {
+    size_t i = skipIndent(line);
     
-    if (i >= line.size() || !std::isdigit(line[i])) return false;
+    if (i >= line.size() || !isDigit(line[i])) return false;
     
-    while (i < line.size() && std::isdigit(line[i])) ++i;
+    while (i < line.size() && isDigit(line[i])) ++i;
     
     if (i >= line.size() || (line[i] != '.' && line[i] != ')')) return false;
     ++i;
@@ -169,9 +196,8 @@ bool isOrderedListItem(const std::string& line, std::string& content) {
 }
 
 /// Checks if line is a blockquote
-bool isBlockquote(const std::string& line, std::string& content) {
-    size_t i = 0;
-    while (i < line.size() && line[i] == ' ' && i < 3) ++i;
+bool isBlockquote(std::string_view line, std::string_view& content) {
+    size_t i = skipIndent(line);
     
     if (i >= line.size() || line[i] != '>') return false;
     ++i;
@@ -189,7 +215,7 @@ bool isBlockquote(const std::string& line, std::string& content) {
 // Public Methods
 // =============================================================================
 
-std::string FallbackRenderer::renderToHtml(const std::string& markdown) const {
+std::string FallbackRenderer::renderToHtml(std::string_view markdown) const {
     std::vector<Block> blocks = parseBlocks(markdown);
     
     std::string html;
@@ -206,197 +232,189 @@ std::string FallbackRenderer::renderToHtml(const std::string& markdown) const {
 // Private Methods
 // =============================================================================
 
-std::vector<FallbackRenderer::Block> FallbackRenderer::parseBlocks(const std::string& markdown) const {
+std::vector<FallbackRenderer::Block> FallbackRenderer::parseBlocks(std::string_view markdown) const {
     std::vector<Block> blocks;
-    std::istringstream stream(markdown);
-    std::string line;
+    LineCursor lines(markdown);
+    std::string_view line;
+    
+    // Paragraphs and code blocks are runs of consecutive source lines,
+    // kept as their first and last line
+    bool inParagraph = false;
+    std::string_view paragraphFirst;
+    std::string_view paragraphLast;
     
-    std::string paragraphBuffer;
     bool inFencedCode = false;
     char fenceChar = '`';
     size_t fenceLen = 3;
-    std::string codeLanguage;
-    std::string codeBuffer;
+    std::string_view codeLanguage;
+    bool hasCode = false;
+    std::string_view codeFirst;
+    std::string_view codeLast;
     
-    std::vector<std::string> listItems;
-    bool inUnorderedList = false;
-    bool inOrderedList = false;
+    std::vector<std::string_view> listItems;
+    bool orderedList = false;
     
-    std::string blockquoteBuffer;
+    std::vector<std::string_view> quoteLines;
     bool inBlockquote = false;
     
     auto flushParagraph = [&]() {
-        if (!paragraphBuffer.empty()) {
-            Block block;
-            block.type = Block::Type::Paragraph;
-            block.content = trim(paragraphBuffer);
-            if (!block.content.empty()) {
-                blocks.push_back(std::move(block));
+        if (inParagraph) {
+            const std::string_view content = trim(span(paragraphFirst, paragraphLast));
+            if (!content.empty()) {
+                blocks.push_back(Block{Block::Type::Paragraph, 0, content, {}, {}});
             }
-            paragraphBuffer.clear();
+            inParagraph = false;
         }
     };
     
-    auto flushList = [&](bool ordered) {
+    auto flushList = [&]() {
         if (!listItems.empty()) {
-            Block block;
-            block.type = ordered ? Block::Type::OrderedList : Block::Type::UnorderedList;
-            block.items = std::move(listItems);
-            blocks.push_back(std::move(block));
+            const auto type = orderedList ? Block::Type::OrderedList : Block::Type::UnorderedList;
+            blocks.push_back(Block{type, 0, {}, {}, std::move(listItems)});
             listItems.clear();
         }
     };
     
     auto flushBlockquote = [&]() {
-        if (!blockquoteBuffer.empty()) {
-            Block block;
-            block.type = Block::Type::Blockquote;
-            block.content = trim(blockquoteBuffer);
-            blocks.push_back(std::move(block));
-            blockquoteBuffer.clear();
+        // A quote of empty lines only ('>' alone) renders nothing
+        if (std::any_of(quoteLines.begin(), quoteLines.end(),
+                        [](std::string_view quoted) { return !quoted.empty(); })) {
+            blocks.push_back(Block{Block::Type::Blockquote, 0, {}, {}, std::move(quoteLines)});
         }
+        quoteLines.clear();
         inBlockquote = false;
     };
     
-    while (std::getline(stream, line)) {
+    // A list item closes any paragraph, so an open paragraph that coexists
+    // with an open list started after it: emit the list first
+    auto closeBlocks = [&]() {
+        flushList();
+        flushParagraph();
+        flushBlockquote();
+    };
+    
+    auto flushCode = [&]() {
+        // Leading empty lines are dropped
+        std::string_view content = hasCode ? span(codeFirst, codeLast) : std::string_view();
+        while (!content.empty() && content.front() == '\n') content.remove_prefix(1);
+        blocks.push_back(Block{Block::Type::FencedCode, 0, content, codeLanguage, {}});
+        hasCode = false;
+    };
+    
+    auto addListItem = [&](bool ordered, std::string_view content) {
+        if (inBlockquote) flushBlockquote();
+        // A paragraph between items, or a change of marker, ends the list
+        if (inParagraph || orderedList != ordered) flushList();
+        flushParagraph();
+        orderedList = ordered;
+        listItems.push_back(content);
+    };
+    
+    while (lines.next(line)) {
         // Handle fenced code blocks
         if (inFencedCode) {
             if (isFencedCodeEnd(line, fenceChar, fenceLen)) {
-                Block block;
-                block.type = Block::Type::FencedCode;
-                block.language = codeLanguage;
-                block.content = codeBuffer;
-                blocks.push_back(std::move(block));
-                codeBuffer.clear();
+                flushCode();
                 inFencedCode = false;
             } else {
-                if (!codeBuffer.empty()) codeBuffer += '\n';
-                codeBuffer += line;
+                if (!hasCode) codeFirst = line;
+                codeLast = line;
+                hasCode = true;
             }
             continue;
         }
         
-        std::string tempLang;
-        char tempFence;
-        size_t tempLen;
-        if (isFencedCodeStart(line, tempLang, tempFence, tempLen)) {
+        // Blank line ends paragraph, list and blockquote
+        const std::string_view trimmed = trim(line);
+        if (trimmed.empty()) {
+            if (inBlockquote) flushBlockquote();
+            flushList();
             flushParagraph();
-            flushList(inOrderedList);
-            inUnorderedList = inOrderedList = false;
-            flushBlockquote();
-            
-            inFencedCode = true;
-            fenceChar = tempFence;
-            fenceLen = tempLen;
-            codeLanguage = tempLang;
-            codeBuffer.clear();
             continue;
         }
         
-        // Horizontal rule
-        if (isHorizontalRule(line)) {
-            flushParagraph();
-            flushList(inOrderedList);
-            inUnorderedList = inOrderedList = false;
-            flushBlockquote();
+        // Dispatch on the first non-blank byte: each block marker has its own
+        std::string_view content;
+        switch (trimmed.front()) {
+            case '`':
+            case '~': {
+                std::string_view language;
+                char fence;
+                size_t length;
+                if (isFencedCodeStart(line, language, fence, length)) {
+                    closeBlocks();
+                    inFencedCode = true;
+                    fenceChar = fence;
+                    fenceLen = length;
+                    codeLanguage = language;
+                    continue;
+                }
+                break;
+            }
             
-            Block block;
-            block.type = Block::Type::HorizontalRule;
-            blocks.push_back(std::move(block));
-            continue;
-        }
-        
-        // Heading
-        int headingLevel = getHeadingLevel(line);
-        if (headingLevel > 0) {
-            flushParagraph();
-            flushList(inOrderedList);
-            inUnorderedList = inOrderedList = false;
-            flushBlockquote();
+            case '-':
+            case '*':
+            case '_':
+                if (isHorizontalRule(trimmed)) {
+                    closeBlocks();
+                    blocks.push_back(Block{Block::Type::HorizontalRule, 0, {}, {}, {}});
+                    continue;
+                }
+                if (trimmed.front() != '_' && isUnorderedListItem(line, content)) {
+                    addListItem(false, content);
+                    continue;
+                }
+                break;
             
-            Block block;
-            block.type = Block::Type::Heading;
-            block.level = headingLevel;
-            block.content = getHeadingContent(line);
-            blocks.push_back(std::move(block));
-            continue;
-        }
-        
-        // Blockquote
-        std::string quoteContent;
-        if (isBlockquote(line, quoteContent)) {
-            flushParagraph();
-            flushList(inOrderedList);
-            inUnorderedList = inOrderedList = false;
+            case '+':
+                if (isUnorderedListItem(line, content)) {
+                    addListItem(false, content);
+                    continue;
+                }
+                break;
             
-            if (!blockquoteBuffer.empty()) blockquoteBuffer += '\n';
-            blockquoteBuffer += quoteContent;
-            inBlockquote = true;
-            continue;
-        } else if (inBlockquote) {
-            flushBlockquote();
-        }
-        
-        // Unordered list
-        std::string itemContent;
-        if (isUnorderedListItem(line, itemContent)) {
-            flushParagraph();
-            if (inOrderedList) {
-                flushList(true);
-                inOrderedList = false;
+            case '#': {
+                const int level = getHeadingLevel(line);
+                if (level > 0) {
+                    closeBlocks();
+                    blocks.push_back(Block{Block::Type::Heading, level, getHeadingContent(line), {}, {}});
+                    continue;
+                }
+                break;
             }
-            inUnorderedList = true;
-            listItems.push_back(itemContent);
-            continue;
-        }
-        
-        // Ordered list
-        if (isOrderedListItem(line, itemContent)) {
-            flushParagraph();
-            if (inUnorderedList) {
-                flushList(false);
-                inUnorderedList = false;
-            }
-            inOrderedList = true;
-            listItems.push_back(itemContent);
-            continue;
-        }
-        
-        // End of list on non-list line
-        if (inUnorderedList || inOrderedList) {
-            if (trim(line).empty()) {
-                flushList(inOrderedList);
-                inUnorderedList = inOrderedList = false;
-                continue;
-            }
-        }
-        
-        // Blank line ends paragraph
-        if (trim(line).empty()) {
-            flushParagraph();
-            flushList(inOrderedList);
-            inUnorderedList = inOrderedList = false;
-            continue;
+            
+            case '>':
+                if (isBlockquote(line, content)) {
+                    flushList();
+                    flushParagraph();
+                    quoteLines.push_back(content);
+                    inBlockquote = true;
+                    continue;
+                }
+                break;
+            
+            default:
+                if (isDigit(trimmed.front()) && isOrderedListItem(line, content)) {
+                    addListItem(true, content);
+                    continue;
+                }
+                break;
         }
         
         // Regular paragraph text
-        if (!paragraphBuffer.empty()) paragraphBuffer += '\n';
-        paragraphBuffer += line;
+        if (inBlockquote) flushBlockquote();
+        if (!inParagraph) paragraphFirst = line;
+        paragraphLast = line;
+        inParagraph = true;
     }
     
     // Flush remaining content
     if (inFencedCode) {
         // Unclosed code block - render what we have
-        Block block;
-        block.type = Block::Type::FencedCode;
-        block.language = codeLanguage;
-        block.content = codeBuffer;
-        blocks.push_back(std::move(block));
+        flushCode();
     }
     
-    flushParagraph();
-    flushList(inOrderedList);
-    flushBlockquote();
+    closeBlocks();
     
     return blocks;
 }
@@ -444,8 +462,13 @@ std::string FallbackRenderer::renderBlock(const Block& block) const {
         }
         
         case Block::Type::Blockquote: {
-            // Recursively parse blockquote content
-            std::string innerHtml = renderToHtml(block.content);
+            // Recursively parse blockquote content, without the '>' markers
+            std::string content;
+            for (const auto& line : block.items) {
+                if (&line != &block.items.front()) content += '\n';
+                content += line;
+            }
+            std::string innerHtml = renderToHtml(trim(content));
             return "<blockquote>\n" + innerHtml + "</blockquote>\n";
         }
         
@@ -457,7 +480,7 @@ std::string FallbackRenderer::renderBlock(const Block& block) const {
     return "";
 }
 
-std::string FallbackRenderer::processInline(const std::string& text) const {
+std::string FallbackRenderer::processInline(std::string_view text) const {
     std::string result;
     result.reserve(text.size() * 1.2);
     
@@ -467,7 +490,7 @@ std::string FallbackRenderer::processInline(const std::string& text) const {
         if (text[i] == '`') {
             size_t start = i + 1;
             size_t end = text.find('`', start);
-            if (end != std::string::npos) {
+            if (end != std::string_view::npos) {
                 result += "<code>";
                 result += html::escape(text.substr(start, end - start));
                 result += "</code>";
@@ -480,7 +503,7 @@ std::string FallbackRenderer::processInline(const std::string& text) const {
         if (i + 1 < text.size() && text[i] == '*' && text[i + 1] == '*') {
             size_t start = i + 2;
             size_t end = text.find("**", start);
-            if (end != std::string::npos) {
+            if (end != std::string_view::npos) {
                 result += "<strong>";
                 result += html::escape(text.substr(start, end - start));
                 result += "</strong>";
@@ -493,7 +516,7 @@ std::string FallbackRenderer::processInline(const std::string& text) const {
         if (i + 1 < text.size() && text[i] == '_' && text[i + 1] == '_') {
             size_t start = i + 2;
             size_t end = text.find("__", start);
-            if (end != std::string::npos) {
+            if (end != std::string_view::npos) {
                 result += "<strong>";
                 result += html::escape(text.substr(start, end - start));
                 result += "</strong>";
@@ -506,7 +529,7 @@ std::string FallbackRenderer::processInline(const std::string& text) const {
         if (text[i] == '*') {
             size_t start = i + 1;
             size_t end = text.find('*', start);
-            if (end != std::string::npos && end > start) {
+            if (end != std::string_view::npos && end > start) {
                 result += "<em>";
                 result += html::escape(text.substr(start, end - start));
                 result += "</em>";
@@ -519,7 +542,7 @@ std::string FallbackRenderer::processInline(const std::string& text) const {
         if (text[i] == '_') {
             size_t start = i + 1;
             size_t end = text.find('_', start);
-            if (end != std::string::npos && end > start) {
+            if (end != std::string_view::npos && end > start) {
                 result += "<em>";
                 result += html::escape(text.substr(start, end - start));
                 result += "</em>";
@@ -16,6 +16,14 @@
 //   - Horizontal rules: ---, ***, ___
 //   - Inline: **bold**, *italic*, `code`
 //
+// PARSING:
+// --------
+// parseBlocks() walks the input with a string_view line cursor and picks
+// the classifier from the first non-blank byte of each line, so a line is
+// tested only against the block type its marker can start. Blocks hold
+// views into the input rather than copies: allocations grow with the
+// number of blocks, not lines.
+//
 // LIMITATIONS:
 // ------------
 //   - No nested lists (single level only)
@@ -36,6 +44,7 @@
 #include "IMarkdownParser.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace mdeditor {
@@ -48,7 +57,7 @@ public:
     ~FallbackRenderer() override = default;
 
     /// Renders markdown to HTML.
-    [[nodiscard]] std::string renderToHtml(const std::string& markdown) const override;
+    [[nodiscard]] std::string renderToHtml(std::string_view markdown) const override;
 
     /// Returns "FallbackRenderer".
     [[nodiscard]] std::string parserName() const override { return "FallbackRenderer"; }
@@ -57,7 +66,8 @@ public:
     [[nodiscard]] bool isFullCommonMark() const override { return false; }
 
 private:
-    /// Represents a parsed block element
+    /// Represents a parsed block element; views point into the markdown
+    /// passed to parseBlocks() and are valid while it is
     struct Block {
         enum class Type {
             Paragraph,
@@ -70,20 +80,20 @@ private:
         };
 
         Type type;
-        int level;              // For headings (1-6) or list nesting
-        std::string content;    // Raw content
-        std::string language;   // For code blocks
-        std::vector<std::string> items;  // For lists
+        int level = 0;                // For headings (1-6) or list nesting
+        std::string_view content;     // Raw content
+        std::string_view language;    // For code blocks
+        std::vector<std::string_view> items;  // List items, or blockquote lines
     };
 
     /// Parses markdown into blocks
-    [[nodiscard]] std::vector<Block> parseBlocks(const std::string& markdown) const;
+    [[nodiscard]] std::vector<Block> parseBlocks(std::string_view markdown) const;
 
     /// Renders a single block to HTML
     [[nodiscard]] std::string renderBlock(const Block& block) const;
 
     /// Processes inline formatting (bold, italic, code)
-    [[nodiscard]] std::string processInline(const std::string& text) const;
+    [[nodiscard]] std::string processInline(std::string_view text) const;
 };
 
 } // namespace mdeditor
@@ -3,6 +3,7 @@
 // =============================================================================
 
 #include "DocumentController.h"
+#include "../gapbuffer/atomic_file.h"
 #include "../gapbuffer/gap_buffer.h"
 #include "../markdown/IMarkdownParser.h"
 
@@ -11,8 +12,60 @@
 #include <QUrl>
 #include <QFileInfo>
 
+#include <algorithm>
+#include <array>
+
 namespace mdeditor {
 
+namespace {
+
+/// Bytes compared per window when matching from the end
+constexpr size_t kSuffixWindow = 4096;
+
+/// Returns the length of the longest common prefix of model and text
+size_t commonPrefix(const IDocumentModel& model, std::string_view text)
+{
+    size_t matched = 0;
+    bool mismatch = false;
+    model.visitChunks(0, std::min(model.length(), text.size()), [&](std::string_view run) {
+        if (mismatch) {
+            return;
+        }
+        const auto diff = std::mismatch(run.begin(), run.end(), text.begin() + matched);
+        const auto same = static_cast<size_t>(diff.first - run.begin());
+        matched += same;
+        mismatch = same < run.size();
+    });
+    return matched;
+}
+
+/// Returns the length (at most limit) of the longest common suffix of
+/// model and text, reading the model a window at a time from the end
+size_t commonSuffix(const IDocumentModel& model, std::string_view text, size_t limit)
+{
+    std::array<char, kSuffixWindow> window;
+    const size_t modelLength = model.length();
+    size_t matched = 0;
+    while (matched < limit) {
+        const size_t take = std::min(kSuffixWindow, limit - matched);
+        size_t filled = 0;
+        model.visitChunks(modelLength - matched - take, take, [&](std::string_view run) {
+            std::copy(run.begin(), run.end(), window.begin() + filled);
+            filled += run.size();
+        });
+        const std::string_view theirs = text.substr(text.size() - matched - take, take);
+        for (size_t i = take; i > 0; --i) {
+            if (window[i - 1] != theirs[i - 1]) {
+                return matched + (take - i);
+            }
+        }
+        matched += take;
+    }
+    return matched;
+}
+
+} // anonymous namespace
+
 // =============================================================================
 // Construction / Destruction
 // =============================================================================
@@ -38,15 +91,22 @@ QString DocumentController::text() const
 void DocumentController::setText(const QString& newText)
 {
     const std::string newTextStd = newText.toStdString();
-    if (m_buffer->getText() == newTextStd) {
+
+    // Replace only the span that differs, so the buffer records one small
+    // patch instead of reloading
+    const size_t oldLength = m_buffer->length();
+    const size_t prefix = commonPrefix(*m_buffer, newTextStd);
+    if (prefix == oldLength && prefix == newTextStd.size()) {
         return;
     }
-
-    m_buffer->loadFromString(newTextStd);
+    const size_t suffix = commonSuffix(*m_buffer, newTextStd,
+                                       std::min(oldLength, newTextStd.size()) - prefix);
+    const std::string_view inserted =
+        std::string_view(newTextStd).substr(prefix, newTextStd.size() - prefix - suffix);
+    m_buffer->applyPatch(Patch(prefix, oldLength - prefix - suffix, inserted));
     emit textChanged();
 
-    // Check if different from last saved
-    setModified(newText != m_lastSavedText);
+    setModified(currentDigest() != m_savedDigest);
 }
 
 QString DocumentController::filePath() const
@@ -64,6 +124,41 @@ QString DocumentController::parserName() const
     return QString::fromStdString(m_parser->parserName());
 }
 
+QVariantMap DocumentController::bufferStats() const
+{
+    const auto* buffer = dynamic_cast<const GapBuffer*>(m_buffer.get());
+    if (buffer == nullptr || !GapBuffer::statsEnabled()) {
+        return {};
+    }
+
+    const GapBuffer::Stats stats = buffer->stats();
+    return {
+        {QStringLiteral("gapMoves"), QVariant::fromValue<quint64>(stats.gapMoves)},
+        {QStringLiteral("bytesMoved"), QVariant::fromValue<quint64>(stats.bytesMoved)},
+        {QStringLiteral("grows"), QVariant::fromValue<quint64>(stats.grows)},
+        {QStringLiteral("bytesAllocated"), QVariant::fromValue<quint64>(stats.bytesAllocated)},
+        {QStringLiteral("patchesCoalesced"), QVariant::fromValue<quint64>(stats.patchesCoalesced)},
+        {QStringLiteral("patchesStarted"), QVariant::fromValue<quint64>(stats.patchesStarted)},
+        {QStringLiteral("lineScanBytes"), QVariant::fromValue<quint64>(stats.lineScanBytes)},
+    };
+}
+
+QVariantMap DocumentController::textStats() const
+{
+    const auto* buffer = dynamic_cast<const GapBuffer*>(m_buffer.get());
+    if (buffer == nullptr) {
+        return {};
+    }
+
+    const TextStats::Counts counts = buffer->textStats();
+    return {
+        {QStringLiteral("characters"), QVariant::fromValue<quint64>(counts.characters)},
+        {QStringLiteral("words"), QVariant::fromValue<quint64>(counts.words)},
+        {QStringLiteral("lines"), QVariant::fromValue<quint64>(counts.lines)},
+        {QStringLiteral("readingMinutes"), QVariant::fromValue<quint64>(counts.readingMinutes())},
+    };
+}
+
 // =============================================================================
 // File Operations
 // =============================================================================
@@ -90,9 +185,8 @@ bool DocumentController::loadFile(const QString& path)
     file.close();
 
     m_buffer->loadFromString(content.toStdString());
-    m_lastSavedText = content;
+    markLoaded();
     setFilePath(localPath);
-    setModified(false);
     emit textChanged();
 
     return true;
@@ -113,19 +207,16 @@ bool DocumentController::saveFile(const QString& path)
         localPath = url.toLocalFile();
     }
 
-    QFile file(localPath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit errorOccurred(tr("Cannot save file: %1").arg(file.errorString()));
+    // Write the buffer's UTF-8 bytes straight from its segments, then
+    // rename over the old file so a failed save never truncates it
+    try {
+        saveDocument(*m_buffer, std::filesystem::path(localPath.toStdU16String()));
+    } catch (const std::exception& e) {
+        emit errorOccurred(tr("Cannot save file: %1").arg(QString::fromLocal8Bit(e.what())));
         return false;
     }
 
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);
-    const QString content = QString::fromStdString(m_buffer->getText());
-    out << content;
-    file.close();
-
-    m_lastSavedText = content;
+    m_savedDigest = currentDigest();
     setFilePath(localPath);
     setModified(false);
 
@@ -139,17 +230,15 @@ bool DocumentController::saveFileUrl(const QUrl& url)
 
 void DocumentController::renderToHtml()
 {
-    const std::string markdown = m_buffer->getText();
-    const std::string html = m_parser->renderToHtml(markdown);
+    const std::string html = m_parser->renderToHtml(m_buffer->contiguousView());
     emit previewReady(QString::fromStdString(html));
 }
 
 void DocumentController::newDocument()
 {
     m_buffer->clear();
-    m_lastSavedText.clear();
+    markLoaded();
     setFilePath(QString());
-    setModified(false);
     emit textChanged();
 }
 
@@ -173,4 +262,19 @@ void DocumentController::setFilePath(const QString& path)
     }
 }
 
+void DocumentController::markLoaded()
+{
+    m_contentHash.rebuild(*m_buffer);
+    m_savedDigest = m_contentHash.digest(*m_buffer);
+    setModified(false);
+}
+
+ContentHash::Digest DocumentController::currentDigest()
+{
+    m_buffer->drainPatches([this](const PatchView& patch) {
+        m_contentHash.recordEdit(patch.start, patch.removedLength, patch.insertedText.size());
+    });
+    return m_contentHash.digest(*m_buffer);
+}
+
 } // namespace mdeditor
@@ -3,8 +3,8 @@
 // =============================================================================
 //
 // This QObject provides the bridge between QML and the C++ document model.
-// It wraps a GapBuffer for text storage and uses the markdown parser for
-// rendering previews.
+// It holds the text in an IDocumentModel (a GapBuffer by default) and uses
+// the markdown parser for rendering previews.
 //
 // USAGE (from QML):
 // -----------------
@@ -25,17 +25,20 @@
 #include <QObject>
 #include <QString>
 #include <QUrl>
+#include <QVariantMap>
+
+#include "../gapbuffer/content_hash.h"
 
 #include <memory>
 
 namespace mdeditor {
 
-class GapBuffer;
+class IDocumentModel;
 class IMarkdownParser;
 
 /// DocumentController - QML bridge for document editing and markdown preview.
 ///
-/// This controller wraps the GapBuffer text model and markdown parser,
+/// This controller wraps the document model and markdown parser,
 /// exposing them to QML through properties and invokable methods.
 class DocumentController : public QObject {
     Q_OBJECT
@@ -52,6 +55,12 @@ class DocumentController : public QObject {
     /// The name of the parser being used.
     Q_PROPERTY(QString parserName READ parserName CONSTANT)
 
+    /// GapBuffer operation counters, refreshed with every text change.
+    Q_PROPERTY(QVariantMap bufferStats READ bufferStats NOTIFY textChanged)
+
+    /// Character, word and line counts for the status bar.
+    Q_PROPERTY(QVariantMap textStats READ textStats NOTIFY textChanged)
+
 public:
     /// Constructs a DocumentController with default parser.
     explicit DocumentController(QObject* parent = nullptr);
@@ -78,6 +87,16 @@ public:
     /// Returns the name of the markdown parser implementation.
     [[nodiscard]] QString parserName() const;
 
+    /// Returns the GapBuffer::Stats counters by field name (gapMoves,
+    /// bytesMoved, ...). Empty unless the gapbuffer library was built with
+    /// MD_GAPBUFFER_STATS.
+    [[nodiscard]] QVariantMap bufferStats() const;
+
+    /// Returns the TextStats counts by field name (characters, words,
+    /// lines, readingMinutes). Kept current by each edit, so reading them
+    /// after every keystroke does not rescan the document.
+    [[nodiscard]] QVariantMap textStats() const;
+
     // -------------------------------------------------------------------------
     // Invokable Methods (callable from QML)
     // -------------------------------------------------------------------------
@@ -127,14 +146,24 @@ signals:
     void errorOccurred(const QString& message);
 
 private:
-    std::unique_ptr<GapBuffer> m_buffer;
+    std::unique_ptr<IDocumentModel> m_buffer;
     std::unique_ptr<IMarkdownParser> m_parser;
     QString m_filePath;
     bool m_modified = false;
-    QString m_lastSavedText;
+
+    /// Digest of the text, kept current from the buffer's patches
+    ContentHash m_contentHash;
+    /// Digest of the text as last loaded or saved
+    ContentHash::Digest m_savedDigest;
 
     void setModified(bool modified);
     void setFilePath(const QString& path);
+
+    /// Hashes the freshly loaded (or cleared) text and marks it as saved
+    void markLoaded();
+
+    /// Feeds pending patches to m_contentHash and returns the digest
+    ContentHash::Digest currentDigest();
 };
 
 } // namespace mdeditor
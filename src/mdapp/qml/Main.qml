@@ -368,6 +368,14 @@ ApplicationWindow {
                     opacity: 0.7
                 }
 
+                Label {
+                    text: doc.textStats.words + " words, "
+                          + doc.textStats.characters + " characters, "
+                          + doc.textStats.lines + " lines, "
+                          + doc.textStats.readingMinutes + " min read"
+                    opacity: 0.7
+                }
+
                 Label {
                     text: doc.modified ? "Modified" : "Saved"
                     opacity: 0.7
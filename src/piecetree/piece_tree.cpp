@@ -0,0 +1,790 @@
+// =============================================================================
+// piece_tree.cpp - Balanced Piece Tree Text Model Implementation
+// =============================================================================
+
+#include "piece_tree.h"
+#include "edit_helpers.h"
+#include "mapped_file.h"
+#include "newline_scan.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mdeditor {
+
+// =============================================================================
+// Buffer
+// =============================================================================
+
+const char* PieceTree::Buffer::data() const noexcept {
+    return block ? block.get() : mapping->view().data();
+}
+
+std::shared_ptr<const void> PieceTree::Buffer::owner() const noexcept {
+    if (block) {
+        return block;
+    }
+    return mapping;
+}
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+PieceTree::PieceTree(const PieceTree& other)
+    : buffers_(other.buffers_)
+    , freeNodes_(other.freeNodes_)
+    , root_(other.root_)
+    , pendingPatches_(other.pendingPatches_)
+    , version_(other.version_)
+    , nodes_(other.nodes_)
+    , lineIndexPending_(other.lineIndexPending_) {
+    sealBlocks();
+}
+
+PieceTree& PieceTree::operator=(const PieceTree& other) {
+    if (this != &other) {
+        buffers_ = other.buffers_;
+        freeNodes_ = other.freeNodes_;
+        root_ = other.root_;
+        flat_.clear();
+        pendingPatches_ = other.pendingPatches_;
+        version_ = other.version_;
+        nodes_ = other.nodes_;
+        lineIndexPending_ = other.lineIndexPending_;
+        sealBlocks();
+    }
+    return *this;
+}
+
+// =============================================================================
+// Loading Content
+// =============================================================================
+
+void PieceTree::loadFromString(std::string_view text) {
+    clear();
+    if (text.empty()) {
+        return;
+    }
+
+    Buffer original;
+    original.block.reset(new char[text.size()]);
+    std::memcpy(original.block.get(), text.data(), text.size());
+    original.size = text.size();
+    original.capacity = text.size();
+    original.newlines.reserve(simd::countNewlines(text));
+    simd::forEachNewline(text, [&](size_t pos) {
+        original.newlines.push_back(pos);
+    });
+
+    const Piece piece{0, 0, text.size(), original.newlines.size()};
+    buffers_.push_back(std::move(original));
+    root_ = newNode(piece);
+}
+
+void PieceTree::loadFromFile(const std::filesystem::path& path) {
+    // Map first so a failure leaves the tree untouched
+    auto mapping = std::make_shared<const MappedFile>(path);
+
+    clear();
+    if (mapping->size() == 0) {
+        return;
+    }
+
+    Buffer original;
+    original.size = mapping->size();
+    original.capacity = mapping->size();
+    original.mapping = std::move(mapping);
+
+    // Defer the newline scan: it reads every page of the file
+    const Piece piece{0, 0, original.size, 0};
+    buffers_.push_back(std::move(original));
+    root_ = newNode(piece);
+    lineIndexPending_ = true;
+}
+
+void PieceTree::clear() {
+    buffers_.clear();
+    nodes_.clear();
+    freeNodes_.clear();
+    root_ = kNil;
+    addBlock_ = kNoBlock;
+    std::string().swap(flat_);
+    pendingPatches_.clear();
+    ++version_;
+    lineIndexPending_ = false;
+}
+
+// =============================================================================
+// Retrieving Content
+// =============================================================================
+
+std::string PieceTree::getText() const {
+    return getText(0, length());
+}
+
+std::string PieceTree::getText(size_t start, size_t len) const {
+    std::string result;
+    if (start < length()) {
+        result.reserve(std::min(len, length() - start));
+    }
+    forEachChunk(start, len, [&](std::string_view run) {
+        result.append(run);
+    });
+    return result;
+}
+
+size_t PieceTree::length() const noexcept {
+    return bytesOf(root_);
+}
+
+bool PieceTree::empty() const noexcept {
+    return root_ == kNil;
+}
+
+// =============================================================================
+// Tree Introspection
+// =============================================================================
+
+size_t PieceTree::pieceCount() const noexcept {
+    return piecesOf(root_);
+}
+
+size_t PieceTree::height() const noexcept {
+    return heightOf(root_);
+}
+
+void PieceTree::compact() {
+    const std::vector<Piece> pieces = collectPieces();
+    std::vector<Piece> compacted;
+    compacted.reserve(pieces.size());
+
+    // Neighbours contiguous in one buffer become a single piece
+    auto push = [&](const Piece& piece) {
+        if (!compacted.empty()) {
+            Piece& last = compacted.back();
+            if (last.buffer == piece.buffer && last.start + last.length == piece.start) {
+                last.length += piece.length;
+                last.newlines += piece.newlines;
+                return;
+            }
+        }
+        compacted.push_back(piece);
+    };
+
+    // Runs of small pieces are copied into one add-block piece
+    std::vector<Piece> run;
+    size_t runBytes = 0;
+    auto flushRun = [&] {
+        if (run.size() == 1) {
+            push(run.front());
+        } else if (run.size() > 1) {
+            std::string text;
+            text.reserve(runBytes);
+            for (const Piece& piece : run) {
+                text.append(pieceText(piece));
+            }
+            push(append(text));
+        }
+        run.clear();
+        runBytes = 0;
+    };
+
+    for (const Piece& piece : pieces) {
+        if (piece.length >= kCompactPieceSize) {
+            flushRun();
+            push(piece);
+            continue;
+        }
+        if (runBytes + piece.length > kAddBlockSize) {
+            flushRun();
+        }
+        run.push_back(piece);
+        runBytes += piece.length;
+    }
+    flushRun();
+
+    rebuild(compacted);
+
+    // Release add blocks that only held the copied pieces; the buffer slots
+    // stay so piece buffer indices remain valid
+    std::vector<bool> referenced(buffers_.size(), false);
+    for (const Piece& piece : compacted) {
+        referenced[piece.buffer] = true;
+    }
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        if (!referenced[i] && i != addBlock_) {
+            buffers_[i] = Buffer{};
+        }
+    }
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+void PieceTree::visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const {
+    forEachChunk(start, len, fn);
+}
+
+std::string_view PieceTree::contiguousView() {
+    if (root_ == kNil) {
+        return {};
+    }
+    if (pieceCount() == 1) {
+        return pieceText(nodes_[root_].piece);
+    }
+
+    flat_.clear();
+    flat_.reserve(length());
+    forEachChunk(0, length(), [&](std::string_view run) {
+        flat_.append(run);
+    });
+    return flat_;
+}
+
+DocumentSnapshot PieceTree::snapshot() const {
+    const std::vector<Piece> pieces = collectPieces();
+    std::vector<std::string_view> runs;
+    runs.reserve(pieces.size());
+    std::vector<bool> referenced(buffers_.size(), false);
+    for (const Piece& piece : pieces) {
+        runs.push_back(pieceText(piece));
+        referenced[piece.buffer] = true;
+    }
+
+    // Bytes below each buffer's size are never rewritten, so sharing the
+    // buffers keeps the runs valid and unchanged
+    std::vector<std::shared_ptr<const void>> owners;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        if (referenced[i]) {
+            owners.push_back(buffers_[i].owner());
+        }
+    }
+    return DocumentSnapshot(std::move(runs), std::move(owners), version_);
+}
+
+uint64_t PieceTree::version() const noexcept {
+    return version_;
+}
+
+// =============================================================================
+// Editing Operations
+// =============================================================================
+
+void PieceTree::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, length());
+    insertText(offset, text);
+    ++version_;
+    pendingPatches_.append(offset, {}, text);
+}
+
+void PieceTree::erase(size_t offset, size_t len) {
+    const size_t textLen = length();
+    if (offset >= textLen || len == 0) {
+        return;
+    }
+    len = std::min(len, textLen - offset);
+
+    const std::string removed = getText(offset, len);
+    eraseText(offset, len);
+    ++version_;
+    pendingPatches_.append(offset, removed, {});
+}
+
+void PieceTree::applyPatch(const Patch& patch) {
+    applyEdits({Edit{patch.start, patch.removedLength, patch.insertedText}});
+}
+
+void PieceTree::applyEdits(const std::vector<Edit>& edits) {
+    // Clamp, order and validate before touching the tree
+    const std::vector<Edit> sorted = detail::sortedEdits(edits, length(), "PieceTree::applyEdits");
+
+    size_t insertedSoFar = 0;
+    size_t removedSoFar = 0;
+    for (const Edit& edit : sorted) {
+        const size_t position = edit.start + insertedSoFar - removedSoFar;
+        const std::string removed = getText(position, edit.removedLength);
+        eraseText(position, edit.removedLength);
+        insertText(position, edit.insertedText);
+        ++version_;
+        pendingPatches_.append(position, removed, edit.insertedText);
+        insertedSoFar += edit.insertedText.size();
+        removedSoFar += edit.removedLength;
+    }
+}
+
+// =============================================================================
+// Line/Offset Mapping
+// =============================================================================
+
+size_t PieceTree::lineFromOffset(size_t offset) const {
+    ensureLineIndex();
+    offset = std::min(offset, length());
+
+    // Count newlines strictly before offset
+    size_t line = 0;
+    size_t node = root_;
+    while (node != kNil) {
+        const Node& current = nodes_[node];
+        const size_t leftBytes = bytesOf(current.left);
+        if (offset < leftBytes) {
+            node = current.left;
+        } else if (offset < leftBytes + current.piece.length) {
+            const Piece& piece = current.piece;
+            return line + newlinesOf(current.left) +
+                   countNewlines(piece.buffer, piece.start, offset - leftBytes);
+        } else {
+            line += newlinesOf(current.left) + current.piece.newlines;
+            offset -= leftBytes + current.piece.length;
+            node = current.right;
+        }
+    }
+    return line;
+}
+
+size_t PieceTree::offsetFromLine(size_t line, size_t column) const {
+    if (line == 0 && column == 0) {
+        return 0;
+    }
+
+    ensureLineIndex();
+    const size_t textLen = length();
+    size_t offset = textLen;  // Past the last line
+
+    if (line == 0) {
+        offset = 0;
+    } else if (line - 1 < newlinesOf(root_)) {
+        // Line N starts one past the (N-1)th newline
+        size_t remaining = line - 1;
+        size_t position = 0;
+        size_t node = root_;
+        while (true) {
+            const Node& current = nodes_[node];
+            const size_t leftNewlines = newlinesOf(current.left);
+            if (remaining < leftNewlines) {
+                node = current.left;
+            } else if (remaining < leftNewlines + current.piece.newlines) {
+                const Piece& piece = current.piece;
+                const std::vector<size_t>& newlines = buffers_[piece.buffer].newlines;
+                const auto first = std::lower_bound(newlines.begin(), newlines.end(), piece.start);
+                offset = position + bytesOf(current.left) +
+                         (first[remaining - leftNewlines] - piece.start) + 1;
+                break;
+            } else {
+                remaining -= leftNewlines + current.piece.newlines;
+                position += bytesOf(current.left) + current.piece.length;
+                node = current.right;
+            }
+        }
+    }
+
+    // Add column offset (clamped to text length)
+    return std::min(offset + column, textLen);
+}
+
+size_t PieceTree::lineCount() const {
+    if (empty()) {
+        return 0;
+    }
+    ensureLineIndex();
+    return 1 + newlinesOf(root_);
+}
+
+// =============================================================================
+// Patch Management
+// =============================================================================
+
+std::vector<Patch> PieceTree::flushPatches() {
+    return pendingPatches_.flush();
+}
+
+void PieceTree::drainPatches(const PatchVisitor& fn) {
+    pendingPatches_.drain(fn);
+}
+
+bool PieceTree::hasPendingPatches() const noexcept {
+    return !pendingPatches_.empty();
+}
+
+// =============================================================================
+// Tree Maintenance
+// =============================================================================
+
+size_t PieceTree::heightOf(size_t node) const noexcept {
+    return node == kNil ? 0 : nodes_[node].height;
+}
+
+size_t PieceTree::piecesOf(size_t node) const noexcept {
+    return node == kNil ? 0 : nodes_[node].pieces;
+}
+
+size_t PieceTree::bytesOf(size_t node) const noexcept {
+    return node == kNil ? 0 : nodes_[node].bytes;
+}
+
+size_t PieceTree::newlinesOf(size_t node) const noexcept {
+    return node == kNil ? 0 : nodes_[node].newlines;
+}
+
+size_t PieceTree::newNode(const Piece& piece) {
+    size_t node;
+    if (!freeNodes_.empty()) {
+        node = freeNodes_.back();
+        freeNodes_.pop_back();
+    } else {
+        node = nodes_.size();
+        nodes_.emplace_back();
+    }
+    nodes_[node] = Node{piece, kNil, kNil, 1, 1, piece.length, piece.newlines};
+    return node;
+}
+
+void PieceTree::pull(size_t node) const noexcept {
+    Node& current = nodes_[node];
+    current.height = 1 + std::max(heightOf(current.left), heightOf(current.right));
+    current.pieces = 1 + piecesOf(current.left) + piecesOf(current.right);
+    current.bytes = current.piece.length + bytesOf(current.left) + bytesOf(current.right);
+    current.newlines = current.piece.newlines + newlinesOf(current.left) +
+                       newlinesOf(current.right);
+}
+
+size_t PieceTree::rotateLeft(size_t node) noexcept {
+    const size_t pivot = nodes_[node].right;
+    nodes_[node].right = nodes_[pivot].left;
+    nodes_[pivot].left = node;
+    pull(node);
+    pull(pivot);
+    return pivot;
+}
+
+size_t PieceTree::rotateRight(size_t node) noexcept {
+    const size_t pivot = nodes_[node].left;
+    nodes_[node].left = nodes_[pivot].right;
+    nodes_[pivot].right = node;
+    pull(node);
+    pull(pivot);
+    return pivot;
+}
+
+size_t PieceTree::balance(size_t node) noexcept {
+    pull(node);
+    Node& current = nodes_[node];
+    const size_t leftHeight = heightOf(current.left);
+    const size_t rightHeight = heightOf(current.right);
+
+    if (leftHeight > rightHeight + 1) {
+        const Node& left = nodes_[current.left];
+        if (heightOf(left.left) < heightOf(left.right)) {
+            current.left = rotateLeft(current.left);
+        }
+        return rotateRight(node);
+    }
+    if (rightHeight > leftHeight + 1) {
+        const Node& right = nodes_[current.right];
+        if (heightOf(right.right) < heightOf(right.left)) {
+            current.right = rotateRight(current.right);
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+size_t PieceTree::insertAt(size_t node, size_t index, size_t fresh) {
+    if (node == kNil) {
+        return fresh;
+    }
+    const size_t leftPieces = piecesOf(nodes_[node].left);
+    if (index <= leftPieces) {
+        nodes_[node].left = insertAt(nodes_[node].left, index, fresh);
+    } else {
+        nodes_[node].right = insertAt(nodes_[node].right, index - leftPieces - 1, fresh);
+    }
+    return balance(node);
+}
+
+size_t PieceTree::eraseAt(size_t node, size_t index) {
+    const size_t leftPieces = piecesOf(nodes_[node].left);
+    if (index < leftPieces) {
+        nodes_[node].left = eraseAt(nodes_[node].left, index);
+        return balance(node);
+    }
+    if (index > leftPieces) {
+        nodes_[node].right = eraseAt(nodes_[node].right, index - leftPieces - 1);
+        return balance(node);
+    }
+
+    const size_t left = nodes_[node].left;
+    const size_t right = nodes_[node].right;
+    freeNodes_.push_back(node);
+    if (left == kNil) {
+        return right;
+    }
+    if (right == kNil) {
+        return left;
+    }
+
+    // Replace the node by its in-order successor
+    size_t successor = kNil;
+    const size_t remainder = removeMin(right, successor);
+    nodes_[successor].left = left;
+    nodes_[successor].right = remainder;
+    return balance(successor);
+}
+
+size_t PieceTree::removeMin(size_t node, size_t& leftmost) {
+    if (nodes_[node].left == kNil) {
+        leftmost = node;
+        return nodes_[node].right;
+    }
+    nodes_[node].left = removeMin(nodes_[node].left, leftmost);
+    return balance(node);
+}
+
+size_t PieceTree::build(const std::vector<Piece>& pieces, size_t first, size_t last) {
+    if (first >= last) {
+        return kNil;
+    }
+    const size_t middle = first + (last - first) / 2;
+    const size_t node = newNode(pieces[middle]);
+    const size_t left = build(pieces, first, middle);
+    const size_t right = build(pieces, middle + 1, last);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+    pull(node);
+    return node;
+}
+
+PieceTree::Location PieceTree::locate(size_t offset) const noexcept {
+    size_t index = 0;
+    size_t node = root_;
+    while (node != kNil) {
+        const Node& current = nodes_[node];
+        const size_t leftBytes = bytesOf(current.left);
+        if (offset < leftBytes) {
+            node = current.left;
+        } else if (offset < leftBytes + current.piece.length) {
+            return Location{index + piecesOf(current.left), offset - leftBytes};
+        } else {
+            offset -= leftBytes + current.piece.length;
+            index += piecesOf(current.left) + 1;
+            node = current.right;
+        }
+    }
+    return Location{index, 0};
+}
+
+const PieceTree::Piece& PieceTree::pieceAt(size_t index) const noexcept {
+    size_t node = root_;
+    while (true) {
+        const Node& current = nodes_[node];
+        const size_t leftPieces = piecesOf(current.left);
+        if (index < leftPieces) {
+            node = current.left;
+        } else if (index == leftPieces) {
+            return current.piece;
+        } else {
+            index -= leftPieces + 1;
+            node = current.right;
+        }
+    }
+}
+
+void PieceTree::setPiece(size_t index, const Piece& piece) {
+    // Record the path so the metrics can be refreshed bottom-up
+    size_t path[2 * sizeof(size_t) * 8];
+    size_t depth = 0;
+    size_t node = root_;
+    while (true) {
+        path[depth++] = node;
+        const Node& current = nodes_[node];
+        const size_t leftPieces = piecesOf(current.left);
+        if (index < leftPieces) {
+            node = current.left;
+        } else if (index == leftPieces) {
+            break;
+        } else {
+            index -= leftPieces + 1;
+            node = current.right;
+        }
+    }
+
+    nodes_[node].piece = piece;
+    while (depth > 0) {
+        pull(path[--depth]);
+    }
+}
+
+std::vector<PieceTree::Piece> PieceTree::collectPieces() const {
+    std::vector<Piece> pieces;
+    pieces.reserve(pieceCount());
+    std::vector<size_t> ancestors;
+    size_t node = root_;
+    while (node != kNil || !ancestors.empty()) {
+        while (node != kNil) {
+            ancestors.push_back(node);
+            node = nodes_[node].left;
+        }
+        node = ancestors.back();
+        ancestors.pop_back();
+        pieces.push_back(nodes_[node].piece);
+        node = nodes_[node].right;
+    }
+    return pieces;
+}
+
+void PieceTree::rebuild(const std::vector<Piece>& pieces) {
+    nodes_.clear();
+    freeNodes_.clear();
+    nodes_.reserve(pieces.size());
+    root_ = build(pieces, 0, pieces.size());
+}
+
+// =============================================================================
+// Internal Implementation
+// =============================================================================
+
+std::string_view PieceTree::pieceText(const Piece& piece) const noexcept {
+    return std::string_view(buffers_[piece.buffer].data() + piece.start, piece.length);
+}
+
+size_t PieceTree::countNewlines(size_t buffer, size_t start, size_t len) const noexcept {
+    // Empty for the original while its scan is deferred; ensureLineIndex()
+    // recounts every piece afterwards
+    const std::vector<size_t>& newlines = buffers_[buffer].newlines;
+    const auto first = std::lower_bound(newlines.begin(), newlines.end(), start);
+    const auto last = std::lower_bound(first, newlines.end(), start + len);
+    return static_cast<size_t>(last - first);
+}
+
+PieceTree::Piece PieceTree::slice(const Piece& piece, size_t offset, size_t len) const noexcept {
+    const size_t start = piece.start + offset;
+    return Piece{piece.buffer, start, len, countNewlines(piece.buffer, start, len)};
+}
+
+PieceTree::Piece PieceTree::append(std::string_view text) {
+    size_t index = addBlock_;
+    if (text.size() > kAddBlockSize) {
+        // Large inserts get a block of their own so the current block keeps
+        // its free space
+        index = buffers_.size();
+        buffers_.emplace_back();
+        buffers_.back().block.reset(new char[text.size()]);
+        buffers_.back().capacity = text.size();
+    } else if (index == kNoBlock ||
+               buffers_[index].capacity - buffers_[index].size < text.size()) {
+        index = buffers_.size();
+        buffers_.emplace_back();
+        buffers_.back().block.reset(new char[kAddBlockSize]);
+        buffers_.back().capacity = kAddBlockSize;
+        addBlock_ = index;
+    }
+
+    Buffer& buffer = buffers_[index];
+    const size_t start = buffer.size;
+    std::memcpy(buffer.block.get() + start, text.data(), text.size());
+    buffer.size += text.size();
+
+    const size_t before = buffer.newlines.size();
+    simd::forEachNewline(text, [&](size_t pos) {
+        buffer.newlines.push_back(start + pos);
+    });
+    return Piece{index, start, text.size(), buffer.newlines.size() - before};
+}
+
+void PieceTree::insertText(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    const Piece piece = append(text);
+    const Location loc = locate(offset);
+    size_t index = loc.index;
+
+    // Split the piece holding offset so the new piece goes between halves
+    if (loc.offset > 0) {
+        const Piece target = pieceAt(loc.index);
+        setPiece(loc.index, slice(target, 0, loc.offset));
+        const size_t right = newNode(slice(target, loc.offset, target.length - loc.offset));
+        root_ = insertAt(root_, loc.index + 1, right);
+        index = loc.index + 1;
+    }
+
+    // Typing forward lands right after the previous insert: grow its piece
+    if (index > 0) {
+        Piece previous = pieceAt(index - 1);
+        if (previous.buffer == piece.buffer &&
+            previous.start + previous.length == piece.start) {
+            previous.length += piece.length;
+            previous.newlines += piece.newlines;
+            setPiece(index - 1, previous);
+            return;
+        }
+    }
+    root_ = insertAt(root_, index, newNode(piece));
+}
+
+void PieceTree::eraseText(size_t offset, size_t len) {
+    while (len > 0) {
+        const Location loc = locate(offset);
+        const Piece target = pieceAt(loc.index);
+        const size_t take = std::min(len, target.length - loc.offset);
+        const size_t tail = target.length - loc.offset - take;
+
+        if (loc.offset == 0 && tail == 0) {
+            root_ = eraseAt(root_, loc.index);
+        } else if (loc.offset == 0) {
+            setPiece(loc.index, slice(target, take, tail));
+        } else {
+            setPiece(loc.index, slice(target, 0, loc.offset));
+            if (tail > 0) {
+                const size_t right = newNode(slice(target, loc.offset + take, tail));
+                root_ = insertAt(root_, loc.index + 1, right);
+            }
+        }
+        len -= take;
+    }
+}
+
+void PieceTree::ensureLineIndex() const {
+    if (!lineIndexPending_) {
+        return;
+    }
+
+    const Buffer& original = buffers_.front();
+    const std::string_view text(original.data(), original.size);
+    original.newlines.reserve(simd::countNewlines(text));
+    simd::forEachNewline(text, [&](size_t pos) {
+        original.newlines.push_back(pos);
+    });
+
+    // Counts of pieces over the original were taken while its list was empty
+    recount(root_);
+    lineIndexPending_ = false;
+}
+
+void PieceTree::recount(size_t node) const {
+    if (node == kNil) {
+        return;
+    }
+    Node& current = nodes_[node];
+    recount(current.left);
+    recount(current.right);
+    current.piece.newlines =
+        countNewlines(current.piece.buffer, current.piece.start, current.piece.length);
+    pull(node);
+}
+
+void PieceTree::sealBlocks() noexcept {
+    // The source keeps appending past each block's size; bytes below it are
+    // shared and never rewritten
+    for (Buffer& buffer : buffers_) {
+        buffer.capacity = buffer.size;
+    }
+    addBlock_ = kNoBlock;
+}
+
+} // namespace mdeditor
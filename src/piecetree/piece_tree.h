@@ -0,0 +1,401 @@
+// =============================================================================
+// piece_tree.h - Balanced Piece Tree Text Model
+// =============================================================================
+//
+// PieceTree stores the text like PieceTable (see piece_table.h): pieces over
+// a read-only original buffer and append-only add blocks, so no edit moves
+// stored text and loadFromFile() is O(1) on top of a memory mapping. The
+// pieces are kept in an AVL tree instead of a flat vector, for documents
+// with millions of lines and many scattered edits.
+//
+// TREE METRICS:
+// -------------
+// Every node stores, for its whole subtree, the number of pieces, bytes and
+// '\n' bytes. Descending from the root by byte offset, piece index or
+// newline number is therefore O(log pieces), and so are:
+//
+//   - insert() and erase() (plus one step per piece an erase removes)
+//   - lineFromOffset() and offsetFromLine() (plus a binary search in the
+//     buffer's newline list for the piece found)
+//   - lineCount() and length(), which read the root
+//
+// Nodes live in a pool (a vector indexed by node number), so copying the
+// tree copies one vector and no node is allocated per edit.
+//
+// COMPACTION:
+// -----------
+// Scattered edits fragment the text into many small pieces. compact() merges
+// neighbouring pieces that are contiguous in the same buffer, copies runs of
+// pieces shorter than kCompactPieceSize into single add-block pieces,
+// rebuilds a perfectly balanced tree, and releases add blocks no piece refers
+// to anymore. It is not an edit: no patch is recorded.
+//
+// Offsets, line semantics and patches are exactly those of GapBuffer; see
+// gap_buffer.h.
+//
+// =============================================================================
+
+#ifndef MDEDITOR_PIECE_TREE_H
+#define MDEDITOR_PIECE_TREE_H
+
+#include "document_model.h"
+#include "patch_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdeditor {
+
+class MappedFile;
+
+// =============================================================================
+// PieceTree - Piece table on a balanced tree with subtree metrics
+// =============================================================================
+/// PieceTree keeps pieces in an AVL tree annotated with subtree byte and
+/// newline counts, giving O(log n) edits and line/offset mapping.
+class PieceTree : public IDocumentModel {
+public:
+    /// Size of each append-only add block.
+    static constexpr size_t kAddBlockSize = 64 * 1024;
+
+    /// compact() copies runs of pieces shorter than this into one piece.
+    static constexpr size_t kCompactPieceSize = 256;
+
+    // -------------------------------------------------------------------------
+    // Construction / Destruction
+    // -------------------------------------------------------------------------
+
+    /// Constructs an empty tree (no buffers are allocated until text arrives).
+    PieceTree() = default;
+
+    ~PieceTree() override = default;
+
+    /// Copies share the stored buffers; neither copy appends to a block
+    /// the other one can see.
+    PieceTree(const PieceTree& other);
+    PieceTree& operator=(const PieceTree& other);
+    PieceTree(PieceTree&& other) noexcept = default;
+    PieceTree& operator=(PieceTree&& other) noexcept = default;
+
+    // -------------------------------------------------------------------------
+    // Loading Content
+    // -------------------------------------------------------------------------
+
+    /// Loads content from a string (copied once into the original buffer).
+    /// @param text The text to load
+    void loadFromString(std::string_view text) override;
+
+    /// Loads a file by memory-mapping it as the original buffer. O(1): the
+    /// file is not read until its text or lines are queried.
+    /// @param path The file to load
+    /// @throws std::runtime_error if the file cannot be opened or mapped;
+    ///         the tree is left unchanged
+    void loadFromFile(const std::filesystem::path& path) override;
+
+    /// Clears all content and releases the buffers.
+    void clear() override;
+
+    // -------------------------------------------------------------------------
+    // Retrieving Content
+    // -------------------------------------------------------------------------
+
+    /// Returns the entire text content as a string.
+    [[nodiscard]] std::string getText() const override;
+
+    /// Returns a substring of the text content.
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to retrieve
+    /// @return The requested substring (clamped to valid range)
+    [[nodiscard]] std::string getText(size_t start, size_t len) const override;
+
+    /// Returns the total length of the text in bytes.
+    /// @note O(1)
+    [[nodiscard]] size_t length() const noexcept override;
+
+    /// Returns true if the tree contains no text.
+    [[nodiscard]] bool empty() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Tree Introspection
+    // -------------------------------------------------------------------------
+
+    /// Returns the number of pieces the text is split into.
+    [[nodiscard]] size_t pieceCount() const noexcept;
+
+    /// Returns the height of the tree (0 when empty).
+    [[nodiscard]] size_t height() const noexcept;
+
+    /// Merges and rebalances pieces; see COMPACTION above. O(pieces) plus
+    /// the bytes of the small pieces it copies.
+    void compact();
+
+    // -------------------------------------------------------------------------
+    // Zero-Copy Access
+    // -------------------------------------------------------------------------
+
+    /// Calls fn(std::string_view) for each contiguous run of a byte range,
+    /// in order (one run per piece the range overlaps).
+    /// @param start Byte offset to start from
+    /// @param len Number of bytes to visit
+    /// @note Range is clamped like getText(start, len); empty runs are skipped
+    template <typename Fn>
+    void forEachChunk(size_t start, size_t len, Fn&& fn) const;
+
+    /// forEachChunk() behind the IDocumentModel interface.
+    void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override;
+
+    /// Returns the whole text as one view. Zero-copy while the text is a
+    /// single piece; otherwise copies it into an internal string that stays
+    /// valid until the next edit or call.
+    [[nodiscard]] std::string_view contiguousView() override;
+
+    /// Returns a snapshot sharing the buffers (O(pieces), no text copied).
+    [[nodiscard]] DocumentSnapshot snapshot() const override;
+
+    /// Returns the document version (see IDocumentModel::version()).
+    [[nodiscard]] uint64_t version() const noexcept override;
+
+    // -------------------------------------------------------------------------
+    // Editing Operations
+    // -------------------------------------------------------------------------
+
+    /// Inserts text at the specified byte offset.
+    /// @note Offset is clamped to [0, length()]; O(log pieces)
+    void insert(size_t offset, std::string_view text) override;
+
+    /// Erases a range of bytes.
+    /// @note Range is clamped to valid bounds; O(log pieces) per piece touched
+    void erase(size_t offset, size_t len) override;
+
+    /// Replaces patch.removedLength bytes at patch.start with
+    /// patch.insertedText as a single patch.
+    void applyPatch(const Patch& patch) override;
+
+    /// Applies a batch of non-overlapping edits, left to right, with the
+    /// same contract as IDocumentModel::applyEdits.
+    /// @throws std::invalid_argument if two edits overlap; the tree is
+    ///         left unchanged
+    void applyEdits(const std::vector<Edit>& edits) override;
+
+    // -------------------------------------------------------------------------
+    // Line/Offset Mapping
+    // -------------------------------------------------------------------------
+
+    /// Returns the 0-indexed line number containing the given byte offset.
+    /// @note O(log pieces + log n)
+    [[nodiscard]] size_t lineFromOffset(size_t offset) const override;
+
+    /// Returns the byte offset of position (line, column).
+    /// @note Returns end of text if line is past last line
+    /// @note O(log pieces + log n)
+    [[nodiscard]] size_t offsetFromLine(size_t line, size_t column = 0) const override;
+
+    /// Returns the total number of lines (at least 1 for non-empty text).
+    /// @note O(1)
+    [[nodiscard]] size_t lineCount() const override;
+
+    // -------------------------------------------------------------------------
+    // Patch Management
+    // -------------------------------------------------------------------------
+
+    /// Returns and clears the accumulated patches since last flush.
+    [[nodiscard]] std::vector<Patch> flushPatches() override;
+
+    /// Calls fn for each accumulated patch, then clears them (no copies).
+    void drainPatches(const PatchVisitor& fn) override;
+
+    /// Returns true if there are unflushed patches.
+    [[nodiscard]] bool hasPendingPatches() const noexcept override;
+
+private:
+    /// Immutable (original) or append-only (add block) text storage.
+    /// Bytes below size never change once written.
+    struct Buffer {
+        std::shared_ptr<char[]> block;               ///< Add block or copied original
+        std::shared_ptr<const MappedFile> mapping;   ///< Mapped original
+        size_t size = 0;                             ///< Bytes written
+        size_t capacity = 0;                         ///< Bytes that may be written
+        mutable std::vector<size_t> newlines;        ///< Sorted '\n' offsets below size
+
+        [[nodiscard]] const char* data() const noexcept;
+        [[nodiscard]] std::shared_ptr<const void> owner() const noexcept;
+    };
+
+    /// A range [start, start + length) of one buffer
+    struct Piece {
+        size_t buffer;
+        size_t start;
+        size_t length;
+        size_t newlines;  ///< Number of '\n' in the range
+    };
+
+    /// A tree node: one piece plus the metrics of its subtree
+    struct Node {
+        Piece piece;
+        size_t left;
+        size_t right;
+        size_t height;    ///< 1 for a leaf
+        size_t pieces;    ///< Pieces in the subtree
+        size_t bytes;     ///< Bytes in the subtree
+        size_t newlines;  ///< '\n' bytes in the subtree
+    };
+
+    /// Position of a byte inside the piece sequence
+    struct Location {
+        size_t index;   ///< Piece index; pieceCount() for the end of the text
+        size_t offset;  ///< Offset within the piece
+    };
+
+    static constexpr size_t kNil = static_cast<size_t>(-1);
+    static constexpr size_t kNoBlock = static_cast<size_t>(-1);
+
+    // Subtree metrics (0 for kNil)
+    [[nodiscard]] size_t heightOf(size_t node) const noexcept;
+    [[nodiscard]] size_t piecesOf(size_t node) const noexcept;
+    [[nodiscard]] size_t bytesOf(size_t node) const noexcept;
+    [[nodiscard]] size_t newlinesOf(size_t node) const noexcept;
+
+    /// Allocates a detached node holding piece
+    size_t newNode(const Piece& piece);
+
+    /// Recomputes a node's metrics from its piece and children
+    void pull(size_t node) const noexcept;
+
+    /// AVL rotations and rebalancing; each returns the new subtree root
+    size_t rotateLeft(size_t node) noexcept;
+    size_t rotateRight(size_t node) noexcept;
+    size_t balance(size_t node) noexcept;
+
+    /// Inserts the detached node fresh at a piece index of a subtree
+    size_t insertAt(size_t node, size_t index, size_t fresh);
+
+    /// Removes the piece at index from a subtree
+    size_t eraseAt(size_t node, size_t index);
+
+    /// Detaches the leftmost node of a subtree into leftmost
+    size_t removeMin(size_t node, size_t& leftmost);
+
+    /// Builds a balanced subtree from pieces [first, last)
+    size_t build(const std::vector<Piece>& pieces, size_t first, size_t last);
+
+    /// Finds the piece holding offset; a piece boundary maps to the start of
+    /// the following piece
+    [[nodiscard]] Location locate(size_t offset) const noexcept;
+
+    /// Returns the piece at index
+    [[nodiscard]] const Piece& pieceAt(size_t index) const noexcept;
+
+    /// Replaces the piece at index, updating the metrics on its path
+    void setPiece(size_t index, const Piece& piece);
+
+    /// Returns all pieces in text order
+    [[nodiscard]] std::vector<Piece> collectPieces() const;
+
+    /// Replaces the tree with a balanced tree over pieces
+    void rebuild(const std::vector<Piece>& pieces);
+
+    /// Returns the text of a piece
+    [[nodiscard]] std::string_view pieceText(const Piece& piece) const noexcept;
+
+    /// Number of '\n' in [start, start + len) of a buffer
+    [[nodiscard]] size_t countNewlines(size_t buffer, size_t start, size_t len) const noexcept;
+
+    /// Returns piece with its newline count recomputed for a new range
+    [[nodiscard]] Piece slice(const Piece& piece, size_t offset, size_t len) const noexcept;
+
+    /// Appends text to an add block and returns a piece over it
+    Piece append(std::string_view text);
+
+    /// Inserts without recording a patch
+    void insertText(size_t offset, std::string_view text);
+
+    /// Erases without recording a patch
+    void eraseText(size_t offset, size_t len);
+
+    /// Builds the original buffer's newline list if deferred by loadFromFile()
+    void ensureLineIndex() const;
+
+    /// Recounts newlines of every piece in a subtree
+    void recount(size_t node) const;
+
+    /// Stops this tree from appending to blocks it shares with a copy
+    void sealBlocks() noexcept;
+
+    std::vector<Buffer> buffers_;        ///< [0] is the original when loaded
+    std::vector<size_t> freeNodes_;      ///< Unused slots of nodes_
+    size_t root_ = kNil;
+    size_t addBlock_ = kNoBlock;         ///< Add block receiving small inserts
+    std::string flat_;                   ///< Backing store for contiguousView()
+    PatchLog pendingPatches_;            ///< Unflushed edit patches
+    uint64_t version_ = 0;               ///< Bumped by every edit and clear
+
+    // Mutable only so deferred counts can be computed by a const query
+    mutable std::vector<Node> nodes_;    ///< Node pool
+    mutable bool lineIndexPending_ = false;  ///< Original not scanned yet (mapped file)
+};
+
+// =============================================================================
+// Template Implementation
+// =============================================================================
+
+template <typename Fn>
+void PieceTree::forEachChunk(size_t start, size_t len, Fn&& fn) const {
+    if (start >= length() || len == 0) {
+        return;
+    }
+    len = std::min(len, length() - start);
+
+    // Descend to the piece holding start, remembering the ancestors whose
+    // pieces follow it (those we stepped left from)
+    std::vector<size_t> ancestors;
+    ancestors.reserve(heightOf(root_));
+    size_t node = root_;
+    size_t offset = start;
+    while (true) {
+        const Node& current = nodes_[node];
+        const size_t leftBytes = bytesOf(current.left);
+        if (offset < leftBytes) {
+            ancestors.push_back(node);
+            node = current.left;
+        } else if (offset < leftBytes + current.piece.length) {
+            offset -= leftBytes;
+            break;
+        } else {
+            offset -= leftBytes + current.piece.length;
+            node = current.right;
+        }
+    }
+
+    // In-order walk from there
+    while (true) {
+        const std::string_view run = pieceText(nodes_[node].piece);
+        const size_t take = std::min(len, run.size() - offset);
+        fn(run.substr(offset, take));
+        len -= take;
+        if (len == 0) {
+            return;
+        }
+        offset = 0;
+
+        if (nodes_[node].right != kNil) {
+            node = nodes_[node].right;
+            while (nodes_[node].left != kNil) {
+                ancestors.push_back(node);
+                node = nodes_[node].left;
+            }
+        } else {
+            node = ancestors.back();
+            ancestors.pop_back();
+        }
+    }
+}
+
+} // namespace mdeditor
+
+#endif // MDEDITOR_PIECE_TREE_H
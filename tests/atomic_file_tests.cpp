@@ -0,0 +1,168 @@
+// =============================================================================
+// atomic_file_tests.cpp - Unit Tests for Vectored Atomic Save
+// =============================================================================
+//
+// Tests for writeFileAtomically() and saveDocument() covering:
+// - Saving GapBuffer and PieceTable documents from their own storage
+// - Replacing an existing file, keeping its permissions and symlinks
+// - Failures leaving the old file and no temporary files behind
+// - More runs than one writev() call takes
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "atomic_file.h"
+#include "gap_buffer.h"
+#include "piece_table.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace fs = std::filesystem;
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class AtomicFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        dir_ = fs::temp_directory_path() / (std::string("mdeditor_") + info->name());
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+        path_ = dir_ / "notes.md";
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(dir_, ec);
+    }
+
+    static std::string readFile(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    static void writeFile(const fs::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::binary) << content;
+    }
+
+    /// Number of entries in the test directory (temporary files included)
+    size_t entryCount() const {
+        return static_cast<size_t>(std::distance(fs::directory_iterator(dir_), fs::directory_iterator()));
+    }
+
+    fs::path dir_;
+    fs::path path_;
+};
+
+// =============================================================================
+// Saving Documents
+// =============================================================================
+
+TEST_F(AtomicFileTest, SaveDocument_GapInMiddle) {
+    GapBuffer buffer;
+    buffer.loadFromString("# Title\n\nbody\n");
+    buffer.insert(8, "intro\n");    // Leaves the gap mid-text: two runs
+
+    saveDocument(buffer, path_);
+    EXPECT_EQ(readFile(path_), "# Title\nintro\n\nbody\n");
+    EXPECT_EQ(entryCount(), 1);
+}
+
+TEST_F(AtomicFileTest, SaveDocument_PieceTable) {
+    PieceTable table;
+    table.loadFromString("one three");
+    table.insert(4, "two ");
+    table.insert(table.length(), "\n");
+
+    saveDocument(table, path_, SaveOptions{false});
+    EXPECT_EQ(readFile(path_), "one two three\n");
+}
+
+TEST_F(AtomicFileTest, SaveDocument_Empty) {
+    writeFile(path_, "old contents");
+    GapBuffer buffer;
+
+    saveDocument(buffer, path_);
+    EXPECT_TRUE(fs::exists(path_));
+    EXPECT_EQ(fs::file_size(path_), 0);
+}
+
+// =============================================================================
+// Replacing Files
+// =============================================================================
+
+TEST_F(AtomicFileTest, Write_ReplacesExistingFile) {
+    writeFile(path_, std::string(10'000, 'x'));
+
+    writeFileAtomically(path_, {"short", " text"});
+    EXPECT_EQ(readFile(path_), "short text");
+    EXPECT_EQ(entryCount(), 1);
+}
+
+TEST_F(AtomicFileTest, Write_ManyRuns) {
+    // More runs than IOV_MAX (1024 on Linux), some of them empty
+    std::vector<std::string> pieces;
+    std::string expected;
+    for (int i = 0; i < 5000; ++i) {
+        pieces.push_back(i % 7 == 0 ? std::string() : std::to_string(i) + ",");
+        expected += pieces.back();
+    }
+    const std::vector<std::string_view> runs(pieces.begin(), pieces.end());
+
+    writeFileAtomically(path_, runs);
+    EXPECT_EQ(readFile(path_), expected);
+}
+
+TEST_F(AtomicFileTest, MissingDirectory_ThrowsAndLeavesNothing) {
+    const fs::path missing = dir_ / "missing" / "notes.md";
+    EXPECT_THROW(writeFileAtomically(missing, {"text"}), std::runtime_error);
+    EXPECT_FALSE(fs::exists(missing));
+    EXPECT_EQ(entryCount(), 0);
+}
+
+TEST_F(AtomicFileTest, FailedReplace_KeepsOldFile) {
+    // A directory cannot be replaced by a file: the rename fails
+    const fs::path target = dir_ / "folder";
+    fs::create_directories(target / "child");
+    writeFile(path_, "untouched");
+
+    EXPECT_THROW(writeFileAtomically(target, {"text"}), std::runtime_error);
+    EXPECT_TRUE(fs::is_directory(target / "child"));
+    EXPECT_EQ(readFile(path_), "untouched");
+    EXPECT_EQ(entryCount(), 2);    // No temporary file left behind
+}
+
+#ifndef _WIN32
+
+TEST_F(AtomicFileTest, Replace_KeepsPermissions) {
+    writeFile(path_, "old");
+    fs::permissions(path_, fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+
+    writeFileAtomically(path_, {"new"});
+    EXPECT_EQ(readFile(path_), "new");
+    EXPECT_EQ(fs::status(path_).permissions() & fs::perms::mask,
+              fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+}
+
+TEST_F(AtomicFileTest, Symlink_ReplacesTarget) {
+    const fs::path target = dir_ / "real.md";
+    const fs::path link = dir_ / "link.md";
+    writeFile(target, "old");
+    fs::create_symlink(target, link);
+
+    writeFileAtomically(link, {"new"});
+    EXPECT_TRUE(fs::is_symlink(link));
+    EXPECT_EQ(readFile(target), "new");
+}
+
+#endif
@@ -0,0 +1,377 @@
+// =============================================================================
+// chunked_gap_buffer_tests.cpp - Unit Tests for ChunkedGapBuffer
+// =============================================================================
+//
+// Tests for the chunked text store covering:
+// - Basic editing and reads within one chunk
+// - Chunk splitting, merging and removal across chunk boundaries
+// - Line/offset mapping across chunks
+// - Zero-copy reads and iterators
+// - Copy-on-write chunk sharing with copies and snapshots
+// - Parity with GapBuffer under random edits
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "chunked_gap_buffer.h"
+#include "gap_buffer.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+constexpr size_t kChunk = ChunkedGapBuffer::kChunkSize;
+
+/// Builds text of the given size with a newline every lineLength bytes
+std::string makeLines(size_t size, size_t lineLength) {
+    std::string text(size, 'x');
+    for (size_t i = lineLength - 1; i < size; i += lineLength) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+/// Reference line lookups on a plain string
+size_t scanLineFromOffset(const std::string& text, size_t offset) {
+    offset = std::min(offset, text.size());
+    return static_cast<size_t>(std::count(text.begin(), text.begin() + offset, '\n'));
+}
+
+size_t scanOffsetFromLine(const std::string& text, size_t line) {
+    size_t offset = 0;
+    for (size_t l = 0; l < line; ++l) {
+        const size_t pos = text.find('\n', offset);
+        if (pos == std::string::npos) {
+            return text.size();
+        }
+        offset = pos + 1;
+    }
+    return offset;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class ChunkedGapBufferTest : public ::testing::Test {
+protected:
+    ChunkedGapBuffer buffer;
+};
+
+// =============================================================================
+// Basic Operations
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, DefaultConstruction_IsEmpty) {
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.length(), 0);
+    EXPECT_EQ(buffer.lineCount(), 0);
+    EXPECT_EQ(buffer.chunkCount(), 0);
+    EXPECT_EQ(buffer.getText(), "");
+    EXPECT_EQ(buffer.begin(), buffer.end());
+}
+
+TEST_F(ChunkedGapBufferTest, InsertEraseWithinChunk) {
+    buffer.insert(0, "Hello World");
+    buffer.insert(5, ",");
+    buffer.erase(6, 1);
+    buffer.insert(6, "\n");
+    EXPECT_EQ(buffer.getText(), "Hello,\nWorld");
+    EXPECT_EQ(buffer.lineCount(), 2);
+    EXPECT_EQ(buffer.chunkCount(), 1);
+}
+
+TEST_F(ChunkedGapBufferTest, OutOfRangeArgumentsAreClamped) {
+    buffer.loadFromString("abc");
+    buffer.insert(100, "d");
+    buffer.erase(2, 100);
+    buffer.erase(100, 1);
+    EXPECT_EQ(buffer.getText(), "ab");
+    EXPECT_EQ(buffer.getText(1, 100), "b");
+    EXPECT_EQ(buffer.getText(5, 1), "");
+}
+
+// =============================================================================
+// Chunk Management
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, LoadLargeText_SplitsIntoBoundedChunks) {
+    const std::string text = makeLines(10 * kChunk + 123, 80);
+    buffer.loadFromString(text);
+
+    EXPECT_EQ(buffer.getText(), text);
+    EXPECT_GT(buffer.chunkCount(), 10);
+    EXPECT_LE(buffer.capacity(), text.size() + buffer.chunkCount() * kChunk);
+    EXPECT_EQ(buffer.lineCount(), 1 + static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+}
+
+TEST_F(ChunkedGapBufferTest, TypingIntoFullChunk_SplitsIt) {
+    std::string text = makeLines(kChunk, 50);
+    buffer.loadFromString(text);
+    const size_t chunksBefore = buffer.chunkCount();
+
+    const size_t position = text.size() / 2;
+    for (size_t i = 0; i < kChunk; ++i) {
+        buffer.insert(position + i, "y");
+    }
+    text.insert(position, std::string(kChunk, 'y'));
+
+    EXPECT_EQ(buffer.getText(), text);
+    EXPECT_GT(buffer.chunkCount(), chunksBefore);
+}
+
+TEST_F(ChunkedGapBufferTest, EraseAcrossChunks_RemovesAndMerges) {
+    std::string text = makeLines(8 * kChunk, 64);
+    buffer.loadFromString(text);
+
+    buffer.erase(100, 6 * kChunk);
+    text.erase(100, 6 * kChunk);
+
+    EXPECT_EQ(buffer.getText(), text);
+    EXPECT_LE(buffer.chunkCount(), 3);
+    EXPECT_EQ(buffer.lineCount(), 1 + static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+}
+
+TEST_F(ChunkedGapBufferTest, EraseEverything_LeavesNoChunks) {
+    buffer.loadFromString(makeLines(5 * kChunk, 10));
+    buffer.erase(0, buffer.length());
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.chunkCount(), 0);
+
+    buffer.insert(0, "again");
+    EXPECT_EQ(buffer.getText(), "again");
+}
+
+TEST_F(ChunkedGapBufferTest, ShrinkToFit_ReleasesGaps) {
+    buffer.loadFromString(makeLines(4 * kChunk, 32));
+    buffer.insert(kChunk, "z");
+    buffer.shrinkToFit();
+    EXPECT_EQ(buffer.capacity(), buffer.length());
+}
+
+// =============================================================================
+// Line/Offset Mapping
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, LineMapping_MatchesScan) {
+    std::string text = makeLines(6 * kChunk, 37);
+    buffer.loadFromString(text);
+    buffer.insert(3 * kChunk + 5, "\n\n");
+    text.insert(3 * kChunk + 5, "\n\n");
+
+    for (size_t offset = 0; offset <= text.size(); offset += 997) {
+        EXPECT_EQ(buffer.lineFromOffset(offset), scanLineFromOffset(text, offset)) << offset;
+    }
+    EXPECT_EQ(buffer.lineFromOffset(text.size()), scanLineFromOffset(text, text.size()));
+
+    const size_t lines = buffer.lineCount();
+    for (size_t line = 0; line < lines + 2; line += 101) {
+        EXPECT_EQ(buffer.offsetFromLine(line), scanOffsetFromLine(text, line)) << line;
+    }
+    EXPECT_EQ(buffer.offsetFromLine(lines - 1), scanOffsetFromLine(text, lines - 1));
+    EXPECT_EQ(buffer.offsetFromLine(1, 1000000), text.size());
+}
+
+// =============================================================================
+// Zero-Copy Access
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, ForEachChunk_CoversRange) {
+    const std::string text = makeLines(3 * kChunk, 20);
+    buffer.loadFromString(text);
+    buffer.insert(kChunk, "mid");
+    const std::string expected = buffer.getText();
+
+    std::string collected;
+    size_t runs = 0;
+    buffer.forEachChunk(10, 2 * kChunk, [&](std::string_view run) {
+        EXPECT_FALSE(run.empty());
+        collected.append(run);
+        ++runs;
+    });
+    EXPECT_EQ(collected, expected.substr(10, 2 * kChunk));
+    EXPECT_GT(runs, 1);
+}
+
+TEST_F(ChunkedGapBufferTest, Iterator_WalksAllBytesBothWays) {
+    std::string text = makeLines(3 * kChunk, 29);
+    buffer.loadFromString(text);
+    buffer.insert(kChunk + 7, "abc");
+    buffer.erase(2 * kChunk, 5);
+    text = buffer.getText();
+
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), text);
+
+    std::string reversed;
+    for (auto it = buffer.end(); it != buffer.begin();) {
+        --it;
+        reversed.push_back(*it);
+    }
+    std::reverse(reversed.begin(), reversed.end());
+    EXPECT_EQ(reversed, text);
+
+    EXPECT_EQ(*buffer.iteratorAt(kChunk + 7), 'a');
+    EXPECT_EQ(buffer.iteratorAt(text.size()), buffer.end());
+}
+
+TEST_F(ChunkedGapBufferTest, ContiguousView_MatchesText) {
+    buffer.loadFromString("small");
+    buffer.insert(2, "--");
+    EXPECT_EQ(buffer.contiguousView(), "sm--all");
+
+    const std::string text = makeLines(3 * kChunk, 20);
+    buffer.loadFromString(text);
+    EXPECT_EQ(buffer.contiguousView(), text);
+}
+
+// =============================================================================
+// Copy-on-Write Sharing
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, Snapshot_CopiesOnlyEditedChunk) {
+    const std::string text = makeLines(4 * kChunk, 100);
+    buffer.loadFromString(text);
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    auto runStarts = [](const DocumentSnapshot& shot) {
+        std::vector<const char*> starts;
+        shot.forEachChunk(0, shot.length(), [&](std::string_view run) {
+            starts.push_back(run.data());
+        });
+        return starts;
+    };
+    const std::vector<const char*> shared = runStarts(snapshot);
+    
+    buffer.insert(10, "edit");
+    const std::vector<const char*> current = runStarts(buffer.snapshot());
+    
+    ASSERT_EQ(current.size(), shared.size() + 1);  // First chunk now has a gap
+    EXPECT_NE(current.front(), shared.front());
+    EXPECT_TRUE(std::equal(shared.begin() + 1, shared.end(), current.begin() + 2));
+    EXPECT_EQ(snapshot.getText(), text);
+}
+
+TEST_F(ChunkedGapBufferTest, Copies_ShareChunksUntilWritten) {
+    buffer.loadFromString(makeLines(3 * kChunk, 50));
+    ChunkedGapBuffer copy = buffer;
+    
+    buffer.insert(0, "left");
+    copy.insert(copy.length(), "right");
+    
+    EXPECT_EQ(buffer.getText().substr(0, 4), "left");
+    EXPECT_EQ(copy.getText().substr(0, 4), "xxxx");
+    EXPECT_EQ(copy.length(), buffer.length() + 1);
+    EXPECT_EQ(buffer.getText().substr(4), copy.getText().substr(0, copy.length() - 5));
+}
+
+// =============================================================================
+// Patches and Batched Edits
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, Patches_CoalesceLikeGapBuffer) {
+    buffer.loadFromString("abcdef");
+    buffer.insert(6, "g");
+    buffer.insert(7, "h");
+    buffer.erase(2, 1);
+    buffer.erase(1, 1);
+
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 2);
+    EXPECT_EQ(patches[0].insertedText, "gh");
+    EXPECT_EQ(patches[1].start, 1);
+    EXPECT_EQ(patches[1].removedText, "bc");
+    EXPECT_FALSE(buffer.hasPendingPatches());
+}
+
+TEST_F(ChunkedGapBufferTest, ApplyEdits_ReplacesAcrossChunks) {
+    std::string text = makeLines(4 * kChunk, 100);
+    buffer.loadFromString(text);
+
+    std::vector<Edit> edits;
+    for (size_t pos = 99; pos < text.size(); pos += 100) {
+        edits.push_back(Edit{pos, 1, "\r\n"});
+    }
+    buffer.applyEdits(edits);
+
+    std::string expected;
+    for (char c : text) {
+        expected += (c == '\n') ? std::string("\r\n") : std::string(1, c);
+    }
+    EXPECT_EQ(buffer.getText(), expected);
+    EXPECT_EQ(buffer.flushPatches().size(), edits.size());
+}
+
+TEST_F(ChunkedGapBufferTest, ApplyEdits_OverlapThrowsAndLeavesText) {
+    buffer.loadFromString("0123456789");
+    const std::vector<Edit> edits = {{2, 3, "x"}, {4, 1, "y"}};
+    EXPECT_THROW(buffer.applyEdits(edits), std::invalid_argument);
+    EXPECT_EQ(buffer.getText(), "0123456789");
+}
+
+// =============================================================================
+// Parity with GapBuffer
+// =============================================================================
+
+TEST_F(ChunkedGapBufferTest, RandomEdits_MatchGapBuffer) {
+    std::mt19937 rng(1234);
+    GapBuffer reference;
+    const std::string initial = makeLines(3 * kChunk, 41);
+    reference.loadFromString(initial);
+    buffer.loadFromString(initial);
+
+    for (int step = 0; step < 3000; ++step) {
+        const size_t len = reference.length();
+        const size_t offset = len == 0 ? 0 : rng() % (len + 1);
+        switch (rng() % 4) {
+            case 0: {
+                const std::string text(1 + rng() % 8, static_cast<char>('a' + rng() % 26));
+                reference.insert(offset, text);
+                buffer.insert(offset, text);
+                break;
+            }
+            case 1: {
+                // Large paste, sometimes bigger than a chunk
+                std::string text = makeLines(1 + rng() % (kChunk + kChunk / 2), 1 + rng() % 90);
+                reference.insert(offset, text);
+                buffer.insert(offset, text);
+                break;
+            }
+            case 2: {
+                const size_t count = 1 + rng() % (kChunk / 2);
+                reference.erase(offset, count);
+                buffer.erase(offset, count);
+                break;
+            }
+            default: {
+                const size_t count = 1 + rng() % 4;
+                reference.erase(offset, count);
+                buffer.erase(offset, count);
+                break;
+            }
+        }
+        // Keep the document from growing without bound
+        if (reference.length() > 12 * kChunk) {
+            reference.erase(0, 6 * kChunk);
+            buffer.erase(0, 6 * kChunk);
+        }
+
+        ASSERT_EQ(buffer.length(), reference.length()) << "step " << step;
+        ASSERT_EQ(buffer.lineCount(), reference.lineCount()) << "step " << step;
+        if (step % 100 == 0) {
+            ASSERT_EQ(buffer.getText(), reference.getText()) << "step " << step;
+            const size_t probe = buffer.length() == 0 ? 0 : rng() % buffer.length();
+            EXPECT_EQ(buffer.lineFromOffset(probe), reference.lineFromOffset(probe));
+            const size_t line = rng() % (buffer.lineCount() + 1);
+            EXPECT_EQ(buffer.offsetFromLine(line, 3), reference.offsetFromLine(line, 3));
+        }
+    }
+    EXPECT_EQ(buffer.getText(), reference.getText());
+}
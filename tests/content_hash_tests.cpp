@@ -0,0 +1,163 @@
+// =============================================================================
+// content_hash_tests.cpp - Unit Tests for ContentHash
+// =============================================================================
+//
+// Tests for the incrementally maintained content digest covering:
+// - Digests depending on the text only, not on chunking or edit history
+// - Telling apart texts that differ by one byte, order or length
+// - Random edits, large pastes (chunk splits) and large erases, fed from
+//   the patch stream of a GapBuffer and a PieceTable
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "content_hash.h"
+#include "gap_buffer.h"
+#include "piece_table.h"
+
+#include <random>
+#include <string>
+
+using namespace mdeditor;
+
+namespace {
+
+std::string makeText(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string text(size, '\0');
+    for (char& c : text) {
+        c = "abc \n#"[rng() % 6];
+    }
+    return text;
+}
+
+/// Feeds the model's pending patches to hash
+void drainInto(IDocumentModel& model, ContentHash& hash) {
+    model.drainPatches([&hash](const PatchView& patch) {
+        hash.recordEdit(patch.start, patch.removedLength, patch.insertedText.size());
+    });
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Digests
+// =============================================================================
+
+TEST(ContentHashTest, DigestDependsOnTextOnly) {
+    const std::string text = makeText(50'000, 1);
+    GapBuffer buffer;
+    buffer.loadFromString(text);
+    ContentHash hash;
+    EXPECT_EQ(hash.digest(buffer), ContentHash::digestOf(text));
+    EXPECT_TRUE(hash.valid());
+
+    // The same text reached by edits, with different chunk boundaries
+    GapBuffer edited;
+    edited.loadFromString(text.substr(10'000));
+    ContentHash editedHash;
+    editedHash.rebuild(edited);
+    edited.insert(0, text.substr(0, 10'000));
+    drainInto(edited, editedHash);
+    EXPECT_EQ(editedHash.digest(edited), hash.digest(buffer));
+}
+
+TEST(ContentHashTest, DifferentTextsDiffer) {
+    EXPECT_EQ(ContentHash::digestOf(""), ContentHash::Digest{});
+    EXPECT_NE(ContentHash::digestOf(std::string(1, '\0')), ContentHash::digestOf(""));
+    EXPECT_NE(ContentHash::digestOf("ab"), ContentHash::digestOf("ba"));
+    EXPECT_NE(ContentHash::digestOf("a"), ContentHash::digestOf("b"));
+
+    const std::string text = makeText(100'000, 2);
+    std::string changed = text;
+    changed[77'777] ^= 1;
+    EXPECT_NE(ContentHash::digestOf(changed), ContentHash::digestOf(text));
+}
+
+TEST(ContentHashTest, UndoRestoresSavedDigest) {
+    GapBuffer buffer;
+    buffer.loadFromString(makeText(20'000, 3));
+    ContentHash hash;
+    const ContentHash::Digest saved = hash.digest(buffer);
+
+    buffer.insert(5000, "typed");
+    drainInto(buffer, hash);
+    EXPECT_NE(hash.digest(buffer), saved);
+
+    buffer.erase(5000, 5);
+    drainInto(buffer, hash);
+    EXPECT_EQ(hash.digest(buffer), saved);
+}
+
+// =============================================================================
+// Incremental Updates
+// =============================================================================
+
+TEST(ContentHashTest, RandomEditsMatchDigestOf) {
+    std::mt19937 rng(24);
+    std::string expected = makeText(40'000, 4);
+    GapBuffer buffer;
+    buffer.loadFromString(expected);
+    ContentHash hash;
+    hash.rebuild(buffer);
+
+    for (int step = 0; step < 1500; ++step) {
+        const size_t pos = rng() % (expected.size() + 1);
+        const unsigned kind = rng() % 20;
+        if (kind == 0) {
+            // Large paste: splits a chunk when it is rehashed
+            const std::string paste = makeText(3 * ContentHash::kChunkSize + rng() % 100, step);
+            buffer.insert(pos, paste);
+            expected.insert(pos, paste);
+        } else if (kind == 1) {
+            // Large erase: empties whole chunks
+            const size_t len = std::min<size_t>(rng() % (4 * ContentHash::kChunkSize), expected.size() - pos);
+            buffer.erase(pos, len);
+            expected.erase(pos, len);
+        } else if (kind < 12) {
+            const std::string text = makeText(rng() % 8 + 1, step);
+            buffer.insert(pos, text);
+            expected.insert(pos, text);
+        } else {
+            const size_t len = std::min<size_t>(rng() % 6, expected.size() - pos);
+            buffer.erase(pos, len);
+            expected.erase(pos, len);
+        }
+        // Several edits between digests, as between two frames
+        if (step % 3 == 0) {
+            drainInto(buffer, hash);
+        }
+        if (step % 30 == 0) {
+            drainInto(buffer, hash);
+            ASSERT_EQ(hash.digest(buffer), ContentHash::digestOf(expected)) << "step " << step;
+        }
+    }
+    drainInto(buffer, hash);
+    EXPECT_EQ(hash.digest(buffer), ContentHash::digestOf(expected));
+}
+
+TEST(ContentHashTest, EmptyingAndRefilling) {
+    PieceTable table;
+    table.loadFromString("some text");
+    ContentHash hash;
+    hash.rebuild(table);
+
+    table.erase(0, table.length());
+    drainInto(table, hash);
+    EXPECT_EQ(hash.digest(table), ContentHash::Digest{});
+
+    table.insert(0, "new");
+    drainInto(table, hash);
+    EXPECT_EQ(hash.digest(table), ContentHash::digestOf("new"));
+}
+
+TEST(ContentHashTest, OutOfRangeEditResets) {
+    GapBuffer buffer;
+    buffer.loadFromString("short");
+    ContentHash hash;
+    hash.rebuild(buffer);
+
+    hash.recordEdit(100, 0, 1);
+    EXPECT_FALSE(hash.valid());
+    EXPECT_EQ(hash.digest(buffer), ContentHash::digestOf("short"));
+}
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include "../src/mdapp/DocumentController.h"
+#include "../src/gapbuffer/gap_buffer.h"
 
 #include <QCoreApplication>
 #include <QSignalSpy>
@@ -105,6 +106,29 @@ TEST_F(DocumentControllerTest, SetText_SetsModified) {
     EXPECT_TRUE(controller->isModified());
 }
 
+TEST_F(DocumentControllerTest, SetText_BackToSavedTextClearsModified) {
+    controller->setText("# Notes\n\nfirst\n");
+    controller->saveFile(tempDir.path() + "/notes.md");
+
+    // Type and delete a character: the text matches the saved file again
+    controller->setText("# Notes\n\nfirsts\n");
+    EXPECT_TRUE(controller->isModified());
+    controller->setText("# Notes\n\nfirst\n");
+    EXPECT_FALSE(controller->isModified());
+    EXPECT_EQ(controller->text(), "# Notes\n\nfirst\n");
+}
+
+TEST_F(DocumentControllerTest, BufferStats_PublishedOnlyWhenCounted) {
+    controller->setText("# Title\n\nBody\n");
+    const QVariantMap stats = controller->bufferStats();
+    if (!mdeditor::GapBuffer::statsEnabled()) {
+        EXPECT_TRUE(stats.isEmpty());
+        return;
+    }
+    EXPECT_EQ(stats.size(), 7);
+    EXPECT_GT(stats.value("bytesAllocated").toULongLong(), 0u);
+}
+
 TEST_F(DocumentControllerTest, SetText_Multiline) {
     QString multiline = "Line 1\nLine 2\nLine 3";
     controller->setText(multiline);
@@ -0,0 +1,312 @@
+// =============================================================================
+// edit_journal_tests.cpp - Unit Tests for EditJournal
+// =============================================================================
+//
+// Tests for the crash recovery journal covering:
+// - Replaying a typing session onto the saved text
+// - Group commit: buffering until the byte threshold or commit()
+// - Failed commits leaving no partial records
+// - Torn and corrupt tails, foreign bases (same length included), reset
+//   after save
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "edit_journal.h"
+#include "gap_buffer.h"
+#include "piece_table.h"
+
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace mdeditor;
+
+namespace fs = std::filesystem;
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class EditJournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path_ = fs::temp_directory_path() /
+                (std::string("mdeditor_") + info->name() + ".journal");
+        saved_.loadFromString(base_);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    /// Never commits on its own: only commit() and destruction write
+    static EditJournal::Options manualCommit() {
+        EditJournal::Options options;
+        options.groupCommitBytes = SIZE_MAX;
+        options.groupCommitInterval = std::chrono::hours(1);
+        return options;
+    }
+
+    /// Flips one byte of the journal file
+    void corruptByte(uint64_t offset) {
+        std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(static_cast<std::streamoff>(offset));
+        char byte = 0;
+        file.get(byte);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(byte ^ 0x40));
+    }
+
+    const std::string base_ = "# Notes\n\nfirst line\nsecond line\n";
+    GapBuffer saved_;       ///< Holds base_
+    fs::path path_;
+};
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+TEST_F(EditJournalTest, Recover_ReplaysEditsOntoSavedText) {
+    GapBuffer buffer;
+    buffer.loadFromString(base_);
+    {
+        EditJournal journal(path_, buffer);
+        buffer.insert(7, " and todos");
+        journal.append(buffer.flushPatches());
+        buffer.erase(0, 2);
+        buffer.applyEdits({{10, 5, "1st"}, {20, 0, "\n"}});
+        journal.append(buffer.flushPatches());
+    }   // Crash after the last commit
+
+    GapBuffer recovered;
+    recovered.loadFromString(base_);
+    const EditJournal::Recovery result = EditJournal::recover(path_, recovered);
+
+    EXPECT_TRUE(result.complete);
+    EXPECT_EQ(result.patchesApplied, 4);
+    EXPECT_EQ(recovered.getText(), buffer.getText());
+    EXPECT_TRUE(recovered.hasPendingPatches());
+}
+
+TEST_F(EditJournalTest, Recover_RandomSessionOntoAnyBackend) {
+    std::string saved(5000, '.');
+    GapBuffer buffer;
+    buffer.loadFromString(saved);
+    {
+        EditJournal journal(path_, buffer);
+        std::mt19937 rng(14);
+        for (int step = 0; step < 2000; ++step) {
+            const size_t pos = rng() % (buffer.length() + 1);
+            if (rng() % 3 != 0) {
+                buffer.insert(pos, std::string(rng() % 300 + 1, "ab\n"[rng() % 3]));
+            } else {
+                buffer.erase(pos, rng() % 200);
+            }
+            if (step % 7 == 0) {
+                buffer.drainPatches([&journal](const PatchView& patch) {
+                    journal.append(patch);
+                });
+            }
+        }
+        journal.append(buffer.flushPatches());
+        journal.commit();
+    }
+
+    PieceTable recovered;
+    recovered.loadFromString(saved);
+    EXPECT_TRUE(EditJournal::recover(path_, recovered).complete);
+    EXPECT_EQ(recovered.getText(), buffer.getText());
+}
+
+// =============================================================================
+// Group Commit
+// =============================================================================
+
+TEST_F(EditJournalTest, Append_BuffersUntilCommit) {
+    EditJournal journal(path_, saved_, manualCommit());
+    const uint64_t header = journal.committedBytes();
+    EXPECT_EQ(fs::file_size(path_), header);
+
+    journal.append(Patch(0, 0, "typed"));
+    journal.append(Patch(5, 0, "!"));
+    EXPECT_GT(journal.pendingBytes(), 0);
+    EXPECT_EQ(fs::file_size(path_), header);
+
+    journal.commit();
+    EXPECT_EQ(journal.pendingBytes(), 0);
+    EXPECT_EQ(fs::file_size(path_), journal.committedBytes());
+    EXPECT_GT(journal.committedBytes(), header);
+}
+
+TEST_F(EditJournalTest, Append_CommitsAtByteThreshold) {
+    EditJournal::Options options = manualCommit();
+    options.groupCommitBytes = 1024;
+    EditJournal journal(path_, GapBuffer(), options);
+
+    journal.append(Patch(0, 0, std::string(100, 'a')));
+    EXPECT_GT(journal.pendingBytes(), 0);
+    journal.append(Patch(100, 0, std::string(1000, 'b')));
+    EXPECT_EQ(journal.pendingBytes(), 0);
+    EXPECT_EQ(fs::file_size(path_), journal.committedBytes());
+}
+
+#ifndef _WIN32
+TEST_F(EditJournalTest, Commit_FailureLeavesNoPartialRecords) {
+    // A file size limit stops write() partway through the second commit
+    rlimit original{};
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &original), 0);
+    const auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+    {
+        EditJournal journal(path_, saved_, manualCommit());
+        journal.append(Patch(0, 0, "A"));
+        journal.commit();
+        const uint64_t committed = journal.committedBytes();
+
+        journal.append(Patch(1, 0, std::string(1000, 'B')));
+        journal.append(Patch(1001, 0, "C"));
+        rlimit limited = original;
+        limited.rlim_cur = committed + 100;
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limited), 0);
+        EXPECT_THROW(journal.commit(), std::runtime_error);
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &original), 0);
+
+        EXPECT_EQ(fs::file_size(path_), committed);
+        EXPECT_EQ(journal.committedBytes(), committed);
+        EXPECT_GT(journal.pendingBytes(), 0);
+        journal.commit();   // The retry writes each record once
+    }
+    std::signal(SIGXFSZ, previousHandler);
+
+    GapBuffer recovered;
+    recovered.loadFromString(base_);
+    const EditJournal::Recovery result = EditJournal::recover(path_, recovered);
+    EXPECT_TRUE(result.complete);
+    EXPECT_EQ(result.patchesApplied, 3);
+    EXPECT_EQ(recovered.getText(), "A" + std::string(1000, 'B') + "C" + base_);
+}
+#endif
+
+TEST_F(EditJournalTest, Records_AreCompact) {
+    EditJournal journal(path_, GapBuffer(), manualCommit());
+    const uint64_t header = journal.committedBytes();
+    journal.append(Patch(100, 0, "x"));
+    journal.commit();
+
+    // length (1) + start (1) + removed (1) + "x" (1) + crc (4)
+    EXPECT_EQ(journal.committedBytes() - header, 8);
+}
+
+// =============================================================================
+// Damage and Reset
+// =============================================================================
+
+TEST_F(EditJournalTest, Recover_StopsAtTornRecord) {
+    {
+        EditJournal journal(path_, saved_, manualCommit());
+        journal.append(Patch(0, 0, "A"));
+        journal.append(Patch(1, 0, "B"));
+        journal.append(Patch(2, 0, "a longer record that is torn"));
+    }
+    fs::resize_file(path_, fs::file_size(path_) - 6);
+
+    GapBuffer recovered;
+    recovered.loadFromString(base_);
+    const EditJournal::Recovery result = EditJournal::recover(path_, recovered);
+
+    EXPECT_FALSE(result.complete);
+    EXPECT_EQ(result.patchesApplied, 2);
+    EXPECT_EQ(recovered.getText(), "AB" + base_);
+}
+
+TEST_F(EditJournalTest, Recover_StopsAtChecksumMismatch) {
+    uint64_t secondRecord = 0;
+    {
+        EditJournal journal(path_, saved_, manualCommit());
+        journal.append(Patch(0, 0, "keep"));
+        journal.commit();
+        secondRecord = journal.committedBytes();
+        journal.append(Patch(0, 2, "drop"));
+        journal.append(Patch(0, 0, "after"));
+    }
+    corruptByte(secondRecord + 3);
+
+    GapBuffer recovered;
+    recovered.loadFromString(base_);
+    const EditJournal::Recovery result = EditJournal::recover(path_, recovered);
+
+    EXPECT_FALSE(result.complete);
+    EXPECT_EQ(result.patchesApplied, 1);
+    EXPECT_EQ(recovered.getText(), "keep" + base_);
+}
+
+TEST_F(EditJournalTest, Recover_RejectsOtherBaseAndGarbage) {
+    {
+        EditJournal journal(path_, saved_);
+        journal.append(Patch(0, 0, "x"));
+    }
+    GapBuffer other;
+    other.loadFromString("a different file");
+    EXPECT_THROW(EditJournal::recover(path_, other), std::runtime_error);
+    EXPECT_EQ(other.getText(), "a different file");
+
+    corruptByte(2);
+    GapBuffer buffer;
+    buffer.loadFromString(base_);
+    EXPECT_THROW(EditJournal::recover(path_, buffer), std::runtime_error);
+    EXPECT_THROW(EditJournal::recover(path_.string() + ".missing", buffer), std::runtime_error);
+}
+
+TEST_F(EditJournalTest, Recover_RejectsSameLengthOtherBase) {
+    // Crash after a save that kept the length, before reset()
+    GapBuffer buffer;
+    buffer.loadFromString(base_);
+    {
+        EditJournal journal(path_, buffer);
+        buffer.applyPatch(Patch(10, 5, "FIRST"));
+        journal.append(buffer.flushPatches());
+    }
+    const std::string saved = buffer.getText();
+    ASSERT_EQ(saved.size(), base_.size());
+
+    GapBuffer reopened;
+    reopened.loadFromString(saved);
+    EXPECT_THROW(EditJournal::recover(path_, reopened), std::runtime_error);
+    EXPECT_EQ(reopened.getText(), saved);
+    EXPECT_FALSE(reopened.hasPendingPatches());
+}
+
+TEST_F(EditJournalTest, Reset_StartsFromSavedText) {
+    GapBuffer buffer;
+    buffer.loadFromString(base_);
+    std::string saved;
+    {
+        EditJournal journal(path_, buffer, manualCommit());
+        buffer.insert(0, "before save ");
+        journal.append(buffer.flushPatches());
+        journal.commit();
+
+        saved = buffer.getText();       // "Save" the file
+        journal.reset(buffer);
+        EXPECT_EQ(fs::file_size(path_), journal.committedBytes());
+
+        buffer.insert(buffer.length(), "after save\n");
+        journal.append(buffer.flushPatches());
+    }
+
+    GapBuffer recovered;
+    recovered.loadFromString(saved);
+    const EditJournal::Recovery result = EditJournal::recover(path_, recovered);
+    EXPECT_EQ(result.patchesApplied, 1);
+    EXPECT_EQ(recovered.getText(), buffer.getText());
+}
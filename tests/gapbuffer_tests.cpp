@@ -1,24 +1,78 @@
 // =============================================================================
-// gapbuffer_tests.cpp - Unit Tests for GapBuffer
+// gapbuffer_tests.cpp - Unit Tests for GapBuffer and the IDocumentModel Backends
 // =============================================================================
 //
-// Comprehensive tests for the GapBuffer text model covering:
+// Comprehensive tests for the text models covering:
 // - Loading content
 // - Insert operations (beginning, middle, end)
 // - Delete operations
 // - getText functionality
 // - Line/offset mapping
 // - Patch tracking and flushing
+// - Snapshots, versions and reading snapshots from another thread
+// - Concurrent readers (seqlock) while the owning thread edits
+// - Operation statistics (MD_GAPBUFFER_STATS builds)
+//
+// Tests written against IDocumentModel (DocumentModelTest) run once per
+// backend: GapBuffer, PieceTable, ChunkedGapBuffer and MultiGapBuffer.
+// GapBufferTest covers the GapBuffer-only API (gap layout, iterators,
+// capacity, copies).
 //
 // =============================================================================
 
 #include <gtest/gtest.h>
+#include "chunked_gap_buffer.h"
 #include "gap_buffer.h"
+#include "multi_gap_buffer.h"
+#include "piece_table.h"
+#include "piece_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace mdeditor;
 
 // =============================================================================
-// Test Fixture
+// Reference Line Mapping (byte scanning, the original implementation)
+// =============================================================================
+
+namespace {
+
+size_t scanLineFromOffset(const std::string& text, size_t offset) {
+    offset = std::min(offset, text.size());
+    return static_cast<size_t>(std::count(text.begin(), text.begin() + offset, '\n'));
+}
+
+size_t scanOffsetFromLine(const std::string& text, size_t line, size_t column) {
+    size_t currentLine = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < text.size() && currentLine < line; ++i) {
+        if (text[i] == '\n') {
+            ++currentLine;
+        }
+        ++offset;
+    }
+    return std::min(offset + column, text.size());
+}
+
+size_t scanLineCount(const std::string& text) {
+    if (text.empty()) {
+        return 0;
+    }
+    return 1 + static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Test Fixtures
 // =============================================================================
 
 class GapBufferTest : public ::testing::Test {
@@ -30,11 +84,33 @@ protected:
     }
 };
 
+/// A document model backend under test
+struct Backend {
+    const char* name;
+    std::unique_ptr<IDocumentModel> (*make)();
+};
+
+class DocumentModelTest : public ::testing::TestWithParam<Backend> {
+protected:
+    std::unique_ptr<IDocumentModel> model = GetParam().make();
+    IDocumentModel& buffer = *model;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    Backends, DocumentModelTest,
+    ::testing::Values(
+        Backend{"GapBuffer", [] { return std::unique_ptr<IDocumentModel>(new GapBuffer); }},
+        Backend{"PieceTable", [] { return std::unique_ptr<IDocumentModel>(new PieceTable); }},
+        Backend{"ChunkedGapBuffer", [] { return std::unique_ptr<IDocumentModel>(new ChunkedGapBuffer); }},
+        Backend{"MultiGapBuffer", [] { return std::unique_ptr<IDocumentModel>(new MultiGapBuffer); }},
+        Backend{"PieceTree", [] { return std::unique_ptr<IDocumentModel>(new PieceTree); }}),
+    [](const ::testing::TestParamInfo<Backend>& info) { return std::string(info.param.name); });
+
 // =============================================================================
 // Construction Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, DefaultConstructor_CreatesEmptyBuffer) {
+TEST_P(DocumentModelTest, DefaultConstructor_CreatesEmptyBuffer) {
     EXPECT_TRUE(buffer.empty());
     EXPECT_EQ(buffer.length(), 0);
     EXPECT_EQ(buffer.getText(), "");
@@ -50,7 +126,7 @@ TEST_F(GapBufferTest, CapacityConstructor_CreatesEmptyBuffer) {
 // Load Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, LoadFromString_SimplString) {
+TEST_P(DocumentModelTest, LoadFromString_SimplString) {
     buffer.loadFromString("Hello, World!");
     
     EXPECT_FALSE(buffer.empty());
@@ -58,28 +134,28 @@ TEST_F(GapBufferTest, LoadFromString_SimplString) {
     EXPECT_EQ(buffer.getText(), "Hello, World!");
 }
 
-TEST_F(GapBufferTest, LoadFromString_EmptyString) {
+TEST_P(DocumentModelTest, LoadFromString_EmptyString) {
     buffer.loadFromString("");
     
     EXPECT_TRUE(buffer.empty());
     EXPECT_EQ(buffer.length(), 0);
 }
 
-TEST_F(GapBufferTest, LoadFromString_MultiLineString) {
+TEST_P(DocumentModelTest, LoadFromString_MultiLineString) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.length(), 20);
     EXPECT_EQ(buffer.lineCount(), 3);
 }
 
-TEST_F(GapBufferTest, LoadFromString_ReplacesExistingContent) {
+TEST_P(DocumentModelTest, LoadFromString_ReplacesExistingContent) {
     buffer.loadFromString("First content");
     buffer.loadFromString("Second content");
     
     EXPECT_EQ(buffer.getText(), "Second content");
 }
 
-TEST_F(GapBufferTest, Clear_RemovesAllContent) {
+TEST_P(DocumentModelTest, Clear_RemovesAllContent) {
     buffer.loadFromString("Some content");
     buffer.clear();
     
@@ -91,48 +167,48 @@ TEST_F(GapBufferTest, Clear_RemovesAllContent) {
 // Insert Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, Insert_AtBeginning) {
+TEST_P(DocumentModelTest, Insert_AtBeginning) {
     buffer.loadFromString("World!");
     buffer.insert(0, "Hello, ");
     
     EXPECT_EQ(buffer.getText(), "Hello, World!");
 }
 
-TEST_F(GapBufferTest, Insert_AtEnd) {
+TEST_P(DocumentModelTest, Insert_AtEnd) {
     buffer.loadFromString("Hello");
     buffer.insert(buffer.length(), ", World!");
     
     EXPECT_EQ(buffer.getText(), "Hello, World!");
 }
 
-TEST_F(GapBufferTest, Insert_InMiddle) {
+TEST_P(DocumentModelTest, Insert_InMiddle) {
     buffer.loadFromString("Hello World!");
     buffer.insert(5, ",");
     
     EXPECT_EQ(buffer.getText(), "Hello, World!");
 }
 
-TEST_F(GapBufferTest, Insert_EmptyString) {
+TEST_P(DocumentModelTest, Insert_EmptyString) {
     buffer.loadFromString("Hello");
     buffer.insert(2, "");
     
     EXPECT_EQ(buffer.getText(), "Hello");
 }
 
-TEST_F(GapBufferTest, Insert_IntoEmptyBuffer) {
+TEST_P(DocumentModelTest, Insert_IntoEmptyBuffer) {
     buffer.insert(0, "Hello");
     
     EXPECT_EQ(buffer.getText(), "Hello");
 }
 
-TEST_F(GapBufferTest, Insert_OffsetBeyondLength_ClampsToEnd) {
+TEST_P(DocumentModelTest, Insert_OffsetBeyondLength_ClampsToEnd) {
     buffer.loadFromString("Hello");
     buffer.insert(100, " World");
     
     EXPECT_EQ(buffer.getText(), "Hello World");
 }
 
-TEST_F(GapBufferTest, Insert_MultipleConsecutive) {
+TEST_P(DocumentModelTest, Insert_MultipleConsecutive) {
     buffer.loadFromString("AC");
     buffer.insert(1, "B");
     
@@ -142,7 +218,7 @@ TEST_F(GapBufferTest, Insert_MultipleConsecutive) {
     EXPECT_EQ(buffer.getText(), "ABCD");
 }
 
-TEST_F(GapBufferTest, Insert_LargeText) {
+TEST_P(DocumentModelTest, Insert_LargeText) {
     std::string largeText(10000, 'x');
     buffer.insert(0, largeText);
     
@@ -154,28 +230,28 @@ TEST_F(GapBufferTest, Insert_LargeText) {
 // Erase Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, Erase_FromBeginning) {
+TEST_P(DocumentModelTest, Erase_FromBeginning) {
     buffer.loadFromString("Hello, World!");
     buffer.erase(0, 7);
     
     EXPECT_EQ(buffer.getText(), "World!");
 }
 
-TEST_F(GapBufferTest, Erase_FromEnd) {
+TEST_P(DocumentModelTest, Erase_FromEnd) {
     buffer.loadFromString("Hello, World!");
     buffer.erase(7, 6);
     
     EXPECT_EQ(buffer.getText(), "Hello, ");
 }
 
-TEST_F(GapBufferTest, Erase_FromMiddle) {
+TEST_P(DocumentModelTest, Erase_FromMiddle) {
     buffer.loadFromString("Hello, World!");
     buffer.erase(5, 2);
     
     EXPECT_EQ(buffer.getText(), "HelloWorld!");
 }
 
-TEST_F(GapBufferTest, Erase_EntireContent) {
+TEST_P(DocumentModelTest, Erase_EntireContent) {
     buffer.loadFromString("Hello");
     buffer.erase(0, 5);
     
@@ -183,21 +259,21 @@ TEST_F(GapBufferTest, Erase_EntireContent) {
     EXPECT_EQ(buffer.getText(), "");
 }
 
-TEST_F(GapBufferTest, Erase_ZeroLength) {
+TEST_P(DocumentModelTest, Erase_ZeroLength) {
     buffer.loadFromString("Hello");
     buffer.erase(2, 0);
     
     EXPECT_EQ(buffer.getText(), "Hello");
 }
 
-TEST_F(GapBufferTest, Erase_OffsetBeyondLength) {
+TEST_P(DocumentModelTest, Erase_OffsetBeyondLength) {
     buffer.loadFromString("Hello");
     buffer.erase(100, 5);
     
     EXPECT_EQ(buffer.getText(), "Hello");
 }
 
-TEST_F(GapBufferTest, Erase_LengthClamped) {
+TEST_P(DocumentModelTest, Erase_LengthClamped) {
     buffer.loadFromString("Hello");
     buffer.erase(2, 100);  // Should only erase "llo"
     
@@ -208,43 +284,43 @@ TEST_F(GapBufferTest, Erase_LengthClamped) {
 // getText Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, GetText_EntireBuffer) {
+TEST_P(DocumentModelTest, GetText_EntireBuffer) {
     buffer.loadFromString("Hello, World!");
     
     EXPECT_EQ(buffer.getText(), "Hello, World!");
 }
 
-TEST_F(GapBufferTest, GetText_Substring_FromBeginning) {
+TEST_P(DocumentModelTest, GetText_Substring_FromBeginning) {
     buffer.loadFromString("Hello, World!");
     
     EXPECT_EQ(buffer.getText(0, 5), "Hello");
 }
 
-TEST_F(GapBufferTest, GetText_Substring_FromMiddle) {
+TEST_P(DocumentModelTest, GetText_Substring_FromMiddle) {
     buffer.loadFromString("Hello, World!");
     
     EXPECT_EQ(buffer.getText(7, 5), "World");
 }
 
-TEST_F(GapBufferTest, GetText_Substring_ToEnd) {
+TEST_P(DocumentModelTest, GetText_Substring_ToEnd) {
     buffer.loadFromString("Hello, World!");
     
     EXPECT_EQ(buffer.getText(7, 100), "World!");  // Clamped
 }
 
-TEST_F(GapBufferTest, GetText_Substring_StartBeyondLength) {
+TEST_P(DocumentModelTest, GetText_Substring_StartBeyondLength) {
     buffer.loadFromString("Hello");
     
     EXPECT_EQ(buffer.getText(100, 5), "");
 }
 
-TEST_F(GapBufferTest, GetText_Substring_ZeroLength) {
+TEST_P(DocumentModelTest, GetText_Substring_ZeroLength) {
     buffer.loadFromString("Hello");
     
     EXPECT_EQ(buffer.getText(2, 0), "");
 }
 
-TEST_F(GapBufferTest, GetText_AfterGapMove) {
+TEST_P(DocumentModelTest, GetText_AfterGapMove) {
     buffer.loadFromString("ABCDEFGHIJ");
     buffer.insert(5, "X");  // Gap moves to position 5
     
@@ -254,7 +330,7 @@ TEST_F(GapBufferTest, GetText_AfterGapMove) {
     EXPECT_EQ(buffer.getText(), "ABCDEXFGHIJ");
 }
 
-TEST_F(GapBufferTest, GetText_SpansGap) {
+TEST_P(DocumentModelTest, GetText_SpansGap) {
     buffer.loadFromString("ABCDEFGHIJ");
     buffer.insert(5, "XYZ");  // Gap at position 5
     
@@ -262,27 +338,452 @@ TEST_F(GapBufferTest, GetText_SpansGap) {
     EXPECT_EQ(buffer.getText(3, 6), "DEXYZF");
 }
 
+// =============================================================================
+// Zero-Copy Access Tests
+// =============================================================================
+
+TEST_F(GapBufferTest, Segments_SplitAtGap) {
+    buffer.loadFromString("ABCDEFGHIJ");
+    buffer.insert(5, "XYZ");
+    
+    auto segs = buffer.segments();
+    EXPECT_EQ(segs.before, "ABCDEXYZ");
+    EXPECT_EQ(segs.after, "FGHIJ");
+}
+
+TEST_F(GapBufferTest, Segments_EmptyBuffer) {
+    auto segs = buffer.segments();
+    EXPECT_TRUE(segs.before.empty());
+    EXPECT_TRUE(segs.after.empty());
+}
+
+TEST_F(GapBufferTest, ForEachChunk_SpansGap) {
+    buffer.loadFromString("ABCDEFGHIJ");
+    buffer.insert(5, "XYZ");
+    
+    std::vector<std::string> chunks;
+    buffer.forEachChunk(3, 6, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+    });
+    
+    ASSERT_EQ(chunks.size(), 2);
+    EXPECT_EQ(chunks[0], "DEXYZ");
+    EXPECT_EQ(chunks[1], "F");
+}
+
+TEST_P(DocumentModelTest, VisitChunks_ClampsAndSkipsEmptyRuns) {
+    buffer.loadFromString("Hello");
+    
+    std::vector<std::string> chunks;
+    buffer.visitChunks(2, 100, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+    });
+    ASSERT_EQ(chunks.size(), 1);
+    EXPECT_EQ(chunks[0], "llo");
+    
+    chunks.clear();
+    buffer.visitChunks(100, 5, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+    });
+    EXPECT_TRUE(chunks.empty());
+
+    // An empty range inside the text visits nothing either
+    buffer.visitChunks(2, 0, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+    });
+    EXPECT_TRUE(chunks.empty());
+}
+
+TEST_F(GapBufferTest, ContiguousView_ReturnsWholeText) {
+    buffer.loadFromString("ABCDEFGHIJ");
+    buffer.insert(2, "--");
+    
+    EXPECT_EQ(buffer.contiguousView(), "AB--CDEFGHIJ");
+    EXPECT_TRUE(buffer.segments().after.empty());
+    EXPECT_EQ(buffer.lineCount(), 1);
+}
+
+TEST_F(GapBufferTest, Iterator_ForwardCrossesGap) {
+    buffer.loadFromString("ABCDEF");
+    buffer.insert(3, "x");
+    
+    std::string collected(buffer.begin(), buffer.end());
+    EXPECT_EQ(collected, "ABCxDEF");
+}
+
+TEST_F(GapBufferTest, Iterator_BackwardCrossesGap) {
+    buffer.loadFromString("ABCDEF");
+    buffer.insert(3, "x");
+    
+    std::string reversed;
+    for (auto it = buffer.end(); it != buffer.begin();) {
+        --it;
+        reversed.push_back(*it);
+    }
+    EXPECT_EQ(reversed, "FEDxCBA");
+}
+
+TEST_F(GapBufferTest, Iterator_GapAtStartAndEnd) {
+    buffer.loadFromString("Hello");
+    buffer.insert(0, "");      // No-op: gap stays at end
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), "Hello");
+    
+    buffer.erase(0, 1);        // Gap moves to start
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), "ello");
+    EXPECT_EQ(*buffer.iteratorAt(0), 'e');
+    EXPECT_EQ(*buffer.iteratorAt(3), 'o');
+    EXPECT_EQ(buffer.iteratorAt(100), buffer.end());
+}
+
+TEST_F(GapBufferTest, Iterator_EmptyBuffer) {
+    EXPECT_EQ(buffer.begin(), buffer.end());
+}
+
+TEST_P(DocumentModelTest, ContiguousView_MatchesText) {
+    EXPECT_TRUE(buffer.contiguousView().empty());
+    
+    buffer.loadFromString("ABCDEFGHIJ");
+    buffer.insert(2, "--");
+    buffer.erase(8, 1);
+    
+    EXPECT_EQ(buffer.contiguousView(), "AB--CDEFHIJ");
+    EXPECT_EQ(buffer.lineCount(), 1);
+}
+
+// =============================================================================
+// Snapshot Tests
+// =============================================================================
+
+TEST_P(DocumentModelTest, Snapshot_UnchangedByLaterEdits) {
+    buffer.loadFromString("one\ntwo\nthree");
+    buffer.insert(4, "new\n");
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    buffer.erase(0, 8);
+    buffer.insert(0, "changed");
+    buffer.insert(buffer.length(), std::string(300, 'x'));
+    
+    EXPECT_EQ(snapshot.length(), 17);
+    EXPECT_EQ(snapshot.getText(), "one\nnew\ntwo\nthree");
+    EXPECT_EQ(snapshot.getText(4, 8), "new\ntwo\n");
+}
+
+TEST_P(DocumentModelTest, Snapshot_OutlivesModel) {
+    buffer.loadFromString("Hello");
+    buffer.insert(5, ", World");
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    model.reset();
+    
+    EXPECT_EQ(snapshot.getText(), "Hello, World");
+}
+
+TEST_P(DocumentModelTest, Snapshot_ChunksCoverRange) {
+    buffer.loadFromString("ABCDEF");
+    buffer.insert(3, "xyz");
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    std::string visited;
+    snapshot.forEachChunk(2, 5, [&](std::string_view chunk) {
+        EXPECT_FALSE(chunk.empty());
+        visited.append(chunk);
+    });
+    EXPECT_EQ(visited, "CxyzD");
+    EXPECT_TRUE(DocumentSnapshot().empty());
+}
+
+TEST_P(DocumentModelTest, Snapshot_CarriesVersion) {
+    const uint64_t initial = buffer.version();
+    buffer.loadFromString("abc");
+    const uint64_t loaded = buffer.version();
+    EXPECT_GT(loaded, initial);
+    
+    (void)buffer.getText();
+    (void)buffer.contiguousView();
+    (void)buffer.flushPatches();
+    EXPECT_EQ(buffer.version(), loaded);  // Reads are not edits
+    
+    const DocumentSnapshot before = buffer.snapshot();
+    buffer.insert(1, "x");
+    const DocumentSnapshot after = buffer.snapshot();
+    buffer.erase(0, 1);
+    EXPECT_EQ(before.version(), loaded);
+    EXPECT_GT(after.version(), before.version());
+    EXPECT_GT(buffer.version(), after.version());
+    
+    const uint64_t edited = buffer.version();
+    buffer.clear();
+    EXPECT_GT(buffer.version(), edited);
+}
+
+TEST_P(DocumentModelTest, Snapshot_GenerationsStayIndependent) {
+    buffer.loadFromString("0123456789");
+    std::vector<DocumentSnapshot> snapshots;
+    std::vector<std::string> expected;
+    
+    // Type, backspace, jump around: every snapshot keeps its own text
+    const size_t positions[] = {10, 11, 12, 3, 4, 0, 15, 7};
+    for (size_t pos : positions) {
+        snapshots.push_back(buffer.snapshot());
+        expected.push_back(buffer.getText());
+        buffer.insert(pos, "ab");
+        buffer.erase(pos + 1, 1);
+    }
+    
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        EXPECT_EQ(snapshots[i].getText(), expected[i]) << "snapshot " << i;
+    }
+}
+
+TEST_P(DocumentModelTest, Snapshot_ReadOnAnotherThreadWhileTyping) {
+    std::string text(200000, '-');
+    for (size_t i = 63; i < text.size(); i += 64) {
+        text[i] = '\n';
+    }
+    buffer.loadFromString(text);
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    // The reader checks the snapshot over and over while this thread edits
+    // near the cursor and far from it
+    std::thread reader([&snapshot, &text] {
+        for (int pass = 0; pass < 20; ++pass) {
+            ASSERT_EQ(snapshot.getText(), text);
+        }
+    });
+    std::mt19937 rng(5);
+    size_t cursor = text.size() / 2;
+    for (int i = 0; i < 2000; ++i) {
+        if (i % 100 == 0) {
+            cursor = rng() % buffer.length();
+        }
+        buffer.insert(cursor, "typed");
+        cursor += 5;
+        if (i % 3 == 0) {
+            buffer.erase(--cursor, 1);
+        }
+    }
+    reader.join();
+    
+    EXPECT_EQ(snapshot.getText(), text);
+    EXPECT_EQ(buffer.length(), text.size() + 2000 * 5 - 667);
+}
+
+// =============================================================================
+// Concurrent Reader Tests
+// =============================================================================
+
+TEST_F(GapBufferTest, ReadConcurrent_MatchesGetText) {
+    buffer.loadFromString("Hello\nWorld");
+    buffer.insert(5, ", brave");
+    EXPECT_EQ(buffer.readConcurrent(3, 8), buffer.getText(3, 8));  // Disabled
+    
+    buffer.setConcurrentReads(true);
+    EXPECT_TRUE(buffer.concurrentReads());
+    EXPECT_EQ(buffer.lengthConcurrent(), buffer.length());
+    for (size_t start = 0; start <= buffer.length() + 1; ++start) {
+        for (size_t len : {size_t(0), size_t(1), size_t(6), size_t(100)}) {
+            ASSERT_EQ(buffer.readConcurrent(start, len), buffer.getText(start, len));
+        }
+    }
+    
+    buffer.insert(0, ">");
+    buffer.erase(3, 2);
+    EXPECT_EQ(buffer.readConcurrent(0, 100), buffer.getText());
+    
+    buffer.setConcurrentReads(false);
+    EXPECT_FALSE(buffer.concurrentReads());
+    EXPECT_EQ(buffer.readConcurrent(0, 100), buffer.getText());
+}
+
+TEST_F(GapBufferTest, ReadConcurrent_NeverSeesTornText) {
+    // The writer only ever inserts then removes letters, so with them
+    // stripped every consistent read is exactly the base text
+    std::string base(20000, '-');
+    for (size_t i = 39; i < base.size(); i += 40) {
+        base[i] = '\n';
+    }
+    buffer.loadFromString(base);
+    buffer.setConcurrentReads(true);
+    
+    std::atomic<bool> done{false};
+    std::atomic<int> reads{0};
+    auto reader = [&] {
+        while (!done.load()) {
+            std::string text = buffer.readConcurrent(0, std::string::npos);
+            text.erase(std::remove_if(text.begin(), text.end(), [](char c) {
+                return c >= 'a' && c <= 'z';
+            }), text.end());
+            ASSERT_EQ(text, base);
+            ++reads;
+        }
+    };
+    std::thread first(reader);
+    std::thread second(reader);
+    
+    std::mt19937 rng(17);
+    for (int i = 0; i < 3000 || reads.load() < 50; ++i) {
+        const size_t pos = rng() % (buffer.length() + 1);
+        if (i % 500 == 250) {
+            // Grow far past the capacity, then shrink back: both reallocate
+            // under the readers
+            buffer.insert(pos, std::string(200000, 'g'));
+            buffer.erase(pos, 200000);
+        } else {
+            buffer.insert(pos, "typed");
+            buffer.erase(pos, 5);
+        }
+        if (i % 1000 == 999) {
+            buffer.loadFromString(base);
+        }
+    }
+    done = true;
+    first.join();
+    second.join();
+    
+    EXPECT_EQ(buffer.getText(), base);
+    EXPECT_EQ(buffer.lengthConcurrent(), base.size());
+}
+
+// =============================================================================
+// Batched Edit Tests
+// =============================================================================
+
+TEST_P(DocumentModelTest, ApplyEdits_ReplaceAll) {
+    buffer.loadFromString("cat dog cat bird cat");
+    buffer.applyEdits({{0, 3, "lion"}, {8, 3, "lion"}, {17, 3, "lion"}});
+    
+    EXPECT_EQ(buffer.getText(), "lion dog lion bird lion");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_UnsortedInput) {
+    buffer.loadFromString("ABCDEFGH");
+    buffer.applyEdits({{6, 1, "g"}, {0, 0, ">"}, {3, 2, ""}});
+    
+    EXPECT_EQ(buffer.getText(), ">ABCFgH");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_InsertsAtSameOffsetKeepOrder) {
+    buffer.loadFromString("XY");
+    buffer.applyEdits({{1, 0, "a"}, {1, 0, "b"}, {1, 1, "c"}});
+    
+    EXPECT_EQ(buffer.getText(), "Xabc");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_OverlapThrowsAndLeavesBufferUnchanged) {
+    buffer.loadFromString("Hello, World!");
+    (void)buffer.flushPatches();
+    
+    EXPECT_THROW(buffer.applyEdits({{0, 5, "Hi"}, {3, 4, "!"}}), std::invalid_argument);
+    EXPECT_EQ(buffer.getText(), "Hello, World!");
+    EXPECT_FALSE(buffer.hasPendingPatches());
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_GrowsForLargeInsertions) {
+    buffer.loadFromString("a-b-c");
+    const std::string big(5000, 'x');
+    buffer.applyEdits({{1, 1, big}, {3, 1, big}});
+    
+    EXPECT_EQ(buffer.getText(), "a" + big + "b" + big + "c");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_ClampsOutOfRange) {
+    buffer.loadFromString("Hello");
+    buffer.applyEdits({{100, 5, "!"}, {3, 100, "p"}});
+    
+    EXPECT_EQ(buffer.getText(), "Help!");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_PatchesReplayInOrder) {
+    const std::string original = "one\ntwo\nthree\nfour";
+    buffer.loadFromString(original);
+    buffer.applyEdits({{14, 5, "4"}, {0, 3, "1\n1"}, {8, 0, "\n"}});
+    
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 3);
+    
+    std::string replayed = original;
+    for (const auto& p : patches) {
+        replayed.replace(p.start, p.removedLength, p.insertedText);
+    }
+    EXPECT_EQ(replayed, buffer.getText());
+    EXPECT_EQ(patches[0].start, 0);
+    EXPECT_EQ(patches[1].start, 8);   // "1\n1" replaced "one" (same length)
+    EXPECT_EQ(patches[2].start, 15);  // Shifted by the inserted "\n"
+}
+
+TEST_P(DocumentModelTest, ApplyPatch_RecordsOnePatch) {
+    buffer.loadFromString("Hello, World!");
+    buffer.applyPatch(Patch(7, 5, "there"));
+    
+    EXPECT_EQ(buffer.getText(), "Hello, there!");
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 1);
+    EXPECT_EQ(patches[0].removedText, "World");
+    EXPECT_EQ(patches[0].insertedText, "there");
+}
+
+TEST_P(DocumentModelTest, ApplyEdits_RandomizedMatchesSequential) {
+    std::mt19937 rng(99);
+    
+    for (int round = 0; round < 200; ++round) {
+        std::string reference(50 + rng() % 200, ' ');
+        for (char& c : reference) {
+            c = "ab\ncd"[rng() % 5];
+        }
+        buffer.loadFromString(reference);
+        buffer.insert(rng() % reference.size(), "");  // Leave gap wherever
+        
+        // Non-overlapping edits with distinct starts and random widths
+        std::vector<std::string> texts;
+        std::vector<Edit> edits;
+        size_t pos = 0;
+        while (true) {
+            pos += 1 + rng() % 12;
+            if (pos > reference.size()) break;
+            const size_t removed = std::min<size_t>(rng() % 5, reference.size() - pos);
+            texts.emplace_back(rng() % 8, "xy\n"[rng() % 3]);
+            edits.push_back(Edit{pos, removed, {}});
+            pos += removed;
+        }
+        for (size_t i = 0; i < edits.size(); ++i) {
+            edits[i].insertedText = texts[i];
+        }
+        
+        // Reference applies right-to-left so earlier offsets stay valid
+        for (auto it = edits.rbegin(); it != edits.rend(); ++it) {
+            reference.replace(it->start, it->removedLength, it->insertedText);
+        }
+        std::shuffle(edits.begin(), edits.end(), rng);
+        buffer.applyEdits(edits);
+        
+        ASSERT_EQ(buffer.getText(), reference) << "round " << round;
+        ASSERT_EQ(buffer.lineCount(), scanLineCount(reference)) << "round " << round;
+        const size_t probe = rng() % (reference.size() + 1);
+        ASSERT_EQ(buffer.lineFromOffset(probe), scanLineFromOffset(reference, probe));
+    }
+}
+
 // =============================================================================
 // Line/Offset Mapping Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, LineCount_EmptyBuffer) {
+TEST_P(DocumentModelTest, LineCount_EmptyBuffer) {
     EXPECT_EQ(buffer.lineCount(), 0);
 }
 
-TEST_F(GapBufferTest, LineCount_SingleLine) {
+TEST_P(DocumentModelTest, LineCount_SingleLine) {
     buffer.loadFromString("Hello");
     
     EXPECT_EQ(buffer.lineCount(), 1);
 }
 
-TEST_F(GapBufferTest, LineCount_MultipleLines) {
+TEST_P(DocumentModelTest, LineCount_MultipleLines) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3\n");
     
     EXPECT_EQ(buffer.lineCount(), 4);  // 3 newlines = 4 lines
 }
 
-TEST_F(GapBufferTest, LineFromOffset_FirstLine) {
+TEST_P(DocumentModelTest, LineFromOffset_FirstLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.lineFromOffset(0), 0);
@@ -290,48 +791,48 @@ TEST_F(GapBufferTest, LineFromOffset_FirstLine) {
     EXPECT_EQ(buffer.lineFromOffset(6), 0);  // At newline
 }
 
-TEST_F(GapBufferTest, LineFromOffset_SecondLine) {
+TEST_P(DocumentModelTest, LineFromOffset_SecondLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.lineFromOffset(7), 1);   // Start of line 2
     EXPECT_EQ(buffer.lineFromOffset(10), 1);
 }
 
-TEST_F(GapBufferTest, LineFromOffset_ThirdLine) {
+TEST_P(DocumentModelTest, LineFromOffset_ThirdLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.lineFromOffset(14), 2);  // Start of line 3
     EXPECT_EQ(buffer.lineFromOffset(19), 2);  // End of buffer
 }
 
-TEST_F(GapBufferTest, LineFromOffset_BeyondEnd) {
+TEST_P(DocumentModelTest, LineFromOffset_BeyondEnd) {
     buffer.loadFromString("Line 1\nLine 2");
     
     // Offset beyond end should clamp
     EXPECT_EQ(buffer.lineFromOffset(100), 1);
 }
 
-TEST_F(GapBufferTest, OffsetFromLine_FirstLine) {
+TEST_P(DocumentModelTest, OffsetFromLine_FirstLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.offsetFromLine(0, 0), 0);
     EXPECT_EQ(buffer.offsetFromLine(0, 3), 3);
 }
 
-TEST_F(GapBufferTest, OffsetFromLine_SecondLine) {
+TEST_P(DocumentModelTest, OffsetFromLine_SecondLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.offsetFromLine(1, 0), 7);
     EXPECT_EQ(buffer.offsetFromLine(1, 4), 11);
 }
 
-TEST_F(GapBufferTest, OffsetFromLine_ThirdLine) {
+TEST_P(DocumentModelTest, OffsetFromLine_ThirdLine) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3");
     
     EXPECT_EQ(buffer.offsetFromLine(2, 0), 14);
 }
 
-TEST_F(GapBufferTest, OffsetFromLine_ColumnClamped) {
+TEST_P(DocumentModelTest, OffsetFromLine_ColumnClamped) {
     buffer.loadFromString("Short\nLine");
     
     // Column beyond line length should clamp to buffer length
@@ -339,7 +840,7 @@ TEST_F(GapBufferTest, OffsetFromLine_ColumnClamped) {
     EXPECT_LE(offset, buffer.length());
 }
 
-TEST_F(GapBufferTest, LineMapping_RoundTrip) {
+TEST_P(DocumentModelTest, LineMapping_RoundTrip) {
     buffer.loadFromString("Line 1\nLine 2\nLine 3\nLine 4\nLine 5");
     
     for (size_t line = 0; line < buffer.lineCount(); ++line) {
@@ -350,25 +851,253 @@ TEST_F(GapBufferTest, LineMapping_RoundTrip) {
     }
 }
 
+TEST_P(DocumentModelTest, LineIndex_UpdatedByInsertAndErase) {
+    buffer.loadFromString("A\nB\nC");
+    buffer.insert(2, "X\nY\n");     // A\nX\nY\nB\nC
+    EXPECT_EQ(buffer.lineCount(), 5);
+    EXPECT_EQ(buffer.offsetFromLine(2), 4);
+    EXPECT_EQ(buffer.lineFromOffset(6), 3);
+    
+    buffer.erase(3, 3);              // A\nXB\nC
+    EXPECT_EQ(buffer.getText(), "A\nXB\nC");
+    EXPECT_EQ(buffer.lineCount(), 3);
+    EXPECT_EQ(buffer.offsetFromLine(1), 2);
+    EXPECT_EQ(buffer.offsetFromLine(2), 5);
+}
+
+TEST_F(GapBufferTest, LineIndex_SurvivesCopyAndMove) {
+    buffer.loadFromString("one\ntwo\nthree");
+    buffer.insert(4, "new\n");
+    
+    GapBuffer copy(buffer);
+    EXPECT_EQ(copy.lineCount(), 4);
+    EXPECT_EQ(copy.offsetFromLine(2), 8);
+    
+    GapBuffer moved(std::move(copy));
+    EXPECT_EQ(moved.lineCount(), 4);
+    EXPECT_EQ(moved.lineFromOffset(8), 2);
+}
+
+TEST_P(DocumentModelTest, LineIndex_RandomizedMatchesScanning) {
+    std::mt19937 rng(12345);
+    std::string reference = "first\nsecond\n\nfourth";
+    buffer.loadFromString(reference);
+    
+    const char alphabet[] = "ab\n\ncd\n";
+    auto randomText = [&](size_t maxLen) {
+        std::string text(rng() % (maxLen + 1), ' ');
+        for (char& c : text) {
+            c = alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+        return text;
+    };
+    
+    for (int step = 0; step < 2000; ++step) {
+        const size_t pos = rng() % (reference.size() + 1);
+        if (rng() % 3 != 0) {
+            const std::string text = randomText(12);
+            buffer.insert(pos, text);
+            reference.insert(pos, text);
+        } else {
+            const size_t len = rng() % 10;
+            buffer.erase(pos, len);
+            if (pos < reference.size()) {
+                reference.erase(pos, len);
+            }
+        }
+        
+        ASSERT_EQ(buffer.getText(), reference) << "step " << step;
+        ASSERT_EQ(buffer.lineCount(), scanLineCount(reference)) << "step " << step;
+        
+        for (int probe = 0; probe < 8; ++probe) {
+            const size_t offset = rng() % (reference.size() + 2);
+            ASSERT_EQ(buffer.lineFromOffset(offset), scanLineFromOffset(reference, offset))
+                << "step " << step << " offset " << offset;
+            
+            const size_t line = rng() % (scanLineCount(reference) + 2);
+            const size_t column = rng() % 4;
+            ASSERT_EQ(buffer.offsetFromLine(line, column),
+                      scanOffsetFromLine(reference, line, column))
+                << "step " << step << " line " << line << " column " << column;
+        }
+    }
+}
+
+// =============================================================================
+// Capacity Management Tests
+// =============================================================================
+
+TEST_F(GapBufferTest, Capacity_IsTextPlusGap) {
+    buffer.loadFromString("Hello");
+    EXPECT_GE(buffer.capacity(), buffer.length());
+    EXPECT_EQ(buffer.capacity(), buffer.length() + buffer.gapSize());
+    
+    buffer.insert(2, "XYZ");
+    EXPECT_EQ(buffer.capacity(), buffer.length() + buffer.gapSize());
+}
+
+TEST_F(GapBufferTest, Shrink_AfterLargeDelete) {
+    buffer.loadFromString(std::string(4 * 1024 * 1024, 'x'));
+    const size_t before = buffer.capacity();
+    
+    buffer.erase(0, buffer.length() - 1000);
+    EXPECT_EQ(buffer.getText(), std::string(1000, 'x'));
+    EXPECT_LT(buffer.capacity(), before);
+    EXPECT_LE(buffer.capacity(), buffer.shrinkPolicy().minCapacity);
+}
+
+TEST_F(GapBufferTest, Shrink_NotAfterSmallDeletes) {
+    buffer.loadFromString(std::string(1024 * 1024, 'x'));
+    const size_t before = buffer.capacity();
+    
+    // Hysteresis: capacity stays until text drops below 1/shrinkFactor
+    for (int i = 0; i < 100; ++i) {
+        buffer.erase(0, 1000);
+    }
+    EXPECT_EQ(buffer.capacity(), before);
+}
+
+TEST_F(GapBufferTest, Shrink_Hysteresis) {
+    GapBuffer::ShrinkPolicy policy;
+    policy.minCapacity = 0;
+    buffer.setShrinkPolicy(policy);
+    buffer.loadFromString(std::string(100000, 'x'));
+    
+    // Drop to just under a quarter: shrinks to about twice the text
+    buffer.erase(0, 76000);
+    const size_t shrunk = buffer.capacity();
+    EXPECT_LT(shrunk, 100000u);
+    EXPECT_GE(shrunk, 2 * buffer.length());
+    
+    // Growing and deleting a little must not reallocate again
+    buffer.insert(0, std::string(1000, 'y'));
+    buffer.erase(0, 2000);
+    EXPECT_EQ(buffer.capacity(), shrunk);
+    EXPECT_EQ(buffer.getText(), std::string(23000, 'x'));
+}
+
+TEST_F(GapBufferTest, ShrinkToFit) {
+    GapBuffer::ShrinkPolicy policy;
+    policy.enabled = false;
+    buffer.setShrinkPolicy(policy);
+    buffer.loadFromString("line1\nline2\n" + std::string(200000, 'x'));
+    buffer.erase(12, 200000);
+    EXPECT_GT(buffer.capacity(), 200000u);
+    
+    buffer.shrinkToFit();
+    EXPECT_LT(buffer.capacity(), 1024u);
+    EXPECT_EQ(buffer.getText(), "line1\nline2\n");
+    EXPECT_EQ(buffer.lineCount(), 3);
+    EXPECT_EQ(buffer.offsetFromLine(1, 0), 6);
+    
+    // Still editable after shrinking
+    buffer.insert(buffer.length(), "line3");
+    EXPECT_EQ(buffer.getText(), "line1\nline2\nline3");
+}
+
+TEST_F(GapBufferTest, Shrink_DisabledPolicy) {
+    GapBuffer::ShrinkPolicy policy;
+    policy.enabled = false;
+    buffer.setShrinkPolicy(policy);
+    buffer.loadFromString(std::string(1024 * 1024, 'x'));
+    const size_t before = buffer.capacity();
+    
+    buffer.erase(0, buffer.length());
+    EXPECT_EQ(buffer.capacity(), before);
+}
+
+TEST_F(GapBufferTest, Shrink_ClearAndReload) {
+    buffer.loadFromString(std::string(1024 * 1024, 'x'));
+    buffer.clear();
+    EXPECT_LE(buffer.capacity(), buffer.shrinkPolicy().minCapacity);
+    
+    buffer.loadFromString(std::string(1024 * 1024, 'x'));
+    buffer.loadFromString("small");
+    EXPECT_LE(buffer.capacity(), buffer.shrinkPolicy().minCapacity);
+    EXPECT_EQ(buffer.getText(), "small");
+}
+
+TEST_F(GapBufferTest, Snapshot_TypingAtGapDoesNotCopy) {
+    buffer.loadFromString("Hello World");
+    buffer.insert(5, ",");
+    const char* storage = buffer.segments().before.data();
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    
+    // Typing and backspacing inside the gap reuse the shared buffer
+    buffer.insert(6, " brave");
+    buffer.erase(11, 1);
+    buffer.insert(11, "e");
+    EXPECT_EQ(buffer.segments().before.data(), storage);
+    
+    // Moving the gap would overwrite text the snapshot holds: copy first
+    buffer.insert(0, ">");
+    EXPECT_NE(buffer.segments().before.data(), storage);
+    EXPECT_EQ(buffer.getText(), ">Hello, brave World");
+    EXPECT_EQ(snapshot.getText(), "Hello, World");
+}
+
+TEST_F(GapBufferTest, Snapshot_ReleasedStorageIsReused) {
+    buffer.loadFromString("abc");
+    const char* storage = buffer.segments().before.data();
+    {
+        const DocumentSnapshot snapshot = buffer.snapshot();
+        EXPECT_EQ(snapshot.getText(), "abc");
+    }
+    
+    buffer.insert(0, "x");
+    EXPECT_EQ(buffer.segments().before.data(), storage);
+    EXPECT_EQ(buffer.getText(), "xabc");
+}
+
+TEST_F(GapBufferTest, Snapshot_CopiesOfBufferDoNotShare) {
+    buffer.loadFromString("base");
+    const DocumentSnapshot snapshot = buffer.snapshot();
+    GapBuffer copy = buffer;
+    
+    buffer.insert(4, "-original");
+    copy.insert(4, "-copy");
+    
+    EXPECT_EQ(buffer.getText(), "base-original");
+    EXPECT_EQ(copy.getText(), "base-copy");
+    EXPECT_EQ(snapshot.getText(), "base");
+}
+
+TEST_F(GapBufferTest, Shrink_PreservesGapPosition) {
+    GapBuffer::ShrinkPolicy policy;
+    policy.minCapacity = 0;
+    buffer.setShrinkPolicy(policy);
+    buffer.loadFromString(std::string(50000, 'a') + "\n" + std::string(50000, 'b'));
+    
+    buffer.erase(100, 99000);
+    std::string expected = std::string(100, 'a') + std::string(901, 'b');
+    EXPECT_EQ(buffer.getText(), expected);
+    EXPECT_EQ(buffer.lineCount(), 1);
+    
+    buffer.insert(100, "\n");
+    expected.insert(100, "\n");
+    EXPECT_EQ(buffer.getText(), expected);
+    EXPECT_EQ(buffer.lineFromOffset(101), 1);
+}
+
 // =============================================================================
 // Patch Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, FlushPatches_EmptyAfterLoad) {
+TEST_P(DocumentModelTest, FlushPatches_EmptyAfterLoad) {
     buffer.loadFromString("Hello");
     
     auto patches = buffer.flushPatches();
     EXPECT_TRUE(patches.empty());
 }
 
-TEST_F(GapBufferTest, HasPendingPatches_AfterInsert) {
+TEST_P(DocumentModelTest, HasPendingPatches_AfterInsert) {
     buffer.loadFromString("Hello");
     buffer.insert(0, "X");
     
     EXPECT_TRUE(buffer.hasPendingPatches());
 }
 
-TEST_F(GapBufferTest, FlushPatches_ClearsPatches) {
+TEST_P(DocumentModelTest, FlushPatches_ClearsPatches) {
     buffer.loadFromString("Hello");
     buffer.insert(0, "X");
     
@@ -380,7 +1109,7 @@ TEST_F(GapBufferTest, FlushPatches_ClearsPatches) {
     EXPECT_FALSE(buffer.hasPendingPatches());
 }
 
-TEST_F(GapBufferTest, FlushPatches_SingleInsert) {
+TEST_P(DocumentModelTest, FlushPatches_SingleInsert) {
     buffer.loadFromString("Hello");
     buffer.insert(0, "XYZ");
     
@@ -393,7 +1122,7 @@ TEST_F(GapBufferTest, FlushPatches_SingleInsert) {
     EXPECT_EQ(p.insertedText, "XYZ");
 }
 
-TEST_F(GapBufferTest, FlushPatches_SingleDelete) {
+TEST_P(DocumentModelTest, FlushPatches_SingleDelete) {
     buffer.loadFromString("Hello");
     buffer.erase(2, 2);  // Erase "ll"
     
@@ -406,7 +1135,7 @@ TEST_F(GapBufferTest, FlushPatches_SingleDelete) {
     EXPECT_EQ(p.insertedText, "");
 }
 
-TEST_F(GapBufferTest, FlushPatches_ConsecutiveInserts_Coalesced) {
+TEST_P(DocumentModelTest, FlushPatches_ConsecutiveInserts_Coalesced) {
     buffer.loadFromString("");
     buffer.insert(0, "A");
     buffer.insert(1, "B");
@@ -418,7 +1147,7 @@ TEST_F(GapBufferTest, FlushPatches_ConsecutiveInserts_Coalesced) {
     EXPECT_EQ(patches[0].insertedText, "ABC");
 }
 
-TEST_F(GapBufferTest, FlushPatches_NonConsecutive_NotCoalesced) {
+TEST_P(DocumentModelTest, FlushPatches_NonConsecutive_NotCoalesced) {
     buffer.loadFromString("Hello");
     buffer.insert(0, "A");    // Insert at beginning
     buffer.insert(10, "B");   // Insert at end (non-adjacent)
@@ -427,7 +1156,7 @@ TEST_F(GapBufferTest, FlushPatches_NonConsecutive_NotCoalesced) {
     EXPECT_GT(patches.size(), 1);  // Should have multiple patches
 }
 
-TEST_F(GapBufferTest, FlushPatches_HasTimestamp) {
+TEST_P(DocumentModelTest, FlushPatches_HasTimestamp) {
     buffer.loadFromString("");
     buffer.insert(0, "Test");
     
@@ -439,6 +1168,87 @@ TEST_F(GapBufferTest, FlushPatches_HasTimestamp) {
     EXPECT_GT(elapsed.count(), 0);
 }
 
+TEST_P(DocumentModelTest, DrainPatches_VisitsSamePatchesAsFlush) {
+    buffer.loadFromString("Hello World");
+    buffer.insert(5, ",");
+    buffer.insert(6, " dear");
+    buffer.erase(0, 1);
+    buffer.applyPatch(Patch(2, "lo", "p!"));
+
+    std::vector<Patch> drained;
+    buffer.drainPatches([&drained](const PatchView& view) {
+        drained.emplace_back(view.start, view.removedText, view.insertedText);
+    });
+    EXPECT_FALSE(buffer.hasPendingPatches());
+    EXPECT_TRUE(buffer.flushPatches().empty());
+
+    // Replay the same edits and compare with the owning patches
+    buffer.loadFromString("Hello World");
+    buffer.insert(5, ",");
+    buffer.insert(6, " dear");
+    buffer.erase(0, 1);
+    buffer.applyPatch(Patch(2, "lo", "p!"));
+    const auto flushed = buffer.flushPatches();
+
+    ASSERT_EQ(drained.size(), 3);
+    ASSERT_EQ(drained.size(), flushed.size());
+    for (size_t i = 0; i < flushed.size(); ++i) {
+        EXPECT_EQ(drained[i].start, flushed[i].start);
+        EXPECT_EQ(drained[i].removedText, flushed[i].removedText);
+        EXPECT_EQ(drained[i].insertedText, flushed[i].insertedText);
+    }
+}
+
+// =============================================================================
+// Statistics Tests
+// =============================================================================
+
+TEST_F(GapBufferTest, Stats_CountEditOperations) {
+    buffer.loadFromString("Hello World");   // Gap at the end
+    buffer.resetStats();
+
+    buffer.insert(5, ",");                  // Gap moves 6 bytes; new patch
+    buffer.insert(6, " dear\n");            // Typing on: coalesced
+    buffer.erase(6, 6);                     // Gap moves 6 bytes; new patch
+    buffer.insert(buffer.length(), std::string(10000, 'x'));   // Grows
+
+    const GapBuffer::Stats stats = buffer.stats();
+    if (!GapBuffer::statsEnabled()) {
+        EXPECT_EQ(stats.gapMoves + stats.bytesMoved + stats.grows + stats.bytesAllocated +
+                  stats.patchesCoalesced + stats.patchesStarted + stats.lineScanBytes, 0u);
+        return;
+    }
+    EXPECT_EQ(stats.gapMoves, 3u);
+    EXPECT_EQ(stats.bytesMoved, 6u + 6u + 6u);
+    EXPECT_EQ(stats.grows, 1u);
+    EXPECT_GE(stats.bytesAllocated, 10000u);
+    EXPECT_EQ(stats.patchesCoalesced, 1u);
+    EXPECT_EQ(stats.patchesStarted, 3u);
+    EXPECT_EQ(stats.lineScanBytes, 1u + 6u + 10000u);
+
+    buffer.resetStats();
+    EXPECT_EQ(buffer.stats().gapMoves, 0u);
+}
+
+TEST_F(GapBufferTest, Stats_CountLineIndexRebuildScans) {
+    if (!GapBuffer::statsEnabled()) {
+        GTEST_SKIP() << "built without MD_GAPBUFFER_STATS";
+    }
+    const auto path = std::filesystem::temp_directory_path() / "gapbuffer_stats_test.md";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "one\ntwo\nthree\n";
+    }
+    buffer.loadFromFile(path);
+    buffer.resetStats();
+    EXPECT_EQ(buffer.lineCount(), 4u);          // Builds the index: count + scan
+    EXPECT_EQ(buffer.stats().lineScanBytes, 2u * 14u);
+    EXPECT_EQ(buffer.lineFromOffset(9), 2u);    // Index reused, no scan
+    EXPECT_EQ(buffer.stats().lineScanBytes, 2u * 14u);
+    buffer.clear();
+    std::filesystem::remove(path);
+}
+
 // =============================================================================
 // Copy/Move Semantics Tests
 // =============================================================================
@@ -485,7 +1295,7 @@ TEST_F(GapBufferTest, MoveAssignment) {
 // Edge Cases and Stress Tests
 // =============================================================================
 
-TEST_F(GapBufferTest, ManyRandomOperations) {
+TEST_P(DocumentModelTest, ManyRandomOperations) {
     // Perform many operations to test gap movement and resizing
     buffer.loadFromString("Initial content here");
     
@@ -497,7 +1307,7 @@ TEST_F(GapBufferTest, ManyRandomOperations) {
     EXPECT_EQ(buffer.length(), 20 + 100);  // Original + 100 'X's
 }
 
-TEST_F(GapBufferTest, AlternatingInsertDelete) {
+TEST_P(DocumentModelTest, AlternatingInsertDelete) {
     buffer.loadFromString("ABCDE");
     
     buffer.insert(2, "X");   // ABXCDE
@@ -520,7 +1330,7 @@ TEST_F(GapBufferTest, AlternatingInsertDelete) {
     EXPECT_EQ(buffer.getText(), "YABXCE");
 }
 
-TEST_F(GapBufferTest, EmptyOperations) {
+TEST_P(DocumentModelTest, EmptyOperations) {
     // Operations on empty buffer shouldn't crash
     EXPECT_EQ(buffer.getText(), "");
     EXPECT_EQ(buffer.getText(0, 10), "");
@@ -0,0 +1,248 @@
+// =============================================================================
+// mapped_file_tests.cpp - Unit Tests for Memory-Mapped Loading
+// =============================================================================
+//
+// Tests for MappedFile and the loadFromFile paths covering:
+// - Mapping regular, empty and missing files
+// - GapBuffer reads served from the mapping and copy on first edit
+// - ChunkedGapBuffer copying only the chunks that are edited
+// - PieceTable using the mapping as its original buffer
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "chunked_gap_buffer.h"
+#include "gap_buffer.h"
+#include "mapped_file.h"
+#include "piece_table.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace mdeditor;
+
+namespace fs = std::filesystem;
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path_ = fs::temp_directory_path() /
+                (std::string("mdeditor_") + info->name() + ".md");
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    /// Writes content to the test file and returns its path
+    const fs::path& writeFile(const std::string& content) {
+        std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+        file << content;
+        return path_;
+    }
+
+    /// Text with a newline every 50 bytes
+    static std::string makeLines(size_t size) {
+        std::string text(size, 'x');
+        for (size_t i = 49; i < size; i += 50) {
+            text[i] = '\n';
+        }
+        return text;
+    }
+
+    fs::path path_;
+};
+
+// =============================================================================
+// MappedFile
+// =============================================================================
+
+TEST_F(MappedFileTest, MapsFileContents) {
+    MappedFile mapping(writeFile("# Title\n\nBody\n"));
+    EXPECT_EQ(mapping.view(), "# Title\n\nBody\n");
+    EXPECT_EQ(mapping.size(), 14);
+}
+
+TEST_F(MappedFileTest, EmptyFile_HasEmptyView) {
+    MappedFile mapping(writeFile(""));
+    EXPECT_TRUE(mapping.view().empty());
+}
+
+TEST_F(MappedFileTest, MissingFile_Throws) {
+    EXPECT_THROW(MappedFile(path_ / "missing.md"), std::runtime_error);
+}
+
+TEST_F(MappedFileTest, Move_TransfersMapping) {
+    MappedFile first(writeFile("abc"));
+    MappedFile second(std::move(first));
+    EXPECT_EQ(second.view(), "abc");
+    EXPECT_TRUE(first.view().empty());
+}
+
+// =============================================================================
+// GapBuffer::loadFromFile
+// =============================================================================
+
+TEST_F(MappedFileTest, GapBuffer_ReadsFromMappingWithoutCopy) {
+    const std::string text = makeLines(200000);
+    GapBuffer buffer;
+    buffer.loadFromFile(writeFile(text));
+
+    EXPECT_TRUE(buffer.isMapped());
+    EXPECT_EQ(buffer.capacity(), 0);
+    EXPECT_EQ(buffer.length(), text.size());
+    EXPECT_EQ(buffer.getText(100, 20), text.substr(100, 20));
+    EXPECT_EQ(buffer.contiguousView(), text);
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), text);
+    EXPECT_EQ(buffer.lineCount(), 4001);
+    EXPECT_EQ(buffer.lineFromOffset(120), 2);
+    EXPECT_EQ(buffer.offsetFromLine(3), 150);
+    EXPECT_TRUE(buffer.isMapped());
+}
+
+TEST_F(MappedFileTest, GapBuffer_FirstEditMaterializes) {
+    std::string text = makeLines(10000);
+    GapBuffer buffer;
+    buffer.loadFromFile(writeFile(text));
+
+    buffer.insert(75, "\nnew line");
+    text.insert(75, "\nnew line");
+    EXPECT_FALSE(buffer.isMapped());
+    EXPECT_EQ(buffer.getText(), text);
+    EXPECT_EQ(buffer.lineFromOffset(80), 2);
+    EXPECT_EQ(buffer.lineCount(), 202);
+
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 1);
+    EXPECT_EQ(patches[0].start, 75);
+}
+
+TEST_F(MappedFileTest, GapBuffer_EraseOnMappedText) {
+    GapBuffer buffer;
+    buffer.loadFromFile(writeFile("line1\nline2\nline3"));
+    buffer.erase(5, 6);
+    EXPECT_EQ(buffer.getText(), "line1\nline3");
+    EXPECT_EQ(buffer.lineCount(), 2);
+    EXPECT_EQ(buffer.flushPatches()[0].removedText, "\nline2");
+}
+
+TEST_F(MappedFileTest, GapBuffer_FailedLoadKeepsContent) {
+    GapBuffer buffer;
+    buffer.loadFromString("keep");
+    EXPECT_THROW(buffer.loadFromFile(path_ / "missing.md"), std::runtime_error);
+    EXPECT_EQ(buffer.getText(), "keep");
+}
+
+TEST_F(MappedFileTest, GapBuffer_SearchesWithoutCopy) {
+    GapBuffer buffer;
+    buffer.loadFromFile(writeFile("# Title\nSome text about titles.\n"));
+    EXPECT_EQ(buffer.findAll("title", 0, std::string_view::npos, true),
+              (std::vector<size_t>{2, 24}));
+    EXPECT_TRUE(buffer.isMapped());
+}
+
+TEST_F(MappedFileTest, GapBuffer_ValidatedLoadRejectsInvalidUtf8) {
+    GapBuffer buffer;
+    buffer.loadFromString("keep");
+    buffer.setUtf8Validation(true);
+    EXPECT_THROW(buffer.loadFromFile(writeFile("text \xC0\xAF")), InvalidUtf8Error);
+    EXPECT_EQ(buffer.getText(), "keep");
+    EXPECT_FALSE(buffer.isMapped());
+
+    buffer.loadFromFile(writeFile("caf\xC3\xA9"));
+    EXPECT_TRUE(buffer.isMapped());
+}
+
+TEST_F(MappedFileTest, GapBuffer_CopiesShareMapping) {
+    GapBuffer buffer;
+    buffer.loadFromFile(writeFile("shared text"));
+    GapBuffer copy = buffer;
+    buffer.insert(0, ">");
+    EXPECT_EQ(buffer.getText(), ">shared text");
+    EXPECT_EQ(copy.getText(), "shared text");
+    EXPECT_TRUE(copy.isMapped());
+}
+
+// =============================================================================
+// ChunkedGapBuffer::loadFromFile
+// =============================================================================
+
+TEST_F(MappedFileTest, Chunked_CopiesOnlyEditedChunks) {
+    std::string text = makeLines(64 * ChunkedGapBuffer::kChunkSize);
+    ChunkedGapBuffer buffer;
+    buffer.loadFromFile(writeFile(text));
+
+    EXPECT_EQ(buffer.capacity(), 0);
+    EXPECT_EQ(buffer.length(), text.size());
+
+    const size_t middle = text.size() / 2;
+    buffer.insert(middle, "edit");
+    text.insert(middle, "edit");
+    buffer.erase(10, 3);
+    text.erase(10, 3);
+
+    EXPECT_LE(buffer.capacity(), 2 * ChunkedGapBuffer::kChunkSize);
+    EXPECT_EQ(buffer.getText(), text);
+}
+
+TEST_F(MappedFileTest, Chunked_LineQueriesOnMappedText) {
+    const std::string text = makeLines(5 * ChunkedGapBuffer::kChunkSize);
+    ChunkedGapBuffer buffer;
+    buffer.loadFromFile(writeFile(text));
+
+    const size_t newlines = text.size() / 50;
+    EXPECT_EQ(buffer.lineCount(), newlines + 1);
+    EXPECT_EQ(buffer.lineFromOffset(text.size() - 1), newlines);
+    EXPECT_EQ(buffer.offsetFromLine(newlines), newlines * 50);
+    EXPECT_EQ(buffer.capacity(), 0);
+
+    buffer.insert(0, "\n");
+    EXPECT_EQ(buffer.lineCount(), newlines + 2);
+}
+
+// =============================================================================
+// PieceTable::loadFromFile
+// =============================================================================
+
+TEST_F(MappedFileTest, PieceTable_EditsBeforeFirstLineQuery) {
+    std::string text = makeLines(20000);
+    PieceTable table;
+    table.loadFromFile(writeFile(text));
+    EXPECT_EQ(table.pieceCount(), 1);
+    EXPECT_EQ(table.contiguousView(), text);
+
+    // Line counts of the mapped pieces are only known after the first query
+    table.insert(75, "\nnew line");
+    text.insert(75, "\nnew line");
+    table.erase(300, 120);
+    text.erase(300, 120);
+
+    EXPECT_EQ(table.getText(), text);
+    EXPECT_EQ(table.lineCount(), 1 + static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+    EXPECT_EQ(table.lineFromOffset(80), 2);
+    EXPECT_EQ(table.offsetFromLine(2), 76);
+}
+
+TEST_F(MappedFileTest, PieceTable_FailedLoadKeepsContent) {
+    PieceTable table;
+    table.loadFromString("keep");
+    EXPECT_THROW(table.loadFromFile(path_ / "missing.md"), std::runtime_error);
+    EXPECT_EQ(table.getText(), "keep");
+}
+
+TEST_F(MappedFileTest, PieceTable_SnapshotKeepsMapping) {
+    PieceTable table;
+    table.loadFromFile(writeFile("mapped text"));
+    const DocumentSnapshot snapshot = table.snapshot();
+    table.clear();
+    EXPECT_EQ(snapshot.getText(), "mapped text");
+}
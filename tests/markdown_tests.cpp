@@ -239,6 +239,21 @@ TEST_F(MarkdownParserTest, OrderedList_WithParenthesis) {
     EXPECT_NE(html.find("<li>One</li>"), std::string::npos);
 }
 
+TEST_F(MarkdownParserTest, List_ParagraphAfterListKeepsOrder) {
+    std::string markdown = "- item\ntext\n\nmore";
+    std::string html = parser->renderToHtml(markdown);
+
+    // The list comes first, and the blank line ends the paragraph
+    size_t list = html.find("<ul>");
+    size_t text = html.find("<p>text</p>");
+    size_t more = html.find("<p>more</p>");
+    ASSERT_NE(list, std::string::npos);
+    ASSERT_NE(text, std::string::npos);
+    ASSERT_NE(more, std::string::npos);
+    EXPECT_LT(list, text);
+    EXPECT_LT(text, more);
+}
+
 // =============================================================================
 // Blockquote Tests
 // =============================================================================
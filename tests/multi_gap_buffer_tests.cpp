@@ -0,0 +1,250 @@
+// =============================================================================
+// multi_gap_buffer_tests.cpp - Unit Tests for MultiGapBuffer
+// =============================================================================
+//
+// Tests for the multi-gap specifics (the shared behaviour runs through
+// DocumentModelTest in gapbuffer_tests.cpp) covering:
+// - Gap assignment: nearby edits reuse a gap, new sites take the least
+//   recently used one
+// - Erasing across gaps and growing one gap
+// - Copies and snapshots not seeing later edits
+// - Parity with GapBuffer under random edits at distant positions
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "multi_gap_buffer.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+/// Builds text of the given size with a newline every lineLength bytes
+std::string makeLines(size_t size, size_t lineLength) {
+    std::string text(size, 'x');
+    for (size_t i = lineLength - 1; i < size; i += lineLength) {
+        text[i] = '\n';
+    }
+    return text;
+}
+
+bool hasGapAt(const MultiGapBuffer& buffer, size_t offset) {
+    const std::vector<size_t> offsets = buffer.gapOffsets();
+    return std::find(offsets.begin(), offsets.end(), offset) != offsets.end();
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class MultiGapBufferTest : public ::testing::Test {
+protected:
+    MultiGapBuffer buffer;
+};
+
+// =============================================================================
+// Gap Assignment
+// =============================================================================
+
+TEST_F(MultiGapBufferTest, GapCount_IsClamped) {
+    EXPECT_EQ(buffer.gapCount(), MultiGapBuffer::kDefaultGapCount);
+    EXPECT_EQ(MultiGapBuffer(0).gapCount(), 1);
+    EXPECT_EQ(MultiGapBuffer(100).gapCount(), MultiGapBuffer::kMaxGapCount);
+    EXPECT_EQ(buffer.gapOffsets(), std::vector<size_t>(MultiGapBuffer::kDefaultGapCount, 0));
+}
+
+TEST_F(MultiGapBufferTest, PingPong_KeepsOneGapPerSite) {
+    std::string expected = makeLines(1 << 20, 64);
+    buffer.loadFromString(expected);
+
+    size_t top = 10;
+    size_t bottom = expected.size() - 10;
+    for (int i = 0; i < 200; ++i) {
+        buffer.insert(top, "t");
+        expected.insert(top++, "t");
+        ++bottom;
+        buffer.insert(bottom, "b");
+        expected.insert(bottom++, "b");
+    }
+
+    EXPECT_EQ(buffer.getText(), expected);
+    EXPECT_TRUE(hasGapAt(buffer, top));
+    EXPECT_TRUE(hasGapAt(buffer, bottom));
+}
+
+TEST_F(MultiGapBufferTest, NearbyEdit_ReusesGap) {
+    buffer.loadFromString(makeLines(1 << 20, 64));
+    buffer.insert(1000, "a");
+    buffer.insert(1000 + MultiGapBuffer::kSiteDistance, "b");
+
+    // Still one site: the first gap followed, the others stayed at the end
+    const std::vector<size_t> offsets = buffer.gapOffsets();
+    EXPECT_EQ(offsets.front(), 1001 + MultiGapBuffer::kSiteDistance);
+    EXPECT_EQ(static_cast<size_t>(std::count(offsets.begin(), offsets.end(), buffer.length())),
+              MultiGapBuffer::kDefaultGapCount - 1);
+}
+
+TEST_F(MultiGapBufferTest, NewSite_TakesLeastRecentlyUsedGap) {
+    MultiGapBuffer two(2);
+    std::string expected = makeLines(1 << 20, 100);
+    two.loadFromString(expected);
+    const size_t a = 100'000;
+    const size_t b = 500'000;
+    const size_t c = 900'000;
+
+    auto edit = [&](size_t offset, const char* text) {
+        two.insert(offset, text);
+        expected.insert(offset, text);
+    };
+    edit(a, "A");
+    edit(b, "B");
+    edit(a + 1, "A");   // A is now the most recent site
+    edit(c, "C");       // Takes B's gap
+
+    EXPECT_EQ(two.getText(), expected);
+    EXPECT_EQ(two.gapOffsets(), (std::vector<size_t>{a + 2, c + 1}));
+}
+
+// =============================================================================
+// Erasing and Growing
+// =============================================================================
+
+TEST_F(MultiGapBufferTest, EraseAcrossGaps_KeepsTextAndLines) {
+    std::string expected = makeLines(200'000, 10);
+    buffer.loadFromString(expected);
+    for (size_t site : {20'000, 60'000, 100'000, 140'000}) {
+        buffer.insert(site, "\n");
+        expected.insert(site, "\n");
+    }
+
+    buffer.erase(10'000, 150'000);
+    expected.erase(10'000, 150'000);
+    EXPECT_EQ(buffer.getText(), expected);
+
+    GapBuffer reference;
+    reference.loadFromString(expected);
+    EXPECT_EQ(buffer.lineCount(), reference.lineCount());
+    for (size_t offset : {9'999, 10'000, 10'005, 30'000}) {
+        EXPECT_EQ(buffer.lineFromOffset(offset), reference.lineFromOffset(offset));
+    }
+    for (size_t line : {999, 1000, 1001, 3000}) {
+        EXPECT_EQ(buffer.offsetFromLine(line), reference.offsetFromLine(line));
+    }
+
+    const auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 5);
+    EXPECT_EQ(patches.back().removedLength, 150'000);
+}
+
+TEST_F(MultiGapBufferTest, LargeInsert_GrowsOneGap) {
+    buffer.loadFromString("head\ntail");
+    const size_t before = buffer.capacity();
+    const std::string large = makeLines(100'000, 50);
+    buffer.insert(5, large);
+
+    EXPECT_GT(buffer.capacity(), before);
+    EXPECT_EQ(buffer.getText(), "head\n" + large + "tail");
+    EXPECT_EQ(buffer.lineCount(), 2 + 2000);
+    EXPECT_EQ(buffer.offsetFromLine(2001), 5 + large.size());
+
+    buffer.erase(0, 5 + large.size());
+    buffer.shrinkToFit();
+    EXPECT_EQ(buffer.getText(), "tail");
+    EXPECT_EQ(buffer.capacity(), 4 + MultiGapBuffer::kDefaultGapCount * MultiGapBuffer::kMinGapSize);
+}
+
+// =============================================================================
+// Sharing
+// =============================================================================
+
+TEST_F(MultiGapBufferTest, Snapshot_SeesNoLaterEdits) {
+    buffer.loadFromString(makeLines(1 << 20, 64));
+    buffer.insert(0, "top ");
+    buffer.insert(buffer.length(), " end");
+    const std::string before = buffer.getText();
+    const DocumentSnapshot snapshot = buffer.snapshot();
+
+    buffer.insert(4, "typed");                  // Into a gap the snapshot ignores
+    buffer.insert(buffer.length() - 4, "x");
+    buffer.erase(0, 2);
+    buffer.insert(500'000, "middle");           // Moves a gap
+
+    EXPECT_EQ(snapshot.getText(), before);
+    EXPECT_EQ(snapshot.version() + 4, buffer.version());
+}
+
+TEST_F(MultiGapBufferTest, Copies_AreIndependent) {
+    buffer.loadFromString("one two three");
+    buffer.insert(3, ",");
+    MultiGapBuffer copy = buffer;
+    copy.insert(4, "!");
+    buffer.insert(4, "?");
+
+    EXPECT_EQ(buffer.getText(), "one,? two three");
+    EXPECT_EQ(copy.getText(), "one,! two three");
+
+    MultiGapBuffer moved = std::move(copy);
+    EXPECT_EQ(moved.getText(), "one,! two three");
+    EXPECT_TRUE(copy.empty());   // Moved-from buffers are empty and reusable
+    copy.insert(0, "reused");
+    EXPECT_EQ(copy.getText(), "reused");
+}
+
+// =============================================================================
+// Parity
+// =============================================================================
+
+TEST_F(MultiGapBufferTest, RandomEdits_MatchGapBuffer) {
+    std::mt19937 rng(2025);
+    GapBuffer reference;
+    const std::string seed = makeLines(200'000, 37);
+    reference.loadFromString(seed);
+    buffer.loadFromString(seed);
+
+    // A few sites far apart, with the odd jump elsewhere
+    std::vector<size_t> sites = {1000, 60'000, 120'000, 190'000, 30'000};
+    for (int step = 0; step < 3000; ++step) {
+        size_t& site = sites[rng() % sites.size()];
+        if (rng() % 50 == 0) {
+            site = rng() % (reference.length() + 1);
+        }
+        site = std::min(site, reference.length());
+        const size_t pos = std::min(site + rng() % 32, reference.length());
+        if (rng() % 3 != 0) {
+            const std::string text(rng() % 6 + 1, "ab\n"[rng() % 3]);
+            reference.insert(pos, text);
+            buffer.insert(pos, text);
+            site = pos + text.size();
+        } else {
+            const size_t len = rng() % 8;
+            reference.erase(pos, len);
+            buffer.erase(pos, len);
+            site = pos;
+        }
+
+        ASSERT_EQ(buffer.length(), reference.length()) << "step " << step;
+        ASSERT_EQ(buffer.lineCount(), reference.lineCount()) << "step " << step;
+        const size_t probe = rng() % (reference.length() + 1);
+        ASSERT_EQ(buffer.lineFromOffset(probe), reference.lineFromOffset(probe));
+        const size_t line = rng() % (reference.lineCount() + 1);
+        ASSERT_EQ(buffer.offsetFromLine(line), reference.offsetFromLine(line));
+    }
+
+    EXPECT_EQ(buffer.getText(), reference.getText());
+    const auto expected = reference.flushPatches();
+    const auto actual = buffer.flushPatches();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].start, expected[i].start);
+        EXPECT_EQ(actual[i].removedText, expected[i].removedText);
+        EXPECT_EQ(actual[i].insertedText, expected[i].insertedText);
+    }
+}
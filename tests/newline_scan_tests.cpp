@@ -0,0 +1,94 @@
+// =============================================================================
+// newline_scan_tests.cpp - Unit Tests for the Newline Scanning Kernels
+// =============================================================================
+//
+// Every SIMD level the CPU supports is checked against the scalar kernel on
+// random inputs of varying length, alignment and newline density.
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "newline_scan.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+std::vector<simd::Level> supportedLevels() {
+    std::vector<simd::Level> levels;
+    for (auto level : {simd::Level::Scalar, simd::Level::SSE2,
+                       simd::Level::AVX2, simd::Level::AVX512}) {
+        if (level <= simd::detectedLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+std::string randomText(std::mt19937& rng, size_t len, unsigned newlinePercent) {
+    std::string text(len, ' ');
+    for (char& c : text) {
+        c = (rng() % 100 < newlinePercent) ? '\n' : static_cast<char>('a' + rng() % 26);
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+TEST(NewlineScanTest, LevelNames) {
+    EXPECT_STREQ(simd::levelName(simd::Level::Scalar), "Scalar");
+    EXPECT_STREQ(simd::levelName(simd::Level::AVX512), "AVX512");
+}
+
+TEST(NewlineScanTest, EmptyInput) {
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::countNewlines("", level), 0);
+        EXPECT_EQ(simd::findNthNewline("", 0, level), std::string_view::npos);
+    }
+}
+
+TEST(NewlineScanTest, SimpleText) {
+    const std::string_view text = "Line 1\nLine 2\nLine 3";
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::countNewlines(text, level), 2) << simd::levelName(level);
+        EXPECT_EQ(simd::findNthNewline(text, 0, level), 6) << simd::levelName(level);
+        EXPECT_EQ(simd::findNthNewline(text, 1, level), 13) << simd::levelName(level);
+        EXPECT_EQ(simd::findNthNewline(text, 2, level), std::string_view::npos);
+    }
+}
+
+TEST(NewlineScanTest, CountBeyondByteCounterLimit) {
+    // More than 255 vector blocks of all-newline input
+    const std::string text(64 * 1024 + 7, '\n');
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::countNewlines(text, level), text.size()) << simd::levelName(level);
+        EXPECT_EQ(simd::findNthNewline(text, text.size() - 1, level), text.size() - 1);
+    }
+}
+
+TEST(NewlineScanTest, RandomizedMatchesScalar) {
+    std::mt19937 rng(2024);
+    const std::string storage = randomText(rng, 8192, 5);
+    
+    for (int round = 0; round < 400; ++round) {
+        // Random sub-range exercises unaligned heads and scalar tails
+        const size_t start = rng() % 97;
+        const size_t len = rng() % (storage.size() - start);
+        const std::string_view text(storage.data() + start, len);
+        
+        const size_t expectedCount = simd::countNewlines(text, simd::Level::Scalar);
+        const size_t n = rng() % (expectedCount + 2);
+        const size_t expectedNth = simd::findNthNewline(text, n, simd::Level::Scalar);
+        
+        for (auto level : supportedLevels()) {
+            ASSERT_EQ(simd::countNewlines(text, level), expectedCount)
+                << simd::levelName(level) << " start " << start << " len " << len;
+            ASSERT_EQ(simd::findNthNewline(text, n, level), expectedNth)
+                << simd::levelName(level) << " start " << start << " len " << len << " n " << n;
+        }
+    }
+}
@@ -0,0 +1,229 @@
+// =============================================================================
+// patch_log_tests.cpp - Unit Tests for PatchLog
+// =============================================================================
+//
+// Tests for the arena-backed pending patch log covering:
+// - Coalescing of typing and backspacing in the side buffers
+// - Side buffers outgrowing the arena's initial block
+// - Copies, flush() and drain()
+// - No allocations beyond the initial block while typing and draining,
+//   directly and through GapBuffer
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "patch_log.h"
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+/// Upstream for a log's arena that counts the blocks it hands out
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+    }
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+std::vector<std::string> insertedTexts(const PatchLog& log) {
+    std::vector<std::string> texts;
+    log.forEach([&](const PatchView& patch) {
+        texts.emplace_back(patch.insertedText);
+    });
+    return texts;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Coalescing
+// =============================================================================
+
+TEST(PatchLogTest, Empty_ByDefault) {
+    PatchLog log;
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(log.size(), 0);
+    EXPECT_TRUE(log.flush().empty());
+}
+
+TEST(PatchLogTest, TypingForward_ExtendsOnePatch) {
+    PatchLog log;
+    log.append(5, {}, "H");
+    log.append(6, {}, "ello");
+    log.append(10, {}, "!");
+    log.append(3, {}, "x");       // Elsewhere: new patch
+
+    ASSERT_EQ(log.size(), 2);
+    EXPECT_EQ(insertedTexts(log), (std::vector<std::string>{"Hello!", "x"}));
+    EXPECT_EQ(log.at(0).start, 5);
+    EXPECT_EQ(log.at(0).removedLength, 0);
+}
+
+TEST(PatchLogTest, Backspacing_PrependsRemovedText) {
+    PatchLog log;
+    log.append(9, "d", {});
+    log.append(8, "l", {});
+    log.append(6, "or", {});
+    log.append(0, "H", "J");      // Replacement: new patch
+
+    ASSERT_EQ(log.size(), 2);
+    const PatchView merged = log.at(0);
+    EXPECT_EQ(merged.start, 6);
+    EXPECT_EQ(merged.removedLength, 4);
+    EXPECT_EQ(merged.removedText, "orld");
+    EXPECT_EQ(log.at(1).removedText, "H");
+    EXPECT_EQ(log.at(1).insertedText, "J");
+}
+
+TEST(PatchLogTest, SideBuffersOutgrowInitialBlock) {
+    PatchLog log;
+    std::string typed;
+    std::string erased;
+    for (int i = 0; i < 3000; ++i) {
+        const std::string chunk(1 + i % 7, static_cast<char>('a' + i % 26));
+        log.append(100 + typed.size(), {}, chunk);
+        typed += chunk;
+    }
+    for (int i = 0; i < 3000; ++i) {
+        const std::string chunk(1 + i % 5, static_cast<char>('A' + i % 26));
+        log.append(50000 - erased.size() - chunk.size(), chunk, {});
+        erased.insert(0, chunk);
+    }
+    log.append(0, "tail", "TAIL");
+
+    ASSERT_EQ(log.size(), 3);
+    EXPECT_EQ(log.at(0).insertedText, typed);
+    EXPECT_EQ(log.at(1).removedText, erased);
+    EXPECT_EQ(log.at(1).start, 50000 - erased.size());
+    EXPECT_EQ(log.at(2).removedText, "tail");
+    EXPECT_EQ(log.at(2).insertedText, "TAIL");
+}
+
+// =============================================================================
+// Copies and Flushing
+// =============================================================================
+
+TEST(PatchLogTest, Copy_IsIndependent) {
+    PatchLog log;
+    log.append(0, {}, "abc");
+    log.append(10, "xyz", {});
+
+    const auto typedAt = log.at(0).timestamp;
+
+    PatchLog copy = log;
+    log.append(3, {}, "d");
+    copy.append(0, "q", {});
+
+    EXPECT_EQ(insertedTexts(log), (std::vector<std::string>{"abc", "", "d"}));
+    ASSERT_EQ(copy.size(), 3);
+    EXPECT_EQ(copy.at(0).insertedText, "abc");
+    EXPECT_EQ(copy.at(0).timestamp, typedAt);   // Copied, not re-stamped
+    EXPECT_EQ(copy.at(1).removedText, "xyz");
+    EXPECT_EQ(copy.at(2).removedText, "q");
+}
+
+TEST(PatchLogTest, Flush_ReturnsOwningPatchesAndClears) {
+    PatchLog log;
+    log.append(0, {}, "Hi");
+    log.append(2, {}, "!");
+    log.append(0, "H", {});
+
+    const std::vector<Patch> patches = log.flush();
+    EXPECT_TRUE(log.empty());
+    ASSERT_EQ(patches.size(), 2);
+    EXPECT_EQ(patches[0].insertedText, "Hi!");
+    EXPECT_TRUE(patches[0].isInvertible());
+    EXPECT_EQ(patches[1].removedText, "H");
+    EXPECT_GT(patches[0].timestamp.time_since_epoch().count(), 0);
+
+    // The log is reusable after the arena was rewound
+    log.append(7, {}, "again");
+    EXPECT_EQ(insertedTexts(log), (std::vector<std::string>{"again"}));
+}
+
+TEST(PatchLogTest, Drain_VisitsInOrderAndClears) {
+    PatchLog log;
+    log.append(0, {}, "one");
+    log.append(10, {}, "two");
+
+    std::vector<std::string> seen;
+    log.drain([&](const PatchView& patch) {
+        seen.emplace_back(patch.insertedText);
+    });
+    EXPECT_EQ(seen, (std::vector<std::string>{"one", "two"}));
+    EXPECT_TRUE(log.empty());
+}
+
+// =============================================================================
+// Allocations
+// =============================================================================
+
+TEST(PatchLogTest, SteadyStateTyping_DoesNotAllocate) {
+    CountingResource upstream;
+    PatchLog log(&upstream);
+    size_t cursor = 500;
+    size_t drained = 0;
+    const auto count = [&drained](const PatchView& patch) {
+        drained += patch.insertedText.size() + patch.removedLength;
+    };
+
+    // Typing and backspacing as GapBuffer records them; draining rewinds
+    // the arena, so everything fits the initial block
+    for (int burst = 0; burst < 200; ++burst) {
+        for (const char* key : {"t", "y", "p", "e", "d"}) {
+            log.append(cursor++, {}, key);
+        }
+        --cursor;
+        log.append(cursor, "d", {});
+        log.drain(count);
+    }
+    EXPECT_EQ(upstream.allocations, 0);
+    EXPECT_EQ(drained, 200 * 6);
+
+    // Outgrowing the initial block draws on the upstream resource
+    log.append(0, {}, std::string(2 * PatchLog::kArenaSize, 'x'));
+    EXPECT_GT(upstream.allocations, 0);
+    log.drain(count);
+}
+
+TEST(PatchLogTest, SteadyStateTyping_ThroughGapBuffer_DoesNotAllocate) {
+    CountingResource upstream;
+    GapBuffer buffer(4096, &upstream);
+    buffer.loadFromString(std::string(1000, '.'));
+    size_t cursor = 500;
+    size_t drained = 0;
+    const IDocumentModel::PatchVisitor count = [&drained](const PatchView& patch) {
+        drained += patch.insertedText.size() + patch.removedLength;
+    };
+
+    for (int burst = 0; burst < 200; ++burst) {
+        for (const char* key : {"t", "y", "p", "e", "d"}) {
+            buffer.insert(cursor++, key);
+        }
+        buffer.erase(--cursor, 1);
+        buffer.drainPatches(count);
+    }
+    EXPECT_EQ(upstream.allocations, 0);
+    EXPECT_EQ(drained, 200 * 6);
+    EXPECT_EQ(buffer.length(), 1000 + 200 * 4);
+
+    // The buffer's log really grows from upstream
+    buffer.insert(0, std::string(2 * PatchLog::kArenaSize, 'x'));
+    EXPECT_GT(upstream.allocations, 0);
+}
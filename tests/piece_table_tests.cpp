@@ -0,0 +1,156 @@
+// =============================================================================
+// piece_table_tests.cpp - Unit Tests for PieceTable
+// =============================================================================
+//
+// Tests for the piece table specifics (the shared behaviour runs through
+// DocumentModelTest in gapbuffer_tests.cpp) covering:
+// - Piece bookkeeping for typing, splitting and erasing
+// - Add blocks, including inserts larger than a block
+// - Copies and snapshots sharing buffers without interfering
+// - Parity with GapBuffer under random edits
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_table.h"
+
+#include <random>
+#include <string>
+
+using namespace mdeditor;
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class PieceTableTest : public ::testing::Test {
+protected:
+    PieceTable table;
+};
+
+// =============================================================================
+// Piece Bookkeeping
+// =============================================================================
+
+TEST_F(PieceTableTest, Load_IsOnePiece) {
+    table.loadFromString("Hello\nWorld");
+    EXPECT_EQ(table.pieceCount(), 1);
+    EXPECT_EQ(table.lineCount(), 2);
+
+    table.loadFromString("");
+    EXPECT_EQ(table.pieceCount(), 0);
+}
+
+TEST_F(PieceTableTest, Typing_ExtendsOnePiece) {
+    table.loadFromString("Hello World");
+    const std::string typed = "brave new ";
+    for (size_t i = 0; i < typed.size(); ++i) {
+        table.insert(6 + i, typed.substr(i, 1));
+    }
+
+    EXPECT_EQ(table.getText(), "Hello brave new World");
+    EXPECT_EQ(table.pieceCount(), 3);
+}
+
+TEST_F(PieceTableTest, Erase_DropsAndTrimsPieces) {
+    table.loadFromString("ABCDEFGH");
+    table.insert(4, "xyz");        // ABCD xyz EFGH
+    EXPECT_EQ(table.pieceCount(), 3);
+
+    table.erase(2, 7);             // AB GH
+    EXPECT_EQ(table.getText(), "ABGH");
+    EXPECT_EQ(table.pieceCount(), 2);
+
+    table.erase(0, 4);
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.pieceCount(), 0);
+    EXPECT_EQ(table.contiguousView(), "");
+}
+
+TEST_F(PieceTableTest, LargeInsert_GetsOwnBlock) {
+    table.loadFromString("ab");
+    table.insert(1, "small\n");
+    const std::string large(PieceTable::kAddBlockSize + 100, 'L');
+    table.insert(0, large);
+    table.insert(large.size() + 7, "\nmore");
+
+    EXPECT_EQ(table.getText(), large + "asmall\n\nmoreb");
+    EXPECT_EQ(table.lineCount(), 3);
+    EXPECT_EQ(table.offsetFromLine(2), large.size() + 8);
+}
+
+// =============================================================================
+// Sharing
+// =============================================================================
+
+TEST_F(PieceTableTest, Copies_DoNotShareAppends) {
+    table.loadFromString("base");
+    table.insert(4, "+");
+
+    PieceTable copy = table;
+    table.insert(5, "original");
+    copy.insert(5, "copy");
+
+    EXPECT_EQ(table.getText(), "base+original");
+    EXPECT_EQ(copy.getText(), "base+copy");
+
+    copy = table;
+    copy.insert(0, "!");
+    table.insert(13, "?");
+    EXPECT_EQ(copy.getText(), "!base+original");
+    EXPECT_EQ(table.getText(), "base+original?");
+}
+
+TEST_F(PieceTableTest, Snapshot_SeesNoLaterAppends) {
+    table.loadFromString("text");
+    table.insert(4, " one");
+    const DocumentSnapshot snapshot = table.snapshot();
+
+    table.insert(8, " two");
+    table.erase(0, 5);
+
+    EXPECT_EQ(snapshot.getText(), "text one");
+    EXPECT_EQ(table.getText(), "one two");
+}
+
+// =============================================================================
+// Parity
+// =============================================================================
+
+TEST_F(PieceTableTest, RandomEdits_MatchGapBuffer) {
+    std::mt19937 rng(2024);
+    GapBuffer reference;
+    reference.loadFromString("seed\ntext\n");
+    table.loadFromString("seed\ntext\n");
+
+    for (int step = 0; step < 3000; ++step) {
+        const size_t pos = rng() % (reference.length() + 1);
+        if (rng() % 3 != 0) {
+            const std::string text(rng() % 6 + 1, "ab\n"[rng() % 3]);
+            reference.insert(pos, text);
+            table.insert(pos, text);
+        } else {
+            const size_t len = rng() % 8;
+            reference.erase(pos, len);
+            table.erase(pos, len);
+        }
+
+        ASSERT_EQ(table.length(), reference.length()) << "step " << step;
+        ASSERT_EQ(table.lineCount(), reference.lineCount()) << "step " << step;
+        const size_t probe = rng() % (reference.length() + 1);
+        ASSERT_EQ(table.lineFromOffset(probe), reference.lineFromOffset(probe));
+        const size_t line = rng() % (reference.lineCount() + 1);
+        ASSERT_EQ(table.offsetFromLine(line), reference.offsetFromLine(line));
+    }
+
+    EXPECT_EQ(table.getText(), reference.getText());
+    const auto expected = reference.flushPatches();
+    const auto actual = table.flushPatches();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].start, expected[i].start);
+        EXPECT_EQ(actual[i].removedText, expected[i].removedText);
+        EXPECT_EQ(actual[i].insertedText, expected[i].insertedText);
+    }
+}
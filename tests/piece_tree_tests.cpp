@@ -0,0 +1,265 @@
+// =============================================================================
+// piece_tree_tests.cpp - Unit Tests for PieceTree
+// =============================================================================
+//
+// Tests for the balanced piece tree covering:
+// - Basic editing, reads and line mapping through the tree metrics
+// - Balance under sequential and scattered edits
+// - compact() merging, copying small pieces and rebalancing
+// - Copies, snapshots and memory-mapped loading
+// - Parity with GapBuffer under random edits
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace mdeditor;
+
+namespace {
+
+/// AVL bound: height < 1.45 * log2(n + 2)
+size_t maxAvlHeight(size_t pieces) {
+    return static_cast<size_t>(1.45 * std::log2(static_cast<double>(pieces) + 2.0)) + 1;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class PieceTreeTest : public ::testing::Test {
+protected:
+    PieceTree tree;
+};
+
+// =============================================================================
+// Basic Operations
+// =============================================================================
+
+TEST_F(PieceTreeTest, DefaultConstruction_IsEmpty) {
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.length(), 0);
+    EXPECT_EQ(tree.lineCount(), 0);
+    EXPECT_EQ(tree.pieceCount(), 0);
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_EQ(tree.getText(), "");
+    EXPECT_EQ(tree.contiguousView(), "");
+}
+
+TEST_F(PieceTreeTest, InsertAndErase_SplitAndMergePieces) {
+    tree.loadFromString("Hello World");
+    tree.insert(6, "brave ");
+    EXPECT_EQ(tree.getText(), "Hello brave World");
+    EXPECT_EQ(tree.pieceCount(), 3);
+
+    tree.insert(12, "new ");
+    EXPECT_EQ(tree.getText(), "Hello brave new World");
+    EXPECT_EQ(tree.pieceCount(), 3);  // Typing forward grows the same piece
+
+    tree.erase(3, 14);
+    EXPECT_EQ(tree.getText(), "Helorld");
+    EXPECT_EQ(tree.pieceCount(), 2);
+    EXPECT_EQ(tree.getText(2, 3), "lor");
+}
+
+TEST_F(PieceTreeTest, LineMapping_AcrossPieces) {
+    tree.loadFromString("a\nb\nc");
+    tree.insert(2, "x\ny\n");   // a\nx\ny\nb\nc
+    tree.insert(0, "\n");       // \na\nx\ny\nb\nc
+
+    EXPECT_EQ(tree.lineCount(), 6);
+    EXPECT_EQ(tree.lineFromOffset(0), 0);
+    EXPECT_EQ(tree.lineFromOffset(1), 1);
+    EXPECT_EQ(tree.lineFromOffset(5), 3);
+    EXPECT_EQ(tree.offsetFromLine(3), 5);
+    EXPECT_EQ(tree.offsetFromLine(5), 9);
+    EXPECT_EQ(tree.offsetFromLine(6), 10);
+    EXPECT_EQ(tree.offsetFromLine(2, 100), 10);
+}
+
+TEST_F(PieceTreeTest, ApplyEdits_OverlapThrowsAndLeavesTreeUnchanged) {
+    tree.loadFromString("cat dog cat");
+    tree.applyEdits({{0, 3, "lion"}, {8, 3, "lion"}});
+    EXPECT_EQ(tree.getText(), "lion dog lion");
+
+    (void)tree.flushPatches();
+    EXPECT_THROW(tree.applyEdits({{0, 5, "x"}, {3, 2, "y"}}), std::invalid_argument);
+    EXPECT_EQ(tree.getText(), "lion dog lion");
+    EXPECT_FALSE(tree.hasPendingPatches());
+}
+
+// =============================================================================
+// Balance
+// =============================================================================
+
+TEST_F(PieceTreeTest, ScatteredInserts_KeepTreeBalanced) {
+    tree.loadFromString(std::string(100000, '.'));
+    std::mt19937 rng(7);
+    for (int i = 0; i < 5000; ++i) {
+        tree.insert(rng() % tree.length(), "ab");
+    }
+
+    EXPECT_GT(tree.pieceCount(), 5000);
+    EXPECT_LE(tree.height(), maxAvlHeight(tree.pieceCount()));
+}
+
+TEST_F(PieceTreeTest, ScatteredErases_KeepTreeBalanced) {
+    tree.loadFromString(std::string(100000, '.'));
+    std::mt19937 rng(11);
+    for (int i = 0; i < 4000; ++i) {
+        tree.insert(rng() % tree.length(), "x\n");
+    }
+    for (int i = 0; i < 3000; ++i) {
+        tree.erase(rng() % tree.length(), 1 + rng() % 40);
+    }
+
+    EXPECT_LE(tree.height(), maxAvlHeight(tree.pieceCount()));
+}
+
+// =============================================================================
+// Compaction
+// =============================================================================
+
+TEST_F(PieceTreeTest, Compact_MergesContiguousPieces) {
+    tree.loadFromString(std::string(1000, 'o'));
+    tree.insert(500, "x");
+    tree.erase(500, 1);   // Leaves two neighbouring pieces of the original
+    EXPECT_EQ(tree.pieceCount(), 2);
+    (void)tree.flushPatches();
+
+    tree.compact();
+    EXPECT_EQ(tree.pieceCount(), 1);
+    EXPECT_EQ(tree.getText(), std::string(1000, 'o'));
+    EXPECT_FALSE(tree.hasPendingPatches());  // Not an edit
+}
+
+TEST_F(PieceTreeTest, Compact_CopiesSmallPiecesAndRebalances) {
+    std::string reference(20000, '-');
+    tree.loadFromString(reference);
+    std::mt19937 rng(3);
+    for (int i = 0; i < 3000; ++i) {
+        const size_t pos = rng() % (reference.size() + 1);
+        const std::string text = (i % 7 == 0) ? "\n" : "ab";
+        tree.insert(pos, text);
+        reference.insert(pos, text);
+    }
+    (void)tree.flushPatches();
+    const size_t before = tree.pieceCount();
+    const size_t lines = tree.lineCount();
+
+    tree.compact();
+
+    EXPECT_LT(tree.pieceCount(), before / 10);
+    EXPECT_LE(tree.height(), maxAvlHeight(tree.pieceCount()));
+    EXPECT_EQ(tree.getText(), reference);
+    EXPECT_EQ(tree.lineCount(), lines);
+    EXPECT_EQ(tree.offsetFromLine(lines - 1),
+              reference.rfind('\n') + 1);
+
+    // Edits keep working on the compacted tree
+    tree.insert(10, "tail");
+    reference.insert(10, "tail");
+    EXPECT_EQ(tree.getText(), reference);
+}
+
+// =============================================================================
+// Sharing and Loading
+// =============================================================================
+
+TEST_F(PieceTreeTest, Copies_AndSnapshotsAreIndependent) {
+    tree.loadFromString("base");
+    tree.insert(4, "+");
+    const DocumentSnapshot snapshot = tree.snapshot();
+
+    PieceTree copy = tree;
+    tree.insert(5, "original");
+    copy.insert(5, "copy");
+    copy.compact();
+
+    EXPECT_EQ(tree.getText(), "base+original");
+    EXPECT_EQ(copy.getText(), "base+copy");
+    EXPECT_EQ(snapshot.getText(), "base+");
+}
+
+TEST_F(PieceTreeTest, LoadFromFile_DefersLineScan) {
+    const auto path = std::filesystem::temp_directory_path() / "mdeditor_piece_tree.md";
+    std::string text(10000, 'x');
+    for (size_t i = 49; i < text.size(); i += 50) {
+        text[i] = '\n';
+    }
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << text;
+    }
+
+    tree.loadFromFile(path);
+    tree.insert(75, "\nnew");
+    text.insert(75, "\nnew");
+    tree.erase(300, 120);
+    text.erase(300, 120);
+
+    EXPECT_EQ(tree.getText(), text);
+    EXPECT_EQ(tree.lineCount(), 1 + static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+    EXPECT_EQ(tree.offsetFromLine(2), 76);
+
+    EXPECT_THROW(tree.loadFromFile(path.string() + ".missing"), std::runtime_error);
+    EXPECT_EQ(tree.getText(), text);
+
+    tree.clear();
+    std::filesystem::remove(path);
+}
+
+// =============================================================================
+// Parity
+// =============================================================================
+
+TEST_F(PieceTreeTest, RandomEdits_MatchGapBuffer) {
+    std::mt19937 rng(2025);
+    GapBuffer reference;
+    reference.loadFromString("seed\ntext\n");
+    tree.loadFromString("seed\ntext\n");
+
+    for (int step = 0; step < 4000; ++step) {
+        const size_t pos = rng() % (reference.length() + 1);
+        if (rng() % 3 != 0) {
+            const std::string text(rng() % 6 + 1, "ab\n"[rng() % 3]);
+            reference.insert(pos, text);
+            tree.insert(pos, text);
+        } else {
+            const size_t len = rng() % 12;
+            reference.erase(pos, len);
+            tree.erase(pos, len);
+        }
+        if (step % 500 == 499) {
+            tree.compact();
+        }
+
+        ASSERT_EQ(tree.length(), reference.length()) << "step " << step;
+        ASSERT_EQ(tree.lineCount(), reference.lineCount()) << "step " << step;
+        const size_t probe = rng() % (reference.length() + 1);
+        ASSERT_EQ(tree.lineFromOffset(probe), reference.lineFromOffset(probe));
+        const size_t line = rng() % (reference.lineCount() + 1);
+        ASSERT_EQ(tree.offsetFromLine(line, 1), reference.offsetFromLine(line, 1));
+    }
+
+    EXPECT_EQ(tree.getText(), reference.getText());
+    const auto expected = reference.flushPatches();
+    const auto actual = tree.flushPatches();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].start, expected[i].start);
+        EXPECT_EQ(actual[i].removedText, expected[i].removedText);
+        EXPECT_EQ(actual[i].insertedText, expected[i].insertedText);
+    }
+}
@@ -0,0 +1,411 @@
+// =============================================================================
+// regex_search_tests.cpp - Unit Tests for Streaming Regex Search
+// =============================================================================
+//
+// Tests for Regex covering:
+// - Syntax, leftmost-longest match selection and empty matches
+// - findAll() reading the text once
+// - Anchors and word boundaries, including at range and chunk edges
+// - UTF-8 aware '.', classes and ASCII case folding
+// - Searching GapBuffer and PieceTable chunks without copying, against the
+//   contiguous result
+// - Random patterns against a brute-force std::regex reference
+// - Pattern errors and the DFA cache cap
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_table.h"
+#include "regex_search.h"
+
+#include <random>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+using Span = std::pair<size_t, size_t>;   // start, length
+
+std::vector<Span> spans(const std::vector<Regex::Match>& matches) {
+    std::vector<Span> result;
+    for (const auto& match : matches) {
+        result.emplace_back(match.start, match.length);
+    }
+    return result;
+}
+
+Span first(Regex& regex, std::string_view text, size_t from = 0) {
+    const auto match = regex.findNext(text, from);
+    return match ? Span{match->start, match->length} : Span{std::string_view::npos, 0};
+}
+
+constexpr Span kNone{std::string_view::npos, 0};
+
+/// Reference leftmost-longest match: earliest start, then longest end, for
+/// which the whole substring matches
+Span referenceFirst(const std::regex& regex, const std::string& text) {
+    for (size_t start = 0; start <= text.size(); ++start) {
+        for (size_t end = text.size() + 1; end-- > start;) {
+            if (std::regex_match(text.begin() + static_cast<std::ptrdiff_t>(start),
+                                 text.begin() + static_cast<std::ptrdiff_t>(end), regex)) {
+                return {start, end - start};
+            }
+        }
+    }
+    return kNone;
+}
+
+/// Random pattern over {a, b}, in syntax shared with ECMAScript
+std::string randomPattern(std::mt19937& rng, int depth) {
+    std::string pattern;
+    const int atoms = 1 + static_cast<int>(rng() % 3);
+    for (int i = 0; i < atoms; ++i) {
+        const char* const quantifiers[] = {"", "", "*", "+", "?", "{1,2}"};
+        switch (depth > 0 ? rng() % 6 : rng() % 4) {
+            case 0: pattern += 'a'; break;
+            case 1: pattern += 'b'; break;
+            case 2: pattern += '.'; break;
+            case 3: pattern += "[ab]"; break;
+            default:
+                // Groups only take '?': std::regex backtracks exponentially
+                // on nested unbounded repeats
+                pattern += "(" + randomPattern(rng, depth - 1) + "|" +
+                           randomPattern(rng, depth - 1) + ")";
+                pattern += quantifiers[rng() % 2 * 4];
+                continue;
+        }
+        pattern += quantifiers[rng() % 6];
+    }
+    return pattern;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Syntax and Match Selection
+// =============================================================================
+
+TEST(RegexSearchTest, MatchesLiteralsClassesAndRepeats) {
+    Regex literal("needle");
+    EXPECT_EQ(first(literal, "haystack with a needle"), Span(16, 6));
+    EXPECT_EQ(first(literal, "needl"), kNone);
+
+    Regex heading("#{1,6} [A-Z]\\w*");
+    EXPECT_EQ(first(heading, "text\n### Setup steps"), Span(5, 9));
+
+    Regex link("\\[[^]]*\\]\\([^)\\s]+\\)");
+    EXPECT_EQ(first(link, "see [docs](http://x.y/z) now"), Span(4, 20));
+
+    Regex digits("\\d+(\\.\\d+)?");
+    EXPECT_EQ(first(digits, "version 12.75b"), Span(8, 5));
+
+    Regex counted("ab{2,3}c");
+    EXPECT_EQ(first(counted, "abc abbc abbbbc abbbc"), Span(4, 4));
+    EXPECT_EQ(first(counted, "abc abbbbc"), kNone);
+
+    Regex brace("a{,2}");   // Not a quantifier: literal text
+    EXPECT_EQ(first(brace, "a{,2}"), Span(0, 5));
+
+    Regex escaped("\\x41\\.\\*\\t");
+    EXPECT_EQ(first(escaped, "xA.*\t"), Span(1, 4));
+}
+
+TEST(RegexSearchTest, PrefersLeftmostThenLongest) {
+    Regex alternatives("a|ab|abc");
+    EXPECT_EQ(first(alternatives, "xxabcd"), Span(2, 3));
+
+    Regex split("(a|ab)(c|bcd)");
+    EXPECT_EQ(first(split, "abcd"), Span(0, 4));
+
+    Regex star("b*");
+    EXPECT_EQ(first(star, "abbb"), Span(0, 0));   // Empty match at 0 is leftmost
+    EXPECT_EQ(first(star, "abbb", 1), Span(1, 3));
+
+    // A later, longer match does not beat an earlier one
+    Regex either("bc|abcdef");
+    EXPECT_EQ(first(either, "xbcabcdef"), Span(1, 2));
+}
+
+TEST(RegexSearchTest, FindAllSkipsEmptyMatchAfterMatch) {
+    Regex optional("x*");
+    EXPECT_EQ(spans(optional.findAll("axxb")),
+              (std::vector<Span>{{0, 0}, {1, 2}, {4, 0}}));
+
+    Regex word("\\w+");
+    EXPECT_EQ(spans(word.findAll("one, two  three")),
+              (std::vector<Span>{{0, 3}, {5, 3}, {10, 5}}));
+    EXPECT_TRUE(word.findAll("").empty());
+    EXPECT_TRUE(word.findAll("!?").empty());
+}
+
+TEST(RegexSearchTest, FindAllReadsEachByteOnce) {
+    // The thread for a*b runs to the end behind every single-'a' match;
+    // restarting after each match would read the text n times
+    class CountingBuffer : public GapBuffer {
+    public:
+        void visitChunks(size_t start, size_t len, const ChunkVisitor& fn) const override {
+            bytesRead += len;
+            GapBuffer::visitChunks(start, len, fn);
+        }
+        mutable size_t bytesRead = 0;
+    };
+
+    for (size_t length : {size_t{20000}, size_t{40000}}) {
+        CountingBuffer buffer;
+        buffer.loadFromString(std::string(length, 'a'));
+        Regex regex("a|a*b");
+        const std::vector<Regex::Match> matches = regex.findAll(buffer);
+        ASSERT_EQ(matches.size(), length);
+        EXPECT_EQ(matches.back().start, length - 1);
+        EXPECT_LE(buffer.bytesRead, length + 1);
+    }
+
+    // Threads that started inside a match that later ended may start the
+    // next one
+    Regex interrupted("ab|b+c");
+    EXPECT_EQ(spans(interrupted.findAll("abbbc")), (std::vector<Span>{{0, 2}, {2, 3}}));
+    Regex resumed("ab|b*z");
+    EXPECT_EQ(spans(resumed.findAll("abz")), (std::vector<Span>{{0, 2}, {2, 1}}));
+}
+
+// =============================================================================
+// Assertions
+// =============================================================================
+
+TEST(RegexSearchTest, AnchorsMatchAtLineEdges) {
+    const std::string text = "# Title\ntext # not\n## Sub\n";
+    Regex heading("^#+ \\w+$");
+    EXPECT_EQ(spans(heading.findAll(text)), (std::vector<Span>{{0, 7}, {19, 6}}));
+
+    Regex lineEnd("$");
+    EXPECT_EQ(spans(lineEnd.findAll("ab\ncd")), (std::vector<Span>{{2, 0}, {5, 0}}));
+
+    Regex empty("^$");
+    EXPECT_EQ(spans(empty.findAll("a\n\nb\n")), (std::vector<Span>{{2, 0}, {5, 0}}));
+}
+
+TEST(RegexSearchTest, WordBoundaries) {
+    Regex whole("\\bcat\\b");
+    EXPECT_EQ(spans(whole.findAll("cat concat cats cat_ (cat)")),
+              (std::vector<Span>{{0, 3}, {22, 3}}));
+
+    Regex inside("\\Bcat");
+    EXPECT_EQ(spans(inside.findAll("cat concat")), (std::vector<Span>{{7, 3}}));
+}
+
+TEST(RegexSearchTest, AssertionsSeeTextAroundTheRange) {
+    GapBuffer buffer;
+    buffer.loadFromString("concat cat");
+    Regex whole("\\bcat");
+    // The range starts inside "concat": no boundary before "cat" at 3
+    EXPECT_EQ(spans(whole.findAll(buffer, 3, 7)), (std::vector<Span>{{7, 3}}));
+
+    Regex lineStart("^c");
+    EXPECT_TRUE(lineStart.findAll(buffer, 3, 7).empty());
+    EXPECT_EQ(first(lineStart, "xc", 1), kNone);
+
+    // The byte after the range decides $ and \b at the range end
+    Regex tail("cat$");
+    buffer.loadFromString("cat\ncats");
+    EXPECT_EQ(spans(tail.findAll(buffer, 0, 3)), (std::vector<Span>{{0, 3}}));
+    EXPECT_TRUE(tail.findAll(buffer, 4, 3).empty());
+}
+
+// =============================================================================
+// UTF-8 and Case Folding
+// =============================================================================
+
+TEST(RegexSearchTest, DotAndClassesMatchWholeCharacters) {
+    const std::string text = "h\xC3\xA9llo w\xE2\x82\xACrld \xF0\x9F\x98\x80!";   // héllo w€rld 😀!
+
+    Regex dot("h.llo");
+    EXPECT_EQ(first(dot, text), Span(0, 6));
+
+    Regex wide("w.r");
+    EXPECT_EQ(first(wide, text), Span(7, 5));
+
+    Regex emoji(". ?!");
+    EXPECT_EQ(first(emoji, text), Span(15, 5));
+
+    // A quantifier repeats the whole character
+    Regex repeated("\xC3\xA9+");
+    EXPECT_EQ(first(repeated, "e\xC3\xA9\xC3\xA9x"), Span(1, 4));
+
+    Regex listed("[\xC3\xA9\xE2\x82\xAC]+");
+    EXPECT_EQ(first(listed, "ab\xE2\x82\xAC\xC3\xA9" "c"), Span(2, 5));
+
+    Regex negated("[^a-z ]");
+    EXPECT_EQ(first(negated, "ab \xC3\xA9"), Span(3, 2));
+
+    Regex notWord("\\W");
+    EXPECT_EQ(first(notWord, "ab\xE2\x82\xAC"), Span(2, 3));
+
+    Regex noNewline("a.b");
+    EXPECT_EQ(first(noNewline, "a\nb"), kNone);
+}
+
+TEST(RegexSearchTest, IgnoresAsciiCase) {
+    Regex hello("hello [a-c]+", true);
+    EXPECT_EQ(first(hello, "say HeLLo AbC!"), Span(4, 9));
+
+    Regex negated("[^x]", true);
+    EXPECT_EQ(first(negated, "xXy"), Span(2, 1));
+
+    Regex exact("\xC3\xA9", true);   // Non-ASCII bytes match exactly
+    EXPECT_EQ(first(exact, "\xC3\x89\xC3\xA9"), Span(2, 2));
+}
+
+// =============================================================================
+// Chunked Sources
+// =============================================================================
+
+TEST(RegexSearchTest, GapBuffer_MatchesAcrossTheGap) {
+    GapBuffer buffer;
+    buffer.loadFromString("alpha beta gamma delta");
+    // Move the gap into the middle of "gamma"
+    buffer.insert(13, "X");
+    buffer.erase(13, 1);
+
+    Regex regex("g\\w+a d");
+    const auto match = regex.findNext(buffer);
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(match->start, 11);
+    EXPECT_EQ(match->length, 7);
+    EXPECT_FALSE(regex.findNext(buffer, 12).has_value());
+}
+
+TEST(RegexSearchTest, DocumentModelsMatchContiguousSearch) {
+    std::mt19937 rng(18);
+    const char* const words[] = {"note", "Note", " ", "\n", "# ", "todo", "\xC3\xA9t\xC3\xA9", "42"};
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += words[rng() % 8];
+    }
+
+    GapBuffer gap;
+    gap.loadFromString(text);
+    PieceTable pieces;
+    pieces.loadFromString(text);
+    for (int i = 0; i < 200; ++i) {
+        // Identical edits: a moving gap and many small pieces
+        const size_t offset = rng() % (text.size() + 1);
+        const std::string insert = words[rng() % 8];
+        text.insert(offset, insert);
+        gap.insert(offset, insert);
+        pieces.insert(offset, insert);
+    }
+    ASSERT_EQ(gap.getText(), text);
+    ASSERT_EQ(pieces.getText(), text);
+
+    for (const char* pattern : {"^# \\w+", "note\\s+todo", "\\b\\d+\\b", ".t.$", "(note|todo)+"}) {
+        Regex regex(pattern, true);
+        const auto expected = spans(regex.findAll(text));
+        EXPECT_FALSE(expected.empty()) << pattern;
+        EXPECT_EQ(spans(regex.findAll(gap)), expected) << pattern;
+        EXPECT_EQ(spans(regex.findAll(pieces)), expected) << pattern;
+    }
+}
+
+TEST(RegexSearchTest, GapBuffer_MatchesAcrossReadWindows) {
+    // Matches around the 64 KB read windows and the gap, found through the
+    // memchr skip ("^" waits for '\n') and the plain DFA loop
+    std::string text(300000, 'x');
+    std::vector<Span> expected;
+    for (size_t at : {size_t{0}, size_t{65533}, size_t{131070}, size_t{199998}, size_t{299992}}) {
+        text.replace(at, 8, at == 0 ? "# Note\nx" : "\n# Note\n");
+        expected.emplace_back(at == 0 ? 0 : at + 1, 6);
+    }
+    GapBuffer buffer;
+    buffer.loadFromString(text);
+    buffer.insert(200000, "X");   // Gap inside the fourth heading
+    buffer.erase(200000, 1);
+
+    Regex heading("^# \\w+");
+    EXPECT_EQ(spans(heading.findAll(buffer)), expected);
+    Regex word("\\bNote\\b");
+    EXPECT_EQ(word.findAll(buffer).size(), 5);
+}
+
+// =============================================================================
+// Reference Comparison
+// =============================================================================
+
+TEST(RegexSearchTest, RandomizedMatchesReference) {
+    std::mt19937 rng(1018);
+    for (int round = 0; round < 1000; ++round) {
+        const std::string pattern = randomPattern(rng, 2);
+        std::string text;
+        const size_t length = rng() % 14;
+        for (size_t i = 0; i < length; ++i) {
+            text += "abc"[rng() % 3];
+        }
+
+        Regex regex(pattern);
+        const std::regex reference(pattern);
+        ASSERT_EQ(first(regex, text), referenceFirst(reference, text))
+            << "pattern " << pattern << " text " << text;
+    }
+}
+
+// =============================================================================
+// Errors and Limits
+// =============================================================================
+
+TEST(RegexSearchTest, RejectsBadPatterns) {
+    const std::pair<const char*, size_t> cases[] = {
+        {"a(b", 3},        // Missing ')'
+        {"ab)", 2},        // Unmatched ')'
+        {"*a", 0},         // Nothing to repeat
+        {"a|{2}", 2},
+        {"^*", 1},
+        {"a**", 2},        // Lazy/possessive
+        {"a+?", 2},
+        {"(?=a)", 1},      // Lookaround
+        {"(a)\\1", 5},     // Backreference
+        {"\\q", 2},        // Unknown escape
+        {"ab\\", 3},       // Trailing backslash
+        {"[abc", 4},       // Unterminated class
+        {"[z-a]", 1},
+        {"[\xC3\xA0-\xC3\xBF]", 1},   // Non-ASCII range
+        {"[^\xC3\xA9]", 2},           // Negated non-ASCII
+        {"a{1001}", 1},
+        {"a{3,2}", 1},
+    };
+    for (const auto& [pattern, position] : cases) {
+        try {
+            Regex regex(pattern);
+            ADD_FAILURE() << "accepted " << pattern;
+        } catch (const RegexError& error) {
+            EXPECT_EQ(error.position(), position) << pattern << ": " << error.what();
+        }
+    }
+    EXPECT_THROW(Regex("((a{1000}){1000}){1000}"), RegexError);   // Too large
+    EXPECT_NO_THROW(Regex("(?:a|)[]x]\\]"));
+}
+
+TEST(RegexSearchTest, StateCacheStaysBounded) {
+    // Every 'a' among the last 15 bytes is a live thread: up to 2^15 states
+    std::mt19937 rng(4);
+    std::string text;
+    for (int i = 0; i < 200000; ++i) {
+        text += "ab"[rng() % 2];
+    }
+
+    Regex regex("a[ab]{14}");
+    std::vector<Span> expected;
+    for (size_t i = 0; i + 15 <= text.size();) {
+        if (text[i] == 'a') {
+            expected.emplace_back(i, 15);
+            i += 15;
+        } else {
+            ++i;
+        }
+    }
+    EXPECT_EQ(spans(regex.findAll(text)), expected);
+    EXPECT_LE(regex.cachedStates(), Regex::kMaxStates);
+}
@@ -0,0 +1,172 @@
+// =============================================================================
+// substring_scan_tests.cpp - Unit Tests for Substring Search
+// =============================================================================
+//
+// Tests for findSubstring() and GapBuffer::findNext()/findAll() covering:
+// - Every supported SIMD level against a scalar reference, with matches
+//   around vector block boundaries and at the very end of the text
+// - ASCII case folding (and exact matching of non-ASCII bytes)
+// - Matches before, after and straddling the gap, and range limits
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "substring_scan.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+constexpr size_t kNotFound = std::string_view::npos;
+
+std::vector<simd::Level> supportedLevels() {
+    std::vector<simd::Level> levels;
+    for (auto level : {simd::Level::Scalar, simd::Level::SSE2,
+                       simd::Level::AVX2, simd::Level::AVX512}) {
+        if (level <= simd::detectedLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+/// Reference: all non-overlapping matches, std::string::find based
+std::vector<size_t> referenceFindAll(const std::string& text, const std::string& pattern) {
+    std::vector<size_t> matches;
+    for (size_t pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + pattern.size())) {
+        matches.push_back(pos);
+    }
+    return matches;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Kernels
+// =============================================================================
+
+TEST(SubstringScanTest, FindsAtEveryPosition) {
+    for (auto level : supportedLevels()) {
+        const std::vector<std::string> patterns = {"x", "xy", "needle", std::string(40, 'n') + "!"};
+        for (const std::string& pattern : patterns) {
+            for (size_t pos = 0; pos < 100; ++pos) {
+                const std::string text = std::string(pos, '.') + pattern + std::string(pos % 7, '.');
+                ASSERT_EQ(simd::findSubstring(text, pattern, false, level), pos)
+                    << simd::levelName(level) << " " << pattern << " at " << pos;
+            }
+        }
+    }
+}
+
+TEST(SubstringScanTest, EdgeCases) {
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::findSubstring("abc", "", false, level), kNotFound);
+        EXPECT_EQ(simd::findSubstring("", "a", false, level), kNotFound);
+        EXPECT_EQ(simd::findSubstring("ab", "abc", false, level), kNotFound);
+        EXPECT_EQ(simd::findSubstring("abc", "abc", false, level), 0);
+        // First and last bytes match everywhere, the middle only once
+        const std::string text = std::string(200, 'a') + "aba" + std::string(50, 'a');
+        EXPECT_EQ(simd::findSubstring(text, "aba", false, level), 200) << simd::levelName(level);
+    }
+}
+
+TEST(SubstringScanTest, IgnoresAsciiCaseOnly) {
+    const std::string text = std::string(37, '-') + "Caf\xC3\xA9 MarkDown [1]" + std::string(37, '-');
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::findSubstring(text, "markdown", true, level), 43) << simd::levelName(level);
+        EXPECT_EQ(simd::findSubstring(text, "markdown", false, level), kNotFound);
+        EXPECT_EQ(simd::findSubstring(text, "CAF\xC3\xA9", true, level), 37);
+        // Non-letters are not folded: '[' (0x5B) is not '{' (0x7B)
+        EXPECT_EQ(simd::findSubstring(text, "{1}", true, level), kNotFound);
+        EXPECT_EQ(simd::findSubstring(text, "[1]", true, level), 52);
+    }
+}
+
+TEST(SubstringScanTest, RandomizedMatchesScalar) {
+    std::mt19937 rng(17);
+    for (int round = 0; round < 300; ++round) {
+        // Small alphabet so partial matches are common
+        std::string text(rng() % 500, ' ');
+        for (char& c : text) {
+            c = "abAB\n"[rng() % 5];
+        }
+        std::string pattern(rng() % 6 + 1, ' ');
+        for (char& c : pattern) {
+            c = "abAB"[rng() % 4];
+        }
+        for (const bool ignoreCase : {false, true}) {
+            const size_t expected = simd::findSubstring(text, pattern, ignoreCase, simd::Level::Scalar);
+            for (auto level : supportedLevels()) {
+                ASSERT_EQ(simd::findSubstring(text, pattern, ignoreCase, level), expected)
+                    << simd::levelName(level) << " round " << round;
+            }
+        }
+    }
+}
+
+// =============================================================================
+// GapBuffer Search
+// =============================================================================
+
+TEST(SubstringScanTest, GapBuffer_FindsAcrossTheGap) {
+    GapBuffer buffer;
+    buffer.loadFromString("one needle, two needles");
+
+    // Move the gap into the middle of the second "needle"
+    buffer.insert(18, "X");
+    buffer.erase(18, 1);
+    ASSERT_EQ(buffer.getText(), "one needle, two needles");
+
+    EXPECT_EQ(buffer.findNext("needle"), 4);
+    EXPECT_EQ(buffer.findNext("needle", 5), 16);
+    EXPECT_EQ(buffer.findNext("needles"), 16);
+    EXPECT_EQ(buffer.findNext("haystack"), kNotFound);
+    EXPECT_EQ(buffer.findAll("needle"), (std::vector<size_t>{4, 16}));
+    EXPECT_EQ(buffer.findAll("NEEDLE", 0, kNotFound, true), (std::vector<size_t>{4, 16}));
+}
+
+TEST(SubstringScanTest, GapBuffer_RespectsRange) {
+    GapBuffer buffer;
+    buffer.loadFromString("abcabcabc");
+    buffer.insert(4, "X");
+    buffer.erase(4, 1);
+
+    EXPECT_EQ(buffer.findAll("abc", 1), (std::vector<size_t>{3, 6}));
+    EXPECT_EQ(buffer.findAll("abc", 0, 8), (std::vector<size_t>{0, 3}));   // 6..9 sticks out
+    EXPECT_EQ(buffer.findAll("abc", 2, 5), (std::vector<size_t>{3}));
+    EXPECT_TRUE(buffer.findAll("abc", 100).empty());
+    EXPECT_TRUE(buffer.findAll("").empty());
+    EXPECT_EQ(buffer.findAll("aa"), std::vector<size_t>{});
+    EXPECT_EQ(buffer.findNext("abc", 9), kNotFound);
+}
+
+TEST(SubstringScanTest, GapBuffer_RandomGapPositionsMatchReference) {
+    std::mt19937 rng(18);
+    std::string reference(3000, ' ');
+    for (char& c : reference) {
+        c = "abc"[rng() % 3];
+    }
+    GapBuffer buffer;
+    buffer.loadFromString(reference);
+
+    for (int round = 0; round < 300; ++round) {
+        // Move the gap with a no-op edit pair
+        const size_t gap = rng() % (reference.size() + 1);
+        buffer.insert(gap, "c");
+        buffer.erase(gap, 1);
+
+        std::string pattern(rng() % 5 + 1, ' ');
+        for (char& c : pattern) {
+            c = "abc"[rng() % 3];
+        }
+        const size_t from = rng() % reference.size();
+        ASSERT_EQ(buffer.findNext(pattern, from), reference.find(pattern, from)) << round;
+        ASSERT_EQ(buffer.findAll(pattern), referenceFindAll(reference, pattern)) << round;
+    }
+}
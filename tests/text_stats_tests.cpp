@@ -0,0 +1,178 @@
+// =============================================================================
+// text_stats_tests.cpp - Unit Tests for TextStats
+// =============================================================================
+//
+// Tests for the incrementally maintained document statistics covering:
+// - Character, word and line counts and reading time of known texts
+// - Edits that join, split, create and remove words at their boundaries
+// - Random edits and applyEdits() batches against a full recount
+// - Copies, reloads and use with another IDocumentModel backend
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_table.h"
+#include "text_stats.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+/// Counts text from scratch
+TextStats::Counts recount(const std::string& text) {
+    GapBuffer buffer;
+    buffer.loadFromString(text);
+    TextStats stats;
+    stats.rebuild(buffer);
+    return stats.totals();
+}
+
+void expectCounts(const TextStats::Counts& actual, const TextStats::Counts& expected) {
+    EXPECT_EQ(actual.bytes, expected.bytes);
+    EXPECT_EQ(actual.characters, expected.characters);
+    EXPECT_EQ(actual.words, expected.words);
+    EXPECT_EQ(actual.lines, expected.lines);
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Counting
+// =============================================================================
+
+TEST(TextStatsTest, CountsKnownText) {
+    const TextStats::Counts counts = recount("# Caf\xC3\xA9 notes\n\n  two\twords \n");
+    EXPECT_EQ(counts.bytes, 28);
+    EXPECT_EQ(counts.characters, 27);
+    EXPECT_EQ(counts.words, 5);
+    EXPECT_EQ(counts.lines, 4);
+
+    expectCounts(recount(""), TextStats::Counts{});
+    EXPECT_EQ(recount("   \n\t").words, 0);
+    EXPECT_EQ(recount("word").lines, 1);
+}
+
+TEST(TextStatsTest, ReadingMinutesRoundUp) {
+    TextStats::Counts counts;
+    EXPECT_EQ(counts.readingMinutes(), 0);
+    counts.words = 1;
+    EXPECT_EQ(counts.readingMinutes(), 1);
+    counts.words = TextStats::kWordsPerMinute;
+    EXPECT_EQ(counts.readingMinutes(), 1);
+    counts.words = TextStats::kWordsPerMinute + 1;
+    EXPECT_EQ(counts.readingMinutes(), 2);
+    EXPECT_EQ(counts.readingMinutes(0), 0);
+}
+
+// =============================================================================
+// Word Boundaries
+// =============================================================================
+
+TEST(TextStatsTest, EditsAtWordBoundaries) {
+    GapBuffer buffer;
+    buffer.loadFromString("alpha beta");
+    EXPECT_EQ(buffer.textStats().words, 2);
+
+    buffer.erase(5, 1);                 // "alphabeta": joined
+    EXPECT_EQ(buffer.textStats().words, 1);
+    buffer.insert(3, " ");              // "alp habeta": split
+    EXPECT_EQ(buffer.textStats().words, 2);
+    buffer.insert(0, "x");              // "xalp habeta": extends a word
+    EXPECT_EQ(buffer.textStats().words, 2);
+    buffer.insert(0, "new ");           // "new xalp habeta"
+    EXPECT_EQ(buffer.textStats().words, 3);
+    buffer.insert(buffer.length(), "\nend");
+    EXPECT_EQ(buffer.textStats().words, 4);
+    EXPECT_EQ(buffer.textStats().lines, 2);
+    buffer.erase(0, buffer.length());
+    expectCounts(buffer.textStats(), TextStats::Counts{});
+}
+
+TEST(TextStatsTest, RandomEditsMatchRecount) {
+    std::mt19937 rng(23);
+    const std::vector<std::string> pieces = {"a", "bc", " ", "\n", "\t", "\xC3\xA9", "de f", "  "};
+    GapBuffer buffer;
+    std::string expected = "start of the document\nsecond line";
+    buffer.loadFromString(expected);
+    (void)buffer.textStats();
+
+    for (int step = 0; step < 2000; ++step) {
+        const size_t pos = rng() % (expected.size() + 1);
+        if (rng() % 3 != 0) {
+            const std::string& text = pieces[rng() % pieces.size()];
+            buffer.insert(pos, text);
+            expected.insert(pos, text);
+        } else {
+            const size_t len = std::min<size_t>(rng() % 5, expected.size() - pos);
+            buffer.erase(pos, len);
+            expected.erase(pos, len);
+        }
+        if (step % 50 == 0) {
+            ASSERT_EQ(buffer.getText(), expected);
+            const TextStats::Counts actual = buffer.textStats();
+            const TextStats::Counts reference = recount(expected);
+            ASSERT_EQ(actual.words, reference.words) << "step " << step;
+            ASSERT_EQ(actual.characters, reference.characters) << "step " << step;
+            ASSERT_EQ(actual.lines, reference.lines) << "step " << step;
+        }
+    }
+    expectCounts(buffer.textStats(), recount(expected));
+}
+
+TEST(TextStatsTest, ApplyEditsBatch) {
+    GapBuffer buffer;
+    buffer.loadFromString("one two three four");
+    (void)buffer.textStats();
+
+    // Adjacent edits: each sees the text left by the previous one
+    buffer.applyEdits({
+        Edit{3, 1, ""},             // "onetwo"
+        Edit{4, 3, "x y"},          // "onetwx y"
+        Edit{13, 1, "-"},           // "three-four"
+        Edit{18, 0, " five"},
+    });
+    EXPECT_EQ(buffer.getText(), "onex y three-four five");
+    expectCounts(buffer.textStats(), recount(buffer.getText()));
+}
+
+// =============================================================================
+// Lifetime and Other Backends
+// =============================================================================
+
+TEST(TextStatsTest, CopiesAndReloadsStayConsistent) {
+    GapBuffer buffer;
+    buffer.loadFromString("two words");
+    EXPECT_EQ(buffer.textStats().words, 2);
+
+    GapBuffer copy = buffer;
+    copy.insert(0, "three ");
+    EXPECT_EQ(copy.textStats().words, 3);
+    EXPECT_EQ(buffer.textStats().words, 2);
+
+    buffer.loadFromString("a b c d");
+    EXPECT_EQ(buffer.textStats().words, 4);
+    buffer.clear();
+    expectCounts(buffer.textStats(), TextStats::Counts{});
+}
+
+TEST(TextStatsTest, WorksWithOtherBackends) {
+    PieceTable table;
+    table.loadFromString("hello world");
+    TextStats stats;
+    stats.rebuild(table);
+
+    // Replace " " with "\n" between 'o' and 'w': still two words
+    table.erase(5, 1);
+    table.insert(5, "\n");
+    stats.recordEdit('o', " ", "\n", 'w');
+    table.erase(0, 6);
+    stats.recordEdit(TextStats::kEdge, "hello\n", {}, 'w');
+
+    expectCounts(stats.totals(), recount(table.getText()));
+    EXPECT_EQ(stats.totals().words, 1);
+}
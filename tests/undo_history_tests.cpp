@@ -0,0 +1,248 @@
+// =============================================================================
+// undo_history_tests.cpp - Unit Tests for UndoHistory
+// =============================================================================
+//
+// Tests for the patch-based undo/redo history covering:
+// - Invertible patches from GapBuffer (and PieceTable through IDocumentModel)
+// - Undo/redo round trips
+// - Transaction grouping by time and adjacency
+// - Memory budget enforcement
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_table.h"
+#include "undo_history.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+// =============================================================================
+// Test Fixture
+// =============================================================================
+
+class UndoHistoryTest : public ::testing::Test {
+protected:
+    GapBuffer buffer;
+    UndoHistory history;
+};
+
+// =============================================================================
+// Invertible Patch Tests
+// =============================================================================
+
+TEST_F(UndoHistoryTest, ErasePatch_CarriesRemovedText) {
+    buffer.loadFromString("Hello, World!");
+    buffer.erase(5, 7);
+    
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 1);
+    EXPECT_EQ(patches[0].removedText, ", World");
+    EXPECT_TRUE(patches[0].isInvertible());
+}
+
+TEST_F(UndoHistoryTest, BackspaceCoalescing_PrependsRemovedText) {
+    buffer.loadFromString("abcdef");
+    buffer.erase(5, 1);
+    buffer.erase(4, 1);
+    buffer.erase(3, 1);
+    
+    auto patches = buffer.flushPatches();
+    ASSERT_EQ(patches.size(), 1);
+    EXPECT_EQ(patches[0].start, 3);
+    EXPECT_EQ(patches[0].removedText, "def");
+}
+
+TEST_F(UndoHistoryTest, InvertedPatch_SwapsTexts) {
+    Patch patch(2, "old", "new");
+    Patch inverse = patch.inverted();
+    
+    EXPECT_EQ(inverse.start, 2);
+    EXPECT_EQ(inverse.removedLength, 3);
+    EXPECT_EQ(inverse.insertedText, "old");
+    EXPECT_EQ(inverse.removedText, "new");
+}
+
+TEST_F(UndoHistoryTest, ApplyEditsPatches_AreInvertible) {
+    buffer.loadFromString("cat dog cat");
+    buffer.applyEdits({{0, 3, "lion"}, {8, 3, "lion"}});
+    
+    for (const auto& p : buffer.flushPatches()) {
+        EXPECT_EQ(p.removedText, "cat");
+    }
+}
+
+// =============================================================================
+// Undo/Redo Tests
+// =============================================================================
+
+TEST_F(UndoHistoryTest, EmptyHistory) {
+    EXPECT_FALSE(history.canUndo());
+    EXPECT_FALSE(history.canRedo());
+    EXPECT_TRUE(history.undo(buffer).empty());
+    EXPECT_TRUE(history.redo(buffer).empty());
+}
+
+TEST_F(UndoHistoryTest, UndoRedo_Insert) {
+    buffer.loadFromString("Hello");
+    buffer.insert(5, " World");
+    history.record(buffer.flushPatches());
+    
+    history.undo(buffer);
+    EXPECT_EQ(buffer.getText(), "Hello");
+    EXPECT_TRUE(history.canRedo());
+    
+    history.redo(buffer);
+    EXPECT_EQ(buffer.getText(), "Hello World");
+    EXPECT_FALSE(history.canRedo());
+}
+
+TEST_F(UndoHistoryTest, Undo_RecordsPendingPatchesFirst) {
+    buffer.loadFromString("Hello");
+    buffer.erase(0, 1);
+    
+    history.undo(buffer);
+    EXPECT_EQ(buffer.getText(), "Hello");
+}
+
+TEST_F(UndoHistoryTest, Undo_ReturnsAppliedPatchesWithoutRecordingThem) {
+    buffer.insert(0, "abc");
+    history.record(buffer.flushPatches());
+    
+    auto applied = history.undo(buffer);
+    ASSERT_FALSE(applied.empty());
+    EXPECT_EQ(applied[0].removedText, "abc");
+    EXPECT_FALSE(buffer.hasPendingPatches());
+    EXPECT_TRUE(history.canRedo());
+}
+
+TEST_F(UndoHistoryTest, NewEdit_DiscardsRedo) {
+    buffer.insert(0, "one");
+    history.record(buffer.flushPatches());
+    history.undo(buffer);
+    
+    buffer.insert(0, "two");
+    history.record(buffer.flushPatches());
+    EXPECT_FALSE(history.canRedo());
+    EXPECT_EQ(history.undoDepth(), 1);
+}
+
+TEST_F(UndoHistoryTest, Grouping_AdjacentTypingIsOneStep) {
+    buffer.insert(0, "a");
+    history.record(buffer.flushPatches());
+    buffer.insert(1, "b");
+    history.record(buffer.flushPatches());
+    buffer.insert(2, "c");
+    history.record(buffer.flushPatches());
+    
+    EXPECT_EQ(history.undoDepth(), 1);
+    history.undo(buffer);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST_F(UndoHistoryTest, Grouping_NonAdjacentEditsAreSeparateSteps) {
+    buffer.loadFromString("0123456789");
+    buffer.insert(0, "a");
+    history.record(buffer.flushPatches());
+    buffer.insert(8, "b");
+    history.record(buffer.flushPatches());
+    
+    EXPECT_EQ(history.undoDepth(), 2);
+    history.undo(buffer);
+    EXPECT_EQ(buffer.getText(), "a0123456789");
+}
+
+TEST_F(UndoHistoryTest, Grouping_PauseStartsNewStep) {
+    UndoHistory strict(UndoHistory::Options{1 << 20, std::chrono::milliseconds(0)});
+    Patch first(0, "", "a");
+    Patch second(1, "", "b");
+    second.timestamp = first.timestamp + std::chrono::milliseconds(5);
+    
+    strict.record(first);
+    strict.record(second);
+    EXPECT_EQ(strict.undoDepth(), 2);
+}
+
+TEST_F(UndoHistoryTest, Grouping_SealStartsNewStep) {
+    buffer.insert(0, "a");
+    history.record(buffer.flushPatches());
+    history.sealTransaction();
+    buffer.insert(1, "b");
+    history.record(buffer.flushPatches());
+    
+    EXPECT_EQ(history.undoDepth(), 2);
+}
+
+TEST_F(UndoHistoryTest, Budget_DropsOldestSteps) {
+    const size_t stepCost = sizeof(Patch) + 100;
+    UndoHistory small(UndoHistory::Options{stepCost * 3, std::chrono::milliseconds(1000)});
+    
+    const std::string chunk(100, 'x');
+    for (int i = 0; i < 10; ++i) {
+        buffer.insert(0, chunk);
+        small.record(buffer.flushPatches());
+        small.sealTransaction();
+    }
+    
+    EXPECT_EQ(small.undoDepth(), 3);
+    EXPECT_LE(small.memoryUsage(), stepCost * 3);
+    
+    while (small.canUndo()) {
+        small.undo(buffer);
+    }
+    EXPECT_EQ(buffer.length(), 7 * chunk.size());
+}
+
+TEST_F(UndoHistoryTest, RandomizedUndoAllRestoresOriginal) {
+    std::mt19937 rng(5);
+    const std::string original = "The quick brown fox\njumps over\nthe lazy dog";
+    buffer.loadFromString(original);
+    
+    std::vector<std::string> states{original};
+    for (int i = 0; i < 300; ++i) {
+        const size_t pos = rng() % (buffer.length() + 1);
+        if (rng() % 2) {
+            buffer.insert(pos, std::string(1 + rng() % 4, "xyz\n"[rng() % 4]));
+        } else {
+            buffer.erase(pos, 1 + rng() % 4);
+        }
+        auto patches = buffer.flushPatches();
+        if (patches.empty()) {
+            continue;  // Clamped to a no-op
+        }
+        history.record(patches);
+        history.sealTransaction();
+        states.push_back(buffer.getText());
+    }
+    
+    for (size_t i = states.size() - 1; i > 0; --i) {
+        history.undo(buffer);
+        ASSERT_EQ(buffer.getText(), states[i - 1]) << "undo to state " << i - 1;
+    }
+    EXPECT_FALSE(history.canUndo());
+    
+    for (size_t i = 1; i < states.size(); ++i) {
+        history.redo(buffer);
+        ASSERT_EQ(buffer.getText(), states[i]) << "redo to state " << i;
+    }
+}
+
+TEST_F(UndoHistoryTest, WorksWithPieceTable) {
+    PieceTable table;
+    table.loadFromString("one two");
+    table.insert(3, " and");
+    history.record(table.flushPatches());
+    history.sealTransaction();
+    table.erase(0, 4);
+    
+    history.undo(table);
+    EXPECT_EQ(table.getText(), "one and two");
+    history.undo(table);
+    EXPECT_EQ(table.getText(), "one two");
+    history.redo(table);
+    EXPECT_EQ(table.getText(), "one and two");
+}
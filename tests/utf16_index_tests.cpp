@@ -0,0 +1,240 @@
+// =============================================================================
+// utf16_index_tests.cpp - Unit Tests for UTF-8 Counting and Utf16Index
+// =============================================================================
+//
+// Tests for the UTF-16 / code point offset mapping covering:
+// - The counting kernels at every supported SIMD level against a scalar
+//   reference, including sequences split across vector blocks
+// - Mapping in both directions, rounding inside characters and pairs
+// - Incremental updates under random edits, chunk splits after large pastes
+// - Use with another IDocumentModel backend
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "piece_table.h"
+#include "utf16_index.h"
+#include "utf8_scan.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+std::vector<simd::Level> supportedLevels() {
+    std::vector<simd::Level> levels;
+    for (auto level : {simd::Level::Scalar, simd::Level::SSE2,
+                       simd::Level::AVX2, simd::Level::AVX512}) {
+        if (level <= simd::detectedLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+/// Characters of 1, 2, 3 and 4 bytes (the last one is a surrogate pair)
+const char* const kSamples[] = {"a", "\n", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+
+std::string randomUtf8(std::mt19937& rng, size_t characters) {
+    std::string text;
+    for (size_t i = 0; i < characters; ++i) {
+        text += kSamples[rng() % 5];
+    }
+    return text;
+}
+
+/// Reference: UTF-16 units of the characters whose lead byte is before offset
+size_t referenceUtf16(const std::string& text, size_t offset) {
+    size_t units = 0;
+    for (size_t i = 0; i < offset; ++i) {
+        const auto byte = static_cast<unsigned char>(text[i]);
+        if ((byte & 0xC0u) != 0x80u) {
+            units += byte >= 0xF0u ? 2 : 1;
+        }
+    }
+    return units;
+}
+
+/// Reference: code points whose lead byte is before offset
+size_t referenceCodePoints(const std::string& text, size_t offset) {
+    size_t count = 0;
+    for (size_t i = 0; i < offset; ++i) {
+        count += (static_cast<unsigned char>(text[i]) & 0xC0u) != 0x80u;
+    }
+    return count;
+}
+
+/// Byte offsets of all character starts, plus the end
+std::vector<size_t> characterStarts(const std::string& text) {
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if ((static_cast<unsigned char>(text[i]) & 0xC0u) != 0x80u) {
+            starts.push_back(i);
+        }
+    }
+    starts.push_back(text.size());
+    return starts;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Counting Kernels
+// =============================================================================
+
+TEST(Utf8ScanTest, CountsKnownText) {
+    // "aé€😀": 4 code points, 5 UTF-16 units, 10 bytes
+    const std::string text = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    for (auto level : supportedLevels()) {
+        const simd::Utf8Counts counts = simd::countUtf8(text, level);
+        EXPECT_EQ(counts.codePoints, 4) << simd::levelName(level);
+        EXPECT_EQ(counts.utf16Units, 5) << simd::levelName(level);
+        EXPECT_EQ(simd::countUtf8("", level).utf16Units, 0);
+    }
+}
+
+TEST(Utf8ScanTest, RandomizedMatchesScalar) {
+    std::mt19937 rng(15);
+    const std::string storage = randomUtf8(rng, 40000);
+
+    for (int round = 0; round < 300; ++round) {
+        // Arbitrary byte ranges split sequences at both ends
+        const size_t start = rng() % 257;
+        const size_t len = rng() % (storage.size() - start);
+        const std::string_view range(storage.data() + start, len);
+        const simd::Utf8Counts expected = simd::countUtf8(range, simd::Level::Scalar);
+        for (auto level : supportedLevels()) {
+            const simd::Utf8Counts actual = simd::countUtf8(range, level);
+            ASSERT_EQ(actual.codePoints, expected.codePoints) << simd::levelName(level);
+            ASSERT_EQ(actual.utf16Units, expected.utf16Units) << simd::levelName(level);
+        }
+    }
+
+    const std::string whole(storage);
+    EXPECT_EQ(simd::countUtf8(whole).utf16Units, referenceUtf16(whole, whole.size()));
+}
+
+// =============================================================================
+// Mapping
+// =============================================================================
+
+TEST(Utf16IndexTest, MapsBothDirections) {
+    GapBuffer buffer;
+    buffer.loadFromString("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z");  // aé€😀z
+
+    EXPECT_EQ(buffer.utf16Length(), 6);
+    EXPECT_EQ(buffer.utf16FromOffset(0), 0);
+    EXPECT_EQ(buffer.utf16FromOffset(3), 2);      // Before €
+    EXPECT_EQ(buffer.utf16FromOffset(6), 3);      // Before 😀
+    EXPECT_EQ(buffer.utf16FromOffset(10), 5);     // Before z
+    EXPECT_EQ(buffer.utf16FromOffset(100), 6);    // Clamped
+    EXPECT_EQ(buffer.offsetFromUtf16(3), 6);
+    EXPECT_EQ(buffer.offsetFromUtf16(5), 10);
+    EXPECT_EQ(buffer.offsetFromUtf16(6), 11);
+    EXPECT_EQ(buffer.codePointFromOffset(10), 4);
+    EXPECT_EQ(buffer.offsetFromCodePoint(4), 10);
+}
+
+TEST(Utf16IndexTest, RoundsInsideCharacters) {
+    GapBuffer buffer;
+    buffer.loadFromString("\xF0\x9F\x98\x80x");   // 😀x
+
+    EXPECT_EQ(buffer.utf16FromOffset(2), 2);      // Inside 😀: past it
+    EXPECT_EQ(buffer.offsetFromUtf16(1), 0);      // Between the surrogates
+    EXPECT_EQ(buffer.offsetFromUtf16(2), 4);
+}
+
+TEST(Utf16IndexTest, RandomEditsMatchReference) {
+    std::mt19937 rng(16);
+    GapBuffer buffer;
+    std::string reference = randomUtf8(rng, 20000);
+    buffer.loadFromString(reference);
+    (void)buffer.utf16Length();   // Build, then maintain incrementally
+
+    for (int step = 0; step < 1500; ++step) {
+        const std::vector<size_t> starts = characterStarts(reference);
+        const size_t pos = starts[rng() % starts.size()];
+        if (rng() % 3 != 0) {
+            const std::string text = randomUtf8(rng, rng() % 20 + 1);
+            buffer.insert(pos, text);
+            reference.insert(pos, text);
+        } else {
+            const size_t end = starts[std::min(starts.size() - 1,
+                static_cast<size_t>(std::lower_bound(starts.begin(), starts.end(), pos) -
+                                    starts.begin()) + rng() % 40)];
+            buffer.erase(pos, end - pos);
+            reference.erase(pos, end - pos);
+        }
+
+        const size_t probe = rng() % (reference.size() + 1);
+        ASSERT_EQ(buffer.utf16FromOffset(probe), referenceUtf16(reference, probe)) << step;
+        ASSERT_EQ(buffer.codePointFromOffset(probe), referenceCodePoints(reference, probe));
+        const std::vector<size_t> after = characterStarts(reference);
+        const size_t start = after[rng() % after.size()];
+        ASSERT_EQ(buffer.offsetFromUtf16(referenceUtf16(reference, start)), start) << step;
+        ASSERT_EQ(buffer.offsetFromCodePoint(referenceCodePoints(reference, start)), start);
+    }
+    EXPECT_EQ(buffer.utf16Length(), referenceUtf16(reference, reference.size()));
+}
+
+TEST(Utf16IndexTest, LargePasteIsSplitOnLookup) {
+    std::mt19937 rng(17);
+    GapBuffer buffer;
+    buffer.loadFromString("start\n");
+    EXPECT_EQ(buffer.utf16Length(), 6);
+
+    // One chunk absorbs the whole paste until a lookup lands in it
+    const std::string paste = randomUtf8(rng, 100000);
+    buffer.insert(3, paste);
+    buffer.applyEdits({{0, 1, "\xE2\x82\xAC"}, {paste.size() + 4, 0, "\xF0\x9F\x98\x80"}});
+    const std::string reference = "\xE2\x82\xAC" "ta" + paste + "r" "\xF0\x9F\x98\x80" "t\n";
+    ASSERT_EQ(buffer.getText(), reference);
+
+    for (const size_t offset : {size_t{0}, size_t{5}, reference.size() / 3, reference.size() - 1}) {
+        EXPECT_EQ(buffer.utf16FromOffset(offset), referenceUtf16(reference, offset));
+    }
+    const std::vector<size_t> starts = characterStarts(reference);
+    for (int i = 0; i < 200; ++i) {
+        const size_t start = starts[rng() % starts.size()];
+        ASSERT_EQ(buffer.offsetFromUtf16(referenceUtf16(reference, start)), start);
+    }
+}
+
+TEST(Utf16IndexTest, CopiesAndReloadsKeepIndexConsistent) {
+    GapBuffer buffer;
+    buffer.loadFromString("\xC3\xA9\xC3\xA9");
+    EXPECT_EQ(buffer.utf16Length(), 2);
+
+    GapBuffer copy = buffer;
+    copy.insert(0, "\xF0\x9F\x98\x80");
+    EXPECT_EQ(copy.utf16Length(), 4);
+    EXPECT_EQ(buffer.utf16Length(), 2);
+
+    buffer.loadFromString("plain");
+    EXPECT_EQ(buffer.utf16Length(), 5);
+    buffer.clear();
+    EXPECT_EQ(buffer.utf16Length(), 0);
+    EXPECT_EQ(buffer.offsetFromUtf16(3), 0);
+}
+
+TEST(Utf16IndexTest, WorksWithOtherBackends) {
+    PieceTable table;
+    table.loadFromString("x\xE2\x82\xAC");
+    Utf16Index index;
+    index.rebuild(table);
+
+    table.insert(1, "\xF0\x9F\x98\x80");
+    index.recordEdit(1, {}, "\xF0\x9F\x98\x80");
+    table.erase(0, 1);
+    index.recordEdit(0, "x", {});
+
+    EXPECT_EQ(index.totals().bytes, table.length());
+    EXPECT_EQ(index.totals().utf16Units, 3);
+    EXPECT_EQ(index.offsetFromUtf16(table, 2), 4);
+    EXPECT_EQ(index.codePointFromOffset(table, 4), 1);
+}
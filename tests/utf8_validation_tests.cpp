@@ -0,0 +1,218 @@
+// =============================================================================
+// utf8_validation_tests.cpp - Unit Tests for UTF-8 Validation
+// =============================================================================
+//
+// Tests for findInvalidUtf8() and GapBuffer's validated mode covering:
+// - Every kind of malformed sequence, at every supported SIMD level
+// - Errors placed on and around vector block boundaries, against a scalar
+//   reference over random text
+// - Rejection without modification, and offset snapping for edits
+//
+// =============================================================================
+
+#include <gtest/gtest.h>
+#include "gap_buffer.h"
+#include "utf8_scan.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mdeditor;
+
+namespace {
+
+constexpr size_t kValid = std::string_view::npos;
+
+std::vector<simd::Level> supportedLevels() {
+    std::vector<simd::Level> levels;
+    for (auto level : {simd::Level::Scalar, simd::Level::SSE2,
+                       simd::Level::AVX2, simd::Level::AVX512}) {
+        if (level <= simd::detectedLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+/// Characters of 1, 2, 3 and 4 bytes
+const char* const kSamples[] = {"a", "\n", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+
+std::string randomUtf8(std::mt19937& rng, size_t characters) {
+    std::string text;
+    for (size_t i = 0; i < characters; ++i) {
+        text += kSamples[rng() % 5];
+    }
+    return text;
+}
+
+/// Malformed sequences; each is invalid at its first byte
+const char* const kMalformed[] = {
+    "\x80",                 // Stray continuation
+    "\xBF\x80",
+    "\xC0\xAF",             // Overlong 2-byte
+    "\xC1\xBF",
+    "\xE0\x80\xAF",         // Overlong 3-byte
+    "\xE0\x9F\xBF",
+    "\xF0\x80\x80\xAF",     // Overlong 4-byte
+    "\xF0\x8F\xBF\xBF",
+    "\xED\xA0\x80",         // Surrogates
+    "\xED\xBF\xBF",
+    "\xF4\x90\x80\x80",     // Above U+10FFFF
+    "\xF5\x80\x80\x80",
+    "\xFF",
+    "\xC3",                 // Truncated
+    "\xE2\x82",
+    "\xF0\x9F\x98",
+    "\xC3" "a",             // Continuation missing
+    "\xE2\x82" "a",
+    "\xF0\x9F\x98" "a",
+};
+
+} // anonymous namespace
+
+// =============================================================================
+// Validation Kernels
+// =============================================================================
+
+TEST(Utf8ValidationTest, AcceptsValidText) {
+    // Boundary code points: U+007F, U+0080, U+07FF, U+0800, U+D7FF, U+E000,
+    // U+FFFF, U+10000, U+10FFFF
+    const std::string edges =
+        "\x7F" "\xC2\x80" "\xDF\xBF" "\xE0\xA0\x80" "\xED\x9F\xBF" "\xEE\x80\x80"
+        "\xEF\xBF\xBF" "\xF0\x90\x80\x80" "\xF4\x8F\xBF\xBF";
+    for (auto level : supportedLevels()) {
+        EXPECT_EQ(simd::findInvalidUtf8("", level), kValid);
+        EXPECT_EQ(simd::findInvalidUtf8(edges, level), kValid) << simd::levelName(level);
+        for (size_t pad = 0; pad < 70; ++pad) {
+            const std::string text = std::string(pad, 'x') + edges + std::string(pad, 'y');
+            ASSERT_EQ(simd::findInvalidUtf8(text, level), kValid)
+                << simd::levelName(level) << " pad " << pad;
+        }
+    }
+}
+
+TEST(Utf8ValidationTest, ReportsFirstBadSequence) {
+    for (auto level : supportedLevels()) {
+        for (const char* bad : kMalformed) {
+            // Slide the error across vector block boundaries
+            for (size_t pad = 0; pad < 70; ++pad) {
+                const std::string text = std::string(pad, 'x') + bad + std::string(40, 'z');
+                ASSERT_EQ(simd::findInvalidUtf8(text, level), pad)
+                    << simd::levelName(level) << " pad " << pad;
+                // At the very end, too
+                const std::string tail = std::string(pad, 'x') + bad;
+                ASSERT_EQ(simd::findInvalidUtf8(tail, level), pad)
+                    << simd::levelName(level) << " tail pad " << pad;
+            }
+        }
+    }
+}
+
+TEST(Utf8ValidationTest, RandomizedMatchesScalar) {
+    std::mt19937 rng(16);
+    for (int round = 0; round < 400; ++round) {
+        std::string text = randomUtf8(rng, rng() % 300);
+        if (round % 4 != 0 && !text.empty()) {
+            // Corrupt one byte; the result may or may not still be valid
+            text[rng() % text.size()] = static_cast<char>(rng() % 256);
+        }
+        const size_t expected = simd::findInvalidUtf8(text, simd::Level::Scalar);
+        for (auto level : supportedLevels()) {
+            ASSERT_EQ(simd::findInvalidUtf8(text, level), expected)
+                << simd::levelName(level) << " round " << round;
+        }
+    }
+
+    std::string large = randomUtf8(rng, 200000);
+    EXPECT_EQ(simd::findInvalidUtf8(large), kValid);
+    large[large.size() / 2 + 1] = '\x80';
+    EXPECT_EQ(simd::findInvalidUtf8(large), simd::findInvalidUtf8(large, simd::Level::Scalar));
+}
+
+// =============================================================================
+// GapBuffer Validated Mode
+// =============================================================================
+
+TEST(Utf8ValidationTest, GapBuffer_RejectsInvalidLoad) {
+    GapBuffer buffer;
+    buffer.loadFromString("ok");
+    buffer.setUtf8Validation(true);
+    EXPECT_TRUE(buffer.utf8Validation());
+
+    try {
+        buffer.loadFromString("abc\xC3(");
+        FAIL() << "expected InvalidUtf8Error";
+    } catch (const InvalidUtf8Error& error) {
+        EXPECT_EQ(error.offset(), 3);
+    }
+    EXPECT_EQ(buffer.getText(), "ok");
+}
+
+TEST(Utf8ValidationTest, GapBuffer_RejectsInvalidInsert) {
+    GapBuffer buffer;
+    buffer.setUtf8Validation(true);
+    buffer.loadFromString("\xC3\xA9t\xC3\xA9");
+    (void)buffer.flushPatches();
+
+    try {
+        buffer.insert(1, "xy\xED\xA0\x80");
+        FAIL() << "expected InvalidUtf8Error";
+    } catch (const InvalidUtf8Error& error) {
+        EXPECT_EQ(error.offset(), 2);   // Relative to the inserted text
+    }
+    EXPECT_THROW(buffer.applyEdits({{0, 0, "ok"}, {3, 0, "\xFF"}}), InvalidUtf8Error);
+    EXPECT_EQ(buffer.getText(), "\xC3\xA9t\xC3\xA9");
+    EXPECT_FALSE(buffer.hasPendingPatches());
+}
+
+TEST(Utf8ValidationTest, GapBuffer_EnablingValidatesCurrentText) {
+    GapBuffer buffer;
+    buffer.loadFromString("ab\xC3");
+    EXPECT_THROW(buffer.setUtf8Validation(true), InvalidUtf8Error);
+    EXPECT_FALSE(buffer.utf8Validation());
+
+    // Without validation anything goes
+    buffer.insert(1, "\xFF");
+    EXPECT_EQ(buffer.getText(), "a\xFF" "b\xC3");
+}
+
+TEST(Utf8ValidationTest, GapBuffer_SnapsEditOffsets) {
+    GapBuffer buffer;
+    buffer.setUtf8Validation(true);
+    buffer.loadFromString("a\xF0\x9F\x98\x80" "b\xE2\x82\xAC" "c");   // a😀b€c
+
+    buffer.insert(3, "x");                  // Inside 😀: before it
+    EXPECT_EQ(buffer.getText(), "ax\xF0\x9F\x98\x80" "b\xE2\x82\xAC" "c");
+
+    buffer.erase(4, 1);                     // Inside 😀: all of it
+    EXPECT_EQ(buffer.getText(), "axb\xE2\x82\xAC" "c");
+
+    buffer.erase(2, 2);                     // "b" and half of €: both
+    EXPECT_EQ(buffer.getText(), "axc");
+
+    buffer.loadFromString("\xC3\xA9\xC3\xA9\xC3\xA9");   // ééé
+    buffer.applyEdits({{1, 0, "["}, {3, 2, "]"}});
+    EXPECT_EQ(buffer.getText(), "[\xC3\xA9]");
+    EXPECT_EQ(simd::findInvalidUtf8(buffer.getText()), kValid);
+}
+
+TEST(Utf8ValidationTest, GapBuffer_RandomEditsStayValid) {
+    std::mt19937 rng(17);
+    GapBuffer buffer;
+    buffer.setUtf8Validation(true);
+    buffer.loadFromString(randomUtf8(rng, 2000));
+
+    for (int step = 0; step < 2000; ++step) {
+        const size_t offset = rng() % (buffer.length() + 1);
+        if (rng() % 2 == 0) {
+            buffer.insert(offset, randomUtf8(rng, rng() % 5 + 1));
+        } else {
+            buffer.erase(offset, rng() % 9);
+        }
+    }
+    EXPECT_EQ(simd::findInvalidUtf8(buffer.getText()), kValid);
+
+    GapBuffer copy = buffer;
+    EXPECT_TRUE(copy.utf8Validation());
+}